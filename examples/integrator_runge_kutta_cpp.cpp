@@ -0,0 +1,673 @@
+#include "OPI/opi_cpp.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Basic information about the plugin that can be queried by the host.
+#define OPI_PLUGIN_NAME "RungeKuttaCPP"
+#define OPI_PLUGIN_AUTHOR "ILR TU BS"
+#define OPI_PLUGIN_DESC "Batch Runge-Kutta integrators (RK4, DP54, RKF78) with per-object step control"
+
+// Set the version number for the plugin here.
+#define OPI_PLUGIN_VERSION_MAJOR 0
+#define OPI_PLUGIN_VERSION_MINOR 1
+#define OPI_PLUGIN_VERSION_PATCH 0
+
+namespace
+{
+	// Butcher tableau of an explicit Runge-Kutta method. a[s] points to the s coefficients
+	// of stage s; e holds the weights of the error estimate (b minus the weights of the
+	// embedded solution) and is a null pointer for fixed-step methods.
+	struct Tableau
+	{
+		int stages;
+		// order of the lower solution, used by the step size control
+		int errorOrder;
+		// true if the last stage is evaluated at the new state (first same as last)
+		bool fsal;
+		const double* c;
+		const double* const* a;
+		const double* b;
+		const double* e;
+	};
+
+	// classical fourth order method
+	const double rk4C[] = { 0.0, 0.5, 0.5, 1.0 };
+	const double rk4A1[] = { 0.5 };
+	const double rk4A2[] = { 0.0, 0.5 };
+	const double rk4A3[] = { 0.0, 0.0, 1.0 };
+	const double* const rk4A[] = { 0, rk4A1, rk4A2, rk4A3 };
+	const double rk4B[] = { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+	const Tableau rk4 = { 4, 0, false, rk4C, rk4A, rk4B, 0 };
+
+	// Dormand-Prince 5(4), propagating the fifth order solution
+	const double dp54C[] = { 0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0 };
+	const double dp54A1[] = { 1.0 / 5.0 };
+	const double dp54A2[] = { 3.0 / 40.0, 9.0 / 40.0 };
+	const double dp54A3[] = { 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 };
+	const double dp54A4[] = { 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 };
+	const double dp54A5[] = { 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 };
+	const double dp54A6[] = { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 };
+	const double* const dp54A[] = { 0, dp54A1, dp54A2, dp54A3, dp54A4, dp54A5, dp54A6 };
+	const double dp54B[] = { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0 };
+	const double dp54E[] = {
+		35.0 / 384.0 - 5179.0 / 57600.0, 0.0, 500.0 / 1113.0 - 7571.0 / 16695.0, 125.0 / 192.0 - 393.0 / 640.0,
+		-2187.0 / 6784.0 + 92097.0 / 339200.0, 11.0 / 84.0 - 187.0 / 2100.0, -1.0 / 40.0
+	};
+	const Tableau dp54 = { 7, 4, true, dp54C, dp54A, dp54B, dp54E };
+
+	// Runge-Kutta-Fehlberg 7(8), propagating the eighth order solution
+	const double rkf78C[] = { 0.0, 2.0 / 27.0, 1.0 / 9.0, 1.0 / 6.0, 5.0 / 12.0, 1.0 / 2.0, 5.0 / 6.0, 1.0 / 6.0, 2.0 / 3.0, 1.0 / 3.0, 1.0, 0.0, 1.0 };
+	const double rkf78A1[] = { 2.0 / 27.0 };
+	const double rkf78A2[] = { 1.0 / 36.0, 1.0 / 12.0 };
+	const double rkf78A3[] = { 1.0 / 24.0, 0.0, 1.0 / 8.0 };
+	const double rkf78A4[] = { 5.0 / 12.0, 0.0, -25.0 / 16.0, 25.0 / 16.0 };
+	const double rkf78A5[] = { 1.0 / 20.0, 0.0, 0.0, 1.0 / 4.0, 1.0 / 5.0 };
+	const double rkf78A6[] = { -25.0 / 108.0, 0.0, 0.0, 125.0 / 108.0, -65.0 / 27.0, 125.0 / 54.0 };
+	const double rkf78A7[] = { 31.0 / 300.0, 0.0, 0.0, 0.0, 61.0 / 225.0, -2.0 / 9.0, 13.0 / 900.0 };
+	const double rkf78A8[] = { 2.0, 0.0, 0.0, -53.0 / 6.0, 704.0 / 45.0, -107.0 / 9.0, 67.0 / 90.0, 3.0 };
+	const double rkf78A9[] = { -91.0 / 108.0, 0.0, 0.0, 23.0 / 108.0, -976.0 / 135.0, 311.0 / 54.0, -19.0 / 60.0, 17.0 / 6.0, -1.0 / 12.0 };
+	const double rkf78A10[] = { 2383.0 / 4100.0, 0.0, 0.0, -341.0 / 164.0, 4496.0 / 1025.0, -301.0 / 82.0, 2133.0 / 4100.0, 45.0 / 82.0, 45.0 / 164.0, 18.0 / 41.0 };
+	const double rkf78A11[] = { 3.0 / 205.0, 0.0, 0.0, 0.0, 0.0, -6.0 / 41.0, -3.0 / 205.0, -3.0 / 41.0, 3.0 / 41.0, 6.0 / 41.0, 0.0 };
+	const double rkf78A12[] = { -1777.0 / 4100.0, 0.0, 0.0, -341.0 / 164.0, 4496.0 / 1025.0, -289.0 / 82.0, 2193.0 / 4100.0, 51.0 / 82.0, 33.0 / 164.0, 12.0 / 41.0, 0.0, 1.0 };
+	const double* const rkf78A[] = { 0, rkf78A1, rkf78A2, rkf78A3, rkf78A4, rkf78A5, rkf78A6, rkf78A7, rkf78A8, rkf78A9, rkf78A10, rkf78A11, rkf78A12 };
+	const double rkf78B[] = { 0.0, 0.0, 0.0, 0.0, 0.0, 34.0 / 105.0, 9.0 / 35.0, 9.0 / 35.0, 9.0 / 280.0, 9.0 / 280.0, 0.0, 41.0 / 840.0, 41.0 / 840.0 };
+	const double rkf78E[] = { -41.0 / 840.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, -41.0 / 840.0, 41.0 / 840.0, 41.0 / 840.0 };
+	const Tableau rkf78 = { 13, 7, false, rkf78C, rkf78A, rkf78B, rkf78E };
+
+	const int MAX_STAGES = 13;
+
+	// number of objects integrated together; the stages of a block stay in the cache
+	const int BLOCK_SIZE = 256;
+
+	// components of a state in the per block scratch data: x, y and z of the position,
+	// followed by x, y and z of the velocity, each as an array of BLOCK_SIZE values
+	const int COMPONENTS = 6;
+
+	const double SECONDS_PER_DAY = 86400.0;
+
+	double norm(const OPI::Vector3& v)
+	{
+		return sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	}
+
+	// Settings and shared data of one integrate call
+	struct Problem
+	{
+		const Tableau* method;
+		const OPI::CustomPropagator* propagator;
+		const OPI::DenseOutput* output;
+		double julianDay;
+		double dt;
+		double stepSize;
+		double relativeTolerance;
+		double absoluteTolerance;
+		int maxSteps;
+		OPI::Vector3* position;
+		OPI::Vector3* velocity;
+		OPI::Vector3* acceleration;
+		const OPI::ObjectProperties* properties;
+	};
+
+	// Copies the x, y and z components of count vectors into three arrays of BLOCK_SIZE values
+	void split(const OPI::Vector3* vectors, int count, double* components)
+	{
+		for(int i = 0; i < count; ++i)
+		{
+			components[i] = vectors[i].x;
+			components[BLOCK_SIZE + i] = vectors[i].y;
+			components[2 * BLOCK_SIZE + i] = vectors[i].z;
+		}
+	}
+
+	// Inverse of split()
+	void join(const double* components, int count, OPI::Vector3* vectors)
+	{
+		for(int i = 0; i < count; ++i)
+		{
+			vectors[i].x = components[i];
+			vectors[i].y = components[BLOCK_SIZE + i];
+			vectors[i].z = components[2 * BLOCK_SIZE + i];
+		}
+	}
+
+	// Adds weight * h[i] * rate to the states of count objects
+	void accumulate(double* state, const double* rate, const double* h, double weight, int count)
+	{
+		for(int c = 0; c < COMPONENTS; ++c)
+		{
+			double* s = state + c * BLOCK_SIZE;
+			const double* r = rate + c * BLOCK_SIZE;
+			for(int i = 0; i < count; ++i)
+				s[i] += weight * h[i] * r[i];
+		}
+	}
+
+	// Length of the vector i of three component arrays
+	double norm(const double* components, int i)
+	{
+		const double x = components[i];
+		const double y = components[BLOCK_SIZE + i];
+		const double z = components[2 * BLOCK_SIZE + i];
+		return sqrt(x * x + y * y + z * z);
+	}
+
+	// Reorders values so that values[i] becomes values[order[i]]
+	template<class T>
+	void permute(std::vector<T>& values, const std::vector<int>& order)
+	{
+		std::vector<T> sorted(order.size());
+		for(size_t i = 0; i < order.size(); ++i)
+			sorted[i] = values[order[i]];
+		values.swap(sorted);
+	}
+
+	// Integrates a range of objects of the Population. The objects that are still being
+	// integrated are kept contiguous and sorted by their current step size, so every block
+	// is filled with objects that take steps of a similar size.
+	class Integration
+	{
+		public:
+			Integration(const Problem& problem, int begin, int end);
+			OPI::ErrorCode run();
+
+		private:
+			OPI::ErrorCode step(int first, int count);
+			OPI::ErrorCode evaluate(const OPI::Vector3* position, const OPI::Vector3* velocity, const double* julianDay, int first, int count, OPI::Vector3* acceleration);
+			void writeOutput(int object, int block, double time, double h);
+			void compact();
+
+			const Problem& problem;
+			const Tableau& method;
+			double direction;
+
+			// per object state of the active objects
+			std::vector<int> index;
+			std::vector<double> time;
+			std::vector<double> stepSize;
+			std::vector<int> nextOutput;
+			std::vector<OPI::Vector3> position;
+			std::vector<OPI::Vector3> velocity;
+			std::vector<OPI::Vector3> acceleration;
+			std::vector<OPI::ObjectProperties> properties;
+
+			// per block scratch data; the states of the stages and their derivatives are kept
+			// as COMPONENTS arrays of BLOCK_SIZE values, so the stage updates run over
+			// contiguous values and can be vectorized by the compiler
+			std::vector<double> startState;
+			std::vector<double> stageState;
+			std::vector<double> stageRate[MAX_STAGES];
+			std::vector<double> newState;
+			std::vector<double> errorState;
+			// the states of a stage as passed to the modules, and the new states of the block
+			std::vector<OPI::Vector3> stagePosition;
+			std::vector<OPI::Vector3> stageVelocity;
+			std::vector<OPI::Vector3> stageAcceleration;
+			std::vector<OPI::Vector3> newPosition;
+			std::vector<OPI::Vector3> newVelocity;
+			std::vector<OPI::Vector3> newAcceleration;
+			std::vector<double> error;
+			std::vector<double> stageJulianDay;
+			std::vector<double> h;
+	};
+
+	Integration::Integration(const Problem& problem, int begin, int end):
+		problem(problem),
+		method(*problem.method),
+		direction(problem.dt < 0.0 ? -1.0 : 1.0)
+	{
+		const int size = end - begin;
+		const double mu = problem.propagator->getGravitationalParameter();
+		std::vector<double> initialStep(size);
+		for(int i = 0; i < size; ++i)
+		{
+			if(method.e && problem.stepSize <= 0.0)
+			{
+				// start with a hundredth of the period of a circular orbit at the current radius
+				double radius = norm(problem.position[begin + i]);
+				initialStep[i] = 0.01 * 6.28318530717958647693 * sqrt(radius * radius * radius / mu);
+			}
+			else initialStep[i] = problem.stepSize;
+		}
+		index.resize(size);
+		for(int i = 0; i < size; ++i)
+			index[i] = i;
+		std::stable_sort(index.begin(), index.end(), [&](int a, int b) { return initialStep[a] < initialStep[b]; });
+
+		time.assign(size, 0.0);
+		stepSize.resize(size);
+		nextOutput.assign(size, 0);
+		position.resize(size);
+		velocity.resize(size);
+		acceleration.resize(size);
+		if(problem.properties)
+			properties.resize(size);
+		for(int i = 0; i < size; ++i)
+		{
+			int object = index[i];
+			stepSize[i] = direction * initialStep[object];
+			position[i] = problem.position[begin + object];
+			velocity[i] = problem.velocity[begin + object];
+			if(problem.properties)
+				properties[i] = problem.properties[begin + object];
+			index[i] = begin + object;
+		}
+		startState.resize(COMPONENTS * BLOCK_SIZE);
+		stageState.resize(COMPONENTS * BLOCK_SIZE);
+		for(int s = 0; s < method.stages; ++s)
+			stageRate[s].resize(COMPONENTS * BLOCK_SIZE);
+		newState.resize(COMPONENTS * BLOCK_SIZE);
+		errorState.resize(COMPONENTS * BLOCK_SIZE);
+		stagePosition.resize(BLOCK_SIZE);
+		stageVelocity.resize(BLOCK_SIZE);
+		stageAcceleration.resize(BLOCK_SIZE);
+		newPosition.resize(BLOCK_SIZE);
+		newVelocity.resize(BLOCK_SIZE);
+		newAcceleration.resize(BLOCK_SIZE);
+		error.resize(BLOCK_SIZE);
+		stageJulianDay.resize(BLOCK_SIZE);
+		h.resize(BLOCK_SIZE);
+	}
+
+	OPI::ErrorCode Integration::evaluate(const OPI::Vector3* position, const OPI::Vector3* velocity, const double* julianDay, int first, int count, OPI::Vector3* acceleration)
+	{
+		OPI::StateBatch batch;
+		batch.count = count;
+		batch.position = position;
+		batch.velocity = velocity;
+		batch.julian_day = julianDay;
+		batch.properties = properties.empty() ? 0 : &properties[first];
+		batch.acceleration = acceleration;
+		return problem.propagator->calculateAccelerations(batch);
+	}
+
+	OPI::ErrorCode Integration::run()
+	{
+		OPI::ErrorCode status = OPI::SUCCESS;
+		const int size = static_cast<int>(index.size());
+		for(int first = 0; first < size && status == OPI::SUCCESS; first += BLOCK_SIZE)
+		{
+			int count = std::min(BLOCK_SIZE, size - first);
+			for(int i = 0; i < count; ++i)
+				stageJulianDay[i] = problem.julianDay;
+			status = evaluate(&position[first], &velocity[first], stageJulianDay.data(), first, count, &acceleration[first]);
+		}
+		if(problem.output)
+		{
+			// output times at the start of the integration
+			for(int i = 0; i < size; ++i)
+				writeOutput(i, 0, 0.0, 0.0);
+		}
+		if(problem.dt == 0.0)
+			compact();
+
+		for(int iteration = 0; !index.empty() && status == OPI::SUCCESS; ++iteration)
+		{
+			if(iteration == problem.maxSteps)
+				return OPI::UNKNOWN_ERROR;
+			const int active = static_cast<int>(index.size());
+			for(int first = 0; first < active && status == OPI::SUCCESS; first += BLOCK_SIZE)
+				status = step(first, std::min(BLOCK_SIZE, active - first));
+			compact();
+		}
+		return status;
+	}
+
+	// Attempts one step for every object of the block
+	OPI::ErrorCode Integration::step(int first, int count)
+	{
+		const Tableau& m = method;
+		const OPI::Vector3* y0 = &position[first];
+		const OPI::Vector3* v0 = &velocity[first];
+		const double* t = &time[first];
+		OPI::ErrorCode status = OPI::SUCCESS;
+
+		for(int i = 0; i < count; ++i)
+		{
+			// stop exactly at the end of the integration
+			double remaining = problem.dt - t[i];
+			h[i] = (direction * stepSize[first + i] >= direction * remaining * (1.0 - 1e-12)) ? remaining : stepSize[first + i];
+		}
+
+		// the first stage is the current state; the derivative of the position is the velocity
+		split(y0, count, &startState[0]);
+		split(v0, count, &startState[3 * BLOCK_SIZE]);
+		std::copy(startState.begin() + 3 * BLOCK_SIZE, startState.end(), stageRate[0].begin());
+		split(&acceleration[first], count, &stageRate[0][3 * BLOCK_SIZE]);
+		for(int s = 1; s < m.stages && status == OPI::SUCCESS; ++s)
+		{
+			stageState = startState;
+			for(int j = 0; j < s; ++j)
+			{
+				if(m.a[s][j] != 0.0)
+					accumulate(stageState.data(), stageRate[j].data(), h.data(), m.a[s][j], count);
+			}
+			join(&stageState[0], count, stagePosition.data());
+			join(&stageState[3 * BLOCK_SIZE], count, stageVelocity.data());
+			for(int i = 0; i < count; ++i)
+				stageJulianDay[i] = problem.julianDay + (t[i] + m.c[s] * h[i]) / SECONDS_PER_DAY;
+			status = evaluate(stagePosition.data(), stageVelocity.data(), stageJulianDay.data(), first, count, stageAcceleration.data());
+			std::copy(stageState.begin() + 3 * BLOCK_SIZE, stageState.end(), stageRate[s].begin());
+			split(stageAcceleration.data(), count, &stageRate[s][3 * BLOCK_SIZE]);
+		}
+		if(status != OPI::SUCCESS)
+			return status;
+
+		// new states and the error estimate
+		newState = startState;
+		std::fill(errorState.begin(), errorState.end(), 0.0);
+		std::fill(error.begin(), error.begin() + count, 0.0);
+		for(int j = 0; j < m.stages; ++j)
+		{
+			if(m.b[j] != 0.0)
+				accumulate(newState.data(), stageRate[j].data(), h.data(), m.b[j], count);
+			if(m.e && m.e[j] != 0.0)
+				accumulate(errorState.data(), stageRate[j].data(), h.data(), m.e[j], count);
+		}
+		if(m.e)
+		{
+			const double rtol = problem.relativeTolerance;
+			const double atol = problem.absoluteTolerance;
+			const double* p0 = &startState[0];
+			const double* p1 = &newState[0];
+			const double* ep = &errorState[0];
+			const double* vel0 = &startState[3 * BLOCK_SIZE];
+			const double* vel1 = &newState[3 * BLOCK_SIZE];
+			const double* ev = &errorState[3 * BLOCK_SIZE];
+			for(int i = 0; i < count; ++i)
+			{
+				double scalePosition = atol + rtol * std::max(norm(p0, i), norm(p1, i));
+				double scaleVelocity = atol + rtol * std::max(norm(vel0, i), norm(vel1, i));
+				error[i] = std::max(norm(ep, i) / scalePosition, norm(ev, i) / scaleVelocity);
+			}
+		}
+		join(&newState[0], count, newPosition.data());
+		join(&newState[3 * BLOCK_SIZE], count, newVelocity.data());
+
+		// the acceleration at the new state starts the next step
+		if(m.fsal)
+			std::copy(stageAcceleration.begin(), stageAcceleration.begin() + count, newAcceleration.begin());
+		else
+		{
+			for(int i = 0; i < count; ++i)
+				stageJulianDay[i] = problem.julianDay + (t[i] + h[i]) / SECONDS_PER_DAY;
+			status = evaluate(newPosition.data(), newVelocity.data(), stageJulianDay.data(), first, count, newAcceleration.data());
+			if(status != OPI::SUCCESS)
+				return status;
+		}
+
+		const double exponent = m.e ? -1.0 / (m.errorOrder + 1) : 0.0;
+		for(int i = 0; i < count; ++i)
+		{
+			const int object = first + i;
+			if(error[i] <= 1.0)
+			{
+				if(problem.output)
+					writeOutput(object, i, t[i], h[i]);
+				position[object] = newPosition[i];
+				velocity[object] = newVelocity[i];
+				acceleration[object] = newAcceleration[i];
+				time[object] = (h[i] == problem.dt - t[i]) ? problem.dt : t[i] + h[i];
+			}
+			if(m.e)
+			{
+				double factor = (error[i] > 0.0) ? 0.9 * pow(error[i], exponent) : 5.0;
+				factor = std::min(error[i] <= 1.0 ? 5.0 : 1.0, std::max(0.2, factor));
+				// a shortened last step does not shrink the step size
+				stepSize[object] = (h[i] != stepSize[object] && error[i] <= 1.0) ? stepSize[object] : h[i] * factor;
+			}
+		}
+		return OPI::SUCCESS;
+	}
+
+	// Interpolates the output times within (time, time + h] with a quintic Hermite polynomial
+	// through the positions, velocities and accelerations at both ends of the step. The states
+	// at the end of the step are still in the new* buffers, the ones at the start are current.
+	void Integration::writeOutput(int object, int block, double time, double h)
+	{
+		const OPI::DenseOutput& output = *problem.output;
+		const long long offset = static_cast<long long>(index[object]) * output.count;
+		int& k = nextOutput[object];
+		if(h == 0.0)
+		{
+			for(; k < output.count && direction * output.times[k] <= direction * time; ++k)
+			{
+				if(output.position)
+					output.position[offset + k] = position[object];
+				if(output.velocity)
+					output.velocity[offset + k] = velocity[object];
+			}
+			return;
+		}
+		const OPI::Vector3& p0 = position[object];
+		const OPI::Vector3& v0 = velocity[object];
+		const OPI::Vector3& a0 = acceleration[object];
+		const OPI::Vector3& p1 = newPosition[block];
+		const OPI::Vector3& v1 = newVelocity[block];
+		const OPI::Vector3& a1 = newAcceleration[block];
+		// the last step also takes the output times that are not reached due to rounding
+		const bool last = (h == problem.dt - time);
+		for(; k < output.count && (last || direction * output.times[k] <= direction * (time + h)); ++k)
+		{
+			double s = std::min(1.0, (output.times[k] - time) / h);
+			double s2 = s * s;
+			double s3 = s2 * s;
+			double s4 = s3 * s;
+			double s5 = s4 * s;
+			if(output.position)
+			{
+				double h0 = 1.0 - 10.0 * s3 + 15.0 * s4 - 6.0 * s5;
+				double h1 = (s - 6.0 * s3 + 8.0 * s4 - 3.0 * s5) * h;
+				double h2 = (0.5 * s2 - 1.5 * s3 + 1.5 * s4 - 0.5 * s5) * h * h;
+				double h3 = (0.5 * s3 - s4 + 0.5 * s5) * h * h;
+				double h4 = (-4.0 * s3 + 7.0 * s4 - 3.0 * s5) * h;
+				double h5 = 1.0 - h0;
+				output.position[offset + k] = p0 * h0 + v0 * h1 + a0 * h2 + a1 * h3 + v1 * h4 + p1 * h5;
+			}
+			if(output.velocity)
+			{
+				double d0 = (-30.0 * s2 + 60.0 * s3 - 30.0 * s4) / h;
+				double d1 = 1.0 - 18.0 * s2 + 32.0 * s3 - 15.0 * s4;
+				double d2 = (s - 4.5 * s2 + 6.0 * s3 - 2.5 * s4) * h;
+				double d3 = (1.5 * s2 - 4.0 * s3 + 2.5 * s4) * h;
+				double d4 = -12.0 * s2 + 28.0 * s3 - 15.0 * s4;
+				output.velocity[offset + k] = p0 * d0 + v0 * d1 + a0 * d2 + a1 * d3 + v1 * d4 - p1 * d0;
+			}
+		}
+	}
+
+	// Stores the finished objects in the Population, removes them from the active set and
+	// sorts the remaining objects by their step size
+	void Integration::compact()
+	{
+		size_t active = 0;
+		for(size_t i = 0; i < index.size(); ++i)
+		{
+			if(time[i] == problem.dt)
+			{
+				problem.position[index[i]] = position[i];
+				problem.velocity[index[i]] = velocity[i];
+				problem.acceleration[index[i]] = acceleration[i];
+				continue;
+			}
+			index[active] = index[i];
+			time[active] = time[i];
+			stepSize[active] = stepSize[i];
+			nextOutput[active] = nextOutput[i];
+			position[active] = position[i];
+			velocity[active] = velocity[i];
+			acceleration[active] = acceleration[i];
+			if(!properties.empty())
+				properties[active] = properties[i];
+			++active;
+		}
+		index.resize(active);
+		time.resize(active);
+		stepSize.resize(active);
+		nextOutput.resize(active);
+		position.resize(active);
+		velocity.resize(active);
+		acceleration.resize(active);
+		if(!properties.empty())
+			properties.resize(active);
+
+		// regroup the remaining objects if the step control has changed their order
+		const double sign = direction;
+		const std::vector<double>& steps = stepSize;
+		if(std::is_sorted(steps.begin(), steps.end(), [sign](double a, double b) { return sign * a < sign * b; }))
+			return;
+		std::vector<int> order(active);
+		for(size_t i = 0; i < active; ++i)
+			order[i] = static_cast<int>(i);
+		std::stable_sort(order.begin(), order.end(), [&steps, sign](int a, int b) { return sign * steps[a] < sign * steps[b]; });
+		permute(index, order);
+		permute(time, order);
+		permute(stepSize, order);
+		permute(nextOutput, order);
+		permute(position, order);
+		permute(velocity, order);
+		permute(acceleration, order);
+		if(!properties.empty())
+			permute(properties, order);
+	}
+}
+
+// Integrates the Cartesian states of a Population with an explicit Runge-Kutta method.
+// All objects are integrated together: every step evaluates the accelerations of a whole
+// block of objects with CustomPropagator::calculateAccelerations(), while every object has
+// its own step size. Objects that reached the end are removed from the blocks and the
+// others are regrouped by their current step size, so the blocks stay filled until the
+// last object is done. Within a block the stages are combined on separate arrays for
+// every component of the states, so these loops are left to the compiler's
+// auto-vectorization; there is no explicit SIMD code. The modules get the states of a
+// stage as arrays of Vector3 like the Population columns.
+//
+// Properties:
+//   method              "RK4", "DP54" (default) or "RKF78"
+//   step_size           fixed step size of RK4 and initial step size of the adaptive
+//                       methods in seconds; 0 estimates the initial step from the orbit
+//   relative_tolerance  relative error tolerance per step of the adaptive methods
+//   absolute_tolerance  absolute error tolerance per step in km and km/s
+//   max_steps           maximum number of steps per object and integrate call
+class RungeKuttaCPP: public OPI::PropagatorIntegrator
+{
+	private:
+		std::string method;
+		double stepSize;
+		double relativeTolerance;
+		double absoluteTolerance;
+		int maxSteps;
+
+		void setDefaultPropertyValues()
+		{
+			method = "DP54";
+			stepSize = 0.0;
+			relativeTolerance = 1e-10;
+			absoluteTolerance = 1e-9;
+			maxSteps = 1000000;
+		}
+
+		const Tableau* getTableau() const
+		{
+			if(method == "RK4")
+				return &rk4;
+			if(method == "DP54")
+				return &dp54;
+			if(method == "RKF78")
+				return &rkf78;
+			return 0;
+		}
+
+	public:
+		RungeKuttaCPP(OPI::Host& host)
+		{
+			setDefaultPropertyValues();
+			registerProperty("method", &method);
+			registerProperty("step_size", &stepSize);
+			registerProperty("relative_tolerance", &relativeTolerance);
+			registerProperty("absolute_tolerance", &absoluteTolerance);
+			registerProperty("max_steps", &maxSteps);
+		}
+
+		virtual ~RungeKuttaCPP()
+		{
+		}
+
+		virtual OPI::ErrorCode runIntegration(OPI::Population& data, double julian_day, double dt, const OPI::CustomPropagator& propagator, const OPI::DenseOutput* output)
+		{
+			Problem problem;
+			problem.method = getTableau();
+			if(!problem.method || (problem.method == &rk4 && stepSize <= 0.0))
+				return OPI::INVALID_PROPERTY;
+			if(!data.hasData(OPI::DATA_CARTESIAN) || !data.hasData(OPI::DATA_VELOCITY))
+				return OPI::INVALID_TYPE;
+			problem.propagator = &propagator;
+			problem.output = (output && output->count > 0) ? output : 0;
+			problem.julianDay = julian_day;
+			problem.dt = dt;
+			problem.stepSize = stepSize;
+			problem.relativeTolerance = relativeTolerance;
+			problem.absoluteTolerance = absoluteTolerance;
+			problem.maxSteps = maxSteps;
+			problem.position = data.getPosition();
+			problem.velocity = data.getVelocity();
+			problem.acceleration = data.getAcceleration(OPI::DEVICE_HOST, true);
+			problem.properties = data.hasData(OPI::DATA_PROPERTIES) ? data.getObjectProperties() : 0;
+
+			// split the objects into one contiguous range per thread
+			const int size = data.getSize();
+			const int minimumRange = 1024;
+			int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+			threads = std::max(1, std::min(threads, (size + minimumRange - 1) / minimumRange));
+			std::vector<OPI::ErrorCode> results(threads, OPI::SUCCESS);
+			std::vector<std::thread> workers;
+			for(int thread = 0; thread < threads; ++thread)
+			{
+				int begin = static_cast<int>(static_cast<long long>(size) * thread / threads);
+				int end = static_cast<int>(static_cast<long long>(size) * (thread + 1) / threads);
+				workers.push_back(std::thread([&problem, &results, thread, begin, end]() {
+					Integration integration(problem, begin, end);
+					results[thread] = integration.run();
+				}));
+			}
+			for(size_t thread = 0; thread < workers.size(); ++thread)
+				workers[thread].join();
+			for(int thread = 0; thread < threads; ++thread)
+			{
+				if(results[thread] != OPI::SUCCESS)
+					return results[thread];
+			}
+			data.updateColumns(OPI::MASK_CARTESIAN | OPI::MASK_VELOCITY | OPI::MASK_ACCELERATION);
+			return OPI::SUCCESS;
+		}
+
+		virtual OPI::ErrorCode runDisable()
+		{
+			setDefaultPropertyValues();
+			return OPI::SUCCESS;
+		}
+
+		// This plugin does not require CUDA.
+		int requiresCUDA()
+		{
+			return 0;
+		}
+
+		// This plugin does not require OpenCL.
+		int requiresOpenCL()
+		{
+			return 0;
+		}
+
+		// This plugin is written for OPI version 1.0.
+		int minimumOPIVersionRequired()
+		{
+			return 1;
+		}
+};
+
+#define OPI_IMPLEMENT_CPP_PROPAGATOR_INTEGRATOR RungeKuttaCPP
+
+#include "OPI/opi_implement_plugin.h"
@@ -0,0 +1,561 @@
+#include "OPI/opi_cpp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Basic information about the plugin that can be queried by the host.
+#define OPI_PLUGIN_NAME "DragSRPCPP"
+#define OPI_PLUGIN_AUTHOR "ILR TU BS"
+#define OPI_PLUGIN_DESC "Atmospheric drag and solar radiation pressure with tabulated densities"
+
+// Set the version number for the plugin here.
+#define OPI_PLUGIN_VERSION_MAJOR 0
+#define OPI_PLUGIN_VERSION_MINOR 1
+#define OPI_PLUGIN_VERSION_PATCH 0
+
+namespace
+{
+	// number of objects evaluated together in the lane loops
+	const int LANES = 8;
+
+	const double PI = 3.14159265358979323846;
+	const double DEGREES = PI / 180.0;
+	const double EARTH_RADIUS = 6378.137;
+	const double EARTH_FLATTENING = 1.0 / 298.257223563;
+	// rotation rate of the atmosphere in rad/s
+	const double EARTH_ROTATION = 7.292115e-5;
+	const double SUN_RADIUS = 696000.0;
+	const double ASTRONOMICAL_UNIT = 149597870.7;
+	// solar radiation pressure at 1 AU in N/m^2
+	const double SOLAR_PRESSURE = 4.56e-6;
+
+	// density table: altitudes in km and number of exospheric temperatures
+	const double TABLE_MIN_ALTITUDE = 100.0;
+	const double TABLE_MAX_ALTITUDE = 2500.0;
+	const double TABLE_ALTITUDE_STEP = 10.0;
+	const int TABLE_ALTITUDES = 241;
+	const int TABLE_TEMPERATURES = 49;
+
+	// Bates-Walker temperature profile and diffusive equilibrium above 120 km
+	const double BASE_ALTITUDE = 120.0;
+	const double BASE_TEMPERATURE = 380.0;
+	// shape parameter of the temperature profile in 1/km
+	const double TEMPERATURE_SHAPE = 0.02;
+	// gravity at the base altitude in m/s^2
+	const double BASE_GRAVITY = 9.80665 * (6356.766 / (6356.766 + BASE_ALTITUDE)) * (6356.766 / (6356.766 + BASE_ALTITUDE));
+	const double BOLTZMANN = 1.380649e-23;
+	const double ATOMIC_MASS = 1.66053907e-27;
+
+	// constituents with molecular mass, number density at 120 km in 1/m^3 (US Standard
+	// Atmosphere 1976) and thermal diffusion coefficient
+	struct Constituent
+	{
+		double mass;
+		double density;
+		double thermalDiffusion;
+	};
+	const Constituent CONSTITUENTS[] = {
+		{ 28.0134, 3.726e17, 0.0 },
+		{ 31.9988, 4.982e16, 0.0 },
+		{ 15.9994, 9.275e16, 0.0 },
+		{ 39.948, 1.16e15, 0.0 },
+		{ 4.0026, 4.0e13, -0.38 }
+	};
+
+	// Returns the mass density in kg/m^3 of the model atmosphere for the given altitude
+	// (at least BASE_ALTITUDE) and exospheric temperature.
+	double modelDensity(double altitude, double exosphericTemperature)
+	{
+		const double base = EARTH_RADIUS + BASE_ALTITUDE;
+		const double sigma = TEMPERATURE_SHAPE + 1.0 / base;
+		// geopotential altitude above the base
+		const double xi = (altitude - BASE_ALTITUDE) * base / (EARTH_RADIUS + altitude);
+		const double a = (exosphericTemperature - BASE_TEMPERATURE) / exosphericTemperature;
+		const double decay = exp(-sigma * xi);
+		const double temperatureRatio = (1.0 - a) / (1.0 - a * decay);
+		double density = 0.0;
+		for(size_t i = 0; i < sizeof(CONSTITUENTS) / sizeof(Constituent); ++i)
+		{
+			const Constituent& constituent = CONSTITUENTS[i];
+			const double mass = constituent.mass * ATOMIC_MASS;
+			const double gamma = mass * BASE_GRAVITY / (sigma * 1e-3 * BOLTZMANN * exosphericTemperature);
+			double n = constituent.density * pow(temperatureRatio, 1.0 + constituent.thermalDiffusion + gamma) * exp(-sigma * gamma * xi);
+			density += n * mass;
+		}
+		return density;
+	}
+
+	// exp(x) for x in [-700, 700] with plain arithmetic, so loops over it can be vectorized
+	inline double vectorExp(double x)
+	{
+		const double magic = 6755399441055744.0;
+		const double scaled = x * 1.4426950408889634 + magic;
+		int64_t bits;
+		memcpy(&bits, &scaled, sizeof(bits));
+		const double k = scaled - magic;
+		const double r = (x - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+		double p = 1.0 / 479001600.0;
+		p = p * r + 1.0 / 39916800.0;
+		p = p * r + 1.0 / 3628800.0;
+		p = p * r + 1.0 / 362880.0;
+		p = p * r + 1.0 / 40320.0;
+		p = p * r + 1.0 / 5040.0;
+		p = p * r + 1.0 / 720.0;
+		p = p * r + 1.0 / 120.0;
+		p = p * r + 1.0 / 24.0;
+		p = p * r + 1.0 / 6.0;
+		p = p * r + 0.5;
+		p = p * r + 1.0;
+		p = p * r + 1.0;
+		int64_t magicBits;
+		memcpy(&magicBits, &magic, sizeof(magicBits));
+		const int64_t exponent = (bits - magicBits + 1023) << 52;
+		double scale;
+		memcpy(&scale, &exponent, sizeof(scale));
+		return p * scale;
+	}
+
+	// log(x) for positive normal x with plain arithmetic, see vectorExp()
+	inline double vectorLog(double x)
+	{
+		int64_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		double exponent = static_cast<double>((bits >> 52) - 1023);
+		const int64_t mantissaBits = (bits & 0xfffffffffffffLL) | 0x3ff0000000000000LL;
+		double mantissa;
+		memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+		// reduce the mantissa to [sqrt(2) / 2, sqrt(2)]
+		const bool large = mantissa > 1.4142135623730951;
+		mantissa = large ? 0.5 * mantissa : mantissa;
+		exponent = large ? exponent + 1.0 : exponent;
+		// log(m) = 2 atanh(s) with s = (m - 1) / (m + 1)
+		const double s = (mantissa - 1.0) / (mantissa + 1.0);
+		const double s2 = s * s;
+		double p = 1.0 / 19.0;
+		p = p * s2 + 1.0 / 17.0;
+		p = p * s2 + 1.0 / 15.0;
+		p = p * s2 + 1.0 / 13.0;
+		p = p * s2 + 1.0 / 11.0;
+		p = p * s2 + 1.0 / 9.0;
+		p = p * s2 + 1.0 / 7.0;
+		p = p * s2 + 1.0 / 5.0;
+		p = p * s2 + 1.0 / 3.0;
+		p = p * s2 + 1.0;
+		return exponent * 0.69314718055994530942 + 2.0 * s * p;
+	}
+
+	// Low precision position of the sun in km in the equatorial frame of date
+	// (Astronomical Almanac, accurate to about 0.01 degrees).
+	OPI::Vector3 sunPosition(double julian_day)
+	{
+		const double n = julian_day - 2451545.0;
+		const double meanLongitude = (280.460 + 0.9856474 * n) * DEGREES;
+		const double meanAnomaly = (357.528 + 0.9856003 * n) * DEGREES;
+		const double longitude = meanLongitude + (1.915 * sin(meanAnomaly) + 0.020 * sin(2.0 * meanAnomaly)) * DEGREES;
+		const double obliquity = (23.439 - 0.0000004 * n) * DEGREES;
+		const double distance = (1.00014 - 0.01671 * cos(meanAnomaly) - 0.00014 * cos(2.0 * meanAnomaly)) * ASTRONOMICAL_UNIT;
+		return OPI::Vector3(distance * cos(longitude), distance * cos(obliquity) * sin(longitude), distance * sin(obliquity) * sin(longitude));
+	}
+
+	// Fraction of the solar disc visible from the satellite for the conical shadow model
+	// (Montenbruck and Gill, Satellite Orbits, 3.4.2), used for objects in the penumbra
+	double penumbraFraction(double sinSun, double sinEarth, double cosSeparation)
+	{
+		const double a = asin(sinSun);
+		const double b = asin(sinEarth);
+		const double c = acos(std::max(-1.0, std::min(1.0, cosSeparation)));
+		if(c < a - b)
+			return 1.0 - b * b / (a * a);
+		const double x = (c * c + a * a - b * b) / (2.0 * c);
+		const double y = sqrt(std::max(0.0, a * a - x * x));
+		const double area = a * a * acos(std::max(-1.0, std::min(1.0, x / a))) + b * b * acos(std::max(-1.0, std::min(1.0, (c - x) / b))) - c * y;
+		return 1.0 - area / (PI * a * a);
+	}
+}
+
+// Adds the accelerations of atmospheric drag and solar radiation pressure to the batches
+// of the CustomPropagator's integrators. The objects need the properties area_to_mass
+// (m^2/kg), drag_coefficient and reflectivity (the radiation pressure coefficient).
+//
+// The densities are interpolated from a table of the logarithmic density over altitude
+// and exospheric temperature, which is built in setTimeStep() for the range of
+// temperatures the current solar and geomagnetic activity can produce. The table uses
+// cubic Hermite interpolation over the altitude and linear interpolation over the
+// temperature. It is filled from a diffusive equilibrium model with a Bates-Walker
+// temperature profile; the exospheric temperature of every object follows the Jacchia
+// 1970 model including the diurnal bulge. The sun position is extrapolated from the
+// start of the time step. All objects of a batch are processed in groups of LANES, so
+// the table lookups, the shadow tests and the accelerations are computed in loops over
+// the lanes; only objects in the penumbra take a scalar path.
+//
+// Properties:
+//   f107               daily solar flux F10.7 (default 150)
+//   f107_average       81-day average of F10.7 (default 150)
+//   kp                 geomagnetic index Kp (default 3)
+//   diurnal_variation  1 to model the diurnal bulge, 0 for a spherically symmetric
+//                      atmosphere (default 1)
+//   drag               1 to calculate atmospheric drag (default 1)
+//   srp                1 to calculate solar radiation pressure (default 1)
+//   shadow_model       "conical" (default), "cylindrical" or "none"
+class DragSRPCPP: public OPI::PerturbationModule
+{
+	private:
+		double f107;
+		double f107Average;
+		double kp;
+		int diurnalVariation;
+		int drag;
+		int srp;
+		std::string shadowModel;
+
+		// activity the table was built for
+		double tableF107;
+		double tableF107Average;
+		double tableKp;
+		// logarithmic density and its derivative over the altitude, for every temperature
+		// the values of all altitudes follow each other
+		std::vector<double> logDensity;
+		std::vector<double> logDensitySlope;
+		double minTemperature;
+		double temperatureStep;
+		// exospheric temperature at night and the geomagnetic correction
+		double nightTemperature;
+		double geomagneticTemperature;
+
+		// sun position, velocity and acceleration at referenceTime
+		double referenceTime;
+		OPI::Vector3 sun;
+		OPI::Vector3 sunVelocity;
+		OPI::Vector3 sunAcceleration;
+
+		void setDefaultPropertyValues()
+		{
+			f107 = 150.0;
+			f107Average = 150.0;
+			kp = 3.0;
+			diurnalVariation = 1;
+			drag = 1;
+			srp = 1;
+			shadowModel = "conical";
+		}
+
+		void buildDensityTable()
+		{
+			nightTemperature = 379.0 + 3.24 * f107Average + 1.3 * (f107 - f107Average);
+			geomagneticTemperature = 28.0 * kp + 0.03 * exp(kp);
+			// the diurnal variation stays within 1 and (1 + R) times the night temperature
+			minTemperature = nightTemperature + geomagneticTemperature;
+			const double maxTemperature = 1.3 * nightTemperature + geomagneticTemperature;
+			temperatureStep = (maxTemperature - minTemperature) / (TABLE_TEMPERATURES - 1);
+			logDensity.resize(TABLE_TEMPERATURES * TABLE_ALTITUDES);
+			logDensitySlope.resize(TABLE_TEMPERATURES * TABLE_ALTITUDES);
+			for(int t = 0; t < TABLE_TEMPERATURES; ++t)
+			{
+				const double temperature = minTemperature + t * temperatureStep;
+				for(int i = 0; i < TABLE_ALTITUDES; ++i)
+				{
+					const double altitude = std::max(BASE_ALTITUDE, TABLE_MIN_ALTITUDE + i * TABLE_ALTITUDE_STEP);
+					const double delta = 0.01;
+					const double upper = log(modelDensity(altitude + delta, temperature));
+					const double lower = log(modelDensity(altitude - (altitude > BASE_ALTITUDE ? delta : 0.0), temperature));
+					double slope = (upper - lower) / (altitude > BASE_ALTITUDE ? 2.0 * delta : delta);
+					double value = log(modelDensity(altitude, temperature));
+					// the model starts at the base altitude, below it the density is extrapolated
+					const double below = TABLE_MIN_ALTITUDE + i * TABLE_ALTITUDE_STEP - BASE_ALTITUDE;
+					if(below < 0.0)
+						value += slope * below;
+					logDensity[t * TABLE_ALTITUDES + i] = value;
+					logDensitySlope[t * TABLE_ALTITUDES + i] = slope;
+				}
+			}
+			tableF107 = f107;
+			tableF107Average = f107Average;
+			tableKp = kp;
+		}
+
+		// Calculates the densities of LANES objects from their altitudes and exospheric temperatures
+		void interpolateDensity(const double* altitude, const double* temperature, double* density) const
+		{
+			for(int l = 0; l < LANES; ++l)
+			{
+				const double h = std::min(std::max(altitude[l], TABLE_MIN_ALTITUDE), TABLE_MAX_ALTITUDE);
+				const double altitudeIndex = std::min((h - TABLE_MIN_ALTITUDE) / TABLE_ALTITUDE_STEP, TABLE_ALTITUDES - 1.000001);
+				const int i = static_cast<int>(altitudeIndex);
+				const double s = altitudeIndex - i;
+				const double temperatureIndex = std::min(std::max((temperature[l] - minTemperature) / temperatureStep, 0.0), TABLE_TEMPERATURES - 1.000001);
+				const int t = static_cast<int>(temperatureIndex);
+				const double u = temperatureIndex - t;
+
+				// cubic Hermite basis over the altitude
+				const double s2 = s * s;
+				const double s3 = s2 * s;
+				const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+				const double h10 = (s3 - 2.0 * s2 + s) * TABLE_ALTITUDE_STEP;
+				const double h01 = 1.0 - h00;
+				const double h11 = (s3 - s2) * TABLE_ALTITUDE_STEP;
+				const int lowerIndex = t * TABLE_ALTITUDES + i;
+				const int upperIndex = lowerIndex + TABLE_ALTITUDES;
+				const double lower = h00 * logDensity[lowerIndex] + h10 * logDensitySlope[lowerIndex]
+					+ h01 * logDensity[lowerIndex + 1] + h11 * logDensitySlope[lowerIndex + 1];
+				const double upper = h00 * logDensity[upperIndex] + h10 * logDensitySlope[upperIndex]
+					+ h01 * logDensity[upperIndex + 1] + h11 * logDensitySlope[upperIndex + 1];
+				// below the table the density is extrapolated with the slope at its lower end
+				const double extrapolation = std::min(altitude[l] - TABLE_MIN_ALTITUDE, 0.0)
+					* ((1.0 - u) * logDensitySlope[t * TABLE_ALTITUDES] + u * logDensitySlope[(t + 1) * TABLE_ALTITUDES]);
+				const double value = std::max((1.0 - u) * lower + u * upper + extrapolation, -700.0);
+				density[l] = altitude[l] > TABLE_MAX_ALTITUDE ? 0.0 : vectorExp(value);
+			}
+		}
+
+		// Calculates the exospheric temperatures of LANES objects (Jacchia 1970). The angles
+		// of the model are replaced by their sines and cosines, so no trigonometric
+		// functions are needed.
+		void exosphericTemperature(const double* x, const double* y, const double* z, const double* radius, const OPI::Vector3* sunDirection, double* temperature) const
+		{
+			if(!diurnalVariation)
+			{
+				for(int l = 0; l < LANES; ++l)
+					temperature[l] = nightTemperature + geomagneticTemperature;
+				return;
+			}
+			const double sin43 = sin(43.0 * DEGREES);
+			const double cos43 = cos(43.0 * DEGREES);
+			for(int l = 0; l < LANES; ++l)
+			{
+				const OPI::Vector3& s = sunDirection[l];
+				const double equatorial = sqrt(x[l] * x[l] + y[l] * y[l]);
+				const double sunEquatorial = sqrt(s.x * s.x + s.y * s.y);
+				const double sinLatitude = z[l] / radius[l];
+				const double cosLatitude = equatorial / radius[l];
+				// theta = |latitude + declination| / 2 and eta = |latitude - declination| / 2
+				const double sin2Theta = 0.5 * (1.0 - (cosLatitude * sunEquatorial - sinLatitude * s.z));
+				const double cos2Eta = 0.5 * (1.0 + (cosLatitude * sunEquatorial + sinLatitude * s.z));
+				// hour angle of the sun at the object
+				const double inverse = 1.0 / std::max(equatorial * sunEquatorial, 1e-300);
+				const double cosHour = (x[l] * s.x + y[l] * s.y) * inverse;
+				const double sinHour = (y[l] * s.x - x[l] * s.y) * inverse;
+				// tau = hour angle + shift with shift = -37 deg + 6 deg sin(hour angle + 43 deg)
+				const double shift = (-37.0 + 6.0 * (sinHour * cos43 + cosHour * sin43)) * DEGREES;
+				const double shift2 = shift * shift;
+				const double cosShift = 1.0 + shift2 * (-1.0 / 2.0 + shift2 * (1.0 / 24.0 + shift2 * (-1.0 / 720.0 + shift2 * (1.0 / 40320.0 + shift2 * (-1.0 / 3628800.0)))));
+				const double sinShift = shift * (1.0 + shift2 * (-1.0 / 6.0 + shift2 * (1.0 / 120.0 + shift2 * (-1.0 / 5040.0 + shift2 * (1.0 / 362880.0 + shift2 * (-1.0 / 39916800.0))))));
+				const double cosTau = cosHour * cosShift - sinHour * sinShift;
+				// cos^2(tau / 2)
+				const double cos2HalfTau = std::max(0.5 * (1.0 + cosTau), 0.0);
+				const double sinTheta = vectorExp(1.1 * vectorLog(std::max(sin2Theta, 1e-300)));
+				const double cosEta = vectorExp(1.1 * vectorLog(std::max(cos2Eta, 1e-300)));
+				const double cosHalfTau = cos2HalfTau * sqrt(cos2HalfTau);
+				const double day = 1.0 + 0.3 * sinTheta;
+				temperature[l] = nightTemperature * day * (1.0 + 0.3 * (cosEta - sinTheta) / day * cosHalfTau) + geomagneticTemperature;
+			}
+		}
+
+	public:
+		DragSRPCPP(OPI::Host& host)
+		{
+			setDefaultPropertyValues();
+			tableF107 = -1.0;
+			tableF107Average = -1.0;
+			tableKp = -1.0;
+			referenceTime = 0.0;
+			registerProperty("f107", &f107);
+			registerProperty("f107_average", &f107Average);
+			registerProperty("kp", &kp);
+			registerProperty("diurnal_variation", &diurnalVariation);
+			registerProperty("drag", &drag);
+			registerProperty("srp", &srp);
+			registerProperty("shadow_model", &shadowModel);
+			// the module only works on the states passed to calculateAcceleration()
+			setColumnUsage(OPI::MASK_NONE, OPI::MASK_NONE);
+		}
+
+		virtual ~DragSRPCPP()
+		{
+		}
+
+		virtual OPI::ErrorCode runDisable()
+		{
+			setDefaultPropertyValues();
+			return OPI::SUCCESS;
+		}
+
+		// Builds the density table if the activity changed and prepares the sun ephemeris.
+		virtual OPI::ErrorCode runSetTimeStep(double julian_day)
+		{
+			if(f107 <= 0.0 || f107Average <= 0.0 || kp < 0.0)
+				return OPI::INVALID_PROPERTY;
+			if(shadowModel != "conical" && shadowModel != "cylindrical" && shadowModel != "none")
+				return OPI::INVALID_PROPERTY;
+			if(logDensity.empty() || tableF107 != f107 || tableF107Average != f107Average || tableKp != kp)
+				buildDensityTable();
+			// second order expansion of the sun's motion, good to 1e-6 over a day
+			const OPI::Vector3 before = sunPosition(julian_day - 1.0);
+			const OPI::Vector3 after = sunPosition(julian_day + 1.0);
+			referenceTime = julian_day;
+			sun = sunPosition(julian_day);
+			sunVelocity = (after - before) / (2.0 * 86400.0);
+			sunAcceleration = (after + before - sun * 2.0) / (86400.0 * 86400.0);
+			return OPI::SUCCESS;
+		}
+
+		virtual OPI::ErrorCode runAccelerationCalculation(const OPI::StateBatch& batch)
+		{
+			if(!batch.properties)
+				return OPI::INVALID_TYPE;
+			// setTimeStep() has not been called
+			if(logDensity.empty())
+				return OPI::INVALID_ARGUMENT;
+			const bool conical = (shadowModel == "conical");
+			const bool cylindrical = (shadowModel == "cylindrical");
+
+			double x[LANES], y[LANES], z[LANES], vx[LANES], vy[LANES], vz[LANES], radius[LANES];
+			double areaToMass[LANES], dragCoefficient[LANES], reflectivity[LANES];
+			double altitude[LANES], temperature[LANES], density[LANES], visible[LANES];
+			double ax[LANES], ay[LANES], az[LANES];
+			OPI::Vector3 sunPositions[LANES], sunDirection[LANES];
+			for(int first = 0; first < batch.count; first += LANES)
+			{
+				const int count = std::min(LANES, batch.count - first);
+				for(int l = 0; l < LANES; ++l)
+				{
+					// unused lanes repeat the last object
+					const int i = first + std::min(l, count - 1);
+					x[l] = batch.position[i].x;
+					y[l] = batch.position[i].y;
+					z[l] = batch.position[i].z;
+					vx[l] = batch.velocity[i].x;
+					vy[l] = batch.velocity[i].y;
+					vz[l] = batch.velocity[i].z;
+					areaToMass[l] = batch.properties[i].area_to_mass;
+					dragCoefficient[l] = batch.properties[i].drag_coefficient;
+					reflectivity[l] = batch.properties[i].reflectivity;
+					const double dt = (batch.julian_day[i] - referenceTime) * 86400.0;
+					sunPositions[l] = sun + sunVelocity * dt + sunAcceleration * (0.5 * dt * dt);
+				}
+				for(int l = 0; l < LANES; ++l)
+				{
+					radius[l] = sqrt(x[l] * x[l] + y[l] * y[l] + z[l] * z[l]);
+					const double sinLatitude = z[l] / radius[l];
+					altitude[l] = radius[l] - EARTH_RADIUS * (1.0 - EARTH_FLATTENING * sinLatitude * sinLatitude);
+					ax[l] = 0.0;
+					ay[l] = 0.0;
+					az[l] = 0.0;
+				}
+
+				if(drag)
+				{
+					for(int l = 0; l < LANES; ++l)
+						sunDirection[l] = sunPositions[l] / sqrt(sunPositions[l] * sunPositions[l]);
+					exosphericTemperature(x, y, z, radius, sunDirection, temperature);
+					interpolateDensity(altitude, temperature, density);
+					for(int l = 0; l < LANES; ++l)
+					{
+						// velocity relative to the rotating atmosphere
+						const double rx = vx[l] + EARTH_ROTATION * y[l];
+						const double ry = vy[l] - EARTH_ROTATION * x[l];
+						const double rz = vz[l];
+						const double speed = sqrt(rx * rx + ry * ry + rz * rz);
+						// kg/m^3 * m^2/kg * (km/s)^2 gives 1000 km/s^2
+						const double factor = -0.5e3 * density[l] * dragCoefficient[l] * areaToMass[l] * speed;
+						ax[l] += factor * rx;
+						ay[l] += factor * ry;
+						az[l] += factor * rz;
+					}
+				}
+
+				if(srp)
+				{
+					for(int l = 0; l < LANES; ++l)
+					{
+						const double dx = x[l] - sunPositions[l].x;
+						const double dy = y[l] - sunPositions[l].y;
+						const double dz = z[l] - sunPositions[l].z;
+						const double distance = sqrt(dx * dx + dy * dy + dz * dz);
+						const double rDotD = x[l] * dx + y[l] * dy + z[l] * dz;
+						visible[l] = 1.0;
+						if(cylindrical)
+						{
+							// behind the Earth and within its radius from the Earth-sun line
+							const double sunDistance = sqrt(sunPositions[l] * sunPositions[l]);
+							const double projection = (x[l] * sunPositions[l].x + y[l] * sunPositions[l].y + z[l] * sunPositions[l].z) / sunDistance;
+							const bool shadow = projection < 0.0 && radius[l] * radius[l] - projection * projection < EARTH_RADIUS * EARTH_RADIUS;
+							visible[l] = shadow ? 0.0 : 1.0;
+						}
+						else if(conical)
+						{
+							// apparent radii of the sun (a) and the Earth (b) and their separation (c)
+							const double sinA = SUN_RADIUS / distance;
+							const double sinB = std::min(EARTH_RADIUS / radius[l], 1.0);
+							const double cosA = sqrt(1.0 - sinA * sinA);
+							const double cosB = sqrt(1.0 - sinB * sinB);
+							const double cosC = rDotD / (radius[l] * distance);
+							if(cosC >= cosB * cosA + sinB * sinA)
+								visible[l] = 0.0;
+							else if(cosC > cosA * cosB - sinA * sinB)
+								visible[l] = -1.0;
+						}
+					}
+					for(int l = 0; l < LANES; ++l)
+					{
+						// objects in the penumbra
+						if(visible[l] < 0.0)
+						{
+							const double dx = x[l] - sunPositions[l].x;
+							const double dy = y[l] - sunPositions[l].y;
+							const double dz = z[l] - sunPositions[l].z;
+							const double distance = sqrt(dx * dx + dy * dy + dz * dz);
+							visible[l] = penumbraFraction(SUN_RADIUS / distance, std::min(EARTH_RADIUS / radius[l], 1.0), (x[l] * dx + y[l] * dy + z[l] * dz) / (radius[l] * distance));
+						}
+					}
+					for(int l = 0; l < LANES; ++l)
+					{
+						const double dx = x[l] - sunPositions[l].x;
+						const double dy = y[l] - sunPositions[l].y;
+						const double dz = z[l] - sunPositions[l].z;
+						const double distance2 = dx * dx + dy * dy + dz * dz;
+						const double distance = sqrt(distance2);
+						// N/m^2 * m^2/kg gives m/s^2, scaled to km/s^2
+						const double pressure = SOLAR_PRESSURE * ASTRONOMICAL_UNIT * ASTRONOMICAL_UNIT / distance2;
+						const double factor = 1e-3 * visible[l] * pressure * reflectivity[l] * areaToMass[l] / distance;
+						ax[l] += factor * dx;
+						ay[l] += factor * dy;
+						az[l] += factor * dz;
+					}
+				}
+
+				for(int l = 0; l < count; ++l)
+				{
+					OPI::Vector3& a = batch.acceleration[first + l];
+					a.x += ax[l];
+					a.y += ay[l];
+					a.z += az[l];
+				}
+			}
+			return OPI::SUCCESS;
+		}
+
+		// This plugin does not require CUDA.
+		int requiresCUDA()
+		{
+			return 0;
+		}
+
+		// This plugin does not require OpenCL.
+		int requiresOpenCL()
+		{
+			return 0;
+		}
+
+		// This plugin is written for OPI version 1.0.
+		int minimumOPIVersionRequired()
+		{
+			return 1;
+		}
+};
+
+#define OPI_IMPLEMENT_CPP_PERTURBATION_MODULE DragSRPCPP
+
+#include "OPI/opi_implement_plugin.h"
@@ -0,0 +1,427 @@
+#include "OPI/opi_cpp.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Basic information about the plugin that can be queried by the host.
+#define OPI_PLUGIN_NAME "GeopotentialCPP"
+#define OPI_PLUGIN_AUTHOR "ILR TU BS"
+#define OPI_PLUGIN_DESC "Spherical harmonics geopotential accelerations (zonal and tesseral terms)"
+
+// Set the version number for the plugin here.
+#define OPI_PLUGIN_VERSION_MAJOR 0
+#define OPI_PLUGIN_VERSION_MINOR 1
+#define OPI_PLUGIN_VERSION_PATCH 0
+
+namespace
+{
+	// number of objects evaluated together; the recursions run over arrays of this width
+	// so the compiler can vectorize them across objects
+	const int LANES = 8;
+
+	// highest degree that can be evaluated without overflowing the unnormalized recursion
+	const int MAX_DEGREE = 100;
+
+	// EGM96 fully normalized coefficients up to degree and order 6, C(n,m) and S(n,m)
+	// stored at n * (n + 1) / 2 + m
+	const int EGM96_DEGREE = 6;
+	const double EGM96_MU = 398600.4415;
+	const double EGM96_RADIUS = 6378.1363;
+	const double EGM96_C[] = {
+		1.0,
+		0.0, 0.0,
+		-0.484165371736e-03, -0.186987635955e-09, 0.243914352398e-05,
+		0.957254173792e-06, 0.202998882184e-05, 0.904627768605e-06, 0.721072657057e-06,
+		0.539873863789e-06, -0.536321616971e-06, 0.350694105785e-06, 0.990771803829e-06, -0.188560802735e-06,
+		0.685323475630e-07, -0.621012128528e-07, 0.652438297612e-06, -0.451955406071e-06, -0.295301647654e-06, 0.174971983203e-06,
+		-0.149957994714e-06, -0.760879384947e-07, 0.481732442832e-07, 0.571730990516e-07, -0.862142660109e-07, -0.267133325490e-06, 0.967616121092e-08
+	};
+	const double EGM96_S[] = {
+		0.0,
+		0.0, 0.0,
+		0.0, 0.119528012031e-08, -0.140016683654e-05,
+		0.0, 0.248513158716e-06, -0.619025944205e-06, 0.141435626958e-05,
+		0.0, -0.473440265853e-06, 0.662671572540e-06, -0.200928369177e-06, 0.308853169333e-06,
+		0.0, -0.944226127525e-07, -0.323349612668e-06, -0.214847190624e-06, 0.496658876769e-07, -0.669384278219e-06,
+		0.0, 0.262890545501e-07, -0.373728201347e-06, 0.902694517163e-08, -0.471408154267e-06, -0.536488432483e-06, -0.237192006935e-06
+	};
+
+	int triangle(int n, int m)
+	{
+		return n * (n + 1) / 2 + m;
+	}
+
+	// Fully normalized coefficients of a gravity field model
+	struct GravityModel
+	{
+		double mu;
+		double radius;
+		int degree;
+		std::vector<double> c;
+		std::vector<double> s;
+	};
+
+	void loadDefaultModel(GravityModel& model)
+	{
+		model.mu = EGM96_MU;
+		model.radius = EGM96_RADIUS;
+		model.degree = EGM96_DEGREE;
+		model.c.assign(EGM96_C, EGM96_C + triangle(EGM96_DEGREE + 1, 0));
+		model.s.assign(EGM96_S, EGM96_S + triangle(EGM96_DEGREE + 1, 0));
+	}
+
+	// Reads an ICGEM (.gfc) file or a plain "n m C S" table with fully normalized
+	// coefficients, like the EGM96 and EGM2008 coefficient files. Coefficients beyond
+	// maxDegree are skipped.
+	bool loadModel(const std::string& filename, int maxDegree, GravityModel& model)
+	{
+		std::ifstream in(filename.c_str());
+		if(!in.is_open())
+			return false;
+		model.mu = EGM96_MU;
+		model.radius = EGM96_RADIUS;
+		model.degree = 0;
+		model.c.assign(triangle(maxDegree + 1, 0), 0.0);
+		model.s.assign(triangle(maxDegree + 1, 0), 0.0);
+		model.c[0] = 1.0;
+		std::string line;
+		while(std::getline(in, line))
+		{
+			// Fortran style exponents
+			std::replace(line.begin(), line.end(), 'D', 'E');
+			std::replace(line.begin(), line.end(), 'd', 'e');
+			std::istringstream tokens(line);
+			std::string key;
+			if(!(tokens >> key))
+				continue;
+			double value;
+			if(key == "earth_gravity_constant" && tokens >> value)
+				model.mu = value * 1e-9;
+			else if(key == "radius" && tokens >> value)
+				model.radius = value * 1e-3;
+			else
+			{
+				std::istringstream entry(key == "gfc" ? line.substr(line.find("gfc") + 3) : line);
+				int n, m;
+				double c, s;
+				if(entry >> n >> m >> c >> s && n >= 0 && m >= 0 && m <= n && n <= maxDegree)
+				{
+					model.c[triangle(n, m)] = c;
+					model.s[triangle(n, m)] = s;
+					model.degree = std::max(model.degree, n);
+				}
+			}
+		}
+		return model.degree > 0;
+	}
+
+	double gmst(double julian_day)
+	{
+		const double degrees = 280.46061837 + 360.98564736629 * (julian_day - 2451545.0);
+		return fmod(degrees, 360.0) * 0.01745329251994329577;
+	}
+}
+
+// Adds the accelerations of the non-spherical part of the Earth's gravity field, from
+// degree 2 up to the configured degree and order, for the numerical integrators of a
+// CustomPropagator. The central term is already calculated by the CustomPropagator.
+//
+// The field is evaluated with the recursion of Cunningham (see Montenbruck and Gill,
+// Satellite Orbits, 3.2) in the Earth-fixed frame, which is approximated by a rotation
+// of the inertial frame by the Greenwich mean sidereal time. The recursions run over
+// LANES objects at once and only keep three orders in memory, so the data of a call
+// stays in the first level cache even for high degrees. Calls for different
+// batches run concurrently on the threads of the integrator.
+//
+// Properties:
+//   degree            maximum degree (2 to 100, default 6)
+//   order             maximum order, 0 for zonal terms only (default 6)
+//   coefficient_file  ICGEM or EGM coefficient file; the EGM96 field up to degree and
+//                     order 6 is used if empty
+class GeopotentialCPP: public OPI::PerturbationModule
+{
+	private:
+		int degree;
+		int order;
+		std::string coefficientFile;
+
+		// coefficient file and field size the tables below were prepared for
+		std::string preparedFile;
+		int preparedDegree;
+		int preparedOrder;
+
+		GravityModel model;
+		// unnormalized coefficients at triangle(n, m)
+		std::vector<double> c;
+		std::vector<double> s;
+		// recursion factors (2n - 1) / (n - m) and (n + m - 1) / (n - m) at m * (degree + 2) + n
+		std::vector<double> alpha;
+		std::vector<double> beta;
+
+		void setDefaultPropertyValues()
+		{
+			degree = 6;
+			order = 6;
+			coefficientFile = "";
+		}
+
+		// Loads the model and precomputes the tables if the properties have changed
+		OPI::ErrorCode prepare()
+		{
+			if(degree < 0 || degree > MAX_DEGREE || order < 0)
+				return OPI::INVALID_PROPERTY;
+			const int maxOrder = std::min(order, degree);
+			if(c.size() > 0 && preparedFile == coefficientFile && preparedDegree == degree && preparedOrder == maxOrder)
+				return OPI::SUCCESS;
+			if(coefficientFile.empty())
+				loadDefaultModel(model);
+			else if(!loadModel(coefficientFile, MAX_DEGREE, model))
+				return OPI::FILE_NOT_FOUND;
+			if(degree > model.degree)
+				return OPI::INVALID_PROPERTY;
+
+			c.assign(triangle(degree + 1, 0), 0.0);
+			s.assign(triangle(degree + 1, 0), 0.0);
+			for(int n = 2; n <= degree; ++n)
+			{
+				// normalization factor sqrt((2 - delta_0m) (2n + 1) (n - m)! / (n + m)!)
+				double factor = sqrt(2.0 * n + 1.0);
+				for(int m = 0; m <= std::min(n, maxOrder); ++m)
+				{
+					if(m == 1)
+						factor *= sqrt(2.0 / (n * (n + 1.0)));
+					else if(m > 1)
+						factor /= sqrt((n + m) * (n - m + 1.0));
+					c[triangle(n, m)] = factor * model.c[triangle(n, m)];
+					s[triangle(n, m)] = factor * model.s[triangle(n, m)];
+				}
+			}
+			const int rows = degree + 2;
+			alpha.assign((maxOrder + 2) * rows, 0.0);
+			beta.assign((maxOrder + 2) * rows, 0.0);
+			for(int m = 0; m <= maxOrder + 1; ++m)
+			{
+				for(int n = m + 1; n < rows; ++n)
+				{
+					alpha[m * rows + n] = (2.0 * n - 1.0) / (n - m);
+					beta[m * rows + n] = (n + m - 1.0) / (n - m);
+				}
+			}
+			preparedFile = coefficientFile;
+			preparedDegree = degree;
+			preparedOrder = maxOrder;
+			return OPI::SUCCESS;
+		}
+
+		// Calculates the accelerations of LANES Earth-fixed positions. V and W of the orders
+		// m - 1, m and m + 1 are kept in a local array, with the rows n of V and W following
+		// each other, so the compiler can vectorize all loops over the lanes.
+		void evaluate(const double* x, const double* y, const double* z, double* accelerationX, double* accelerationY, double* accelerationZ) const
+		{
+			const int rows = preparedDegree + 2;
+			const double radius = model.radius;
+			double column[3][MAX_DEGREE + 2][2][LANES];
+			double x0[LANES], y0[LANES], z0[LANES], rho[LANES];
+			double ax[LANES], ay[LANES], az[LANES];
+			for(int l = 0; l < LANES; ++l)
+			{
+				double r2 = x[l] * x[l] + y[l] * y[l] + z[l] * z[l];
+				x0[l] = radius * x[l] / r2;
+				y0[l] = radius * y[l] / r2;
+				z0[l] = radius * z[l] / r2;
+				rho[l] = radius * radius / r2;
+				column[0][0][0][l] = radius / sqrt(r2);
+				column[0][0][1][l] = 0.0;
+				ax[l] = 0.0;
+				ay[l] = 0.0;
+				az[l] = 0.0;
+			}
+
+			// calculates the rows m to degree + 1 of order m from the diagonal element of order m - 1
+			auto recurse = [&](int m) {
+				double (*vw)[2][LANES] = column[m % 3];
+				if(m > 0)
+				{
+					const double (*previous)[LANES] = column[(m + 2) % 3][m - 1];
+					const double f = 2.0 * m - 1.0;
+					for(int l = 0; l < LANES; ++l)
+					{
+						vw[m][0][l] = f * (x0[l] * previous[0][l] - y0[l] * previous[1][l]);
+						vw[m][1][l] = f * (x0[l] * previous[1][l] + y0[l] * previous[0][l]);
+					}
+				}
+				if(m + 1 < rows)
+				{
+					const double f = 2.0 * m + 1.0;
+					for(int l = 0; l < LANES; ++l)
+					{
+						vw[m + 1][0][l] = f * z0[l] * vw[m][0][l];
+						vw[m + 1][1][l] = f * z0[l] * vw[m][1][l];
+					}
+				}
+				for(int n = m + 2; n < rows; ++n)
+				{
+					const double a = alpha[m * rows + n];
+					const double b = beta[m * rows + n];
+					for(int l = 0; l < LANES; ++l)
+					{
+						vw[n][0][l] = a * z0[l] * vw[n - 1][0][l] - b * rho[l] * vw[n - 2][0][l];
+						vw[n][1][l] = a * z0[l] * vw[n - 1][1][l] - b * rho[l] * vw[n - 2][1][l];
+					}
+				}
+			};
+			recurse(0);
+			recurse(1);
+
+			for(int m = 0; m <= preparedOrder; ++m)
+			{
+				const double (*vw)[2][LANES] = column[m % 3];
+				const double (*plus)[2][LANES] = column[(m + 1) % 3];
+				const double (*minus)[2][LANES] = column[(m + 2) % 3];
+				for(int n = std::max(2, m); n <= preparedDegree; ++n)
+				{
+					const double cnm = c[triangle(n, m)];
+					const double snm = s[triangle(n, m)];
+					const double fz = n - m + 1.0;
+					if(m == 0)
+					{
+						for(int l = 0; l < LANES; ++l)
+						{
+							ax[l] -= cnm * plus[n + 1][0][l];
+							ay[l] -= cnm * plus[n + 1][1][l];
+							az[l] -= fz * cnm * vw[n + 1][0][l];
+						}
+					}
+					else
+					{
+						const double fxy = (n - m + 2.0) * (n - m + 1.0);
+						for(int l = 0; l < LANES; ++l)
+						{
+							ax[l] += 0.5 * ((-cnm * plus[n + 1][0][l] - snm * plus[n + 1][1][l]) + fxy * (cnm * minus[n + 1][0][l] + snm * minus[n + 1][1][l]));
+							ay[l] += 0.5 * ((-cnm * plus[n + 1][1][l] + snm * plus[n + 1][0][l]) + fxy * (-cnm * minus[n + 1][1][l] + snm * minus[n + 1][0][l]));
+							az[l] += fz * (-cnm * vw[n + 1][0][l] - snm * vw[n + 1][1][l]);
+						}
+					}
+				}
+				// the next order needs the order m + 2
+				if(m + 2 <= preparedOrder + 1)
+					recurse(m + 2);
+			}
+			const double scale = model.mu / (radius * radius);
+			for(int l = 0; l < LANES; ++l)
+			{
+				accelerationX[l] = scale * ax[l];
+				accelerationY[l] = scale * ay[l];
+				accelerationZ[l] = scale * az[l];
+			}
+		}
+
+	public:
+		GeopotentialCPP(OPI::Host& host)
+		{
+			setDefaultPropertyValues();
+			preparedDegree = -1;
+			preparedOrder = -1;
+			registerProperty("degree", &degree);
+			registerProperty("order", &order);
+			registerProperty("coefficient_file", &coefficientFile);
+			// the module only works on the states passed to calculateAcceleration()
+			setColumnUsage(OPI::MASK_NONE, OPI::MASK_NONE);
+		}
+
+		virtual ~GeopotentialCPP()
+		{
+		}
+
+		virtual OPI::ErrorCode runEnable()
+		{
+			return prepare();
+		}
+
+		virtual OPI::ErrorCode runDisable()
+		{
+			setDefaultPropertyValues();
+			return OPI::SUCCESS;
+		}
+
+		// Applies changed properties before the next propagation.
+		virtual OPI::ErrorCode runSetTimeStep(double julian_day)
+		{
+			return prepare();
+		}
+
+		virtual OPI::ErrorCode runAccelerationCalculation(const OPI::StateBatch& batch)
+		{
+			if(preparedDegree < 2)
+				return OPI::SUCCESS;
+			const bool tesseral = preparedOrder > 0;
+			double x[LANES], y[LANES], z[LANES], ax[LANES], ay[LANES], az[LANES];
+			double cosTheta[LANES], sinTheta[LANES];
+			for(int first = 0; first < batch.count; first += LANES)
+			{
+				const int count = std::min(LANES, batch.count - first);
+				for(int l = 0; l < LANES; ++l)
+				{
+					// unused lanes repeat the last object
+					const int i = first + std::min(l, count - 1);
+					const OPI::Vector3& r = batch.position[i];
+					if(tesseral)
+					{
+						double theta = gmst(batch.julian_day[i]);
+						cosTheta[l] = cos(theta);
+						sinTheta[l] = sin(theta);
+						x[l] = cosTheta[l] * r.x + sinTheta[l] * r.y;
+						y[l] = cosTheta[l] * r.y - sinTheta[l] * r.x;
+					}
+					else
+					{
+						x[l] = r.x;
+						y[l] = r.y;
+					}
+					z[l] = r.z;
+				}
+				evaluate(x, y, z, ax, ay, az);
+				for(int l = 0; l < count; ++l)
+				{
+					OPI::Vector3& a = batch.acceleration[first + l];
+					if(tesseral)
+					{
+						a.x += cosTheta[l] * ax[l] - sinTheta[l] * ay[l];
+						a.y += sinTheta[l] * ax[l] + cosTheta[l] * ay[l];
+					}
+					else
+					{
+						a.x += ax[l];
+						a.y += ay[l];
+					}
+					a.z += az[l];
+				}
+			}
+			return OPI::SUCCESS;
+		}
+
+		// This plugin does not require CUDA.
+		int requiresCUDA()
+		{
+			return 0;
+		}
+
+		// This plugin does not require OpenCL.
+		int requiresOpenCL()
+		{
+			return 0;
+		}
+
+		// This plugin is written for OPI version 1.0.
+		int minimumOPIVersionRequired()
+		{
+			return 1;
+		}
+};
+
+#define OPI_IMPLEMENT_CPP_PERTURBATION_MODULE GeopotentialCPP
+
+#include "OPI/opi_implement_plugin.h"
@@ -39,16 +39,23 @@ class BasicCPP: public OPI::Propagator
             if (baseDay == 0) baseDay = julian_day;
             float seconds = (julian_day-baseDay)*86400.0 + dt;
 
-            // Get the orbit and position vectors from the given Population.
+            // This example calculates the mean anomaly and the position of every object. If the
+            // host requested neither (see Propagator::propagate), there is nothing to do.
+            const bool orbits = (getOutputMask() & OPI::MASK_ORBIT) != 0;
+            const bool positions = (getOutputMask() & OPI::MASK_CARTESIAN) != 0;
+            if (!orbits && !positions) return OPI::SUCCESS;
+
+            // Get the orbit and position vectors from the given Population. Positions are
+            // skipped by the propagation function if they were not requested.
             OPI::Orbit* orbit = data.getOrbit(OPI::DEVICE_HOST);
-            OPI::Vector3* position = data.getPosition(OPI::DEVICE_HOST);
+            OPI::Vector3* position = positions ? data.getPosition(OPI::DEVICE_HOST) : 0;
 
             // Call the propagation function.
             cpp_propagate(orbit, position, seconds, data.getSize());
 
             // The propagation function writes to the Population's position and orbit vectors, so
             // these two have to be marked for updated values on the host device.
-            data.update(OPI::DATA_CARTESIAN, OPI::DEVICE_HOST);
+            if (positions) data.update(OPI::DATA_CARTESIAN, OPI::DEVICE_HOST);
             data.update(OPI::DATA_ORBIT, OPI::DEVICE_HOST);
 
             return OPI::SUCCESS;
@@ -186,6 +193,10 @@ class BasicCPP: public OPI::Propagator
                 // Note: This disregards the initial mean anomaly given in the Population -
                 // avoid this in production plugins.
                 float mean_anomaly = fmodf(sqrtf((RMUE * t * t) / powf(sma,3.0f)), 2.0f*PI);
+                // Write back the new mean anomaly into the orbit.
+                orbit[i].mean_anomaly = (double)mean_anomaly;
+                if (!position) continue;
+
                 float excentric_anomaly = mean2eccentric(mean_anomaly, ecc);
 
                 // Convert eccentric anomaly to true anomaly.
@@ -209,9 +220,6 @@ class BasicCPP: public OPI::Propagator
                 position[i].x = (double)(w.x*r);
                 position[i].y = (double)(w.y*r);
                 position[i].z = (double)(w.z*r);
-
-                // Finally, also write back the new mean anomaly into the orbit.
-                orbit[i].mean_anomaly = (double)mean_anomaly;
             }
         }
 
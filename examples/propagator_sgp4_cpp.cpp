@@ -0,0 +1,1330 @@
+#include "OPI/opi_cpp.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Basic information about the plugin that can be queried by the host.
+#define OPI_PLUGIN_NAME "SGP4CPP"
+#define OPI_PLUGIN_AUTHOR "ILR TU BS"
+#define OPI_PLUGIN_DESC "SGP4/SDP4 propagator for two-line element sets with batched near-earth evaluation"
+
+// Set the version number for the plugin here.
+#define OPI_PLUGIN_VERSION_MAJOR 0
+#define OPI_PLUGIN_VERSION_MINOR 1
+#define OPI_PLUGIN_VERSION_PATCH 0
+
+// This plugin implements the SGP4/SDP4 model as revised by Vallado et al. (AIAA 2006-6753)
+// in the improved operation mode with WGS-72 constants. The Orbit column holds the mean
+// elements of the element sets as read by Population::importTLE, original_epoch their
+// epoch and area_to_mass * drag_coefficient the B* term. The elements are not modified;
+// propagation always starts from them and writes TEME position and velocity.
+namespace
+{
+	// number of near-earth objects evaluated together in the lane loops
+	const int LANES = 8;
+
+	const double PI = 3.14159265358979323846;
+	const double TWO_PI = 2.0 * PI;
+	const double X2O3 = 2.0 / 3.0;
+
+	// WGS-72 constants of the SGP4 reference implementation
+	const double MU = 398600.8;
+	const double EARTH_RADIUS = 6378.135;
+	const double XKE = 60.0 / sqrt(EARTH_RADIUS * EARTH_RADIUS * EARTH_RADIUS / MU);
+	const double J2 = 0.001082616;
+	const double J3 = -0.00000253881;
+	const double J4 = -0.00000165597;
+	const double J3OJ2 = J3 / J2;
+	const double VELOCITY_UNIT = EARTH_RADIUS * XKE / 60.0;
+
+	// B* per area to mass ratio and drag coefficient, see Population::importTLE
+	const double BSTAR_FACTOR = 0.15696615 / 2.0;
+	// start of the SGP4 epoch count (1949 December 31 0h) as Julian date
+	const double SGP4_EPOCH = 2433281.5;
+
+	const double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+
+	// sine and cosine with plain arithmetic, so loops over them can be vectorized; the
+	// argument is reduced by multiples of pi/2 in three parts (accurate for |x| < 1e6)
+	inline void vectorSinCos(double x, double& s, double& c)
+	{
+		const double magic = 6755399441055744.0;
+		const double scaled = x * 0.63661977236758134308 + magic;
+		int64_t quadrant;
+		memcpy(&quadrant, &scaled, sizeof(quadrant));
+		const double k = scaled - magic;
+		const double r = ((x - k * 1.57079632673412561417e+00) - k * 6.07710050630396597660e-11) - k * 2.02226624871116645580e-21;
+		const double r2 = r * r;
+		double ps = 1.58969099521155010221e-10;
+		ps = ps * r2 - 2.50507602534068634195e-08;
+		ps = ps * r2 + 2.75573137070700676789e-06;
+		ps = ps * r2 - 1.98412698298579493134e-04;
+		ps = ps * r2 + 8.33333333332248946124e-03;
+		ps = ps * r2 - 1.66666666666666324348e-01;
+		const double sinR = r + r * r2 * ps;
+		double pc = -1.13596475577881948265e-11;
+		pc = pc * r2 + 2.08757232129817482790e-09;
+		pc = pc * r2 - 2.75573143513906633035e-07;
+		pc = pc * r2 + 2.48015872894767294178e-05;
+		pc = pc * r2 - 1.38888888888741095749e-03;
+		pc = pc * r2 + 4.16666666666666019037e-02;
+		const double cosR = 1.0 - 0.5 * r2 + r2 * r2 * pc;
+		// odd quadrants swap sine and cosine, the sign bits follow the quadrant
+		int64_t sinBits, cosBits;
+		memcpy(&sinBits, &sinR, sizeof(sinBits));
+		memcpy(&cosBits, &cosR, sizeof(cosBits));
+		const int64_t swap = -(quadrant & 1);
+		int64_t sBits = (sinBits & ~swap) | (cosBits & swap);
+		int64_t cBits = (cosBits & ~swap) | (sinBits & swap);
+		sBits ^= (quadrant & 2) << 62;
+		cBits ^= ((quadrant + 1) & 2) << 62;
+		memcpy(&s, &sBits, sizeof(s));
+		memcpy(&c, &cBits, sizeof(c));
+	}
+
+	// reduces an angle to [-pi, pi] with plain arithmetic
+	inline double reduceAngle(double x)
+	{
+		const double magic = 6755399441055744.0;
+		const double revolutions = (x * (1.0 / TWO_PI) + magic) - magic;
+		return x - revolutions * TWO_PI;
+	}
+
+	// the inputs an object was initialized from, used to detect changed elements
+	struct MeanElements
+	{
+		double epoch;
+		double semiMajorAxis;
+		double eccentricity;
+		double inclination;
+		double raan;
+		double argOfPerigee;
+		double meanAnomaly;
+		double bstar;
+
+		bool operator==(const MeanElements& other) const
+		{
+			return epoch == other.epoch && semiMajorAxis == other.semiMajorAxis && eccentricity == other.eccentricity
+				&& inclination == other.inclination && raan == other.raan && argOfPerigee == other.argOfPerigee
+				&& meanAnomaly == other.meanAnomaly && bstar == other.bstar;
+		}
+	};
+
+	// lunar-solar and resonance terms of deep-space objects (SDP4)
+	struct DeepSpace
+	{
+		double e3, ee2, se2, se3, sgh2, sgh3, sgh4, sh2, sh3, si2, si3, sl2, sl3, sl4;
+		double xgh2, xgh3, xgh4, xh2, xh3, xi2, xi3, xl2, xl3, xl4, zmol, zmos;
+		double dedt, didt, dmdt, domdt, dnodt;
+		// 0 without resonance, 1 for synchronous and 2 for 12 hour orbits
+		int irez;
+		double d2201, d2211, d3210, d3222, d4410, d4422, d5220, d5232, d5421, d5433;
+		double del1, del2, del3, xfact, xlamo, gsto;
+		// state of the resonance integrator, restarted from the epoch when necessary
+		double atime, xli, xni;
+	};
+
+	// per-object constants of SGP4, computed once from the mean elements
+	struct Constants
+	{
+		MeanElements elements;
+		bool valid;
+		bool deep;
+		// index of the DeepSpace record, -1 if none has been assigned
+		int deepIndex;
+		// Brouwer mean motion in rad/min and the remaining elements
+		double no, ecco, inclo, nodeo, argpo, mo, bstar;
+		// (XKE / no)^(2/3)
+		double ao;
+		double sinio, cosio, con41, x1mth2, x7thm1, xlcof, aycof;
+		double mdot, argpdot, nodedot, nodecf, cc1, cc4, cc5, t2cof, omgcof, xmcof, eta, delmo, sinmao;
+		double d2, d3, d4, t3cof, t4cof, t5cof;
+	};
+
+	// lunar-solar terms shared by the deep-space initialization steps
+	struct DeepSpaceSetup
+	{
+		double sinim, cosim, emsq;
+		double s1, s2, s3, s4, s5, ss1, ss2, ss3, ss4, ss5;
+		double z1, z3, z11, z13, z21, z23, z31, z33;
+		double sz1, sz3, sz11, sz13, sz21, sz23, sz31, sz33;
+	};
+
+	// Greenwich mean sidereal time in radians (IAU-82)
+	double greenwichSiderealTime(double julianDay)
+	{
+		double tut1 = (julianDay - 2451545.0) / 36525.0;
+		double seconds = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1 + (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+		double angle = fmod(seconds * PI / 180.0 / 240.0, TWO_PI);
+		return angle < 0.0 ? angle + TWO_PI : angle;
+	}
+
+	// lunar-solar terms of the deep-space model at the epoch (dscom)
+	void initializeLunarSolar(double epoch, const Constants& c, DeepSpace& d, DeepSpaceSetup& s)
+	{
+		const double zes = 0.01675, zel = 0.05490;
+		const double c1ss = 2.9864797e-6, c1l = 4.7968065e-7;
+		const double zsinis = 0.39785416, zcosis = 0.91744867;
+		const double zcosgs = 0.1945905, zsings = -0.98088458;
+
+		const double nm = c.no;
+		const double em = c.ecco;
+		const double snodm = sin(c.nodeo), cnodm = cos(c.nodeo);
+		const double sinomm = sin(c.argpo), cosomm = cos(c.argpo);
+		s.sinim = sin(c.inclo);
+		s.cosim = cos(c.inclo);
+		s.emsq = em * em;
+		const double betasq = 1.0 - s.emsq;
+		const double rtemsq = sqrt(betasq);
+
+		const double day = epoch + 18261.5;
+		const double xnodce = fmod(4.5236020 - 9.2422029e-4 * day, TWO_PI);
+		const double stem = sin(xnodce), ctem = cos(xnodce);
+		const double zcosil = 0.91375164 - 0.03568096 * ctem;
+		const double zsinil = sqrt(1.0 - zcosil * zcosil);
+		const double zsinhl = 0.089683511 * stem / zsinil;
+		const double zcoshl = sqrt(1.0 - zsinhl * zsinhl);
+		const double gam = 5.8351514 + 0.0019443680 * day;
+		double zx = 0.39785416 * stem / zsinil;
+		const double zy = zcoshl * ctem + 0.91744867 * zsinhl * stem;
+		zx = atan2(zx, zy);
+		zx = gam + zx - xnodce;
+		const double zcosgl = cos(zx), zsingl = sin(zx);
+
+		// the first pass computes the solar terms, the second the lunar terms
+		double zcosg = zcosgs, zsing = zsings, zcosi = zcosis, zsini = zsinis;
+		double zcosh = cnodm, zsinh = snodm, cc = c1ss;
+		const double xnoi = 1.0 / nm;
+		double s6 = 0.0, s7 = 0.0, ss6 = 0.0, ss7 = 0.0;
+		double z2 = 0.0, z12 = 0.0, z22 = 0.0, z32 = 0.0;
+		double sz2 = 0.0, sz12 = 0.0, sz22 = 0.0, sz32 = 0.0;
+		for(int pass = 1; pass <= 2; ++pass)
+		{
+			const double a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+			const double a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+			const double a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+			const double a8 = zsing * zsini;
+			const double a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+			const double a10 = zcosg * zsini;
+			const double a2 = s.cosim * a7 + s.sinim * a8;
+			const double a4 = s.cosim * a9 + s.sinim * a10;
+			const double a5 = -s.sinim * a7 + s.cosim * a8;
+			const double a6 = -s.sinim * a9 + s.cosim * a10;
+
+			const double x1 = a1 * cosomm + a2 * sinomm;
+			const double x2 = a3 * cosomm + a4 * sinomm;
+			const double x3 = -a1 * sinomm + a2 * cosomm;
+			const double x4 = -a3 * sinomm + a4 * cosomm;
+			const double x5 = a5 * sinomm;
+			const double x6 = a6 * sinomm;
+			const double x7 = a5 * cosomm;
+			const double x8 = a6 * cosomm;
+
+			s.z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+			z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+			s.z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+			s.z1 = 3.0 * (a1 * a1 + a2 * a2) + s.z31 * s.emsq;
+			z2 = 6.0 * (a1 * a3 + a2 * a4) + z32 * s.emsq;
+			s.z3 = 3.0 * (a3 * a3 + a4 * a4) + s.z33 * s.emsq;
+			s.z11 = -6.0 * a1 * a5 + s.emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+			z12 = -6.0 * (a1 * a6 + a3 * a5) + s.emsq * (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+			s.z13 = -6.0 * a3 * a6 + s.emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+			s.z21 = 6.0 * a2 * a5 + s.emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+			z22 = 6.0 * (a4 * a5 + a2 * a6) + s.emsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+			s.z23 = 6.0 * a4 * a6 + s.emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+			s.z1 = s.z1 + s.z1 + betasq * s.z31;
+			z2 = z2 + z2 + betasq * z32;
+			s.z3 = s.z3 + s.z3 + betasq * s.z33;
+			s.s3 = cc * xnoi;
+			s.s2 = -0.5 * s.s3 / rtemsq;
+			s.s4 = s.s3 * rtemsq;
+			s.s1 = -15.0 * em * s.s4;
+			s.s5 = x1 * x3 + x2 * x4;
+			s6 = x2 * x3 + x1 * x4;
+			s7 = x2 * x4 - x1 * x3;
+
+			if(pass == 1)
+			{
+				s.ss1 = s.s1; s.ss2 = s.s2; s.ss3 = s.s3; s.ss4 = s.s4; s.ss5 = s.s5; ss6 = s6; ss7 = s7;
+				s.sz1 = s.z1; sz2 = z2; s.sz3 = s.z3;
+				s.sz11 = s.z11; sz12 = z12; s.sz13 = s.z13;
+				s.sz21 = s.z21; sz22 = z22; s.sz23 = s.z23;
+				s.sz31 = s.z31; sz32 = z32; s.sz33 = s.z33;
+				zcosg = zcosgl;
+				zsing = zsingl;
+				zcosi = zcosil;
+				zsini = zsinil;
+				zcosh = zcoshl * cnodm + zsinhl * snodm;
+				zsinh = snodm * zcoshl - cnodm * zsinhl;
+				cc = c1l;
+			}
+		}
+
+		d.zmol = fmod(4.7199672 + 0.22997150 * day - gam, TWO_PI);
+		d.zmos = fmod(6.2565837 + 0.017201977 * day, TWO_PI);
+
+		// solar terms
+		d.se2 = 2.0 * s.ss1 * ss6;
+		d.se3 = 2.0 * s.ss1 * ss7;
+		d.si2 = 2.0 * s.ss2 * sz12;
+		d.si3 = 2.0 * s.ss2 * (s.sz13 - s.sz11);
+		d.sl2 = -2.0 * s.ss3 * sz2;
+		d.sl3 = -2.0 * s.ss3 * (s.sz3 - s.sz1);
+		d.sl4 = -2.0 * s.ss3 * (-21.0 - 9.0 * s.emsq) * zes;
+		d.sgh2 = 2.0 * s.ss4 * sz32;
+		d.sgh3 = 2.0 * s.ss4 * (s.sz33 - s.sz31);
+		d.sgh4 = -18.0 * s.ss4 * zes;
+		d.sh2 = -2.0 * s.ss2 * sz22;
+		d.sh3 = -2.0 * s.ss2 * (s.sz23 - s.sz21);
+
+		// lunar terms
+		d.ee2 = 2.0 * s.s1 * s6;
+		d.e3 = 2.0 * s.s1 * s7;
+		d.xi2 = 2.0 * s.s2 * z12;
+		d.xi3 = 2.0 * s.s2 * (s.z13 - s.z11);
+		d.xl2 = -2.0 * s.s3 * z2;
+		d.xl3 = -2.0 * s.s3 * (s.z3 - s.z1);
+		d.xl4 = -2.0 * s.s3 * (-21.0 - 9.0 * s.emsq) * zel;
+		d.xgh2 = 2.0 * s.s4 * z32;
+		d.xgh3 = 2.0 * s.s4 * (s.z33 - s.z31);
+		d.xgh4 = -18.0 * s.s4 * zel;
+		d.xh2 = -2.0 * s.s2 * z22;
+		d.xh3 = -2.0 * s.s2 * (s.z23 - s.z21);
+	}
+
+	// secular lunar-solar rates and resonance terms at the epoch (dsinit)
+	void initializeResonance(const Constants& c, const DeepSpaceSetup& s, DeepSpace& d)
+	{
+		const double q22 = 1.7891679e-6, q31 = 2.1460748e-6, q33 = 2.2123015e-7;
+		const double root22 = 1.7891679e-6, root44 = 7.3636953e-9, root54 = 2.1765803e-9;
+		const double root32 = 3.7393792e-7, root52 = 1.1428639e-7;
+		const double rptim = 4.37526908801129966e-3;
+		const double znl = 1.5835218e-4, zns = 1.19459e-5;
+
+		const double nm = c.no;
+		const double em = c.ecco;
+		const double inclm = c.inclo;
+
+		d.irez = 0;
+		if(nm < 0.0052359877 && nm > 0.0034906585)
+			d.irez = 1;
+		if(nm >= 8.26e-3 && nm <= 9.24e-3 && em >= 0.5)
+			d.irez = 2;
+
+		// solar terms
+		const double ses = s.ss1 * zns * s.ss5;
+		const double sis = s.ss2 * zns * (s.sz11 + s.sz13);
+		const double sls = -zns * s.ss3 * (s.sz1 + s.sz3 - 14.0 - 6.0 * s.emsq);
+		const double sghs = s.ss4 * zns * (s.sz31 + s.sz33 - 6.0);
+		double shs = -zns * s.ss2 * (s.sz21 + s.sz23);
+		if(inclm < 5.2359877e-2 || inclm > PI - 5.2359877e-2)
+			shs = 0.0;
+		if(s.sinim != 0.0)
+			shs = shs / s.sinim;
+		const double sgs = sghs - s.cosim * shs;
+
+		// lunar terms
+		d.dedt = ses + s.s1 * znl * s.s5;
+		d.didt = sis + s.s2 * znl * (s.z11 + s.z13);
+		d.dmdt = sls - znl * s.s3 * (s.z1 + s.z3 - 14.0 - 6.0 * s.emsq);
+		const double sghl = s.s4 * znl * (s.z31 + s.z33 - 6.0);
+		double shll = -znl * s.s2 * (s.z21 + s.z23);
+		if(inclm < 5.2359877e-2 || inclm > PI - 5.2359877e-2)
+			shll = 0.0;
+		d.domdt = sgs + sghl;
+		d.dnodt = shs;
+		if(s.sinim != 0.0)
+		{
+			d.domdt = d.domdt - s.cosim / s.sinim * shll;
+			d.dnodt = d.dnodt + shll / s.sinim;
+		}
+
+		d.gsto = greenwichSiderealTime(c.elements.epoch);
+		const double theta = fmod(d.gsto, TWO_PI);
+		d.d2201 = d.d2211 = d.d3210 = d.d3222 = d.d4410 = d.d4422 = 0.0;
+		d.d5220 = d.d5232 = d.d5421 = d.d5433 = 0.0;
+		d.del1 = d.del2 = d.del3 = d.xfact = d.xlamo = 0.0;
+		if(d.irez != 0)
+		{
+			const double aonv = pow(nm / XKE, X2O3);
+
+			// geopotential resonance for 12 hour orbits
+			if(d.irez == 2)
+			{
+				const double cosisq = s.cosim * s.cosim;
+				const double e = c.ecco;
+				const double esq = e * e;
+				const double eoc = e * esq;
+				const double g201 = -0.306 - (e - 0.64) * 0.440;
+				double g211, g310, g322, g410, g422, g520, g521, g532, g533;
+				if(e <= 0.65)
+				{
+					g211 = 3.616 - 13.2470 * e + 16.2900 * esq;
+					g310 = -19.302 + 117.3900 * e - 228.4190 * esq + 156.5910 * eoc;
+					g322 = -18.9068 + 109.7927 * e - 214.6334 * esq + 146.5816 * eoc;
+					g410 = -41.122 + 242.6940 * e - 471.0940 * esq + 313.9530 * eoc;
+					g422 = -146.407 + 841.8800 * e - 1629.014 * esq + 1083.4350 * eoc;
+					g520 = -532.114 + 3017.977 * e - 5740.032 * esq + 3708.2760 * eoc;
+				}
+				else {
+					g211 = -72.099 + 331.819 * e - 508.738 * esq + 266.724 * eoc;
+					g310 = -346.844 + 1582.851 * e - 2415.925 * esq + 1246.113 * eoc;
+					g322 = -342.585 + 1554.908 * e - 2366.899 * esq + 1215.972 * eoc;
+					g410 = -1052.797 + 4758.686 * e - 7193.992 * esq + 3651.957 * eoc;
+					g422 = -3581.690 + 16178.110 * e - 24462.770 * esq + 12422.520 * eoc;
+					if(e > 0.715)
+						g520 = -5149.66 + 29936.92 * e - 54087.36 * esq + 31324.56 * eoc;
+					else
+						g520 = 1464.74 - 4664.75 * e + 3763.64 * esq;
+				}
+				if(e < 0.7)
+				{
+					g533 = -919.22770 + 4988.6100 * e - 9064.7700 * esq + 5542.21 * eoc;
+					g521 = -822.71072 + 4568.6173 * e - 8491.4146 * esq + 5337.524 * eoc;
+					g532 = -853.66600 + 4690.2500 * e - 8624.7700 * esq + 5341.4 * eoc;
+				}
+				else {
+					g533 = -37995.780 + 161616.52 * e - 229838.20 * esq + 109377.94 * eoc;
+					g521 = -51752.104 + 218913.95 * e - 309468.16 * esq + 146349.42 * eoc;
+					g532 = -40023.880 + 170470.89 * e - 242699.48 * esq + 115605.82 * eoc;
+				}
+
+				const double sini2 = s.sinim * s.sinim;
+				const double f220 = 0.75 * (1.0 + 2.0 * s.cosim + cosisq);
+				const double f221 = 1.5 * sini2;
+				const double f321 = 1.875 * s.sinim * (1.0 - 2.0 * s.cosim - 3.0 * cosisq);
+				const double f322 = -1.875 * s.sinim * (1.0 + 2.0 * s.cosim - 3.0 * cosisq);
+				const double f441 = 35.0 * sini2 * f220;
+				const double f442 = 39.3750 * sini2 * sini2;
+				const double f522 = 9.84375 * s.sinim * (sini2 * (1.0 - 2.0 * s.cosim - 5.0 * cosisq) + 0.33333333 * (-2.0 + 4.0 * s.cosim + 6.0 * cosisq));
+				const double f523 = s.sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * s.cosim + 10.0 * cosisq) + 6.56250012 * (1.0 + 2.0 * s.cosim - 3.0 * cosisq));
+				const double f542 = 29.53125 * s.sinim * (2.0 - 8.0 * s.cosim + cosisq * (-12.0 + 8.0 * s.cosim + 10.0 * cosisq));
+				const double f543 = 29.53125 * s.sinim * (-2.0 - 8.0 * s.cosim + cosisq * (12.0 + 8.0 * s.cosim - 10.0 * cosisq));
+
+				const double xno2 = nm * nm;
+				const double ainv2 = aonv * aonv;
+				double temp1 = 3.0 * xno2 * ainv2;
+				double temp = temp1 * root22;
+				d.d2201 = temp * f220 * g201;
+				d.d2211 = temp * f221 * g211;
+				temp1 = temp1 * aonv;
+				temp = temp1 * root32;
+				d.d3210 = temp * f321 * g310;
+				d.d3222 = temp * f322 * g322;
+				temp1 = temp1 * aonv;
+				temp = 2.0 * temp1 * root44;
+				d.d4410 = temp * f441 * g410;
+				d.d4422 = temp * f442 * g422;
+				temp1 = temp1 * aonv;
+				temp = temp1 * root52;
+				d.d5220 = temp * f522 * g520;
+				d.d5232 = temp * f523 * g532;
+				temp = 2.0 * temp1 * root54;
+				d.d5421 = temp * f542 * g521;
+				d.d5433 = temp * f543 * g533;
+				d.xlamo = fmod(c.mo + c.nodeo + c.nodeo - theta - theta, TWO_PI);
+				d.xfact = c.mdot + d.dmdt + 2.0 * (c.nodedot + d.dnodt - rptim) - c.no;
+			}
+
+			// synchronous resonance terms
+			if(d.irez == 1)
+			{
+				const double g200 = 1.0 + s.emsq * (-2.5 + 0.8125 * s.emsq);
+				const double g310 = 1.0 + 2.0 * s.emsq;
+				const double g300 = 1.0 + s.emsq * (-6.0 + 6.60937 * s.emsq);
+				const double f220 = 0.75 * (1.0 + s.cosim) * (1.0 + s.cosim);
+				const double f311 = 0.9375 * s.sinim * s.sinim * (1.0 + 3.0 * s.cosim) - 0.75 * (1.0 + s.cosim);
+				double f330 = 1.0 + s.cosim;
+				f330 = 1.875 * f330 * f330 * f330;
+				d.del1 = 3.0 * nm * nm * aonv * aonv;
+				d.del2 = 2.0 * d.del1 * f220 * g200 * q22;
+				d.del3 = 3.0 * d.del1 * f330 * g300 * q33 * aonv;
+				d.del1 = d.del1 * f311 * g310 * q31 * aonv;
+				d.xlamo = fmod(c.mo + c.nodeo + c.argpo - theta, TWO_PI);
+				d.xfact = c.mdot + (c.argpdot + c.nodedot) - rptim + d.dmdt + d.domdt + d.dnodt - c.no;
+			}
+		}
+
+		// the resonance integrator starts at the epoch
+		d.atime = 0.0;
+		d.xli = d.xlamo;
+		d.xni = c.no;
+	}
+
+	// initializes the near-earth constants and the deep-space flag (initl and sgp4init)
+	void initialize(const MeanElements& elements, Constants& c)
+	{
+		c.elements = elements;
+		c.ecco = elements.eccentricity;
+		c.inclo = elements.inclination;
+		c.nodeo = elements.raan;
+		c.argpo = elements.argOfPerigee;
+		c.mo = elements.meanAnomaly;
+		c.bstar = elements.bstar;
+		c.valid = elements.semiMajorAxis > 0.0 && c.ecco >= 0.0 && c.ecco < 1.0 && std::isfinite(elements.epoch);
+		c.deep = false;
+		if(!c.valid)
+			return;
+
+		// the Kozai mean motion of the element set in rad/min
+		const double noKozai = sqrt(MU / (elements.semiMajorAxis * elements.semiMajorAxis * elements.semiMajorAxis)) * 60.0;
+		const double eccsq = c.ecco * c.ecco;
+		const double omeosq = 1.0 - eccsq;
+		const double rteosq = sqrt(omeosq);
+		c.cosio = cos(c.inclo);
+		const double cosio2 = c.cosio * c.cosio;
+
+		// un-Kozai the mean motion
+		const double ak = pow(XKE / noKozai, X2O3);
+		const double d1 = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+		double del = d1 / (ak * ak);
+		const double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+		del = d1 / (adel * adel);
+		c.no = noKozai / (1.0 + del);
+
+		c.ao = pow(XKE / c.no, X2O3);
+		c.sinio = sin(c.inclo);
+		const double po = c.ao * omeosq;
+		const double con42 = 1.0 - 5.0 * cosio2;
+		c.con41 = -con42 - cosio2 - cosio2;
+		const double posq = po * po;
+		const double rp = c.ao * (1.0 - c.ecco);
+
+		// near-earth objects with a perigee below 220 km use a simplified drag model
+		bool simple = rp < 220.0 / EARTH_RADIUS + 1.0;
+		const double ss = 78.0 / EARTH_RADIUS + 1.0;
+		const double qzms2ttemp = (120.0 - 78.0) / EARTH_RADIUS;
+		double sfour = ss;
+		double qzms24 = qzms2ttemp * qzms2ttemp * qzms2ttemp * qzms2ttemp;
+		const double perigee = (rp - 1.0) * EARTH_RADIUS;
+		if(perigee < 156.0)
+		{
+			sfour = perigee - 78.0;
+			if(perigee < 98.0)
+				sfour = 20.0;
+			qzms24 = pow((120.0 - sfour) / EARTH_RADIUS, 4.0);
+			sfour = sfour / EARTH_RADIUS + 1.0;
+		}
+		const double pinvsq = 1.0 / posq;
+		const double tsi = 1.0 / (c.ao - sfour);
+		c.eta = c.ao * c.ecco * tsi;
+		const double etasq = c.eta * c.eta;
+		const double eeta = c.ecco * c.eta;
+		const double psisq = fabs(1.0 - etasq);
+		const double coef = qzms24 * pow(tsi, 4.0);
+		const double coef1 = coef / pow(psisq, 3.5);
+		const double cc2 = coef1 * c.no * (c.ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) + 0.375 * J2 * tsi / psisq * c.con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+		c.cc1 = c.bstar * cc2;
+		double cc3 = 0.0;
+		if(c.ecco > 1.0e-4)
+			cc3 = -2.0 * coef * tsi * J3OJ2 * c.no * c.sinio / c.ecco;
+		c.x1mth2 = 1.0 - cosio2;
+		c.cc4 = 2.0 * c.no * coef1 * c.ao * omeosq * (c.eta * (2.0 + 0.5 * etasq) + c.ecco * (0.5 + 2.0 * etasq)
+			- J2 * tsi / (c.ao * psisq) * (-3.0 * c.con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta))
+			+ 0.75 * c.x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * cos(2.0 * c.argpo)));
+		c.cc5 = 2.0 * coef1 * c.ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+		const double cosio4 = cosio2 * cosio2;
+		const double temp1 = 1.5 * J2 * pinvsq * c.no;
+		const double temp2 = 0.5 * temp1 * J2 * pinvsq;
+		const double temp3 = -0.46875 * J4 * pinvsq * pinvsq * c.no;
+		c.mdot = c.no + 0.5 * temp1 * rteosq * c.con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+		c.argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) + temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+		const double xhdot1 = -temp1 * c.cosio;
+		c.nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * c.cosio;
+		c.omgcof = c.bstar * cc3 * cos(c.argpo);
+		c.xmcof = 0.0;
+		if(c.ecco > 1.0e-4)
+			c.xmcof = -X2O3 * coef * c.bstar / eeta;
+		c.nodecf = 3.5 * omeosq * xhdot1 * c.cc1;
+		c.t2cof = 1.5 * c.cc1;
+		if(fabs(c.cosio + 1.0) > 1.5e-12)
+			c.xlcof = -0.25 * J3OJ2 * c.sinio * (3.0 + 5.0 * c.cosio) / (1.0 + c.cosio);
+		else
+			c.xlcof = -0.25 * J3OJ2 * c.sinio * (3.0 + 5.0 * c.cosio) / 1.5e-12;
+		c.aycof = -0.5 * J3OJ2 * c.sinio;
+		const double delmotemp = 1.0 + c.eta * cos(c.mo);
+		c.delmo = delmotemp * delmotemp * delmotemp;
+		c.sinmao = sin(c.mo);
+		c.x7thm1 = 7.0 * cosio2 - 1.0;
+
+		// objects with a period of 225 minutes or more are deep-space objects
+		if(TWO_PI / c.no >= 225.0)
+		{
+			c.deep = true;
+			simple = true;
+		}
+
+		if(simple)
+		{
+			// the higher order drag terms vanish, so the near-earth pass needs no branches
+			c.omgcof = c.xmcof = c.cc5 = 0.0;
+			c.d2 = c.d3 = c.d4 = 0.0;
+			c.t3cof = c.t4cof = c.t5cof = 0.0;
+		}
+		else {
+			const double cc1sq = c.cc1 * c.cc1;
+			c.d2 = 4.0 * c.ao * tsi * cc1sq;
+			const double temp = c.d2 * tsi * c.cc1 / 3.0;
+			c.d3 = (17.0 * c.ao + sfour) * temp;
+			c.d4 = 0.5 * temp * c.ao * tsi * (221.0 * c.ao + 31.0 * sfour) * c.cc1;
+			c.t3cof = c.d2 + 2.0 * cc1sq;
+			c.t4cof = 0.25 * (3.0 * c.d3 + c.cc1 * (12.0 * c.d2 + 10.0 * cc1sq));
+			c.t5cof = 0.2 * (3.0 * c.d4 + 12.0 * c.cc1 * c.d3 + 6.0 * c.d2 * c.d2 + 15.0 * cc1sq * (2.0 * c.d2 + cc1sq));
+		}
+	}
+
+	// initializes the deep-space terms of an object after initialize()
+	void initializeDeepSpace(const Constants& c, DeepSpace& d)
+	{
+		DeepSpaceSetup setup;
+		initializeLunarSolar(c.elements.epoch - SGP4_EPOCH, c, d, setup);
+		initializeResonance(c, setup, d);
+	}
+
+	// the mean elements of a batch after the secular and long-period lunar-solar terms
+	struct Batch
+	{
+		double am[LANES], nm[LANES], ep[LANES], xincp[LANES], argpp[LANES], nodep[LANES], mp[LANES];
+		double sinip[LANES], cosip[LANES], aycof[LANES], xlcof[LANES];
+		double con41[LANES], x1mth2[LANES], x7thm1[LANES];
+		// 1 for objects that can be propagated, 0 for errors
+		double valid[LANES];
+		// the resulting positions and velocities
+		double x[LANES], y[LANES], z[LANES], vx[LANES], vy[LANES], vz[LANES];
+	};
+
+	// secular terms of near-earth objects for a full batch
+	void nearEarthSecular(const Constants* const* objects, const double* tsince, Batch& b)
+	{
+		double mo[LANES], mdot[LANES], argpo[LANES], argpdot[LANES], nodeo[LANES], nodedot[LANES], nodecf[LANES];
+		double cc1[LANES], bstar[LANES], cc4[LANES], cc5[LANES], t2cof[LANES], omgcof[LANES], xmcof[LANES], eta[LANES];
+		double delmo[LANES], sinmao[LANES], d2[LANES], d3[LANES], d4[LANES], t3cof[LANES], t4cof[LANES], t5cof[LANES];
+		double no[LANES], ao[LANES], ecco[LANES], t[LANES];
+		for(int l = 0; l < LANES; ++l)
+		{
+			const Constants& c = *objects[l];
+			mo[l] = c.mo; mdot[l] = c.mdot; argpo[l] = c.argpo; argpdot[l] = c.argpdot;
+			nodeo[l] = c.nodeo; nodedot[l] = c.nodedot; nodecf[l] = c.nodecf;
+			cc1[l] = c.cc1; bstar[l] = c.bstar; cc4[l] = c.cc4; cc5[l] = c.cc5; t2cof[l] = c.t2cof;
+			omgcof[l] = c.omgcof; xmcof[l] = c.xmcof; eta[l] = c.eta; delmo[l] = c.delmo; sinmao[l] = c.sinmao;
+			d2[l] = c.d2; d3[l] = c.d3; d4[l] = c.d4; t3cof[l] = c.t3cof; t4cof[l] = c.t4cof; t5cof[l] = c.t5cof;
+			no[l] = c.no; ao[l] = c.ao; ecco[l] = c.ecco; t[l] = tsince[l];
+			b.xincp[l] = c.inclo; b.sinip[l] = c.sinio; b.cosip[l] = c.cosio;
+			b.aycof[l] = c.aycof; b.xlcof[l] = c.xlcof;
+			b.con41[l] = c.con41; b.x1mth2[l] = c.x1mth2; b.x7thm1[l] = c.x7thm1;
+			b.valid[l] = c.valid ? 1.0 : 0.0;
+		}
+		for(int l = 0; l < LANES; ++l)
+		{
+			// secular gravity and atmospheric drag
+			const double xmdf = mo[l] + mdot[l] * t[l];
+			const double argpdf = argpo[l] + argpdot[l] * t[l];
+			const double nodedf = nodeo[l] + nodedot[l] * t[l];
+			const double t2 = t[l] * t[l];
+			const double t3 = t2 * t[l];
+			const double t4 = t3 * t[l];
+			double nodem = nodedf + nodecf[l] * t2;
+			double sinXmdf, cosXmdf;
+			vectorSinCos(xmdf, sinXmdf, cosXmdf);
+			const double delomg = omgcof[l] * t[l];
+			const double delmtemp = 1.0 + eta[l] * cosXmdf;
+			const double delm = xmcof[l] * (delmtemp * delmtemp * delmtemp - delmo[l]);
+			double mm = xmdf + (delomg + delm);
+			double argpm = argpdf - (delomg + delm);
+			const double tempa = 1.0 - cc1[l] * t[l] - d2[l] * t2 - d3[l] * t3 - d4[l] * t4;
+			double sinMm, cosMm;
+			vectorSinCos(mm, sinMm, cosMm);
+			const double tempe = bstar[l] * cc4[l] * t[l] + bstar[l] * cc5[l] * (sinMm - sinmao[l]);
+			const double templ = t2cof[l] * t2 + t3cof[l] * t3 + t4 * (t4cof[l] + t[l] * t5cof[l]);
+
+			const double am = ao[l] * tempa * tempa;
+			double em = ecco[l] - tempe;
+			b.valid[l] = (em < 1.0 && em >= -0.001 && am > 0.0) ? b.valid[l] : 0.0;
+			em = em < 1.0e-6 ? 1.0e-6 : em;
+			mm = mm + no[l] * templ;
+			double xlm = mm + argpm + nodem;
+			nodem = reduceAngle(nodem);
+			argpm = reduceAngle(argpm);
+			xlm = reduceAngle(xlm);
+			b.mp[l] = reduceAngle(xlm - argpm - nodem);
+			b.am[l] = am;
+			b.nm[l] = XKE / (am * sqrt(am));
+			b.ep[l] = em;
+			b.argpp[l] = argpm;
+			b.nodep[l] = nodem;
+		}
+	}
+
+	// lunar-solar periodics (dpper)
+	void deepSpacePeriodics(const DeepSpace& d, double t, double& ep, double& inclp, double& nodep, double& argpp, double& mp)
+	{
+		const double zns = 1.19459e-5, zes = 0.01675, znl = 1.5835218e-4, zel = 0.05490;
+		double zm = d.zmos + zns * t;
+		double zf = zm + 2.0 * zes * sin(zm);
+		double sinzf = sin(zf);
+		double f2 = 0.5 * sinzf * sinzf - 0.25;
+		double f3 = -0.5 * sinzf * cos(zf);
+		const double ses = d.se2 * f2 + d.se3 * f3;
+		const double sis = d.si2 * f2 + d.si3 * f3;
+		const double sls = d.sl2 * f2 + d.sl3 * f3 + d.sl4 * sinzf;
+		const double sghs = d.sgh2 * f2 + d.sgh3 * f3 + d.sgh4 * sinzf;
+		const double shs = d.sh2 * f2 + d.sh3 * f3;
+		zm = d.zmol + znl * t;
+		zf = zm + 2.0 * zel * sin(zm);
+		sinzf = sin(zf);
+		f2 = 0.5 * sinzf * sinzf - 0.25;
+		f3 = -0.5 * sinzf * cos(zf);
+		const double sel = d.ee2 * f2 + d.e3 * f3;
+		const double sil = d.xi2 * f2 + d.xi3 * f3;
+		const double sll = d.xl2 * f2 + d.xl3 * f3 + d.xl4 * sinzf;
+		const double sghl = d.xgh2 * f2 + d.xgh3 * f3 + d.xgh4 * sinzf;
+		const double shll = d.xh2 * f2 + d.xh3 * f3;
+		// the periodics at the epoch are zero in this version of the model
+		const double pe = ses + sel;
+		const double pinc = sis + sil;
+		const double pl = sls + sll;
+		double pgh = sghs + sghl;
+		double ph = shs + shll;
+
+		inclp = inclp + pinc;
+		ep = ep + pe;
+		const double sinip = sin(inclp);
+		const double cosip = cos(inclp);
+		if(inclp >= 0.2)
+		{
+			ph = ph / sinip;
+			pgh = pgh - cosip * ph;
+			argpp = argpp + pgh;
+			nodep = nodep + ph;
+			mp = mp + pl;
+		}
+		else {
+			// apply the periodics with the Lyddane modification
+			const double sinop = sin(nodep);
+			const double cosop = cos(nodep);
+			double alfdp = sinip * sinop;
+			double betdp = sinip * cosop;
+			const double dalf = ph * cosop + pinc * cosip * sinop;
+			const double dbet = -ph * sinop + pinc * cosip * cosop;
+			alfdp = alfdp + dalf;
+			betdp = betdp + dbet;
+			nodep = fmod(nodep, TWO_PI);
+			double xls = mp + argpp + cosip * nodep;
+			const double dls = pl + pgh - pinc * nodep * sinip;
+			xls = xls + dls;
+			const double xnoh = nodep;
+			nodep = atan2(alfdp, betdp);
+			if(fabs(xnoh - nodep) > PI)
+			{
+				if(nodep < xnoh)
+					nodep = nodep + TWO_PI;
+				else
+					nodep = nodep - TWO_PI;
+			}
+			mp = mp + pl;
+			argpp = xls - mp - cosip * nodep;
+		}
+	}
+
+	// secular and resonance terms of a deep-space object (dspace), updates the integrator state
+	void deepSpaceSecular(const Constants& c, DeepSpace& d, double t, double& em, double& argpm, double& inclm, double& mm, double& nodem, double& nm)
+	{
+		const double fasx2 = 0.13130908, fasx4 = 2.8843198, fasx6 = 0.37448087;
+		const double g22 = 5.7686396, g32 = 0.95240898, g44 = 1.8014998, g52 = 1.0508330, g54 = 4.4108898;
+		const double rptim = 4.37526908801129966e-3;
+		const double stepp = 720.0, stepn = -720.0, step2 = 259200.0;
+
+		const double theta = fmod(d.gsto + t * rptim, TWO_PI);
+		em = em + d.dedt * t;
+		inclm = inclm + d.didt * t;
+		argpm = argpm + d.domdt * t;
+		nodem = nodem + d.dnodt * t;
+		mm = mm + d.dmdt * t;
+		if(d.irez == 0)
+			return;
+
+		// restart the integration from the epoch if it cannot continue from its last state
+		if(d.atime == 0.0 || t * d.atime <= 0.0 || fabs(t) < fabs(d.atime))
+		{
+			d.atime = 0.0;
+			d.xni = c.no;
+			d.xli = d.xlamo;
+		}
+		const double delt = t > 0.0 ? stepp : stepn;
+		double xndt, xldot, xnddt, ft;
+		while(true)
+		{
+			if(d.irez != 2)
+			{
+				xndt = d.del1 * sin(d.xli - fasx2) + d.del2 * sin(2.0 * (d.xli - fasx4)) + d.del3 * sin(3.0 * (d.xli - fasx6));
+				xldot = d.xni + d.xfact;
+				xnddt = d.del1 * cos(d.xli - fasx2) + 2.0 * d.del2 * cos(2.0 * (d.xli - fasx4)) + 3.0 * d.del3 * cos(3.0 * (d.xli - fasx6));
+				xnddt = xnddt * xldot;
+			}
+			else {
+				const double xomi = c.argpo + c.argpdot * d.atime;
+				const double x2omi = xomi + xomi;
+				const double x2li = d.xli + d.xli;
+				xndt = d.d2201 * sin(x2omi + d.xli - g22) + d.d2211 * sin(d.xli - g22)
+					+ d.d3210 * sin(xomi + d.xli - g32) + d.d3222 * sin(-xomi + d.xli - g32)
+					+ d.d4410 * sin(x2omi + x2li - g44) + d.d4422 * sin(x2li - g44)
+					+ d.d5220 * sin(xomi + d.xli - g52) + d.d5232 * sin(-xomi + d.xli - g52)
+					+ d.d5421 * sin(xomi + x2li - g54) + d.d5433 * sin(-xomi + x2li - g54);
+				xldot = d.xni + d.xfact;
+				xnddt = d.d2201 * cos(x2omi + d.xli - g22) + d.d2211 * cos(d.xli - g22)
+					+ d.d3210 * cos(xomi + d.xli - g32) + d.d3222 * cos(-xomi + d.xli - g32)
+					+ d.d5220 * cos(xomi + d.xli - g52) + d.d5232 * cos(-xomi + d.xli - g52)
+					+ 2.0 * (d.d4410 * cos(x2omi + x2li - g44) + d.d4422 * cos(x2li - g44)
+					+ d.d5421 * cos(xomi + x2li - g54) + d.d5433 * cos(-xomi + x2li - g54));
+				xnddt = xnddt * xldot;
+			}
+			if(fabs(t - d.atime) < stepp)
+			{
+				ft = t - d.atime;
+				break;
+			}
+			d.xli = d.xli + xldot * delt + xndt * step2;
+			d.xni = d.xni + xndt * delt + xnddt * step2;
+			d.atime = d.atime + delt;
+		}
+		nm = d.xni + xndt * ft + xnddt * ft * ft * 0.5;
+		const double xl = d.xli + xldot * ft + xndt * ft * ft * 0.5;
+		if(d.irez != 1)
+			mm = xl - 2.0 * nodem + 2.0 * theta;
+		else
+			mm = xl - nodem - argpm + theta;
+	}
+
+	// secular and lunar-solar terms of a deep-space object for lane l of a batch
+	void deepSpaceObject(const Constants& c, DeepSpace& d, double t, Batch& b, int l)
+	{
+		b.valid[l] = c.valid ? 1.0 : 0.0;
+		const double xmdf = c.mo + c.mdot * t;
+		double argpm = c.argpo + c.argpdot * t;
+		double nodem = c.nodeo + c.nodedot * t + c.nodecf * t * t;
+		double mm = xmdf;
+		const double tempa = 1.0 - c.cc1 * t;
+		const double tempe = c.bstar * c.cc4 * t;
+		const double templ = c.t2cof * t * t;
+		double nm = c.no;
+		double em = c.ecco;
+		double inclm = c.inclo;
+		deepSpaceSecular(c, d, t, em, argpm, inclm, mm, nodem, nm);
+		if(nm <= 0.0)
+			b.valid[l] = 0.0;
+		const double am = pow(XKE / nm, X2O3) * tempa * tempa;
+		b.am[l] = am;
+		b.nm[l] = XKE / pow(am, 1.5);
+		em = em - tempe;
+		if(em >= 1.0 || em < -0.001 || !(am > 0.0))
+			b.valid[l] = 0.0;
+		if(em < 1.0e-6)
+			em = 1.0e-6;
+		mm = mm + c.no * templ;
+		double xlm = mm + argpm + nodem;
+		nodem = fmod(nodem, TWO_PI);
+		argpm = fmod(argpm, TWO_PI);
+		xlm = fmod(xlm, TWO_PI);
+		mm = fmod(xlm - argpm - nodem, TWO_PI);
+
+		double ep = em, xincp = inclm, argpp = argpm, nodep = nodem, mp = mm;
+		deepSpacePeriodics(d, t, ep, xincp, nodep, argpp, mp);
+		if(xincp < 0.0)
+		{
+			xincp = -xincp;
+			nodep = nodep + PI;
+			argpp = argpp - PI;
+		}
+		if(ep < 0.0 || ep > 1.0)
+			b.valid[l] = 0.0;
+
+		// long-period coefficients for the perturbed inclination
+		const double sinip = sin(xincp);
+		const double cosip = cos(xincp);
+		b.ep[l] = ep;
+		b.xincp[l] = xincp;
+		b.argpp[l] = argpp;
+		b.nodep[l] = nodep;
+		b.mp[l] = mp;
+		b.sinip[l] = sinip;
+		b.cosip[l] = cosip;
+		b.aycof[l] = -0.5 * J3OJ2 * sinip;
+		if(fabs(cosip + 1.0) > 1.5e-12)
+			b.xlcof[l] = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / (1.0 + cosip);
+		else
+			b.xlcof[l] = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / 1.5e-12;
+		const double cosisq = cosip * cosip;
+		b.con41[l] = 3.0 * cosisq - 1.0;
+		b.x1mth2[l] = 1.0 - cosisq;
+		b.x7thm1[l] = 7.0 * cosisq - 1.0;
+	}
+
+	// copies the mean elements of one lane of a batch to another
+	void copyLane(Batch& b, int from, int to)
+	{
+		b.am[to] = b.am[from]; b.nm[to] = b.nm[from]; b.ep[to] = b.ep[from]; b.xincp[to] = b.xincp[from];
+		b.argpp[to] = b.argpp[from]; b.nodep[to] = b.nodep[from]; b.mp[to] = b.mp[from];
+		b.sinip[to] = b.sinip[from]; b.cosip[to] = b.cosip[from]; b.aycof[to] = b.aycof[from]; b.xlcof[to] = b.xlcof[from];
+		b.con41[to] = b.con41[from]; b.x1mth2[to] = b.x1mth2[from]; b.x7thm1[to] = b.x7thm1[from];
+		b.valid[to] = b.valid[from];
+	}
+
+	// long-period periodics, Kepler's equation and short-period periodics for a batch;
+	// objects that cannot be propagated or have decayed receive NaN
+	void finishBatch(Batch& b)
+	{
+		double axnl[LANES], aynl[LANES], u[LANES], eo1[LANES], sineo1[LANES], coseo1[LANES], active[LANES];
+		for(int l = 0; l < LANES; ++l)
+		{
+			double sinArgp, cosArgp;
+			vectorSinCos(b.argpp[l], sinArgp, cosArgp);
+			axnl[l] = b.ep[l] * cosArgp;
+			const double temp = 1.0 / (b.am[l] * (1.0 - b.ep[l] * b.ep[l]));
+			aynl[l] = b.ep[l] * sinArgp + temp * b.aycof[l];
+			const double xl = b.mp[l] + b.argpp[l] + b.nodep[l] + temp * b.xlcof[l] * axnl[l];
+			u[l] = reduceAngle(xl - b.nodep[l]);
+			eo1[l] = u[l];
+			sineo1[l] = 0.0;
+			coseo1[l] = 1.0;
+			active[l] = 1.0;
+		}
+
+		// Kepler's equation, every object stops after its own convergence
+		for(int iteration = 0; iteration < 10; ++iteration)
+		{
+			for(int l = 0; l < LANES; ++l)
+			{
+				double s, c;
+				vectorSinCos(eo1[l], s, c);
+				double tem5 = 1.0 - c * axnl[l] - s * aynl[l];
+				tem5 = (u[l] - aynl[l] * c + axnl[l] * s - eo1[l]) / tem5;
+				tem5 = tem5 > 0.95 ? 0.95 : (tem5 < -0.95 ? -0.95 : tem5);
+				// converged objects keep their anomaly, so s and c stay valid for them
+				const double step = active[l] * tem5;
+				sineo1[l] = s;
+				coseo1[l] = c;
+				eo1[l] += step;
+				active[l] = fabs(step) >= 1.0e-12 ? 1.0 : 0.0;
+			}
+			double remaining = 0.0;
+			for(int l = 0; l < LANES; ++l)
+				remaining += active[l];
+			if(remaining == 0.0)
+				break;
+		}
+
+		// short-period periodics
+		for(int l = 0; l < LANES; ++l)
+		{
+			const double am = b.am[l];
+			const double ecose = axnl[l] * coseo1[l] + aynl[l] * sineo1[l];
+			const double esine = axnl[l] * sineo1[l] - aynl[l] * coseo1[l];
+			const double el2 = axnl[l] * axnl[l] + aynl[l] * aynl[l];
+			const double pl = am * (1.0 - el2);
+			const double rl = am * (1.0 - ecose);
+			const double rdotl = sqrt(am) * esine / rl;
+			const double rvdotl = sqrt(pl) / rl;
+			const double betal = sqrt(1.0 - el2);
+			double temp = esine / (1.0 + betal);
+			double sinu = am / rl * (sineo1[l] - aynl[l] - axnl[l] * temp);
+			double cosu = am / rl * (coseo1[l] - axnl[l] + aynl[l] * temp);
+			const double norm = 1.0 / sqrt(sinu * sinu + cosu * cosu);
+			sinu *= norm;
+			cosu *= norm;
+			const double sin2u = (cosu + cosu) * sinu;
+			const double cos2u = 1.0 - 2.0 * sinu * sinu;
+			temp = 1.0 / pl;
+			const double temp1 = 0.5 * J2 * temp;
+			const double temp2 = temp1 * temp;
+
+			const double mrt = rl * (1.0 - 1.5 * temp2 * betal * b.con41[l]) + 0.5 * temp1 * b.x1mth2[l] * cos2u;
+			double sinDelta, cosDelta;
+			vectorSinCos(-0.25 * temp2 * b.x7thm1[l] * sin2u, sinDelta, cosDelta);
+			const double sinsu = sinu * cosDelta + cosu * sinDelta;
+			const double cossu = cosu * cosDelta - sinu * sinDelta;
+			const double xnode = b.nodep[l] + 1.5 * temp2 * b.cosip[l] * sin2u;
+			const double xinc = b.xincp[l] + 1.5 * temp2 * b.cosip[l] * b.sinip[l] * cos2u;
+			const double mvt = rdotl - b.nm[l] * temp1 * b.x1mth2[l] * sin2u / XKE;
+			const double rvdot = rvdotl + b.nm[l] * temp1 * (b.x1mth2[l] * cos2u + 1.5 * b.con41[l]) / XKE;
+
+			// orientation vectors
+			double snod, cnod, sini, cosi;
+			vectorSinCos(xnode, snod, cnod);
+			vectorSinCos(xinc, sini, cosi);
+			const double xmx = -snod * cosi;
+			const double xmy = cnod * cosi;
+			const double ux = xmx * sinsu + cnod * cossu;
+			const double uy = xmy * sinsu + snod * cossu;
+			const double uz = sini * sinsu;
+			const double vx = xmx * cossu - cnod * sinsu;
+			const double vy = xmy * cossu - snod * sinsu;
+			const double vz = sini * cossu;
+
+			const bool valid = b.valid[l] != 0.0 && pl > 0.0 && mrt >= 1.0;
+			const double r = valid ? mrt * EARTH_RADIUS : NOT_A_NUMBER;
+			const double v1 = valid ? mvt * VELOCITY_UNIT : NOT_A_NUMBER;
+			const double v2 = valid ? rvdot * VELOCITY_UNIT : NOT_A_NUMBER;
+			b.x[l] = r * ux;
+			b.y[l] = r * uy;
+			b.z[l] = r * uz;
+			b.vx[l] = v1 * ux + v2 * vx;
+			b.vy[l] = v1 * uy + v2 * vy;
+			b.vz[l] = v1 * uz + v2 * vz;
+		}
+	}
+
+	// runs func(begin, end) on contiguous ranges of [0, count) on several threads
+	template<class Function>
+	void parallelRanges(int count, int minimumRange, Function func)
+	{
+		int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		threads = std::max(1, std::min(threads, (count + minimumRange - 1) / minimumRange));
+		if(threads == 1)
+		{
+			func(0, count);
+			return;
+		}
+		std::vector<std::thread> workers;
+		for(int thread = 0; thread < threads; ++thread)
+		{
+			int begin = static_cast<int>(static_cast<long long>(count) * thread / threads);
+			int end = static_cast<int>(static_cast<long long>(count) * (thread + 1) / threads);
+			workers.push_back(std::thread(func, begin, end));
+		}
+		for(size_t thread = 0; thread < workers.size(); ++thread)
+			workers[thread].join();
+	}
+}
+
+// SGP4/SDP4 propagator. The constants of each object are derived from its element set in
+// the first propagation and kept until the elements change, so repeated propagations of a
+// catalog only evaluate the time-dependent terms. Near-earth objects are propagated in
+// batches of LANES objects with loops the compiler can vectorize; deep-space objects need
+// the lunar-solar terms and the resonance integrator and are propagated in a separate,
+// scalar pass. Objects that cannot be propagated (invalid elements, decayed orbits) receive
+// NaN positions and velocities.
+class SGP4CPP: public OPI::Propagator
+{
+	public:
+		SGP4CPP(OPI::Host& host)
+		{
+			setColumnUsage(OPI::MASK_ORBIT | OPI::MASK_PROPERTIES | OPI::MASK_EPOCH, OPI::MASK_CARTESIAN | OPI::MASK_VELOCITY | OPI::MASK_EPOCH);
+		}
+
+		virtual ~SGP4CPP()
+		{
+		}
+
+		virtual OPI::ErrorCode runPropagation(OPI::Population& data, double julian_day, double dt)
+		{
+			return propagateObjects(data, 0, data.getSize(), 0, julian_day, dt);
+		}
+
+		OPI::ErrorCode runIndexedPropagation(OPI::Population& data, OPI::IndexList& indices, double julian_day, double dt)
+		{
+			const int* list = indices.getData(OPI::DEVICE_HOST);
+			const int count = indices.getSize();
+			for(int i = 0; i < count; ++i)
+			{
+				if(list[i] < 0 || list[i] >= data.getSize())
+					return OPI::INDEX_RANGE;
+			}
+			return propagateObjects(data, list, count, 0, julian_day, dt);
+		}
+
+		OPI::ErrorCode runMultiTimePropagation(OPI::Population& data, double* julian_days, int length, double dt)
+		{
+			return propagateObjects(data, 0, data.getSize(), julian_days, 0.0, dt);
+		}
+
+		virtual OPI::ErrorCode runDisable()
+		{
+			constants.clear();
+			deepSpace.clear();
+			return OPI::SUCCESS;
+		}
+
+		virtual OPI::ErrorCode runEnable()
+		{
+			return OPI::SUCCESS;
+		}
+
+		// SGP4 is an analytic theory and can propagate in both directions.
+		bool backwardPropagation()
+		{
+			return true;
+		}
+
+		// This propagator returns position and velocity vectors.
+		bool cartesianCoordinates()
+		{
+			return true;
+		}
+
+		// SGP4 states refer to the true equator, mean equinox frame.
+		OPI::ReferenceFrame referenceFrame()
+		{
+			return OPI::REF_TEME;
+		}
+
+		// This plugin does not require CUDA.
+		int requiresCUDA()
+		{
+			return 0;
+		}
+
+		// This plugin does not require OpenCL.
+		int requiresOpenCL()
+		{
+			return 0;
+		}
+
+		// This plugin is written for OPI version 1.0.
+		int minimumOPIVersionRequired()
+		{
+			return 1;
+		}
+
+	protected:
+		// Each near-earth batch holds one object at LANES consecutive times, so the constants
+		// are shared by all lanes and the states of a batch are contiguous in the trajectory.
+		OPI::ErrorCode runTrajectoryPropagation(OPI::Population& data, const double* julian_days, int length, OPI::TrajectoryBuffer& trajectory)
+		{
+			std::vector<int> nearList, deepList;
+			OPI::ErrorCode status = initializeObjects(data, 0, data.getSize(), nearList, deepList);
+			if(status != OPI::SUCCESS)
+				return status;
+			OPI::Vector3* position = trajectory.getPosition(OPI::DEVICE_HOST, true);
+			OPI::Vector3* velocity = trajectory.getVelocity(OPI::DEVICE_HOST, true);
+			const Constants* table = constants.data();
+			auto store = [&](int object, int first, const Batch& batch, int lanes) {
+				const size_t offset = static_cast<size_t>(object) * length + first;
+				for(int l = 0; l < lanes; ++l)
+				{
+					position[offset + l].x = batch.x[l];
+					position[offset + l].y = batch.y[l];
+					position[offset + l].z = batch.z[l];
+					if(velocity)
+					{
+						velocity[offset + l].x = batch.vx[l];
+						velocity[offset + l].y = batch.vy[l];
+						velocity[offset + l].z = batch.vz[l];
+					}
+				}
+			};
+
+			const int nearCount = static_cast<int>(nearList.size());
+			parallelRanges(nearCount, 16, [&](int begin, int end) {
+				Batch batch;
+				const Constants* objects[LANES];
+				double tsince[LANES];
+				for(int i = begin; i < end; ++i)
+				{
+					const int object = nearList[i];
+					for(int l = 0; l < LANES; ++l)
+						objects[l] = &table[object];
+					for(int first = 0; first < length; first += LANES)
+					{
+						const int lanes = std::min(LANES, length - first);
+						// a partial batch repeats its last time
+						for(int l = 0; l < LANES; ++l)
+							tsince[l] = (julian_days[first + std::min(l, lanes - 1)] - table[object].elements.epoch) * 1440.0;
+						nearEarthSecular(objects, tsince, batch);
+						finishBatch(batch);
+						store(object, first, batch, lanes);
+					}
+				}
+			});
+
+			const int deepCount = static_cast<int>(deepList.size());
+			parallelRanges(deepCount, 4, [&](int begin, int end) {
+				Batch batch;
+				for(int i = begin; i < end; ++i)
+				{
+					const int object = deepList[i];
+					const Constants& c = table[object];
+					for(int first = 0; first < length; first += LANES)
+					{
+						const int lanes = std::min(LANES, length - first);
+						for(int l = 0; l < lanes; ++l)
+							deepSpaceObject(c, deepSpace[c.deepIndex], (julian_days[first + l] - c.elements.epoch) * 1440.0, batch, l);
+						for(int l = lanes; l < LANES; ++l)
+							copyLane(batch, lanes - 1, l);
+						finishBatch(batch);
+						store(object, first, batch, lanes);
+					}
+				}
+			});
+			trajectory.update(OPI::DEVICE_HOST);
+
+			// the Population ends at the last time; the constants are initialized already
+			return propagateObjects(data, 0, data.getSize(), 0, julian_days[length - 1], 0.0);
+		}
+
+	private:
+		// Initializes the constants of the listed objects (all objects for a null list) if
+		// their elements changed and partitions them into near-earth and deep-space objects.
+		OPI::ErrorCode initializeObjects(OPI::Population& data, const int* list, int count, std::vector<int>& nearList, std::vector<int>& deepList)
+		{
+			if(!data.hasData(OPI::DATA_ORBIT) || !data.hasData(OPI::DATA_EPOCH))
+				return OPI::INVALID_TYPE;
+			const OPI::Orbit* orbits = data.getOrbit();
+			const OPI::ObjectProperties* properties = data.hasData(OPI::DATA_PROPERTIES) ? data.getObjectProperties() : 0;
+			const OPI::Epoch* epochs = data.getEpoch();
+			if(static_cast<int>(constants.size()) < data.getSize())
+			{
+				Constants unset;
+				memset(&unset, 0, sizeof(unset));
+				unset.elements.epoch = NOT_A_NUMBER;
+				unset.deepIndex = -1;
+				constants.resize(data.getSize(), unset);
+			}
+
+			// initialize objects with new or changed elements
+			std::vector<char> changed(count, 0);
+			parallelRanges(count, 4096, [&](int begin, int end) {
+				for(int i = begin; i < end; ++i)
+				{
+					const int object = list ? list[i] : i;
+					const OPI::Orbit& orbit = orbits[object];
+					MeanElements elements;
+					elements.epoch = epochs[object].original_epoch;
+					elements.semiMajorAxis = orbit.semi_major_axis;
+					elements.eccentricity = orbit.eccentricity;
+					elements.inclination = orbit.inclination;
+					elements.raan = orbit.raan;
+					elements.argOfPerigee = orbit.arg_of_perigee;
+					elements.meanAnomaly = orbit.mean_anomaly;
+					elements.bstar = properties ? properties[object].area_to_mass * properties[object].drag_coefficient * BSTAR_FACTOR : 0.0;
+					if(!(constants[object].elements == elements))
+					{
+						initialize(elements, constants[object]);
+						changed[i] = 1;
+					}
+				}
+			});
+			std::vector<int> deepObjects;
+			for(int i = 0; i < count; ++i)
+			{
+				const int object = list ? list[i] : i;
+				Constants& c = constants[object];
+				if(changed[i] && c.deep && c.valid)
+				{
+					if(c.deepIndex < 0)
+					{
+						c.deepIndex = static_cast<int>(deepSpace.size());
+						deepSpace.push_back(DeepSpace());
+					}
+					deepObjects.push_back(object);
+				}
+			}
+			parallelRanges(static_cast<int>(deepObjects.size()), 64, [&](int begin, int end) {
+				for(int i = begin; i < end; ++i)
+				{
+					const Constants& c = constants[deepObjects[i]];
+					initializeDeepSpace(c, deepSpace[c.deepIndex]);
+				}
+			});
+
+			// partition the objects into a near-earth and a deep-space pass
+			nearList.clear();
+			deepList.clear();
+			nearList.reserve(count);
+			for(int i = 0; i < count; ++i)
+			{
+				const int object = list ? list[i] : i;
+				const Constants& c = constants[object];
+				if(c.deep && c.valid)
+					deepList.push_back(object);
+				else
+					nearList.push_back(object);
+			}
+			return OPI::SUCCESS;
+		}
+
+		// Propagates the listed objects (all objects for a null list) to julian_day + dt,
+		// or to julian_days[object] + dt if per-object dates are given.
+		OPI::ErrorCode propagateObjects(OPI::Population& data, const int* list, int count, const double* julian_days, double julian_day, double dt)
+		{
+			std::vector<int> nearList, deepList;
+			OPI::ErrorCode status = initializeObjects(data, list, count, nearList, deepList);
+			if(status != OPI::SUCCESS)
+				return status;
+			OPI::Epoch* epochs = data.getEpoch();
+			OPI::Vector3* position = data.getPosition(OPI::DEVICE_HOST, true);
+			OPI::Vector3* velocity = data.getVelocity(OPI::DEVICE_HOST, true);
+
+			// minutes since the epoch of the element set
+			const Constants* table = constants.data();
+			auto minutes = [&](int object) {
+				const double day = julian_days ? julian_days[object] : julian_day;
+				return (day - table[object].elements.epoch) * 1440.0 + dt / 60.0;
+			};
+			auto store = [&](int object, const Batch& batch, int l) {
+				position[object].x = batch.x[l];
+				position[object].y = batch.y[l];
+				position[object].z = batch.z[l];
+				velocity[object].x = batch.vx[l];
+				velocity[object].y = batch.vy[l];
+				velocity[object].z = batch.vz[l];
+				epochs[object].current_epoch = (julian_days ? julian_days[object] : julian_day) + dt / 86400.0;
+			};
+
+			const int nearCount = static_cast<int>(nearList.size());
+			parallelRanges((nearCount + LANES - 1) / LANES, 256, [&](int begin, int end) {
+				Batch batch;
+				const Constants* objects[LANES];
+				double tsince[LANES];
+				for(int block = begin; block < end; ++block)
+				{
+					const int first = block * LANES;
+					const int lanes = std::min(LANES, nearCount - first);
+					// a partial batch repeats its last object
+					for(int l = 0; l < LANES; ++l)
+					{
+						const int object = nearList[first + std::min(l, lanes - 1)];
+						objects[l] = &table[object];
+						tsince[l] = minutes(object);
+					}
+					nearEarthSecular(objects, tsince, batch);
+					finishBatch(batch);
+					for(int l = 0; l < lanes; ++l)
+						store(nearList[first + l], batch, l);
+				}
+			});
+
+			const int deepCount = static_cast<int>(deepList.size());
+			parallelRanges((deepCount + LANES - 1) / LANES, 16, [&](int begin, int end) {
+				Batch batch;
+				for(int block = begin; block < end; ++block)
+				{
+					const int first = block * LANES;
+					const int lanes = std::min(LANES, deepCount - first);
+					for(int l = 0; l < lanes; ++l)
+					{
+						const int object = deepList[first + l];
+						deepSpaceObject(table[object], deepSpace[table[object].deepIndex], minutes(object), batch, l);
+					}
+					// a partial batch repeats its last object
+					for(int l = lanes; l < LANES; ++l)
+						copyLane(batch, lanes - 1, l);
+					finishBatch(batch);
+					for(int l = 0; l < lanes; ++l)
+						store(deepList[first + l], batch, l);
+				}
+			});
+
+			return OPI::SUCCESS;
+		}
+
+		std::vector<Constants> constants;
+		std::vector<DeepSpace> deepSpace;
+};
+
+#define OPI_IMPLEMENT_CPP_PROPAGATOR SGP4CPP
+
+#include "OPI/opi_implement_plugin.h"
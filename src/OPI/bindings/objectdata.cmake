@@ -6,6 +6,7 @@ BIND_CLASS( Population
   FUNCTION getPosition RETURN Vector3*
   FUNCTION getVelocity RETURN Vector3*
   FUNCTION getAcceleration RETURN Vector3*
+  FUNCTION getEpoch RETURN Epoch*
   FUNCTION getSize RETURN int
   FUNCTION update RETURN ErrorCode ARGS int type
 )
@@ -46,6 +46,14 @@ BEGIN_STRUCTURE( Vector3 )
   STRUCTURE_VARIABLE(double z)
 END_STRUCTURE( Vector3 )
 
+COMMENT("This type contains the epochs an object's state refers to")
+BEGIN_STRUCTURE( Epoch )
+  COMMENT("The epoch of the initial orbit or state as Julian date")
+  STRUCTURE_VARIABLE(double original_epoch)
+  COMMENT("The epoch of the current orbit or state as Julian date")
+  STRUCTURE_VARIABLE(double current_epoch)
+END_STRUCTURE( Epoch )
+
 COMMENT("This type represents a pair of two object indices")
 BEGIN_STRUCTURE( IndexPair )
   COMMENT("the first object")
@@ -54,6 +62,22 @@ BEGIN_STRUCTURE( IndexPair )
   STRUCTURE_VARIABLE(int object2)
 END_STRUCTURE( IndexPair )
 
+COMMENT("This type represents a range of consecutive object indices")
+BEGIN_STRUCTURE( IndexRange )
+  COMMENT("the first object of the range")
+  STRUCTURE_VARIABLE(int first)
+  COMMENT("the number of objects in the range")
+  STRUCTURE_VARIABLE(int count)
+END_STRUCTURE( IndexRange )
+
+COMMENT("This type identifies an object of a Population with enabled slot map")
+BEGIN_STRUCTURE( ObjectHandle )
+  COMMENT("the index of the object")
+  STRUCTURE_VARIABLE(int index)
+  COMMENT("the generation of the slot, incremented whenever the slot is freed or moved")
+  STRUCTURE_VARIABLE(int generation)
+END_STRUCTURE( ObjectHandle )
+
 COMMENT("This type contains all available object data values")
 BEGIN_ENUM(DataType)
   ENUM_VALUE(DATA_ORBIT 0)
@@ -62,8 +86,22 @@ BEGIN_ENUM(DataType)
   ENUM_VALUE(DATA_VELOCITY 3)
   ENUM_VALUE(DATA_ACCELERATION 4)
   ENUM_VALUE(DATA_BYTES 5)
+  ENUM_VALUE(DATA_EPOCH 6)
 END_ENUM(DataType)
 
+COMMENT("This type contains bit masks of object data values, one bit per DataType")
+BEGIN_ENUM_AS_INT(DataMask)
+  ENUM_VALUE(MASK_NONE 0)
+  ENUM_VALUE(MASK_ORBIT 1)
+  ENUM_VALUE(MASK_PROPERTIES 2)
+  ENUM_VALUE(MASK_CARTESIAN 4)
+  ENUM_VALUE(MASK_VELOCITY 8)
+  ENUM_VALUE(MASK_ACCELERATION 16)
+  ENUM_VALUE(MASK_BYTES 32)
+  ENUM_VALUE(MASK_EPOCH 64)
+  ENUM_VALUE(MASK_ALL 127)
+END_ENUM(DataMask)
+
 COMMENT("This type contains all available device types")
 BEGIN_ENUM_AS_INT(Device)
   ENUM_VALUE(DEVICE_NOT_SET -1)
@@ -103,6 +141,34 @@ BEGIN_ENUM(ReferenceFrame)
   ENUM_VALUE(REF_UNLISTED 100)
 END_ENUM(ReferenceFrame)
 
+COMMENT("This type defines how written files are flushed to the storage device")
+BEGIN_ENUM(FileSyncPolicy)
+  ENUM_VALUE(FILE_SYNC_NONE 0)
+  ENUM_VALUE(FILE_SYNC_DATA 1)
+  ENUM_VALUE(FILE_SYNC_FULL 2)
+END_ENUM(FileSyncPolicy)
+
+COMMENT("This type defines how large host memory blocks are distributed across NUMA nodes")
+BEGIN_ENUM(MemoryPlacement)
+  ENUM_VALUE(MEMORY_PLACEMENT_DEFAULT 0)
+  ENUM_VALUE(MEMORY_PLACEMENT_INTERLEAVED 1)
+  ENUM_VALUE(MEMORY_PLACEMENT_PARTITIONED 2)
+END_ENUM(MemoryPlacement)
+
+COMMENT("This type defines how a column is compressed when a Population is written to disk")
+BEGIN_ENUM(CompressionMode)
+  ENUM_VALUE(COMPRESSION_NONE 0)
+  ENUM_VALUE(COMPRESSION_LOSSLESS 1)
+  ENUM_VALUE(COMPRESSION_LOSSY 2)
+END_ENUM(CompressionMode)
+
+COMMENT("This type defines if Population::merge appends new and removes missing objects")
+BEGIN_ENUM(MergePolicy)
+  ENUM_VALUE(MERGE_UPDATE 0)
+  ENUM_VALUE(MERGE_UPSERT 1)
+  ENUM_VALUE(MERGE_REPLACE 2)
+END_ENUM(MergePolicy)
+
 COMMENT("This type contains all error values")
 BEGIN_ENUM(ErrorCode)
   ENUM_VALUE(SUCCESS 0)
@@ -115,6 +181,8 @@ BEGIN_ENUM(ErrorCode)
   ENUM_VALUE(INVALID_DEVICE 7)
   ENUM_VALUE(INVALID_PROPERTY 8)
   ENUM_VALUE(INCOMPATIBLE_TYPES 9)
+  ENUM_VALUE(FILE_NOT_FOUND 10)
+  ENUM_VALUE(INVALID_FILE_FORMAT 11)
   ENUM_VALUE(NOT_IMPLEMENTED 50)
   ENUM_VALUE(CUDA_REQUIRED 100)
   ENUM_VALUE(CUDA_OLDVERSION 101)
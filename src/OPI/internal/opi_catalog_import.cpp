@@ -0,0 +1,815 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_catalog_import.h"
+#include "opi_parallel.h"
+#include "../opi_population.h"
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	MappedFile::MappedFile():
+		data(0),
+		size(0)
+	{
+#ifdef WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = 0;
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& filename)
+	{
+		close();
+#ifdef WIN32
+		file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		if(!GetFileSizeEx(file, &fileSize))
+			return false;
+		size = fileSize.QuadPart;
+		// empty files cannot be mapped
+		if(size == 0)
+			return true;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(mapping)
+			data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		int handle = ::open(filename.c_str(), O_RDONLY);
+		if(handle < 0)
+			return false;
+		struct stat info;
+		if(fstat(handle, &info) != 0)
+		{
+			::close(handle);
+			return false;
+		}
+		size = info.st_size;
+		// empty files cannot be mapped
+		if(size == 0)
+		{
+			::close(handle);
+			return true;
+		}
+		void* address = mmap(0, size, PROT_READ, MAP_PRIVATE, handle, 0);
+		::close(handle);
+		if(address != MAP_FAILED)
+		{
+			data = static_cast<const char*>(address);
+			madvise(address, size, MADV_SEQUENTIAL);
+		}
+#endif
+		if(!data)
+			size = 0;
+		return data != 0;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef WIN32
+		if(data)
+			UnmapViewOfFile(data);
+		if(mapping)
+			CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		file = INVALID_HANDLE_VALUE;
+		mapping = 0;
+#else
+		if(data)
+			munmap(const_cast<char*>(data), size);
+#endif
+		data = 0;
+		size = 0;
+	}
+
+	const char* MappedFile::getData() const
+	{
+		return data;
+	}
+
+	long long MappedFile::getSize() const
+	{
+		return size;
+	}
+
+	namespace
+	{
+		const double PI = 3.14159265358979323846;
+		const double DEG_TO_RAD = PI / 180.0;
+		//! Gravitational parameter of the WGS-72 model used for TLE generation [km^3/s^2]
+		const double MU_WGS72 = 398600.8;
+		//! Reference air density of the SGP4 model divided by two [kg/m^2/ER]
+		const double BSTAR_DENSITY = 0.15696615 / 2.0;
+		//! Drag coefficient assumed when converting B* to an area to mass ratio
+		const double TLE_DRAG_COEFFICIENT = 2.2;
+
+		//! A line-aligned range [begin, end) of a text file
+		struct TextChunk
+		{
+			long long begin;
+			long long end;
+			//! Index of the first object parsed from this chunk
+			int first;
+			//! Number of objects in this chunk
+			int count;
+		};
+
+		//! A line of text without its line break
+		struct TextLine
+		{
+			const char* begin;
+			const char* end;
+			int length() const { return end - begin; }
+		};
+
+		//! Returns the line starting at position and moves position to the next line
+		TextLine nextLine(const char* text, long long end, long long& position)
+		{
+			TextLine line;
+			line.begin = text + position;
+			const char* lineBreak = static_cast<const char*>(memchr(line.begin, '\n', end - position));
+			line.end = lineBreak ? lineBreak : text + end;
+			position = lineBreak ? lineBreak - text + 1 : end;
+			if(line.end > line.begin && line.end[-1] == '\r')
+				line.end--;
+			return line;
+		}
+
+		//! Splits [begin, end) into at most count chunks that start at the beginning of a line
+		std::vector<TextChunk> splitLines(const char* text, long long begin, long long end, int count)
+		{
+			std::vector<TextChunk> chunks;
+			long long position = begin;
+			for(int i = 1; i <= count && position < end; ++i)
+			{
+				long long target = std::max(position, begin + (end - begin) * i / count);
+				long long next = end;
+				if(i < count && target < end)
+				{
+					const char* lineBreak = static_cast<const char*>(memchr(text + target, '\n', end - target));
+					if(lineBreak)
+						next = lineBreak - text + 1;
+				}
+				TextChunk chunk;
+				chunk.begin = position;
+				chunk.end = next;
+				chunk.first = 0;
+				chunk.count = 0;
+				chunks.push_back(chunk);
+				position = next;
+			}
+			return chunks;
+		}
+
+		//! Runs func(chunk) for all chunks in parallel
+		template<class Function>
+		void forEachChunk(std::vector<TextChunk>& chunks, Function func)
+		{
+			parallelFor(0, chunks.size(), 1, [&chunks, &func](int begin, int end) {
+				for(int i = begin; i < end; ++i)
+					func(chunks[i]);
+			});
+		}
+
+		//! Assigns the index of the first object to every chunk and returns the total number of objects
+		int assignObjectIndices(std::vector<TextChunk>& chunks)
+		{
+			int total = 0;
+			for(size_t i = 0; i < chunks.size(); ++i)
+			{
+				chunks[i].first = total;
+				total += chunks[i].count;
+			}
+			return total;
+		}
+
+		//! Remembers the smallest file position at which an error occurred
+		void reportError(std::atomic<long long>& errorPosition, long long position)
+		{
+			long long current = errorPosition.load();
+			while(position < current && !errorPosition.compare_exchange_weak(current, position));
+		}
+
+		//! Returns the line number (starting at one) of a file position
+		long long lineNumber(const char* text, long long position)
+		{
+			long long line = 1;
+			for(long long i = 0; i < position; ++i)
+			{
+				if(text[i] == '\n')
+					line++;
+			}
+			return line;
+		}
+
+		//! Parses an unsigned decimal integer made of digits only
+		bool parseDigits(const char* begin, const char* end, long long& value)
+		{
+			if(begin == end || end - begin > 18)
+				return false;
+			value = 0;
+			for(const char* c = begin; c < end; ++c)
+			{
+				if(*c < '0' || *c > '9')
+					return false;
+				value = value * 10 + (*c - '0');
+			}
+			return true;
+		}
+
+		//! Parses a decimal number surrounded by optional spaces
+		/**
+		 * Numbers with up to 15 significant digits and a decimal exponent of at most 22 are
+		 * converted exactly by a single multiplication or division with a power of ten. All
+		 * other numbers are passed to strtod.
+		 */
+		bool parseNumber(const char* begin, const char* end, double& value)
+		{
+			static const double powers[] = {
+				1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+			};
+			while(begin < end && *begin == ' ') begin++;
+			while(end > begin && end[-1] == ' ') end--;
+			const char* c = begin;
+			bool negative = false;
+			if(c < end && (*c == '-' || *c == '+'))
+				negative = (*c++ == '-');
+
+			unsigned long long mantissa = 0;
+			int significant = 0;
+			int exponent = 0;
+			bool hasDigits = false;
+			for(; c < end && *c >= '0' && *c <= '9'; ++c)
+			{
+				hasDigits = true;
+				if(mantissa == 0 && *c == '0')
+					continue;
+				if(significant < 19)
+				{
+					mantissa = mantissa * 10 + (*c - '0');
+					significant++;
+				}
+				else exponent++;
+			}
+			if(c < end && *c == '.')
+			{
+				for(++c; c < end && *c >= '0' && *c <= '9'; ++c)
+				{
+					hasDigits = true;
+					if(mantissa == 0 && *c == '0')
+					{
+						exponent--;
+						continue;
+					}
+					if(significant < 19)
+					{
+						mantissa = mantissa * 10 + (*c - '0');
+						significant++;
+						exponent--;
+					}
+				}
+			}
+			if(!hasDigits)
+				return false;
+			if(c < end && (*c == 'e' || *c == 'E'))
+			{
+				++c;
+				bool negativeExponent = false;
+				if(c < end && (*c == '-' || *c == '+'))
+					negativeExponent = (*c++ == '-');
+				long long explicitExponent;
+				const char* digits = c;
+				while(c < end && *c >= '0' && *c <= '9') ++c;
+				if(!parseDigits(digits, c, explicitExponent) || explicitExponent > 100000)
+					return false;
+				exponent += negativeExponent ? -(int)explicitExponent : (int)explicitExponent;
+			}
+			if(c != end)
+				return false;
+
+			if(significant <= 15 && exponent >= -22 && exponent <= 22)
+			{
+				value = (double)mantissa;
+				value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+			}
+			else {
+				char buffer[64];
+				int length = std::min((int)(end - begin), 63);
+				memcpy(buffer, begin, length);
+				buffer[length] = 0;
+				value = fabs(strtod(buffer, 0));
+			}
+			if(negative)
+				value = -value;
+			return true;
+		}
+
+		//! Parses a signed integer surrounded by optional spaces
+		bool parseInteger(const char* begin, const char* end, int& value)
+		{
+			while(begin < end && *begin == ' ') begin++;
+			while(end > begin && end[-1] == ' ') end--;
+			bool negative = false;
+			if(begin < end && (*begin == '-' || *begin == '+'))
+				negative = (*begin++ == '-');
+			long long result;
+			if(!parseDigits(begin, end, result) || result > INT_MAX)
+				return false;
+			value = negative ? -(int)result : (int)result;
+			return true;
+		}
+
+		//! Returns the Julian date of the given day of year (starting at 1.0 for January 1st, 0h)
+		double julianDate(int year, double dayOfYear)
+		{
+			// Julian date of January 0th, 0h
+			double january0 = 367.0 * year - floor(7.0 * year / 4.0) + 30.0 + 1721013.5;
+			return january0 + dayOfYear;
+		}
+
+		bool isTLELine1(const TextLine& line)
+		{
+			return line.length() >= 61 && line.begin[0] == '1' && line.begin[1] == ' ';
+		}
+
+		bool isTLELine2(const TextLine& line)
+		{
+			return line.length() >= 63 && line.begin[0] == '2' && line.begin[1] == ' ';
+		}
+
+		//! Parses the catalog number, which may use the alpha-5 scheme for numbers above 99999
+		bool parseCatalogNumber(const char* begin, const char* end, int& id)
+		{
+			while(begin < end && *begin == ' ') begin++;
+			if(begin < end && *begin >= 'A' && *begin <= 'Z' && *begin != 'I' && *begin != 'O')
+			{
+				// A = 10, ..., H = 17, J = 18, ..., N = 22, P = 23, ..., Z = 33
+				int prefix = *begin - 'A' + 10;
+				if(*begin > 'I') prefix--;
+				if(*begin > 'O') prefix--;
+				long long rest;
+				if(!parseDigits(begin + 1, end, rest))
+					return false;
+				id = prefix * 10000 + (int)rest;
+				return true;
+			}
+			return parseInteger(begin, end, id);
+		}
+
+		//! Parses a number in the TLE exponential notation (e.g. " 12345-4" = 0.12345e-4)
+		bool parseTLEExponential(const char* begin, double& value)
+		{
+			// sign, five digits with implied leading decimal point, exponent sign, exponent digit
+			long long mantissa, exponent;
+			const char* digits = begin + 1;
+			while(digits < begin + 6 && *digits == ' ') digits++;
+			if(digits == begin + 6)
+				mantissa = 0;
+			else if(!parseDigits(digits, begin + 6, mantissa))
+				return false;
+			if(!parseDigits(begin + 7, begin + 8, exponent))
+				return false;
+			value = mantissa * 1e-5 * pow(10.0, (begin[6] == '-') ? -exponent : exponent);
+			if(begin[0] == '-')
+				value = -value;
+			return true;
+		}
+
+		//! Returns the name line preceding the line that starts at position, if any
+		bool findNameLine(const char* text, long long position, TextLine& name)
+		{
+			if(position == 0)
+				return false;
+			long long start = position - 1;
+			while(start > 0 && text[start - 1] != '\n')
+				start--;
+			long long next = start;
+			name = nextLine(text, position, next);
+			if(isTLELine1(name) || isTLELine2(name))
+				return false;
+			if(name.length() >= 2 && name.begin[0] == '0' && name.begin[1] == ' ')
+				name.begin += 2;
+			while(name.end > name.begin && (name.end[-1] == ' ' || name.end[-1] == '\t'))
+				name.end--;
+			while(name.begin < name.end && name.begin[0] == ' ')
+				name.begin++;
+			return name.length() > 0;
+		}
+
+		//! Calls func(line1, line2, position of line 1) for every TLE starting in the chunk
+		template<class Function>
+		void forEachTLE(const char* text, long long size, const TextChunk& chunk, Function func)
+		{
+			long long position = chunk.begin;
+			while(position < chunk.end)
+			{
+				long long lineStart = position;
+				TextLine line1 = nextLine(text, size, position);
+				if(!isTLELine1(line1) || position >= size)
+					continue;
+				long long next = position;
+				TextLine line2 = nextLine(text, size, next);
+				if(!isTLELine2(line2))
+					continue;
+				func(line1, line2, lineStart);
+				position = next;
+			}
+		}
+
+		//! Converts one TLE, returns false if a field is malformed
+		/**
+		 * The mean motion is converted to a semi-major axis using the WGS-72 gravitational
+		 * parameter. B* is stored as an area to mass ratio for a drag coefficient of 2.2
+		 * using the SGP4 reference density, i.e. area_to_mass * 2.2 = 12.741621 * B*.
+		 */
+		bool parseTLE(const TextLine& line1, const TextLine& line2, Orbit& orbit, ObjectProperties& properties, Epoch& epoch)
+		{
+			const char* l1 = line1.begin;
+			const char* l2 = line2.begin;
+			int id, year;
+			long long eccentricity;
+			double dayOfYear, bstar, inclination, raan, argOfPerigee, meanAnomaly, meanMotion;
+			if(!parseCatalogNumber(l1 + 2, l1 + 7, id)
+				|| !parseInteger(l1 + 18, l1 + 20, year)
+				|| !parseNumber(l1 + 20, l1 + 32, dayOfYear)
+				|| !parseTLEExponential(l1 + 53, bstar)
+				|| !parseNumber(l2 + 8, l2 + 16, inclination)
+				|| !parseNumber(l2 + 17, l2 + 25, raan)
+				|| !parseDigits(l2 + 26, l2 + 33, eccentricity)
+				|| !parseNumber(l2 + 34, l2 + 42, argOfPerigee)
+				|| !parseNumber(l2 + 43, l2 + 51, meanAnomaly)
+				|| !parseNumber(l2 + 52, l2 + 63, meanMotion)
+				|| meanMotion <= 0.0)
+				return false;
+
+			double n = meanMotion * 2.0 * PI / 86400.0;
+			orbit.semi_major_axis = cbrt(MU_WGS72 / (n * n));
+			orbit.eccentricity = eccentricity / 1e7;
+			orbit.inclination = inclination * DEG_TO_RAD;
+			orbit.raan = raan * DEG_TO_RAD;
+			orbit.arg_of_perigee = argOfPerigee * DEG_TO_RAD;
+			orbit.mean_anomaly = meanAnomaly * DEG_TO_RAD;
+			orbit.bol = 0.0;
+			orbit.eol = 0.0;
+
+			properties.mass = 0.0;
+			properties.diameter = 0.0;
+			properties.area_to_mass = bstar / (BSTAR_DENSITY * TLE_DRAG_COEFFICIENT);
+			properties.drag_coefficient = TLE_DRAG_COEFFICIENT;
+			properties.reflectivity = 0.0;
+			properties.id = id;
+
+			// two-digit years from 57 to 99 belong to the 20th century
+			year += (year < 57) ? 2000 : 1900;
+			epoch.original_epoch = julianDate(year, dayOfYear);
+			epoch.current_epoch = epoch.original_epoch;
+			return true;
+		}
+
+		//! Columns that can be read from CSV files
+		enum CSVField
+		{
+			CSV_IGNORED,
+			CSV_ID,
+			CSV_NAME,
+			CSV_EPOCH,
+			CSV_ORIGINAL_EPOCH,
+			CSV_CURRENT_EPOCH,
+			CSV_SEMI_MAJOR_AXIS,
+			CSV_ECCENTRICITY,
+			CSV_INCLINATION,
+			CSV_RAAN,
+			CSV_ARG_OF_PERIGEE,
+			CSV_MEAN_ANOMALY,
+			CSV_BOL,
+			CSV_EOL,
+			CSV_MASS,
+			CSV_DIAMETER,
+			CSV_AREA_TO_MASS,
+			CSV_DRAG_COEFFICIENT,
+			CSV_REFLECTIVITY,
+			CSV_X,
+			CSV_Y,
+			CSV_Z,
+			CSV_VX,
+			CSV_VY,
+			CSV_VZ
+		};
+
+		CSVField getCSVField(const std::string& name)
+		{
+			static const char* names[] = {
+				"", "id", "name", "epoch", "original_epoch", "current_epoch",
+				"semi_major_axis", "eccentricity", "inclination", "raan", "arg_of_perigee",
+				"mean_anomaly", "bol", "eol", "mass", "diameter", "area_to_mass",
+				"drag_coefficient", "reflectivity", "x", "y", "z", "vx", "vy", "vz"
+			};
+			for(int i = 1; i <= CSV_VZ; ++i)
+			{
+				if(name == names[i])
+					return static_cast<CSVField>(i);
+			}
+			return CSV_IGNORED;
+		}
+
+		//! Returns the next comma-separated field of a line, removing quotes
+		bool nextField(const char*& position, const char* end, TextLine& field)
+		{
+			if(position > end)
+				return false;
+			while(position < end && *position == ' ') position++;
+			if(position < end && *position == '"')
+			{
+				// quoted fields may contain commas, doubled quotes are not unescaped
+				field.begin = ++position;
+				const char* quote = position;
+				while(quote < end && !(quote[0] == '"' && (quote + 1 == end || quote[1] != '"')))
+					quote += (quote[0] == '"') ? 2 : 1;
+				field.end = std::min(quote, end);
+				position = std::min(quote + 1, end);
+				while(position < end && *position != ',') position++;
+			}
+			else {
+				field.begin = position;
+				while(position < end && *position != ',') position++;
+				field.end = position;
+				while(field.end > field.begin && field.end[-1] == ' ') field.end--;
+			}
+			// skip the separator, position is beyond end after the last field
+			position++;
+			return true;
+		}
+
+		bool isCSVRecord(const TextLine& line)
+		{
+			const char* c = line.begin;
+			while(c < line.end && (*c == ' ' || *c == '\t')) c++;
+			return c < line.end && *c != '#';
+		}
+
+		//! Parses one CSV line into the given objects, returns false if a field is malformed
+		bool parseCSVRecord(const TextLine& line, const std::vector<CSVField>& fields, Orbit& orbit,
+							ObjectProperties& properties, Vector3& position, Vector3& velocity, Epoch& epoch, std::string& name)
+		{
+			const char* c = line.begin;
+			for(size_t i = 0; i < fields.size(); ++i)
+			{
+				TextLine field;
+				if(!nextField(c, line.end, field))
+					return false;
+				if(fields[i] == CSV_IGNORED)
+					continue;
+				if(fields[i] == CSV_NAME)
+				{
+					name.assign(field.begin, field.end);
+					continue;
+				}
+				// empty fields keep their default value of zero
+				if(field.length() == 0)
+					continue;
+				if(fields[i] == CSV_ID)
+				{
+					if(!parseInteger(field.begin, field.end, properties.id))
+						return false;
+					continue;
+				}
+				double value;
+				if(!parseNumber(field.begin, field.end, value))
+					return false;
+				switch(fields[i])
+				{
+					case CSV_EPOCH: epoch.original_epoch = value; epoch.current_epoch = value; break;
+					case CSV_ORIGINAL_EPOCH: epoch.original_epoch = value; break;
+					case CSV_CURRENT_EPOCH: epoch.current_epoch = value; break;
+					case CSV_SEMI_MAJOR_AXIS: orbit.semi_major_axis = value; break;
+					case CSV_ECCENTRICITY: orbit.eccentricity = value; break;
+					case CSV_INCLINATION: orbit.inclination = value; break;
+					case CSV_RAAN: orbit.raan = value; break;
+					case CSV_ARG_OF_PERIGEE: orbit.arg_of_perigee = value; break;
+					case CSV_MEAN_ANOMALY: orbit.mean_anomaly = value; break;
+					case CSV_BOL: orbit.bol = value; break;
+					case CSV_EOL: orbit.eol = value; break;
+					case CSV_MASS: properties.mass = value; break;
+					case CSV_DIAMETER: properties.diameter = value; break;
+					case CSV_AREA_TO_MASS: properties.area_to_mass = value; break;
+					case CSV_DRAG_COEFFICIENT: properties.drag_coefficient = value; break;
+					case CSV_REFLECTIVITY: properties.reflectivity = value; break;
+					case CSV_X: position.x = value; break;
+					case CSV_Y: position.y = value; break;
+					case CSV_Z: position.z = value; break;
+					case CSV_VX: velocity.x = value; break;
+					case CSV_VY: velocity.y = value; break;
+					case CSV_VZ: velocity.z = value; break;
+					default: break;
+				}
+			}
+			// surplus fields are not allowed
+			return c > line.end;
+		}
+	}
+
+	/**
+	 * \detail
+	 * The file is split into line-aligned chunks that are processed in two parallel passes.
+	 * The first pass counts the element sets per chunk, which determines the index of the
+	 * first object of every chunk. After the Population has been resized, the second pass
+	 * converts the element sets directly into the Population's host memory. A TLE belongs
+	 * to the chunk containing its first line, the second line and the optional name line
+	 * may be part of a neighbouring chunk.
+	 */
+	ErrorCode importTLECatalog(Population& population, const std::string& filename)
+	{
+		MappedFile file;
+		if(!file.open(filename))
+			return FILE_NOT_FOUND;
+		const char* text = file.getData();
+		long long size = file.getSize();
+
+		std::vector<TextChunk> chunks = splitLines(text, 0, size, 4 * getWorkerCount());
+		forEachChunk(chunks, [text, size](TextChunk& chunk) {
+			forEachTLE(text, size, chunk, [&chunk](const TextLine&, const TextLine&, long long) {
+				chunk.count++;
+			});
+		});
+		int count = assignObjectIndices(chunks);
+
+		population.resize(count, population.getByteArraySize());
+		Orbit* orbit = population.getOrbit(DEVICE_HOST, true);
+		ObjectProperties* properties = population.getObjectProperties(DEVICE_HOST, true);
+		Epoch* epoch = population.getEpoch(DEVICE_HOST, true);
+		std::atomic<long long> errorPosition(LLONG_MAX);
+		forEachChunk(chunks, [text, size, orbit, properties, epoch, &population, &errorPosition](TextChunk& chunk) {
+			int index = chunk.first;
+			forEachTLE(text, size, chunk, [text, &index, orbit, properties, epoch, &population, &errorPosition](const TextLine& line1, const TextLine& line2, long long position) {
+				if(!parseTLE(line1, line2, orbit[index], properties[index], epoch[index]))
+					reportError(errorPosition, position);
+				TextLine name;
+				population.setObjectName(index, findNameLine(text, position, name) ? std::string(name.begin, name.end) : std::string());
+				index++;
+			});
+		});
+		population.update(DATA_ORBIT);
+		population.update(DATA_PROPERTIES);
+		population.update(DATA_EPOCH);
+
+		if(errorPosition != LLONG_MAX)
+		{
+			std::cout << "Invalid TLE in line " << lineNumber(text, errorPosition) << " of " << filename << std::endl;
+			return INVALID_FILE_FORMAT;
+		}
+		return SUCCESS;
+	}
+
+	/**
+	 * \detail
+	 * The first non-empty line must contain the column names. Columns are matched by name to
+	 * the members of Orbit, ObjectProperties and Epoch, to "x", "y", "z" for the position and
+	 * "vx", "vy", "vz" for the velocity, "epoch" (which sets both epochs) and "name". Other
+	 * columns are ignored. Values are stored as they are, without unit conversion. Lines
+	 * starting with '#' are skipped. Like TLE files, the data lines are parsed in parallel
+	 * in two passes.
+	 */
+	ErrorCode importCSVCatalog(Population& population, const std::string& filename)
+	{
+		MappedFile file;
+		if(!file.open(filename))
+			return FILE_NOT_FOUND;
+		const char* text = file.getData();
+		long long size = file.getSize();
+
+		// read the header
+		long long position = 0;
+		TextLine header;
+		header.begin = header.end = text;
+		while(position < size)
+		{
+			TextLine line = nextLine(text, size, position);
+			if(isCSVRecord(line))
+			{
+				header = line;
+				break;
+			}
+		}
+		std::vector<CSVField> fields;
+		bool columns[DATA_EPOCH + 1] = { false };
+		bool hasNames = false;
+		const char* c = header.begin;
+		TextLine field;
+		while(header.length() > 0 && nextField(c, header.end, field))
+		{
+			CSVField type = getCSVField(std::string(field.begin, field.end));
+			fields.push_back(type);
+			if(type == CSV_NAME) hasNames = true;
+			else if(type == CSV_ID || (type >= CSV_MASS && type <= CSV_REFLECTIVITY)) columns[DATA_PROPERTIES] = true;
+			else if(type >= CSV_EPOCH && type <= CSV_CURRENT_EPOCH) columns[DATA_EPOCH] = true;
+			else if(type >= CSV_SEMI_MAJOR_AXIS && type <= CSV_EOL) columns[DATA_ORBIT] = true;
+			else if(type >= CSV_X && type <= CSV_Z) columns[DATA_CARTESIAN] = true;
+			else if(type >= CSV_VX && type <= CSV_VZ) columns[DATA_VELOCITY] = true;
+		}
+		if(fields.empty())
+		{
+			std::cout << filename << " does not contain a CSV header." << std::endl;
+			return INVALID_FILE_FORMAT;
+		}
+
+		std::vector<TextChunk> chunks = splitLines(text, position, size, 4 * getWorkerCount());
+		forEachChunk(chunks, [text](TextChunk& chunk) {
+			long long position = chunk.begin;
+			while(position < chunk.end)
+			{
+				if(isCSVRecord(nextLine(text, chunk.end, position)))
+					chunk.count++;
+			}
+		});
+		int count = assignObjectIndices(chunks);
+
+		population.resize(count, population.getByteArraySize());
+		// columns that are not in the file stay unallocated
+		Orbit* orbit = columns[DATA_ORBIT] ? population.getOrbit(DEVICE_HOST, true) : 0;
+		ObjectProperties* properties = columns[DATA_PROPERTIES] ? population.getObjectProperties(DEVICE_HOST, true) : 0;
+		Vector3* positions = columns[DATA_CARTESIAN] ? population.getPosition(DEVICE_HOST, true) : 0;
+		Vector3* velocities = columns[DATA_VELOCITY] ? population.getVelocity(DEVICE_HOST, true) : 0;
+		Epoch* epoch = columns[DATA_EPOCH] ? population.getEpoch(DEVICE_HOST, true) : 0;
+		std::atomic<long long> errorPosition(LLONG_MAX);
+		const bool* stored = columns;
+		forEachChunk(chunks, [&](TextChunk& chunk) {
+			int index = chunk.first;
+			long long position = chunk.begin;
+			while(position < chunk.end)
+			{
+				long long lineStart = position;
+				TextLine line = nextLine(text, chunk.end, position);
+				if(!isCSVRecord(line))
+					continue;
+				Orbit o(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+				ObjectProperties p(0.0, 0.0, 0.0, 0.0, 0.0, 0);
+				Vector3 x(0.0, 0.0, 0.0);
+				Vector3 v(0.0, 0.0, 0.0);
+				Epoch e(0.0, 0.0);
+				std::string name;
+				if(!parseCSVRecord(line, fields, o, p, x, v, e, name))
+					reportError(errorPosition, lineStart);
+				if(stored[DATA_ORBIT]) orbit[index] = o;
+				if(stored[DATA_PROPERTIES]) properties[index] = p;
+				if(stored[DATA_CARTESIAN]) positions[index] = x;
+				if(stored[DATA_VELOCITY]) velocities[index] = v;
+				if(stored[DATA_EPOCH]) epoch[index] = e;
+				if(hasNames) population.setObjectName(index, name);
+				index++;
+			}
+		});
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(columns[type])
+				population.update(type);
+		}
+
+		if(errorPosition != LLONG_MAX)
+		{
+			std::cout << "Invalid CSV record in line " << lineNumber(text, errorPosition) << " of " << filename << std::endl;
+			return INVALID_FILE_FORMAT;
+		}
+		return SUCCESS;
+	}
+
+	/**
+	 * \endcond
+	 */
+}
@@ -0,0 +1,66 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_CATALOG_IMPORT_H
+#define OPI_CATALOG_IMPORT_H
+#include "../opi_error.h"
+#include <string>
+namespace OPI
+{
+	class Population;
+
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! A read-only memory mapping of a complete file
+	class MappedFile
+	{
+		public:
+			MappedFile();
+			~MappedFile();
+
+			//! Maps the given file into memory
+			bool open(const std::string& filename);
+			//! Removes the mapping
+			void close();
+
+			//! Returns the file contents
+			const char* getData() const;
+			//! Returns the size of the file in bytes
+			long long getSize() const;
+
+		private:
+			const char* data;
+			long long size;
+#ifdef WIN32
+			void* file;
+			void* mapping;
+#endif
+	};
+
+	//! Reads a catalog of two-line element sets into a Population
+	ErrorCode importTLECatalog(Population& population, const std::string& filename);
+
+	//! Reads a catalog in CSV format into a Population
+	ErrorCode importCSVCatalog(Population& population, const std::string& filename);
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
@@ -0,0 +1,249 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_compression.h"
+#include <algorithm>
+#include <cstring>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace
+	{
+		const int minMatch = 4;
+		const int hashBits = 14;
+		const long long maxOffset = 65535;
+
+		inline unsigned int read32(const unsigned char* data)
+		{
+			unsigned int value;
+			memcpy(&value, data, sizeof(unsigned int));
+			return value;
+		}
+
+		inline unsigned int hashValue(unsigned int value)
+		{
+			return (value * 2654435761u) >> (32 - hashBits);
+		}
+
+		// lengths of 15 and more are continued in additional bytes
+		void appendLength(std::vector<char>& dest, long long length)
+		{
+			while(length >= 255)
+			{
+				dest.push_back((char)255);
+				length -= 255;
+			}
+			dest.push_back((char)length);
+		}
+
+		bool readLength(const unsigned char*& in, const unsigned char* end, long long& length)
+		{
+			int value;
+			do {
+				if(in == end)
+					return false;
+				value = *in++;
+				length += value;
+			} while(value == 255);
+			return true;
+		}
+
+		// a sequence is a token, the literals and an optional match, matchLength 0 ends the stream
+		void appendSequence(std::vector<char>& dest, const unsigned char* literals, long long literalLength, int offset, long long matchLength)
+		{
+			long long matchCode = (matchLength > 0) ? matchLength - minMatch : 0;
+			dest.push_back((char)((std::min(literalLength, 15LL) << 4) | std::min(matchCode, 15LL)));
+			if(literalLength >= 15)
+				appendLength(dest, literalLength - 15);
+			dest.insert(dest.end(), literals, literals + literalLength);
+			if(matchLength > 0)
+			{
+				dest.push_back((char)(offset & 0xff));
+				dest.push_back((char)(offset >> 8));
+				if(matchCode >= 15)
+					appendLength(dest, matchCode - 15);
+			}
+		}
+	}
+
+	void shuffleBytes(const char* source, int entrySize, int count, char* dest)
+	{
+		for(int i = 0; i < count; ++i)
+		{
+			const char* entry = source + (long long)i * entrySize;
+			for(int j = 0; j < entrySize; ++j)
+				dest[(long long)j * count + i] = entry[j];
+		}
+	}
+
+	void unshuffleBytes(const char* source, int entrySize, int count, int first, int last, char* dest)
+	{
+		for(int i = first; i < last; ++i)
+		{
+			char* entry = dest + (long long)(i - first) * entrySize;
+			for(int j = 0; j < entrySize; ++j)
+				entry[j] = source[(long long)j * count + i];
+		}
+	}
+
+	/**
+	 * \detail
+	 * Values are rounded to nearest. Infinite values and NaN are left untouched, as are values
+	 * that would overflow to infinity when rounded up.
+	 */
+	void truncateMantissa(char* data, int entrySize, int count, int doubleCount, int mantissaBits)
+	{
+		int dropped = 52 - std::max(0, mantissaBits);
+		doubleCount = std::min(doubleCount, entrySize / (int)sizeof(double));
+		if(dropped <= 0 || doubleCount <= 0)
+			return;
+		const unsigned long long exponentMask = 0x7ffULL << 52;
+		const unsigned long long mask = ~((1ULL << dropped) - 1);
+		const unsigned long long half = 1ULL << (dropped - 1);
+		for(int i = 0; i < count; ++i)
+		{
+			char* entry = data + (long long)i * entrySize;
+			for(int k = 0; k < doubleCount; ++k)
+			{
+				unsigned long long value;
+				memcpy(&value, entry + k * sizeof(double), sizeof(double));
+				if((value & exponentMask) == exponentMask)
+					continue;
+				unsigned long long rounded = (value + half) & mask;
+				if((rounded & exponentMask) == exponentMask)
+					rounded = value & mask;
+				memcpy(entry + k * sizeof(double), &rounded, sizeof(double));
+			}
+		}
+	}
+
+	/**
+	 * \detail
+	 * The format follows the LZ4 block format: every sequence starts with a token holding the
+	 * number of literals in the upper and the match length minus four in the lower four bits,
+	 * followed by the literals, a 16 bit little endian match offset and the extended match
+	 * length. Matches are found with a single-entry hash table over four-byte sequences.
+	 * Positions are skipped faster in incompressible regions.
+	 */
+	void blockCompress(const char* source, long long size, std::vector<char>& dest)
+	{
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+		std::vector<long long> table(1 << hashBits, -1);
+		long long anchor = 0;
+		long long i = 0;
+		while(i + minMatch <= size)
+		{
+			unsigned int value = read32(in + i);
+			unsigned int hash = hashValue(value);
+			long long candidate = table[hash];
+			table[hash] = i;
+			if(candidate >= 0 && i - candidate <= maxOffset && read32(in + candidate) == value)
+			{
+				long long length = minMatch;
+				while(i + length < size && in[candidate + length] == in[i + length])
+					++length;
+				appendSequence(dest, in + anchor, i - anchor, (int)(i - candidate), length);
+				i += length;
+				anchor = i;
+			}
+			else i += 1 + ((i - anchor) >> 8);
+		}
+		appendSequence(dest, in + anchor, size - anchor, 0, 0);
+	}
+
+	bool blockDecompress(const char* source, long long size, char* dest, long long destSize)
+	{
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+		const unsigned char* end = in + size;
+		long long out = 0;
+		while(in < end)
+		{
+			int token = *in++;
+			long long literals = token >> 4;
+			if(literals == 15 && !readLength(in, end, literals))
+				return false;
+			if(literals > end - in || literals > destSize - out)
+				return false;
+			memcpy(dest + out, in, literals);
+			in += literals;
+			out += literals;
+			if(in == end)
+				break;
+
+			if(end - in < 2)
+				return false;
+			long long offset = in[0] | (in[1] << 8);
+			in += 2;
+			long long length = token & 15;
+			if(length == 15 && !readLength(in, end, length))
+				return false;
+			length += minMatch;
+			if(offset == 0 || offset > out || length > destSize - out)
+				return false;
+			if(offset >= length)
+				memcpy(dest + out, dest + out - offset, length);
+			else {
+				// overlapping matches repeat the last offset bytes
+				for(long long k = 0; k < length; ++k)
+					dest[out + k] = dest[out - offset + k];
+			}
+			out += length;
+		}
+		return out == destSize;
+	}
+
+	bool encodeBlock(const char* source, int entrySize, int count, const ColumnCompression& compression,
+					 std::vector<char>& dest, std::vector<char>& scratch)
+	{
+		long long size = (long long)entrySize * count;
+		dest.clear();
+		if(compression.mode == COMPRESSION_NONE || size == 0)
+			return false;
+		if(compression.mode == COMPRESSION_LOSSY && compression.doubleCount > 0)
+		{
+			// round a copy of the data and shuffle it to the first half of the scratch buffer
+			scratch.resize(2 * size);
+			memcpy(&scratch[size], source, size);
+			truncateMantissa(&scratch[size], entrySize, count, compression.doubleCount, compression.mantissaBits);
+			shuffleBytes(&scratch[size], entrySize, count, &scratch[0]);
+		}
+		else {
+			scratch.resize(size);
+			shuffleBytes(source, entrySize, count, &scratch[0]);
+		}
+		blockCompress(&scratch[0], size, dest);
+		return (long long)dest.size() < size;
+	}
+
+	bool decodeBlock(const char* source, long long size, int entrySize, int count, int first, int last,
+					 char* dest, std::vector<char>& scratch)
+	{
+		long long decodedSize = (long long)entrySize * count;
+		if(decodedSize == 0)
+			return true;
+		scratch.resize(decodedSize);
+		if(!blockDecompress(source, size, &scratch[0], decodedSize))
+			return false;
+		unshuffleBytes(&scratch[0], entrySize, count, first, last, dest);
+		return true;
+	}
+
+	/**
+	 * \endcond
+	 */
+}
@@ -0,0 +1,82 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_COMPRESSION_H
+#define OPI_COMPRESSION_H
+#include "../opi_common.h"
+#include "../opi_datatypes.h"
+#include <vector>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Block encoding: the payload is stored as is
+	const int BLOCK_ENCODING_RAW = 0;
+	//! Block encoding: the entries are byte-shuffled and compressed with blockCompress()
+	const int BLOCK_ENCODING_SHUFFLE_LZ = 1;
+
+	//! Describes how the entries of a column are compressed
+	struct ColumnCompression
+	{
+		ColumnCompression(CompressionMode _mode = COMPRESSION_NONE, int _mantissaBits = 52, int _doubleCount = 0):
+			mode(_mode),
+			mantissaBits(_mantissaBits),
+			doubleCount(_doubleCount)
+		{
+		}
+
+		//! The compression mode
+		CompressionMode mode;
+		//! Number of mantissa bits kept by lossy compression
+		int mantissaBits;
+		//! Number of doubles at the beginning of each entry that may be truncated
+		int doubleCount;
+	};
+
+	//! Transposes count entries of entrySize bytes so that byte j of entry i is stored at dest[j * count + i]
+	void shuffleBytes(const char* source, int entrySize, int count, char* dest);
+
+	//! Restores the entries [first, last) from shuffled data holding count entries
+	void unshuffleBytes(const char* source, int entrySize, int count, int first, int last, char* dest);
+
+	//! Rounds the first doubleCount doubles of every entry to the given number of mantissa bits
+	void truncateMantissa(char* data, int entrySize, int count, int doubleCount, int mantissaBits);
+
+	//! Appends the LZ-compressed representation of size bytes to dest
+	void blockCompress(const char* source, long long size, std::vector<char>& dest);
+
+	//! Decompresses data created by blockCompress, returns false if the data is corrupt
+	bool blockDecompress(const char* source, long long size, char* dest, long long destSize);
+
+	//! Encodes a block of count entries, returns false if the encoded block would not be smaller
+	/**
+	 * The scratch buffer is used for intermediate results and can be reused between calls.
+	 */
+	bool encodeBlock(const char* source, int entrySize, int count, const ColumnCompression& compression,
+					 std::vector<char>& dest, std::vector<char>& scratch);
+
+	//! Decodes the entries [first, last) of an encoded block of count entries to dest
+	bool decodeBlock(const char* source, long long size, int entrySize, int count, int first, int last,
+					 char* dest, std::vector<char>& scratch);
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
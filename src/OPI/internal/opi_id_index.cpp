@@ -0,0 +1,103 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_id_index.h"
+#include <algorithm>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	IdIndex::IdIndex():
+		mask(0)
+	{
+	}
+
+	void IdIndex::build(const ObjectProperties* properties, int count, const unsigned long long* valid)
+	{
+		// at least twice as many slots as objects, rounded up to a power of two
+		unsigned int capacity = 16;
+		while(capacity < 2u * (unsigned int)count)
+			capacity *= 2;
+		Slot empty;
+		empty.id = 0;
+		empty.index = -1;
+		slots.assign(capacity, empty);
+		mask = capacity - 1;
+		duplicates.clear();
+		for(int i = 0; i < count; ++i)
+		{
+			if(valid && !((valid[i >> 6] >> (i & 63)) & 1))
+				continue;
+			int id = properties[i].id;
+			unsigned int slot = hash(id) & mask;
+			while(slots[slot].index >= 0 && slots[slot].id != id)
+				slot = (slot + 1) & mask;
+			// keep the first object of duplicate ids
+			if(slots[slot].index < 0)
+			{
+				slots[slot].id = id;
+				slots[slot].index = i;
+			}
+			else
+				duplicates.push_back(id);
+		}
+		std::sort(duplicates.begin(), duplicates.end());
+		duplicates.erase(std::unique(duplicates.begin(), duplicates.end()), duplicates.end());
+	}
+
+	/**
+	 * Uses backward shift deletion, so lookups never need to skip deleted entries.
+	 */
+	bool IdIndex::erase(int id, int index)
+	{
+		if(slots.empty())
+			return true;
+		unsigned int slot = hash(id) & mask;
+		while(slots[slot].index >= 0 && slots[slot].id != id)
+			slot = (slot + 1) & mask;
+		if(slots[slot].index != index)
+			return true;
+		// the next object with this id is unknown
+		if(std::binary_search(duplicates.begin(), duplicates.end(), id))
+			return false;
+		// move following entries of the probe sequence into the gap
+		unsigned int gap = slot;
+		for(unsigned int next = (gap + 1) & mask; slots[next].index >= 0; next = (next + 1) & mask)
+		{
+			unsigned int home = hash(slots[next].id) & mask;
+			// the entry may fill the gap if its home slot is not between gap and next
+			if(((next - home) & mask) >= ((next - gap) & mask))
+			{
+				slots[gap] = slots[next];
+				gap = next;
+			}
+		}
+		slots[gap].index = -1;
+		return true;
+	}
+
+	void IdIndex::clear()
+	{
+		std::vector<Slot>().swap(slots);
+		std::vector<int>().swap(duplicates);
+		mask = 0;
+	}
+
+	/**
+	 * \endcond
+	 */
+}
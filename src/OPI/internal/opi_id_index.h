@@ -0,0 +1,91 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_ID_INDEX_H
+#define OPI_ID_INDEX_H
+#include "../opi_common.h"
+#include "../opi_datatypes.h"
+#include <vector>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Hash table mapping object ids to Population indices
+	/**
+	 * The table uses open addressing with linear probing and is kept at most half full, so
+	 * lookups usually touch a single cache line. It is rebuilt as a whole, only single entries
+	 * can be erased. If several objects share an id, the one with the lowest index is found.
+	 */
+	class IdIndex
+	{
+		public:
+			IdIndex();
+
+			//! Rebuilds the table from the ids of count objects
+			/**
+			 * If valid is not null, it points to a bitmap of (count + 63) / 64 words and only
+			 * objects whose bit is set are added.
+			 */
+			void build(const ObjectProperties* properties, int count, const unsigned long long* valid = 0);
+			//! Removes the entry of the given id if it refers to the given index
+			/**
+			 * Returns false if the entry refers to the given index but other objects share
+			 * its id. The table is left unchanged then and has to be rebuilt to find them.
+			 */
+			bool erase(int id, int index);
+			//! Releases the memory of the table
+			void clear();
+
+			//! Returns the index of the object with the given id, or -1 if it does not exist
+			int find(int id) const
+			{
+				if(slots.empty())
+					return -1;
+				for(unsigned int slot = hash(id) & mask; ; slot = (slot + 1) & mask)
+				{
+					const Slot& entry = slots[slot];
+					if(entry.index < 0 || entry.id == id)
+						return entry.index;
+				}
+			}
+
+		private:
+			struct Slot
+			{
+				int id;
+				int index;
+			};
+
+			static unsigned int hash(int id)
+			{
+				unsigned int value = static_cast<unsigned int>(id) * 2654435761u;
+				return value ^ (value >> 16);
+			}
+
+			std::vector<Slot> slots;
+			unsigned int mask;
+			// sorted ids that belong to more than one object, usually empty
+			std::vector<int> duplicates;
+	};
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
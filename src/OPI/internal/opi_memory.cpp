@@ -0,0 +1,257 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_memory.h"
+#include "opi_parallel.h"
+#include <cstdlib>
+#ifdef __linux__
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace
+	{
+		void* allocateAligned(size_t alignment, size_t bytes)
+		{
+#ifdef WIN32
+			return _aligned_malloc(bytes, alignment);
+#else
+			void* memory = 0;
+			if(posix_memalign(&memory, alignment, bytes) != 0)
+				return 0;
+			return memory;
+#endif
+		}
+
+		void freeAligned(void* memory)
+		{
+#ifdef WIN32
+			_aligned_free(memory);
+#else
+			::free(memory);
+#endif
+		}
+
+#ifdef __linux__
+		// memory policy of the mbind system call (see numaif.h)
+		const int MEMORY_POLICY_INTERLEAVE = 3;
+
+		//! Returns a bit mask of the online NUMA nodes (0 if unknown)
+		unsigned long getOnlineNodes()
+		{
+			std::ifstream in("/sys/devices/system/node/online");
+			std::string list;
+			if(!(in >> list))
+				return 0;
+			// the list has the format "0-3,5,7-8"
+			unsigned long mask = 0;
+			size_t position = 0;
+			while(position < list.size())
+			{
+				size_t end = list.find(',', position);
+				if(end == std::string::npos)
+					end = list.size();
+				std::string range = list.substr(position, end - position);
+				size_t dash = range.find('-');
+				int first = atoi(range.c_str());
+				int last = (dash == std::string::npos) ? first : atoi(range.c_str() + dash + 1);
+				for(int node = first; node <= last && node < (int)sizeof(unsigned long) * 8; ++node)
+					mask |= 1ul << node;
+				position = end + 1;
+			}
+			return mask;
+		}
+#endif
+	}
+
+	DefaultHostAllocator::DefaultHostAllocator():
+		placement(MEMORY_PLACEMENT_DEFAULT),
+		hugePages(true)
+	{
+	}
+
+	void DefaultHostAllocator::setPlacement(MemoryPlacement memoryPlacement, bool useHugePages)
+	{
+		placement = memoryPlacement;
+		hugePages = useHugePages;
+	}
+
+	/**
+	 * The placement hints have to be given before the pages are touched for the first time.
+	 * With MEMORY_PLACEMENT_PARTITIONED the pages are zeroed in consecutive ranges by
+	 * parallelFor(), which only spreads their first touch across threads.
+	 */
+	void* DefaultHostAllocator::allocate(size_t bytes)
+	{
+		bool large = bytes >= HUGE_PAGE_SIZE;
+		size_t alignment = large ? HUGE_PAGE_SIZE : HOST_MEMORY_ALIGNMENT;
+		size_t size = (bytes + alignment - 1) / alignment * alignment;
+		char* memory = static_cast<char*>(allocateAligned(alignment, size));
+		if(!memory || !large)
+			return memory;
+#ifdef __linux__
+		if(hugePages)
+			madvise(memory, size, MADV_HUGEPAGE);
+		if(placement == MEMORY_PLACEMENT_INTERLEAVED)
+		{
+			unsigned long nodes = getOnlineNodes();
+			// nothing to do on single-node systems
+			if(nodes & (nodes - 1))
+				syscall(SYS_mbind, memory, size, MEMORY_POLICY_INTERLEAVE, &nodes, sizeof(nodes) * 8, 0);
+		}
+#endif
+		if(placement == MEMORY_PLACEMENT_PARTITIONED)
+		{
+			const size_t pageSize = hugePages ? HUGE_PAGE_SIZE : 4096;
+			int pages = (size + pageSize - 1) / pageSize;
+			parallelFor(0, pages, 1, [memory, size, pageSize](int begin, int end) {
+				size_t last = std::min(size, end * pageSize);
+				memset(memory + begin * pageSize, 0, last - begin * pageSize);
+			});
+		}
+		return memory;
+	}
+
+	void DefaultHostAllocator::free(void* memory, size_t)
+	{
+		freeAligned(memory);
+	}
+
+	DeviceMemoryPool::DeviceMemoryPool():
+		cachedBytes(0),
+		limit(256 << 20)
+	{
+	}
+
+	size_t DeviceMemoryPool::getSizeClass(size_t size)
+	{
+		const size_t minimum = 256;
+		if(size <= minimum)
+			return minimum;
+		// sizes in (2^k, 2^(k+1)] are rounded up to multiples of 2^(k-2)
+		size_t power = minimum;
+		while(power * 2 < size)
+			power *= 2;
+		size_t step = power / 4;
+		return (size + step - 1) / step * step;
+	}
+
+	void* DeviceMemoryPool::allocate(GpuSupport* cuda, Device device, size_t size)
+	{
+		size_t sizeClass = getSizeClass(size);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::map<BlockClass, std::vector<void*> >::iterator cached = blocks.find(BlockClass(device, sizeClass));
+			if(cached != blocks.end() && !cached->second.empty())
+			{
+				void* memory = cached->second.back();
+				cached->second.pop_back();
+				cachedBytes -= sizeClass;
+				return memory;
+			}
+		}
+		// change device, allocate and select the old device again
+		void* memory = 0;
+		int oldDevice = cuda->getCurrentDevice();
+		cuda->selectDevice(device - DEVICE_CUDA);
+		cuda->allocate(&memory, sizeClass);
+		if(!memory)
+		{
+			// the cached blocks may take the memory that is missing
+			cuda->selectDevice(oldDevice);
+			clear(cuda);
+			cuda->selectDevice(device - DEVICE_CUDA);
+			cuda->allocate(&memory, sizeClass);
+		}
+		cuda->selectDevice(oldDevice);
+		return memory;
+	}
+
+	void DeviceMemoryPool::free(GpuSupport* cuda, Device device, void* memory, size_t size)
+	{
+		size_t sizeClass = getSizeClass(size);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(cachedBytes + sizeClass <= limit)
+			{
+				blocks[BlockClass(device, sizeClass)].push_back(memory);
+				cachedBytes += sizeClass;
+				return;
+			}
+		}
+		freeBlock(cuda, device, memory);
+	}
+
+	void DeviceMemoryPool::clear(GpuSupport* cuda)
+	{
+		trim(cuda, 0);
+	}
+
+	void DeviceMemoryPool::setLimit(GpuSupport* cuda, size_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			limit = bytes;
+		}
+		trim(cuda, bytes);
+	}
+
+	void DeviceMemoryPool::freeBlock(GpuSupport* cuda, Device device, void* memory)
+	{
+		int oldDevice = cuda->getCurrentDevice();
+		cuda->selectDevice(device - DEVICE_CUDA);
+		cuda->free(memory);
+		cuda->selectDevice(oldDevice);
+	}
+
+	/**
+	 * Frees cached blocks, starting with the largest classes, until at most bytes are cached.
+	 */
+	void DeviceMemoryPool::trim(GpuSupport* cuda, size_t bytes)
+	{
+		std::vector<std::pair<Device, void*> > released;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::map<BlockClass, std::vector<void*> >::reverse_iterator block = blocks.rbegin();
+			while(cachedBytes > bytes && block != blocks.rend())
+			{
+				while(cachedBytes > bytes && !block->second.empty())
+				{
+					released.push_back(std::make_pair(block->first.first, block->second.back()));
+					block->second.pop_back();
+					cachedBytes -= block->first.second;
+				}
+				++block;
+			}
+		}
+		if(cuda)
+		{
+			for(size_t i = 0; i < released.size(); ++i)
+				freeBlock(cuda, released[i].first, released[i].second);
+		}
+	}
+
+	/**
+	 * \endcond
+	 */
+}
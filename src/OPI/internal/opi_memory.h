@@ -0,0 +1,282 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_MEMORY_H
+#define OPI_MEMORY_H
+#include "../opi_host.h"
+#include "../opi_allocator.h"
+#include "../opi_gpusupport.h"
+#include "../opi_datatypes.h"
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Alignment of all host memory blocks in bytes (one cache line)
+	const size_t HOST_MEMORY_ALIGNMENT = 64;
+
+	//! Size of the pages used for large blocks
+	const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+	//! The allocator used by a Host unless another one is set
+	/**
+	 * All blocks are aligned to HOST_MEMORY_ALIGNMENT. Blocks of at least HUGE_PAGE_SIZE
+	 * bytes are aligned to HUGE_PAGE_SIZE and, on Linux, marked for transparent huge pages
+	 * and placed on the NUMA nodes according to the placement policy.
+	 */
+	class DefaultHostAllocator: public HostAllocator
+	{
+		public:
+			DefaultHostAllocator();
+
+			void* allocate(size_t bytes);
+			void free(void* memory, size_t bytes);
+
+			//! Sets the NUMA placement and huge page usage of large blocks
+			void setPlacement(MemoryPlacement placement, bool hugePages);
+
+		private:
+			MemoryPlacement placement;
+			bool hugePages;
+	};
+
+	//! Allocates a block of host memory that is returned to the allocator by the last owner
+	inline std::shared_ptr<char> allocateHostBlock(HostAllocator* allocator, size_t bytes)
+	{
+		return std::shared_ptr<char>(static_cast<char*>(allocator->allocate(bytes)), [allocator, bytes](char* memory) {
+			allocator->free(memory, bytes);
+		});
+	}
+
+	//! Array of trivially copyable objects in aligned host memory
+	/**
+	 * The interface resembles std::vector. New elements are set to zero. Instead of owning its
+	 * memory, the array can also use a region of a larger block (see attach()); it switches
+	 * back to own memory if it has to grow beyond the size of the region.
+	 */
+	template<class T>
+	class HostArray
+	{
+		public:
+			explicit HostArray(HostAllocator* hostAllocator):
+				allocator(hostAllocator),
+				ptr(0),
+				count(0),
+				reserved(0)
+			{
+			}
+
+			//! Creates a copy in own memory with the same capacity
+			HostArray(const HostArray& source):
+				allocator(source.allocator),
+				ptr(0),
+				count(0),
+				reserved(0)
+			{
+				reserve(source.reserved);
+				assign(source.begin(), source.end());
+			}
+
+			~HostArray()
+			{
+				release();
+			}
+
+			T* data() { return ptr; }
+			const T* data() const { return ptr; }
+			T* begin() { return ptr; }
+			const T* begin() const { return ptr; }
+			T* end() { return ptr + count; }
+			const T* end() const { return ptr + count; }
+			size_t size() const { return count; }
+			size_t capacity() const { return reserved; }
+			T& operator[](size_t index) { return ptr[index]; }
+			const T& operator[](size_t index) const { return ptr[index]; }
+
+			//! Makes sure the array can hold at least n elements without reallocation
+			void reserve(size_t n)
+			{
+				if(n <= reserved)
+					return;
+				T* memory = static_cast<T*>(allocator->allocate(n * sizeof(T)));
+				if(count > 0)
+					memcpy(static_cast<void*>(memory), ptr, count * sizeof(T));
+				release();
+				ptr = memory;
+				reserved = n;
+			}
+
+			//! Changes the number of elements, new elements are set to zero
+			void resize(size_t n)
+			{
+				reserve(n);
+				if(n > count)
+					memset(static_cast<void*>(ptr + count), 0, (n - count) * sizeof(T));
+				count = n;
+			}
+
+			//! Replaces the content with the elements in [first, last)
+			void assign(const T* first, const T* last)
+			{
+				count = 0;
+				reserve(last - first);
+				if(last > first)
+					memcpy(static_cast<void*>(ptr), first, (last - first) * sizeof(T));
+				count = last - first;
+			}
+
+			//! Removes the elements in [first, last)
+			void erase(T* first, T* last)
+			{
+				std::copy(last, end(), first);
+				count -= last - first;
+			}
+
+			//! Uses n elements at memory (a region of the block owned by owner) from now on
+			/**
+			 * Existing elements are copied to the region and truncated to n elements.
+			 */
+			void attach(const std::shared_ptr<char>& owner, T* memory, size_t n)
+			{
+				size_t kept = std::min(count, n);
+				if(kept > 0 && memory != ptr)
+					memmove(static_cast<void*>(memory), ptr, kept * sizeof(T));
+				release();
+				block = owner;
+				ptr = memory;
+				count = kept;
+				reserved = n;
+			}
+
+		private:
+			HostArray& operator=(const HostArray&);
+
+			void release()
+			{
+				if(!block && ptr)
+					allocator->free(ptr, reserved * sizeof(T));
+				block.reset();
+				ptr = 0;
+			}
+
+			HostAllocator* allocator;
+			T* ptr;
+			size_t count;
+			size_t reserved;
+			//! The block containing the elements, null if the memory is owned by this array
+			std::shared_ptr<char> block;
+	};
+
+	//! Cache of device memory blocks that have been released but not yet freed
+	/**
+	 * Requests are rounded up to size classes (steps of a quarter of a power of two) so that
+	 * blocks of similar size can be reused. A released block is kept until the cache exceeds
+	 * its limit; allocating or freeing device memory synchronizes the device, which the
+	 * cache avoids for the short-lived objects that are created in every propagation step.
+	 */
+	class DeviceMemoryPool
+	{
+		public:
+			DeviceMemoryPool();
+
+			//! Returns a block of at least size bytes on device, or a null pointer on failure
+			void* allocate(GpuSupport* cuda, Device device, size_t size);
+			//! Returns a block obtained from allocate() with the same size to the cache
+			void free(GpuSupport* cuda, Device device, void* memory, size_t size);
+			//! Frees all cached blocks
+			void clear(GpuSupport* cuda);
+			//! Sets the maximum number of bytes kept in the cache and frees blocks above it
+			void setLimit(GpuSupport* cuda, size_t bytes);
+
+			//! Returns the size of the class a request of size bytes belongs to
+			static size_t getSizeClass(size_t size);
+
+		private:
+			typedef std::pair<Device, size_t> BlockClass;
+
+			void freeBlock(GpuSupport* cuda, Device device, void* memory);
+			void trim(GpuSupport* cuda, size_t bytes);
+
+			std::mutex mutex;
+			std::map<BlockClass, std::vector<void*> > blocks;
+			size_t cachedBytes;
+			size_t limit;
+	};
+
+	//! Memory on a CUDA device, freed when the last owner releases it
+	/**
+	 * The memory is either allocated by this object or a region of another DeviceMemory
+	 * object, which is kept alive as long as the region is in use.
+	 */
+	class DeviceMemory
+	{
+		public:
+			//! Allocates size bytes on the given device
+			DeviceMemory(Host& owning_host, Device owning_device, size_t size):
+				ptr(0),
+				bytes(size),
+				host(owning_host),
+				device(owning_device)
+			{
+				GpuSupport* cuda = host.getGPUSupport();
+				if(cuda && bytes > 0)
+					ptr = host.getDeviceMemoryPool()->allocate(cuda, device, bytes);
+			}
+
+			//! Refers to the memory at offset bytes inside of block
+			DeviceMemory(const std::shared_ptr<DeviceMemory>& block, size_t offset):
+				ptr(static_cast<char*>(block->ptr) + offset),
+				bytes(0),
+				host(block->host),
+				device(block->device),
+				parent(block)
+			{
+			}
+
+			~DeviceMemory()
+			{
+				GpuSupport* cuda = host.getGPUSupport();
+				if(cuda && ptr && !parent)
+					host.getDeviceMemoryPool()->free(cuda, device, ptr, bytes);
+			}
+
+			//! The pointer to the on-device memory
+			void* ptr;
+			//! The requested size, zero for regions of another block
+			size_t bytes;
+			Host& host;
+			Device device;
+			//! The block containing this region, null if the memory was allocated by this object
+			std::shared_ptr<DeviceMemory> parent;
+
+		private:
+			DeviceMemory(const DeviceMemory&);
+			DeviceMemory& operator=(const DeviceMemory&);
+	};
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
@@ -0,0 +1,62 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_ORBIT_KERNELS_H
+#define OPI_ORBIT_KERNELS_H
+#include "../opi_common.h"
+#include "../opi_datatypes.h"
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Batch kernels of the orbit math functions for one instruction set
+	/**
+	 * Every instruction set is compiled in its own translation unit (see
+	 * opi_orbit_kernels_impl.h) and selected at runtime by getOrbitKernels().
+	 */
+	struct OrbitKernels
+	{
+		//! Name of the instruction set
+		const char* name;
+		//! Number of objects processed at once
+		int width;
+		void (*meanToEccentric)(const double* meanAnomaly, const double* eccentricity, double* eccentricAnomaly, int count, double tolerance, int maxIterations);
+		void (*eccentricToTrue)(const double* eccentricAnomaly, const double* eccentricity, double* trueAnomaly, int count);
+		void (*meanToTrue)(const double* meanAnomaly, const double* eccentricity, double* trueAnomaly, int count, double tolerance, int maxIterations);
+		void (*trueToMean)(const double* trueAnomaly, const double* eccentricity, double* meanAnomaly, int count);
+		void (*elementsToState)(const Orbit* orbits, Vector3* position, Vector3* velocity, int count, double mu);
+		void (*stateToElements)(const Vector3* position, const Vector3* velocity, Orbit* orbits, int count, double mu);
+	};
+
+	namespace generic { extern const OrbitKernels kernels; }
+#ifdef OPI_HAVE_AVX2_KERNELS
+	namespace avx2 { extern const OrbitKernels kernels; }
+#endif
+#ifdef OPI_HAVE_AVX512_KERNELS
+	namespace avx512 { extern const OrbitKernels kernels; }
+#endif
+
+	//! Returns the kernels for the best instruction set supported by the CPU
+	const OrbitKernels& getOrbitKernels();
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
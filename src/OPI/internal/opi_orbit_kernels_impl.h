@@ -0,0 +1,589 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+// This file has no include guard on purpose: it is included by one translation unit per
+// instruction set, each compiled with its own code generation flags. Everything is placed
+// in the namespace OPI_SIMD_NAMESPACE so that no inline function compiled for one
+// instruction set can be picked by the linker for another one.
+#ifndef OPI_SIMD_NAMESPACE
+#error "OPI_SIMD_NAMESPACE has to be defined before including opi_orbit_kernels_impl.h"
+#endif
+
+#include "opi_orbit_kernels.h"
+#include <cmath>
+#include <limits>
+#if defined(OPI_SIMD_AVX512) || defined(OPI_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(OPI_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace OPI_SIMD_NAMESPACE
+	{
+		namespace
+		{
+#if defined(OPI_SIMD_AVX512)
+			const char* const INSTRUCTION_SET = "AVX-512";
+
+			struct Mask
+			{
+				Mask(__mmask8 bits): m(bits) {}
+				__mmask8 m;
+			};
+			inline Mask operator&(Mask a, Mask b) { return Mask(static_cast<__mmask8>(a.m & b.m)); }
+			inline Mask operator|(Mask a, Mask b) { return Mask(static_cast<__mmask8>(a.m | b.m)); }
+			inline bool any(Mask a) { return a.m != 0; }
+
+			struct Vec
+			{
+				static const int width = 8;
+				Vec() {}
+				Vec(__m512d value): v(value) {}
+				Vec(double value): v(_mm512_set1_pd(value)) {}
+				static Vec load(const double* p) { return _mm512_loadu_pd(p); }
+				void store(double* p) const { _mm512_storeu_pd(p, v); }
+				__m512d v;
+			};
+			inline Vec operator+(Vec a, Vec b) { return _mm512_add_pd(a.v, b.v); }
+			inline Vec operator-(Vec a, Vec b) { return _mm512_sub_pd(a.v, b.v); }
+			inline Vec operator*(Vec a, Vec b) { return _mm512_mul_pd(a.v, b.v); }
+			inline Vec operator/(Vec a, Vec b) { return _mm512_div_pd(a.v, b.v); }
+			inline Vec operator-(Vec a) { return _mm512_sub_pd(_mm512_setzero_pd(), a.v); }
+			inline Mask operator<(Vec a, Vec b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ); }
+			inline Mask operator>(Vec a, Vec b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ); }
+			inline Mask operator<=(Vec a, Vec b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ); }
+			inline Mask operator>=(Vec a, Vec b) { return _mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ); }
+			//! Returns a * b + c
+			inline Vec fma(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a.v, b.v, c.v); }
+			// the zero-masked forms avoid a false maybe-uninitialized warning of GCC 12
+			inline Vec sqrt(Vec a) { return _mm512_maskz_sqrt_pd(0xff, a.v); }
+			inline Vec abs(Vec a) { return _mm512_abs_pd(a.v); }
+			inline Vec round(Vec a) { return _mm512_maskz_roundscale_pd(0xff, a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+			inline Vec floor(Vec a) { return _mm512_maskz_roundscale_pd(0xff, a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+			//! Returns a where the mask is set, b otherwise
+			inline Vec select(Mask m, Vec a, Vec b) { return _mm512_mask_blend_pd(m.m, b.v, a.v); }
+#elif defined(OPI_SIMD_AVX2)
+			const char* const INSTRUCTION_SET = "AVX2";
+
+			struct Mask
+			{
+				Mask(__m256d bits): m(bits) {}
+				__m256d m;
+			};
+			inline Mask operator&(Mask a, Mask b) { return Mask(_mm256_and_pd(a.m, b.m)); }
+			inline Mask operator|(Mask a, Mask b) { return Mask(_mm256_or_pd(a.m, b.m)); }
+			inline bool any(Mask a) { return _mm256_movemask_pd(a.m) != 0; }
+
+			struct Vec
+			{
+				static const int width = 4;
+				Vec() {}
+				Vec(__m256d value): v(value) {}
+				Vec(double value): v(_mm256_set1_pd(value)) {}
+				static Vec load(const double* p) { return _mm256_loadu_pd(p); }
+				void store(double* p) const { _mm256_storeu_pd(p, v); }
+				__m256d v;
+			};
+			inline Vec operator+(Vec a, Vec b) { return _mm256_add_pd(a.v, b.v); }
+			inline Vec operator-(Vec a, Vec b) { return _mm256_sub_pd(a.v, b.v); }
+			inline Vec operator*(Vec a, Vec b) { return _mm256_mul_pd(a.v, b.v); }
+			inline Vec operator/(Vec a, Vec b) { return _mm256_div_pd(a.v, b.v); }
+			inline Vec operator-(Vec a) { return _mm256_xor_pd(a.v, _mm256_set1_pd(-0.0)); }
+			inline Mask operator<(Vec a, Vec b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+			inline Mask operator>(Vec a, Vec b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ); }
+			inline Mask operator<=(Vec a, Vec b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+			inline Mask operator>=(Vec a, Vec b) { return _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ); }
+			//! Returns a * b + c
+			inline Vec fma(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a.v, b.v, c.v); }
+			inline Vec sqrt(Vec a) { return _mm256_sqrt_pd(a.v); }
+			inline Vec abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+			inline Vec round(Vec a) { return _mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+			inline Vec floor(Vec a) { return _mm256_floor_pd(a.v); }
+			//! Returns a where the mask is set, b otherwise
+			inline Vec select(Mask m, Vec a, Vec b) { return _mm256_blendv_pd(b.v, a.v, m.m); }
+#elif defined(OPI_SIMD_NEON)
+			const char* const INSTRUCTION_SET = "NEON";
+
+			struct Mask
+			{
+				Mask(uint64x2_t bits): m(bits) {}
+				uint64x2_t m;
+			};
+			inline Mask operator&(Mask a, Mask b) { return Mask(vandq_u64(a.m, b.m)); }
+			inline Mask operator|(Mask a, Mask b) { return Mask(vorrq_u64(a.m, b.m)); }
+			inline bool any(Mask a) { return (vgetq_lane_u64(a.m, 0) | vgetq_lane_u64(a.m, 1)) != 0; }
+
+			struct Vec
+			{
+				static const int width = 2;
+				Vec() {}
+				Vec(float64x2_t value): v(value) {}
+				Vec(double value): v(vdupq_n_f64(value)) {}
+				static Vec load(const double* p) { return vld1q_f64(p); }
+				void store(double* p) const { vst1q_f64(p, v); }
+				float64x2_t v;
+			};
+			inline Vec operator+(Vec a, Vec b) { return vaddq_f64(a.v, b.v); }
+			inline Vec operator-(Vec a, Vec b) { return vsubq_f64(a.v, b.v); }
+			inline Vec operator*(Vec a, Vec b) { return vmulq_f64(a.v, b.v); }
+			inline Vec operator/(Vec a, Vec b) { return vdivq_f64(a.v, b.v); }
+			inline Vec operator-(Vec a) { return vnegq_f64(a.v); }
+			inline Mask operator<(Vec a, Vec b) { return vcltq_f64(a.v, b.v); }
+			inline Mask operator>(Vec a, Vec b) { return vcgtq_f64(a.v, b.v); }
+			inline Mask operator<=(Vec a, Vec b) { return vcleq_f64(a.v, b.v); }
+			inline Mask operator>=(Vec a, Vec b) { return vcgeq_f64(a.v, b.v); }
+			//! Returns a * b + c
+			inline Vec fma(Vec a, Vec b, Vec c) { return vfmaq_f64(c.v, a.v, b.v); }
+			inline Vec sqrt(Vec a) { return vsqrtq_f64(a.v); }
+			inline Vec abs(Vec a) { return vabsq_f64(a.v); }
+			inline Vec round(Vec a) { return vrndnq_f64(a.v); }
+			inline Vec floor(Vec a) { return vrndmq_f64(a.v); }
+			//! Returns a where the mask is set, b otherwise
+			inline Vec select(Mask m, Vec a, Vec b) { return vbslq_f64(m.m, a.v, b.v); }
+#else
+			const char* const INSTRUCTION_SET = "scalar";
+
+			struct Mask
+			{
+				Mask(bool bit): m(bit) {}
+				bool m;
+			};
+			inline Mask operator&(Mask a, Mask b) { return a.m && b.m; }
+			inline Mask operator|(Mask a, Mask b) { return a.m || b.m; }
+			inline bool any(Mask a) { return a.m; }
+
+			struct Vec
+			{
+				static const int width = 1;
+				Vec() {}
+				Vec(double value): v(value) {}
+				static Vec load(const double* p) { return *p; }
+				void store(double* p) const { *p = v; }
+				double v;
+			};
+			inline Vec operator+(Vec a, Vec b) { return a.v + b.v; }
+			inline Vec operator-(Vec a, Vec b) { return a.v - b.v; }
+			inline Vec operator*(Vec a, Vec b) { return a.v * b.v; }
+			inline Vec operator/(Vec a, Vec b) { return a.v / b.v; }
+			inline Vec operator-(Vec a) { return -a.v; }
+			inline Mask operator<(Vec a, Vec b) { return a.v < b.v; }
+			inline Mask operator>(Vec a, Vec b) { return a.v > b.v; }
+			inline Mask operator<=(Vec a, Vec b) { return a.v <= b.v; }
+			inline Mask operator>=(Vec a, Vec b) { return a.v >= b.v; }
+			//! Returns a * b + c
+			inline Vec fma(Vec a, Vec b, Vec c) { return a.v * b.v + c.v; }
+			inline Vec sqrt(Vec a) { return ::sqrt(a.v); }
+			inline Vec abs(Vec a) { return ::fabs(a.v); }
+			inline Vec round(Vec a) { return ::floor(a.v + 0.5); }
+			inline Vec floor(Vec a) { return ::floor(a.v); }
+			//! Returns a where the mask is set, b otherwise
+			inline Vec select(Mask m, Vec a, Vec b) { return m.m ? a : b; }
+#endif
+
+			const int WIDTH = Vec::width;
+			const double PI = 3.14159265358979323846;
+			const double TWO_PI = 6.28318530717958647693;
+			const double HALF_PI = 1.57079632679489661923;
+			const double QUARTER_PI = 0.78539816339744830962;
+			// pi/2 split into three parts, the first two with trailing zero bits (fdlibm)
+			const double HALF_PI_1 = 1.57079632673412561417e+00;
+			const double HALF_PI_2 = 6.07710050630396597660e-11;
+			const double HALF_PI_3 = 2.02226624871116645580e-21;
+			// pi/2 - HALF_PI, added to improve the precision of results near pi/2 (cephes)
+			const double HALF_PI_LOW = 6.123233995736765886130e-17;
+
+			//! Loads n values, the remaining lanes are set to fill
+			inline Vec loadPartial(const double* p, int n, double fill)
+			{
+				if(n == WIDTH)
+					return Vec::load(p);
+				double lanes[WIDTH];
+				for(int i = 0; i < WIDTH; ++i)
+					lanes[i] = (i < n) ? p[i] : fill;
+				return Vec::load(lanes);
+			}
+
+			//! Stores the first n lanes
+			inline void storePartial(Vec value, double* p, int n)
+			{
+				if(n == WIDTH)
+				{
+					value.store(p);
+					return;
+				}
+				double lanes[WIDTH];
+				value.store(lanes);
+				for(int i = 0; i < n; ++i)
+					p[i] = lanes[i];
+			}
+
+			//! Reduces angles to [-pi, pi]
+			inline Vec wrapAngle(Vec x)
+			{
+				return fma(round(x * (1.0 / TWO_PI)), Vec(-TWO_PI), x);
+			}
+
+			//! Reduces angles to [0, 2pi)
+			inline Vec wrapPositive(Vec x)
+			{
+				Vec r = fma(floor(x * (1.0 / TWO_PI)), Vec(-TWO_PI), x);
+				r = select(r < Vec(0.0), r + TWO_PI, r);
+				return select(r >= Vec(TWO_PI), r - TWO_PI, r);
+			}
+
+			//! Calculates the sine and cosine, accurate to a few ulp for |x| < 1e6
+			/**
+			 * The argument is reduced to [-pi/4, pi/4] and both functions are approximated by
+			 * the minimax polynomials of fdlibm. The quadrant is handled with selects, so all
+			 * lanes run the same instructions.
+			 */
+			inline void sinCos(Vec x, Vec& s, Vec& c)
+			{
+				Vec q = round(x * (1.0 / HALF_PI));
+				Vec r = fma(q, Vec(-HALF_PI_1), x);
+				r = fma(q, Vec(-HALF_PI_2), r);
+				r = fma(q, Vec(-HALF_PI_3), r);
+				Vec z = r * r;
+
+				Vec ps = fma(z, Vec(1.58969099521155010221e-10), Vec(-2.50507602534068634195e-08));
+				ps = fma(z, ps, Vec(2.75573137070700676789e-06));
+				ps = fma(z, ps, Vec(-1.98412698298579493134e-04));
+				ps = fma(z, ps, Vec(8.33333333332248946124e-03));
+				ps = fma(z, ps, Vec(-1.66666666666666324348e-01));
+				Vec sinr = fma(r * z, ps, r);
+
+				Vec pc = fma(z, Vec(-1.13596475577881948265e-11), Vec(2.08757232129817482790e-09));
+				pc = fma(z, pc, Vec(-2.75573143513906633035e-07));
+				pc = fma(z, pc, Vec(2.48015872894767294178e-05));
+				pc = fma(z, pc, Vec(-1.38888888888741095749e-03));
+				pc = fma(z, pc, Vec(4.16666666666666019037e-02));
+				Vec cosr = fma(z * z, pc, fma(z, Vec(-0.5), Vec(1.0)));
+
+				// quadrant k = q mod 4
+				Vec k = fma(floor(q * 0.25), Vec(-4.0), q);
+				Vec odd = fma(floor(k * 0.5), Vec(-2.0), k);
+				Mask swap = odd > Vec(0.5);
+				Mask negateSin = k > Vec(1.5);
+				Mask negateCos = (k > Vec(0.5)) & (k < Vec(2.5));
+				Vec s0 = select(swap, cosr, sinr);
+				Vec c0 = select(swap, sinr, cosr);
+				s = select(negateSin, -s0, s0);
+				c = select(negateCos, -c0, c0);
+			}
+
+			//! Calculates atan2(y, x) in [-pi, pi] with the rational approximation of cephes
+			inline Vec atan2(Vec y, Vec x)
+			{
+				Vec ax = abs(x);
+				Vec ay = abs(y);
+				Mask steep = ay > ax;
+				Vec numerator = select(steep, ax, ay);
+				Vec denominator = select(steep, ay, ax);
+				// t = atan argument in [0, 1], zero if both inputs are zero
+				Vec t = numerator / select(denominator > Vec(0.0), denominator, Vec(1.0));
+				Mask upper = t > Vec(0.66);
+				Vec u = select(upper, (t - 1.0) / (t + 1.0), t);
+				Vec base = select(upper, Vec(QUARTER_PI), Vec(0.0));
+				Vec low = select(upper, Vec(0.5 * HALF_PI_LOW), Vec(0.0));
+				Vec z = u * u;
+
+				Vec p = fma(z, Vec(-8.750608600031904122785e-01), Vec(-1.615753718733365076637e+01));
+				p = fma(z, p, Vec(-7.500855792314704667340e+01));
+				p = fma(z, p, Vec(-1.228866684490136173410e+02));
+				p = fma(z, p, Vec(-6.485021904942025371773e+01));
+				Vec q = z + 2.485846490142306297962e+01;
+				q = fma(z, q, Vec(1.650270098316988542046e+02));
+				q = fma(z, q, Vec(4.328810604912902668951e+02));
+				q = fma(z, q, Vec(4.853903996359136964868e+02));
+				q = fma(z, q, Vec(1.945506571482613964425e+02));
+				Vec a = base + (u + fma(u * z, p / q, low));
+
+				a = select(steep, (HALF_PI - a) + HALF_PI_LOW, a);
+				a = select(x < Vec(0.0), PI - a, a);
+				return select(y < Vec(0.0), -a, a);
+			}
+
+			//! Replaces the lanes of value whose eccentricity is not elliptic (0 <= e < 1) with NaN
+			inline Vec ellipticOnly(Vec value, Vec e)
+			{
+				return select((e >= Vec(0.0)) & (e < Vec(1.0)), value, Vec(std::numeric_limits<double>::quiet_NaN()));
+			}
+
+			//! Solves Kepler's equation M = E - e sin(E) with per-lane convergence
+			/**
+			 * Newton's method starts at M + e sin(M), or at +-pi for e > 0.8 where convergence
+			 * from that point is guaranteed. Lanes that have converged keep their value while
+			 * the others continue. The result is in the same revolution as M.
+			 */
+			inline Vec solveKepler(Vec m, Vec e, double tolerance, int maxIterations)
+			{
+				Vec mw = wrapAngle(m);
+				Vec sm, cm;
+				sinCos(mw, sm, cm);
+				Vec E = select(e < Vec(0.8), fma(e, sm, mw), select(mw < Vec(0.0), Vec(-PI), Vec(PI)));
+				// NaN lanes never become active
+				Mask active = abs(mw) <= Vec(PI);
+				for(int iteration = 0; iteration < maxIterations && any(active); ++iteration)
+				{
+					Vec s, c;
+					sinCos(E, s, c);
+					Vec f = fma(-e, s, E) - mw;
+					Vec derivative = fma(-e, c, Vec(1.0));
+					Vec step = f / derivative;
+					E = select(active, E - step, E);
+					active = active & (abs(step) > Vec(tolerance));
+				}
+				return ellipticOnly(E + (m - mw), e);
+			}
+
+			//! Converts the eccentric anomaly to the true anomaly in the same revolution
+			inline Vec eccentricToTrue(Vec E, Vec e)
+			{
+				Vec Ew = wrapAngle(E);
+				Vec s, c;
+				sinCos(Ew * 0.5, s, c);
+				Vec nu = atan2(sqrt(e + 1.0) * s, sqrt(Vec(1.0) - e) * c) * 2.0;
+				return ellipticOnly(nu + (E - Ew), e);
+			}
+
+			//! Converts the true anomaly to the mean anomaly in the same revolution
+			inline Vec trueToMean(Vec nu, Vec e)
+			{
+				Vec nw = wrapAngle(nu);
+				Vec s, c;
+				sinCos(nw * 0.5, s, c);
+				Vec E = atan2(sqrt(Vec(1.0) - e) * s, sqrt(e + 1.0) * c) * 2.0;
+				Vec sE, cE;
+				sinCos(E, sE, cE);
+				return ellipticOnly(fma(-e, sE, E) + (nu - nw), e);
+			}
+
+			// array kernels
+
+			void meanToEccentricKernel(const double* meanAnomaly, const double* eccentricity, double* eccentricAnomaly, int count, double tolerance, int maxIterations)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					Vec m = loadPartial(meanAnomaly + i, n, 0.0);
+					Vec e = loadPartial(eccentricity + i, n, 0.0);
+					storePartial(solveKepler(m, e, tolerance, maxIterations), eccentricAnomaly + i, n);
+				}
+			}
+
+			void eccentricToTrueKernel(const double* eccentricAnomaly, const double* eccentricity, double* trueAnomaly, int count)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					Vec E = loadPartial(eccentricAnomaly + i, n, 0.0);
+					Vec e = loadPartial(eccentricity + i, n, 0.0);
+					storePartial(eccentricToTrue(E, e), trueAnomaly + i, n);
+				}
+			}
+
+			void meanToTrueKernel(const double* meanAnomaly, const double* eccentricity, double* trueAnomaly, int count, double tolerance, int maxIterations)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					Vec m = loadPartial(meanAnomaly + i, n, 0.0);
+					Vec e = loadPartial(eccentricity + i, n, 0.0);
+					storePartial(eccentricToTrue(solveKepler(m, e, tolerance, maxIterations), e), trueAnomaly + i, n);
+				}
+			}
+
+			void trueToMeanKernel(const double* trueAnomaly, const double* eccentricity, double* meanAnomaly, int count)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					Vec nu = loadPartial(trueAnomaly + i, n, 0.0);
+					Vec e = loadPartial(eccentricity + i, n, 0.0);
+					storePartial(trueToMean(nu, e), meanAnomaly + i, n);
+				}
+			}
+
+			void elementsToStateKernel(const Orbit* orbits, Vector3* position, Vector3* velocity, int count, double mu)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					// transpose the elements of this block, unused lanes hold a circular orbit
+					double elements[6][WIDTH];
+					for(int j = 0; j < WIDTH; ++j)
+					{
+						const Orbit& orbit = orbits[i + (j < n ? j : 0)];
+						elements[0][j] = (j < n) ? orbit.semi_major_axis : 1.0;
+						elements[1][j] = (j < n) ? orbit.eccentricity : 0.0;
+						elements[2][j] = orbit.inclination;
+						elements[3][j] = orbit.raan;
+						elements[4][j] = orbit.arg_of_perigee;
+						elements[5][j] = orbit.mean_anomaly;
+					}
+					Vec a = Vec::load(elements[0]);
+					Vec e = Vec::load(elements[1]);
+					Vec E = solveKepler(Vec::load(elements[5]), e, 1e-12, 50);
+
+					Vec sE, cE, si, ci, sO, cO, sw, cw;
+					sinCos(E, sE, cE);
+					sinCos(Vec::load(elements[2]), si, ci);
+					sinCos(Vec::load(elements[3]), sO, cO);
+					sinCos(Vec::load(elements[4]), sw, cw);
+
+					// perifocal coordinates
+					Vec b = sqrt((Vec(1.0) - e) * (e + 1.0));
+					Vec xp = a * (cE - e);
+					Vec yp = a * b * sE;
+					Vec f = sqrt(Vec(mu) / a) / fma(-e, cE, Vec(1.0));
+					Vec vxp = -f * sE;
+					Vec vyp = f * b * cE;
+
+					// perifocal unit vectors P and Q in the reference frame
+					Vec Px = cO * cw - sO * sw * ci;
+					Vec Py = sO * cw + cO * sw * ci;
+					Vec Pz = sw * si;
+					Vec Qx = -(cO * sw) - sO * cw * ci;
+					Vec Qy = cO * cw * ci - sO * sw;
+					Vec Qz = cw * si;
+
+					double state[6][WIDTH];
+					fma(xp, Px, yp * Qx).store(state[0]);
+					fma(xp, Py, yp * Qy).store(state[1]);
+					fma(xp, Pz, yp * Qz).store(state[2]);
+					fma(vxp, Px, vyp * Qx).store(state[3]);
+					fma(vxp, Py, vyp * Qy).store(state[4]);
+					fma(vxp, Pz, vyp * Qz).store(state[5]);
+					for(int j = 0; j < n; ++j)
+					{
+						if(position)
+						{
+							position[i + j].x = state[0][j];
+							position[i + j].y = state[1][j];
+							position[i + j].z = state[2][j];
+						}
+						if(velocity)
+						{
+							velocity[i + j].x = state[3][j];
+							velocity[i + j].y = state[4][j];
+							velocity[i + j].z = state[5][j];
+						}
+					}
+				}
+			}
+
+			void stateToElementsKernel(const Vector3* position, const Vector3* velocity, Orbit* orbits, int count, double mu)
+			{
+				for(int i = 0; i < count; i += WIDTH)
+				{
+					int n = (count - i < WIDTH) ? count - i : WIDTH;
+					// transpose the state of this block, unused lanes hold a circular orbit
+					double state[6][WIDTH];
+					for(int j = 0; j < WIDTH; ++j)
+					{
+						bool used = j < n;
+						state[0][j] = used ? position[i + j].x : 1.0;
+						state[1][j] = used ? position[i + j].y : 0.0;
+						state[2][j] = used ? position[i + j].z : 0.0;
+						state[3][j] = used ? velocity[i + j].x : 0.0;
+						state[4][j] = used ? velocity[i + j].y : ::sqrt(mu);
+						state[5][j] = used ? velocity[i + j].z : 0.0;
+					}
+					Vec rx = Vec::load(state[0]), ry = Vec::load(state[1]), rz = Vec::load(state[2]);
+					Vec vx = Vec::load(state[3]), vy = Vec::load(state[4]), vz = Vec::load(state[5]);
+
+					// angular momentum, node vector n = z x h and eccentricity vector
+					Vec hx = ry * vz - rz * vy;
+					Vec hy = rz * vx - rx * vz;
+					Vec hz = rx * vy - ry * vx;
+					Vec hxy = sqrt(fma(hx, hx, hy * hy));
+					Vec h = sqrt(fma(hz, hz, hxy * hxy));
+					Vec r = sqrt(fma(rx, rx, fma(ry, ry, rz * rz)));
+					Vec v2 = fma(vx, vx, fma(vy, vy, vz * vz));
+					Vec rv = fma(rx, vx, fma(ry, vy, rz * vz));
+					Vec inverseMu = Vec(1.0 / mu);
+					Vec cr = v2 * inverseMu - Vec(1.0) / r;
+					Vec cv = rv * inverseMu;
+					Vec ex = cr * rx - cv * vx;
+					Vec ey = cr * ry - cv * vy;
+					Vec ez = cr * rz - cv * vz;
+					Vec e = sqrt(fma(ex, ex, fma(ey, ey, ez * ez)));
+					Vec a = Vec(1.0) / (Vec(2.0) / r - v2 * inverseMu);
+					Vec inclination = atan2(hxy, hz);
+
+					// the node of equatorial orbits is placed on the x axis
+					Mask equatorial = hxy <= h * 1e-12;
+					Vec nx = select(equatorial, h, -hy);
+					Vec ny = select(equatorial, Vec(0.0), hx);
+					Vec raan = wrapPositive(atan2(ny, nx));
+
+					// the periapsis of circular orbits is placed on the node
+					Mask circular = e <= Vec(1e-12);
+					Vec px = select(circular, nx, ex);
+					Vec py = select(circular, ny, ey);
+					Vec pz = select(circular, Vec(0.0), ez);
+
+					// angles around h; the sines are scaled by |h| through the triple product, so the
+					// cosines are scaled by h as well
+					Vec sinPerigee = hx * (ny * pz) - hy * (nx * pz) + hz * (nx * py - ny * px);
+					Vec cosPerigee = fma(nx, px, ny * py) * h;
+					Vec perigee = wrapPositive(atan2(sinPerigee, cosPerigee));
+					Vec sinTrue = hx * (py * rz - pz * ry) + hy * (pz * rx - px * rz) + hz * (px * ry - py * rx);
+					Vec cosTrue = fma(px, rx, fma(py, ry, pz * rz)) * h;
+					Vec meanAnomaly = wrapPositive(trueToMean(atan2(sinTrue, cosTrue), e));
+
+					double elements[6][WIDTH];
+					a.store(elements[0]);
+					e.store(elements[1]);
+					inclination.store(elements[2]);
+					raan.store(elements[3]);
+					perigee.store(elements[4]);
+					meanAnomaly.store(elements[5]);
+					for(int j = 0; j < n; ++j)
+					{
+						Orbit& orbit = orbits[i + j];
+						orbit.semi_major_axis = elements[0][j];
+						orbit.eccentricity = elements[1][j];
+						orbit.inclination = elements[2][j];
+						orbit.raan = elements[3][j];
+						orbit.arg_of_perigee = elements[4][j];
+						orbit.mean_anomaly = elements[5][j];
+					}
+				}
+			}
+		}
+
+		const OrbitKernels kernels = {
+			INSTRUCTION_SET,
+			WIDTH,
+			&meanToEccentricKernel,
+			&eccentricToTrueKernel,
+			&meanToTrueKernel,
+			&trueToMeanKernel,
+			&elementsToStateKernel,
+			&stateToElementsKernel
+		};
+	}
+	/**
+	 * \endcond
+	 */
+}
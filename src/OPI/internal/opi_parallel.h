@@ -0,0 +1,66 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_PARALLEL_H
+#define OPI_PARALLEL_H
+#include <thread>
+#include <vector>
+#include <algorithm>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Returns the number of threads used for parallel host operations
+	inline int getWorkerCount()
+	{
+		unsigned int count = std::thread::hardware_concurrency();
+		return (count > 0) ? count : 1;
+	}
+
+	//! Splits [first, last) into consecutive ranges and calls func(begin, end) for each on its own thread
+	/**
+	 * Every range contains at least minRange elements. The first range is processed on the
+	 * calling thread and the function returns after all ranges have been processed.
+	 */
+	template<class Function>
+	void parallelFor(int first, int last, int minRange, Function func)
+	{
+		int count = last - first;
+		if(count <= 0)
+			return;
+		int threads = std::min(getWorkerCount(), std::max(1, count / std::max(1, minRange)));
+		if(threads <= 1)
+		{
+			func(first, last);
+			return;
+		}
+		int step = (count + threads - 1) / threads;
+		std::vector<std::thread> workers;
+		for(int begin = first + step; begin < last; begin += step)
+			workers.push_back(std::thread(func, begin, std::min(last, begin + step)));
+		func(first, first + step);
+		for(size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+	}
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
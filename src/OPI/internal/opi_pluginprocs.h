@@ -27,6 +27,8 @@ typedef void* OPI_CollisionDetection;
 namespace OPI
 {
 	class Propagator;
+	class PerturbationModule;
+	class PropagatorIntegrator;
 	class DistanceQuery;
 	class CollisionDetection;
 
@@ -53,6 +55,15 @@ namespace OPI
     // c interface propagation function
     typedef ErrorCode (*pluginPropagateFunctionMultiTime)(OPI_Propagator propagator, OPI_Population data, double* julian_days, int length, double dt);
 
+    // c interface trajectory function, velocities is a null pointer if no velocities are requested
+    typedef ErrorCode (*pluginPropagateFunctionTrajectory)(OPI_Propagator propagator, OPI_Population data, const double* julian_days, int length, Vector3* positions, Vector3* velocities);
+
+	// cpp perturbation module interface function
+	typedef PerturbationModule* (*pluginPerturbationModuleFunction)(OPI_Host host);
+
+	// cpp integrator interface function
+	typedef PropagatorIntegrator* (*pluginPropagatorIntegratorFunction)(OPI_Host host);
+
 	// cpp distance query interface function
 	typedef DistanceQuery* (*pluginDistanceQueryFunction)(OPI_Host host);
 
@@ -0,0 +1,526 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_population_file.h"
+#include "opi_parallel.h"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace
+	{
+		template<class T>
+		bool readValue(std::ifstream& in, T& value)
+		{
+			in.read(reinterpret_cast<char*>(&value), sizeof(T));
+			return in.gcount() == sizeof(T);
+		}
+
+		template<class T>
+		void appendValue(std::vector<char>& buffer, const T& value)
+		{
+			const char* bytes = reinterpret_cast<const char*>(&value);
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		// type, entry size, first object, object count, encoding and payload size
+		const long long blockHeaderSize = 5 * sizeof(int) + sizeof(long long);
+	}
+
+	PopulationFileReader::PopulationFileReader():
+		version(0),
+		size(0),
+		byteArraySize(1)
+	{
+	}
+
+	/**
+	 * \detail
+	 * Both file versions start with the magic number, the version and the number of objects.
+	 * Version 1 continues with the length of the propagator name, the name and one block per
+	 * column consisting of the type, the entry size and entry_size * number_of_objects bytes.
+	 * Version 2 stores the byte array size in front of the propagator name and prefixes every
+	 * block with its type, entry size, first object, object count, encoding and payload size.
+	 * Blocks with BLOCK_ENCODING_SHUFFLE_LZ store the entries byte-shuffled (all first bytes,
+	 * then all second bytes and so on) and compressed with blockCompress().
+	 * This will not work between machines with different endianness!
+	 */
+	ErrorCode PopulationFileReader::open(const std::string& filename)
+	{
+		close();
+		in.open(filename.c_str(), std::ifstream::binary);
+		if(!in.is_open())
+			return FILE_NOT_FOUND;
+
+		int magic = 0;
+		if(!readValue(in, magic) || magic != POPULATION_FILE_MAGIC)
+		{
+			std::cout << filename << " does not appear to be an OPI population file." << std::endl;
+			return INVALID_FILE_FORMAT;
+		}
+		if(!readValue(in, version) || !readValue(in, size) || size < 0)
+			return INVALID_FILE_FORMAT;
+
+		ErrorCode status = SUCCESS;
+		if(version == 1)
+			status = readLegacyBlocks();
+		else if(version == 2)
+			status = readBlocks();
+		else
+		{
+			std::cout << "Unknown file version" << std::endl;
+			status = INVALID_FILE_FORMAT;
+		}
+		return status;
+	}
+
+	ErrorCode PopulationFileReader::readLegacyBlocks()
+	{
+		int nameLength = 0;
+		if(!readValue(in, nameLength) || nameLength < 0)
+			return INVALID_FILE_FORMAT;
+		// version 1 files contain the raw memory of the name object instead of the
+		// characters, so the stored name cannot be recovered
+		in.seekg(nameLength, std::ios::cur);
+		propagatorName = "None";
+		byteArraySize = 1;
+
+		bool hasVelocity = false;
+		PopulationFileBlock block;
+		while(readValue(in, block.type))
+		{
+			if(!readValue(in, block.entrySize) || block.entrySize <= 0)
+				return INVALID_FILE_FORMAT;
+			// version 1 writers labelled the acceleration block as velocity
+			if(block.type == DATA_VELOCITY)
+			{
+				if(hasVelocity) block.type = DATA_ACCELERATION;
+				hasVelocity = true;
+			}
+			if(block.type == DATA_BYTES)
+				byteArraySize = block.entrySize;
+			block.firstObject = 0;
+			block.objectCount = size;
+			block.encoding = 0;
+			block.payloadSize = (long long)block.entrySize * size;
+			block.offset = in.tellg();
+			blocks.push_back(block);
+			in.seekg(block.payloadSize, std::ios::cur);
+		}
+		in.clear();
+		return SUCCESS;
+	}
+
+	ErrorCode PopulationFileReader::readBlocks()
+	{
+		int nameLength = 0;
+		if(!readValue(in, byteArraySize) || !readValue(in, nameLength) || nameLength < 0)
+			return INVALID_FILE_FORMAT;
+		std::vector<char> name(nameLength);
+		if(nameLength > 0)
+			in.read(&name[0], nameLength);
+		propagatorName = std::string(name.begin(), name.end());
+
+		PopulationFileBlock block;
+		while(readValue(in, block.type))
+		{
+			if(!readValue(in, block.entrySize) || !readValue(in, block.firstObject)
+				|| !readValue(in, block.objectCount) || !readValue(in, block.encoding)
+				|| !readValue(in, block.payloadSize))
+				return INVALID_FILE_FORMAT;
+			if(block.entrySize <= 0 || block.firstObject < 0 || block.objectCount < 0
+				|| block.firstObject + block.objectCount > size)
+				return INVALID_FILE_FORMAT;
+			// raw payloads are read in place and must hold exactly the entries of the block
+			if(block.payloadSize < 0 || (block.encoding == BLOCK_ENCODING_RAW
+				&& block.payloadSize != (long long)block.entrySize * block.objectCount))
+				return INVALID_FILE_FORMAT;
+			block.offset = in.tellg();
+			blocks.push_back(block);
+			in.seekg(block.payloadSize, std::ios::cur);
+		}
+		in.clear();
+		return SUCCESS;
+	}
+
+	void PopulationFileReader::close()
+	{
+		if(in.is_open())
+			in.close();
+		in.clear();
+		blocks.clear();
+		version = 0;
+		size = 0;
+		byteArraySize = 1;
+		propagatorName = "";
+	}
+
+	int PopulationFileReader::getVersion() const
+	{
+		return version;
+	}
+
+	int PopulationFileReader::getSize() const
+	{
+		return size;
+	}
+
+	int PopulationFileReader::getByteArraySize() const
+	{
+		return byteArraySize;
+	}
+
+	const std::string& PopulationFileReader::getPropagatorName() const
+	{
+		return propagatorName;
+	}
+
+	bool PopulationFileReader::hasColumn(int type) const
+	{
+		for(size_t i = 0; i < blocks.size(); ++i)
+		{
+			if(blocks[i].type == type)
+				return true;
+		}
+		return false;
+	}
+
+	ErrorCode PopulationFileReader::readColumn(int type, int entrySize, int first, int count, char* dest)
+	{
+		if(first < 0 || count < 0 || first + count > size)
+			return INDEX_RANGE;
+		int last = first + count;
+		std::vector<const PopulationFileBlock*> encoded;
+		for(size_t i = 0; i < blocks.size(); ++i)
+		{
+			const PopulationFileBlock& block = blocks[i];
+			if(block.type != type)
+				continue;
+			// intersect the requested range with the block
+			int from = std::max(first, block.firstObject);
+			int to = std::min(last, block.firstObject + block.objectCount);
+			if(from >= to)
+				continue;
+			if(block.entrySize != entrySize)
+			{
+				std::cout << "Block " << type << " has entry size " << block.entrySize
+						  << ", expected " << entrySize << std::endl;
+				return INVALID_FILE_FORMAT;
+			}
+			if(block.encoding == BLOCK_ENCODING_SHUFFLE_LZ)
+			{
+				encoded.push_back(&block);
+				continue;
+			}
+			if(block.encoding != BLOCK_ENCODING_RAW)
+				return NOT_IMPLEMENTED;
+			in.seekg(block.offset + (long long)(from - block.firstObject) * entrySize);
+			in.read(dest + (long long)(from - first) * entrySize, (long long)(to - from) * entrySize);
+			if(!in.good())
+			{
+				in.clear();
+				return INVALID_FILE_FORMAT;
+			}
+		}
+		return readEncodedBlocks(encoded, first, last, dest);
+	}
+
+	/**
+	 * \detail
+	 * The payloads are read in batches of a few blocks per worker thread, every batch is
+	 * decoded in parallel while the memory required for compressed data stays bounded.
+	 */
+	ErrorCode PopulationFileReader::readEncodedBlocks(const std::vector<const PopulationFileBlock*>& encoded, int first, int last, char* dest)
+	{
+		const int batchSize = 2 * getWorkerCount();
+		std::vector<std::vector<char> > payloads(batchSize);
+		for(int start = 0; start < (int)encoded.size(); start += batchSize)
+		{
+			int batchEnd = std::min((int)encoded.size(), start + batchSize);
+			for(int i = start; i < batchEnd; ++i)
+			{
+				std::vector<char>& payload = payloads[i - start];
+				payload.resize(encoded[i]->payloadSize);
+				in.seekg(encoded[i]->offset);
+				in.read(payload.data(), payload.size());
+				if(!in.good())
+				{
+					in.clear();
+					return INVALID_FILE_FORMAT;
+				}
+			}
+
+			std::atomic<bool> failed(false);
+			parallelFor(start, batchEnd, 1, [&encoded, &payloads, &failed, start, first, last, dest](int begin, int end) {
+				std::vector<char> scratch;
+				for(int i = begin; i < end; ++i)
+				{
+					const PopulationFileBlock& block = *encoded[i];
+					const std::vector<char>& payload = payloads[i - start];
+					int from = std::max(first, block.firstObject);
+					int to = std::min(last, block.firstObject + block.objectCount);
+					if(!decodeBlock(payload.data(), payload.size(), block.entrySize, block.objectCount,
+									from - block.firstObject, to - block.firstObject,
+									dest + (long long)(from - first) * block.entrySize, scratch))
+						failed = true;
+				}
+			});
+			if(failed)
+				return INVALID_FILE_FORMAT;
+		}
+		return SUCCESS;
+	}
+
+	PositionalFile::PositionalFile()
+	{
+#ifdef WIN32
+		handle = INVALID_HANDLE_VALUE;
+#else
+		handle = -1;
+#endif
+	}
+
+	PositionalFile::~PositionalFile()
+	{
+		close();
+	}
+
+	bool PositionalFile::open(const std::string& filename)
+	{
+		close();
+#ifdef WIN32
+		handle = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+		handle = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+		return isOpen();
+	}
+
+	bool PositionalFile::writeAt(long long offset, const char* data, long long size)
+	{
+		while(size > 0)
+		{
+			// write in pieces of at most 1 GiB
+			long long piece = std::min(size, 1LL << 30);
+#ifdef WIN32
+			OVERLAPPED position;
+			memset(&position, 0, sizeof(OVERLAPPED));
+			position.Offset = (DWORD)(offset & 0xffffffff);
+			position.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD written = 0;
+			if(!WriteFile(handle, data, (DWORD)piece, &written, &position) || written == 0)
+				return false;
+#else
+			ssize_t written = pwrite(handle, data, piece, offset);
+			if(written < 0 && errno == EINTR)
+				continue;
+			if(written <= 0)
+				return false;
+#endif
+			offset += written;
+			data += written;
+			size -= written;
+		}
+		return true;
+	}
+
+	bool PositionalFile::sync(FileSyncPolicy policy)
+	{
+		if(policy == FILE_SYNC_NONE)
+			return true;
+#ifdef WIN32
+		return FlushFileBuffers(handle) != 0;
+#elif defined(__linux__)
+		if(policy == FILE_SYNC_DATA)
+			return fdatasync(handle) == 0;
+		return fsync(handle) == 0;
+#else
+		return fsync(handle) == 0;
+#endif
+	}
+
+	void PositionalFile::close()
+	{
+		if(isOpen())
+		{
+#ifdef WIN32
+			CloseHandle(handle);
+			handle = INVALID_HANDLE_VALUE;
+#else
+			::close(handle);
+			handle = -1;
+#endif
+		}
+	}
+
+	bool PositionalFile::isOpen() const
+	{
+#ifdef WIN32
+		return handle != INVALID_HANDLE_VALUE;
+#else
+		return handle >= 0;
+#endif
+	}
+
+	PopulationFileWriter::PopulationFileWriter():
+		fileEnd(0),
+		sizeOffset(0)
+	{
+	}
+
+	PopulationFileWriter::~PopulationFileWriter()
+	{
+		file.close();
+	}
+
+	ErrorCode PopulationFileWriter::open(const std::string& filename, const std::string& propagatorName, int byteArraySize)
+	{
+		pending.clear();
+		if(!file.open(filename))
+			return FILE_NOT_FOUND;
+		int nameLength = propagatorName.length();
+		std::vector<char> header;
+		appendValue(header, POPULATION_FILE_MAGIC);
+		appendValue(header, POPULATION_FILE_VERSION);
+		// the object count is patched when the file is finished
+		sizeOffset = header.size();
+		appendValue(header, 0);
+		appendValue(header, byteArraySize);
+		appendValue(header, nameLength);
+		header.insert(header.end(), propagatorName.begin(), propagatorName.end());
+		fileEnd = header.size();
+		return file.writeAt(0, &header[0], header.size()) ? SUCCESS : UNKNOWN_ERROR;
+	}
+
+	void PopulationFileWriter::addBlock(int type, int entrySize, int first, int count, const char* data, const ColumnCompression& compression)
+	{
+		PendingBlock entry;
+		entry.block.type = type;
+		entry.block.entrySize = entrySize;
+		entry.block.firstObject = first;
+		entry.block.objectCount = count;
+		entry.block.encoding = BLOCK_ENCODING_RAW;
+		entry.block.payloadSize = (long long)entrySize * count;
+		entry.block.offset = 0;
+		entry.data = data;
+		entry.compression = compression;
+		pending.push_back(entry);
+	}
+
+	void PopulationFileWriter::addColumn(int type, int entrySize, int first, int count, const char* data, const ColumnCompression& compression)
+	{
+		for(int i = 0; i < count; i += maxBlockObjects)
+		{
+			int blockCount = std::min(maxBlockObjects, count - i);
+			addBlock(type, entrySize, first + i, blockCount, data + (long long)i * entrySize, compression);
+		}
+	}
+
+	/**
+	 * \detail
+	 * The blocks are processed in batches of a few blocks per worker thread. All blocks of a
+	 * batch are encoded in parallel first, which determines their size and therefore their
+	 * position in the file. Afterwards, the blocks are distributed among several threads that
+	 * write them independently. Blocks that do not get smaller by compression are stored raw.
+	 */
+	ErrorCode PopulationFileWriter::flush()
+	{
+		if(!file.isOpen())
+			return FILE_NOT_FOUND;
+		std::atomic<bool> failed(false);
+		std::vector<PendingBlock>& blocks = pending;
+		PositionalFile& target = file;
+		const int batchSize = 2 * getWorkerCount();
+		std::vector<std::vector<char> > encoded(batchSize);
+		for(int start = 0; start < (int)blocks.size() && !failed; start += batchSize)
+		{
+			int batchEnd = std::min((int)blocks.size(), start + batchSize);
+			parallelFor(start, batchEnd, 1, [&blocks, &encoded, start](int begin, int end) {
+				std::vector<char> scratch;
+				for(int i = begin; i < end; ++i)
+				{
+					PopulationFileBlock& block = blocks[i].block;
+					std::vector<char>& payload = encoded[i - start];
+					if(encodeBlock(blocks[i].data, block.entrySize, block.objectCount, blocks[i].compression, payload, scratch))
+					{
+						block.encoding = BLOCK_ENCODING_SHUFFLE_LZ;
+						block.payloadSize = payload.size();
+					}
+				}
+			});
+
+			for(int i = start; i < batchEnd; ++i)
+			{
+				PopulationFileBlock& block = blocks[i].block;
+				block.offset = fileEnd + blockHeaderSize;
+				fileEnd = block.offset + block.payloadSize;
+			}
+
+			parallelFor(start, batchEnd, 1, [&blocks, &encoded, &target, &failed, start](int begin, int end) {
+				for(int i = begin; i < end && !failed; ++i)
+				{
+					const PopulationFileBlock& block = blocks[i].block;
+					const char* payload = (block.encoding == BLOCK_ENCODING_RAW) ? blocks[i].data : encoded[i - start].data();
+					std::vector<char> header;
+					appendValue(header, block.type);
+					appendValue(header, block.entrySize);
+					appendValue(header, block.firstObject);
+					appendValue(header, block.objectCount);
+					appendValue(header, block.encoding);
+					appendValue(header, block.payloadSize);
+					if(!target.writeAt(block.offset - blockHeaderSize, &header[0], header.size())
+						|| !target.writeAt(block.offset, payload, block.payloadSize))
+						failed = true;
+				}
+			});
+		}
+		pending.clear();
+		return failed ? UNKNOWN_ERROR : SUCCESS;
+	}
+
+	ErrorCode PopulationFileWriter::finish(int numObjects, FileSyncPolicy policy)
+	{
+		ErrorCode status = flush();
+		if(status == SUCCESS)
+		{
+			if(!file.writeAt(sizeOffset, reinterpret_cast<char*>(&numObjects), sizeof(int)) || !file.sync(policy))
+				status = UNKNOWN_ERROR;
+		}
+		file.close();
+		return status;
+	}
+
+	bool PopulationFileWriter::isOpen() const
+	{
+		return file.isOpen();
+	}
+
+	/**
+	 * \endcond
+	 */
+}
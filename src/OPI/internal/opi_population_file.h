@@ -0,0 +1,178 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_POPULATION_FILE_H
+#define OPI_POPULATION_FILE_H
+#include "../opi_error.h"
+#include "opi_compression.h"
+#include <string>
+#include <vector>
+#include <fstream>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+
+	//! Magic number at the beginning of every population file
+	const int POPULATION_FILE_MAGIC = 47627;
+	//! The file version written by this version of OPI
+	const int POPULATION_FILE_VERSION = 2;
+
+	//! Describes one block of column data inside a population file
+	/**
+	 * Version 1 files contain exactly one block per column that covers all objects.
+	 * Version 2 files may contain any number of blocks per column, each one covering
+	 * the object range [firstObject, firstObject + objectCount).
+	 */
+	struct PopulationFileBlock
+	{
+		//! The column type (a value of DataType)
+		int type;
+		//! Size in bytes of one entry
+		int entrySize;
+		//! Index of the first object stored in this block
+		int firstObject;
+		//! Number of objects stored in this block
+		int objectCount;
+		//! Encoding of the payload (BLOCK_ENCODING_RAW or BLOCK_ENCODING_SHUFFLE_LZ)
+		int encoding;
+		//! Size of the payload in bytes
+		long long payloadSize;
+		//! Position of the payload in the file (not stored)
+		long long offset;
+	};
+
+	//! Low-level reader for population files
+	/**
+	 * Opening a file only parses the header and the block headers, the payload is read on
+	 * request so that arbitrary object ranges can be loaded without reading the whole file.
+	 * Compressed blocks are always read completely and decoded on multiple threads.
+	 */
+	class PopulationFileReader
+	{
+		public:
+			PopulationFileReader();
+
+			//! Opens a file and builds the block index
+			ErrorCode open(const std::string& filename);
+			//! Closes the file
+			void close();
+
+			//! Returns the file version
+			int getVersion() const;
+			//! Returns the number of objects stored in the file
+			int getSize() const;
+			//! Returns the per-object size of the byte array
+			int getByteArraySize() const;
+			//! Returns the name of the last propagator stored in the file
+			const std::string& getPropagatorName() const;
+
+			//! Checks if the file contains data for the given column
+			bool hasColumn(int type) const;
+			//! Reads the entries [first, first + count) of a column to dest
+			ErrorCode readColumn(int type, int entrySize, int first, int count, char* dest);
+
+		private:
+			ErrorCode readLegacyBlocks();
+			ErrorCode readBlocks();
+			ErrorCode readEncodedBlocks(const std::vector<const PopulationFileBlock*>& encoded, int first, int last, char* dest);
+
+			std::ifstream in;
+			int version;
+			int size;
+			int byteArraySize;
+			std::string propagatorName;
+			std::vector<PopulationFileBlock> blocks;
+	};
+
+	//! A file that supports concurrent writes at explicit positions
+	class PositionalFile
+	{
+		public:
+			PositionalFile();
+			~PositionalFile();
+
+			//! Creates (or truncates) the file
+			bool open(const std::string& filename);
+			//! Writes size bytes at the given offset, may be called from multiple threads
+			bool writeAt(long long offset, const char* data, long long size);
+			//! Flushes the file contents to the storage device
+			bool sync(FileSyncPolicy policy);
+			//! Closes the file
+			void close();
+			//! Checks if the file is open
+			bool isOpen() const;
+
+		private:
+#ifdef WIN32
+			void* handle;
+#else
+			int handle;
+#endif
+	};
+
+	//! Low-level writer for population files
+	/**
+	 * Blocks are queued with addBlock() or addColumn() and written by flush(), which encodes
+	 * and writes the payloads in parallel at precomputed positions. The total number of objects
+	 * is written to the header when the file is finished.
+	 */
+	class PopulationFileWriter
+	{
+		public:
+			PopulationFileWriter();
+			~PopulationFileWriter();
+
+			//! Creates the file and writes the header
+			ErrorCode open(const std::string& filename, const std::string& propagatorName, int byteArraySize);
+			//! Queues a block, data must stay valid until flush() returns
+			void addBlock(int type, int entrySize, int first, int count, const char* data,
+						  const ColumnCompression& compression = ColumnCompression());
+			//! Queues a column split into blocks of at most maxBlockObjects objects
+			void addColumn(int type, int entrySize, int first, int count, const char* data,
+						   const ColumnCompression& compression = ColumnCompression());
+			//! Writes all queued blocks
+			ErrorCode flush();
+			//! Writes the final object count and closes the file
+			ErrorCode finish(int numObjects, FileSyncPolicy policy = FILE_SYNC_NONE);
+
+			//! Checks if the file has been opened successfully
+			bool isOpen() const;
+
+			//! The maximum number of objects per block written by addColumn()
+			static const int maxBlockObjects = 65536;
+
+		private:
+			struct PendingBlock
+			{
+				PopulationFileBlock block;
+				const char* data;
+				ColumnCompression compression;
+			};
+
+			PositionalFile file;
+			long long fileEnd;
+			long long sizeOffset;
+			std::vector<PendingBlock> pending;
+	};
+
+	/**
+	 * \endcond
+	 */
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include "opi_propagator_plugin.h"
 #include "opi_plugin.h"
 #include "dynlib.h"
+#include "../opi_trajectory_buffer.h"
 namespace OPI
 {
 	/**
@@ -35,6 +36,7 @@ namespace OPI
 		proc_propagate = (pluginPropagateFunction)(handle->loadFunction("OPI_Plugin_propagate", true));
 		proc_propagate_indexed = (pluginPropagateFunctionIndexed)(handle->loadFunction("OPI_Plugin_propagateIndexed", true));
         proc_propagate_multitime = (pluginPropagateFunctionMultiTime)(handle->loadFunction("OPI_Plugin_propagateMultiTime", true));
+        proc_propagate_trajectory = (pluginPropagateFunctionTrajectory)(handle->loadFunction("OPI_Plugin_propagateTrajectory", true));
 		setName(plugin->getName());
 		setAuthor(plugin->getAuthor());
 		setDescription(plugin->getDescription());
@@ -76,6 +78,18 @@ namespace OPI
         return NOT_IMPLEMENTED;
     }
 
+    ErrorCode PropagatorPlugin::runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory)
+    {
+        if(proc_propagate_trajectory)
+        {
+            ErrorCode status = proc_propagate_trajectory(this, &data, julian_days, length,
+                trajectory.getPosition(DEVICE_HOST, true), trajectory.getVelocity(DEVICE_HOST, true));
+            trajectory.update(DEVICE_HOST);
+            return status;
+        }
+        return NOT_IMPLEMENTED;
+    }
+
 	int PropagatorPlugin::requiresCUDA()
 	{
 		return 0;
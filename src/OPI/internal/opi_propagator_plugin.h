@@ -38,6 +38,7 @@ namespace OPI
             virtual ErrorCode runPropagation(Population& data, double julian_day, double dt);
             virtual ErrorCode runIndexedPropagation(Population& data, int* indices, int index_size, double julian_day, double dt);
             virtual ErrorCode runMultiTimePropagation(Population& data, double* julian_days, int length, double dt);
+            virtual ErrorCode runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory);
 			virtual int requiresCUDA();
 		private:
 			Plugin* plugin;
@@ -45,6 +46,7 @@ namespace OPI
 			pluginPropagateFunction proc_propagate;
 			pluginPropagateFunctionIndexed proc_propagate_indexed;
             pluginPropagateFunctionMultiTime proc_propagate_multitime;
+            pluginPropagateFunctionTrajectory proc_propagate_trajectory;
 			pluginInitFunction proc_init;
 
 	};
@@ -18,20 +18,56 @@
 #define OPI_SYNCHRONIZED_DATA_H
 #include "../opi_host.h"
 #include "opi_gpusupport.h"
+#include "opi_parallel.h"
+#include "opi_memory.h"
 #include <vector>
 #include <map>
+#include <memory>
 #include <algorithm>
 namespace OPI
 {
+	//! Type independent interface of SynchronizedData used to place several columns in one memory block
+	class SynchronizedStorage
+	{
+		public:
+			virtual ~SynchronizedStorage() {}
+
+			//! Returns the size of one object in bytes
+			virtual size_t getEntrySize() const = 0;
+			//! Returns the number of used objects
+			virtual int getSize() = 0;
+			//! Checks if the memory of the device holds the latest data
+			virtual bool isCurrent(Device device) const = 0;
+			//! Marks the memory of the device as up to date after it has been copied externally
+			virtual void setCurrent(Device device) = 0;
+			//! Checks if the memory of the device is an exclusively used region of block at offset
+			virtual bool ownsRegion(Device device, const void* block, size_t offset) const = 0;
+			//! Moves the host memory to a region of capacity objects at offset bytes inside of block
+			virtual void attachHost(const std::shared_ptr<char>& block, size_t offset, int capacity) = 0;
+			//! Moves the memory of a device to the region at offset bytes inside of block
+			virtual void attachDevice(Device device, const std::shared_ptr<DeviceMemory>& block, size_t offset) = 0;
+	};
+
 	//! Template based inter-device synchronization helper class
+	/**
+	 * The host memory and the memory on each device (the replicas) are reference counted and
+	 * may be shared with other SynchronizedData objects (see share()). A shared replica is
+	 * duplicated as soon as one of the objects requests a pointer to it, all other replicas
+	 * remain shared.
+	 *
+	 * Replicas can also be regions of larger memory blocks shared by several objects (see
+	 * attachHost() and attachDevice()), e.g. to transfer several columns with a single copy.
+	 */
 	template< class DataType >
-	class SynchronizedData
+	class SynchronizedData: public SynchronizedStorage
 	{
 		public:
             //! Initialize with a reference to the host object
             SynchronizedData(Host& owning_host);
 			~SynchronizedData();
 
+			//! Shares all replicas of source instead of copying them
+			void share(const SynchronizedData& source);
 			//! Reserves space to hold a specific amount of objects
 			void reserve(int num_Objects);
 			//! Resize all memory objects
@@ -56,12 +92,26 @@ namespace OPI
 			void add(const DataType& object);
 			//! Sets an specific object
 			void set(const DataType& object, int index);
+			//! Replaces all objects with count objects from values on the host
+			void assign(const DataType* values, int count);
+			//! Removes all objects, the allocated memory is kept for reuse
+			void clear(bool keepReservation = true);
 
 			//! Checks if some data has been stored
 			bool hasData();
 
 			//! Removes duplicate data entries
 			void removeDuplicates();
+
+			//! Copies the latest data to dest without changing the synchronization state
+			void snapshot(DataType* dest);
+
+			size_t getEntrySize() const;
+			bool isCurrent(Device device) const;
+			void setCurrent(Device device);
+			bool ownsRegion(Device device, const void* block, size_t offset) const;
+			void attachHost(const std::shared_ptr<char>& block, size_t offset, int capacity);
+			void attachDevice(Device device, const std::shared_ptr<DeviceMemory>& block, size_t offset);
 		private:
 			//! Makes sure the data pointer on the specific device is allocated
 			void ensure_allocation(Device device);
@@ -73,16 +123,21 @@ namespace OPI
 			//! Clears all device data but keeps host data
 			void clearDevices();
 
+			//! Returns the host memory, duplicating it first if it is shared
+			HostArray<DataType>& hostVector(bool keepContent = true);
+			//! Returns the pointer to the memory of a device
+			DataType* devicePointer(Device device);
+
 			//! the host memory
-			std::vector<DataType> hostData;
+			std::shared_ptr< HostArray<DataType> > hostData;
 			//! if the host needs an update
 			bool hostNeedsUpdate;
 			//! Device specific data container
 			struct DeviceData
 			{
-					DeviceData(): ptr(0),needsUpdate(false)	{ }
-					//! The pointer to the on-device memory data location
-					DataType* ptr;
+					DeviceData(): needsUpdate(false)	{ }
+					//! The on-device memory, may be shared with other objects
+					std::shared_ptr<DeviceMemory> buffer;
 					//! If this device needs an update
 					bool needsUpdate;
 			};
@@ -99,6 +154,7 @@ namespace OPI
 
 	template<class DataType>
     SynchronizedData<DataType>::SynchronizedData(Host& owning_host):
+		hostData(std::make_shared< HostArray<DataType> >(owning_host.getHostAllocator())),
 		host(owning_host)
 	{
 		// set latest device to -1
@@ -112,24 +168,49 @@ namespace OPI
 	template<class DataType>
 	SynchronizedData<DataType>::~SynchronizedData()
 	{
-		// retrieve cuda support object
-		GpuSupport* cuda = host.getGPUSupport();
-		// check if the object is valid
-		if(cuda) {
-			// store currently selected device
-			int oldDevice = cuda->getCurrentDevice();
-			for(typename std::map<Device, DeviceData>::iterator itr = deviceData.begin(); itr != deviceData.end(); ++itr) {
-				// check if the pointer is allocated (not 0)
-				if(itr->second.ptr) {
-					// select device
-					cuda->selectDevice(itr->first - DEVICE_CUDA);
-					// and free pointer
-					cuda->free(itr->second.ptr);
-				}
-			}
-			// select the old device again
-			cuda->selectDevice(oldDevice);
+		// device memory is freed by the last owner of each buffer
+	}
+
+	template<class DataType>
+	DataType* SynchronizedData<DataType>::devicePointer(Device device)
+	{
+		DeviceData& replica = deviceData[device];
+		return replica.buffer ? static_cast<DataType*>(replica.buffer->ptr) : 0;
+	}
+
+	/**
+	 * The replicas are duplicated on the first call to getData() or any other modifying
+	 * function of either object, so sharing is O(1). Pointers returned by getData() before
+	 * sharing still point to the shared replica and must not be used for writing afterwards.
+	 */
+	template<class DataType>
+	void SynchronizedData<DataType>::share(const SynchronizedData& source)
+	{
+		hostData = source.hostData;
+		hostNeedsUpdate = source.hostNeedsUpdate;
+		deviceData = source.deviceData;
+		latestDevice = source.latestDevice;
+		numObjects = source.numObjects;
+		reservedSize = source.reservedSize;
+	}
+
+	/**
+	 * If keepContent is false and the memory is shared, the returned vector has the same size
+	 * but undefined content. This is used before downloading the latest data from a device.
+	 */
+	template<class DataType>
+	HostArray<DataType>& SynchronizedData<DataType>::hostVector(bool keepContent)
+	{
+		if(hostData.use_count() > 1) {
+			std::shared_ptr< HostArray<DataType> > copy = std::make_shared< HostArray<DataType> >(host.getHostAllocator());
+			copy->reserve(hostData->capacity());
+			if(keepContent)
+				copy->assign(hostData->begin(), hostData->end());
+			else
+				copy->resize(hostData->size());
+			hostData = copy;
 		}
+		return *hostData;
 	}
 
 	template<class DataType>
@@ -137,8 +218,9 @@ namespace OPI
 	{
 		ensure_synchronization(DEVICE_HOST);
 		reserve(numObjects + 1);
-		hostData.resize(numObjects + 1);
-		hostData[numObjects] = object;
+		HostArray<DataType>& values = hostVector();
+		values.resize(numObjects + 1);
+		values[numObjects] = object;
 		resize(numObjects + 1);
 		update(DEVICE_HOST);
 	}
@@ -149,18 +231,47 @@ namespace OPI
 		if((index >= 0)&&(index < numObjects))
 		{
 			ensure_synchronization(DEVICE_HOST);
-			hostData[index] = object;
+			hostVector()[index] = object;
 			update(DEVICE_HOST);
 		}
 	}
 
+	template<class DataType>
+	void SynchronizedData<DataType>::assign(const DataType* values, int count)
+	{
+		clearDevices();
+		HostArray<DataType>& hostValues = hostVector(false);
+		hostValues.assign(values, values + count);
+		numObjects = count;
+		reservedSize = count;
+		update(DEVICE_HOST);
+	}
+
+	/**
+	 * If keepReservation is false, the reserved size is reset as well, but the host memory
+	 * is still kept. Memory shared with a copy is released instead of being duplicated.
+	 */
+	template<class DataType>
+	void SynchronizedData<DataType>::clear(bool keepReservation)
+	{
+		if(hostData.use_count() > 1)
+			hostData = std::make_shared< HostArray<DataType> >(host.getHostAllocator());
+		else
+			hostData->resize(0);
+		numObjects = 0;
+		if(!keepReservation)
+			reservedSize = 0;
+		update(DEVICE_HOST);
+	}
+
 	template<class DataType>
 	void SynchronizedData<DataType>::sort()
 	{
 		if(hasData())
 		{
 			ensure_synchronization(DEVICE_HOST);
-			std::sort(hostData.begin(), hostData.end());
+			HostArray<DataType>& values = hostVector();
+			std::sort(values.begin(), values.end());
 
 			update(DEVICE_HOST);
 		}
@@ -171,11 +282,11 @@ namespace OPI
 	{
 		// check if there is any data stored
 		bool hasDataStored = false;
-		if(hostData.size() > 0)
+		if(hostData->size() > 0)
 			hasDataStored = true;
 		for(typename std::map<Device, DeviceData>::iterator itr = deviceData.begin(); itr != deviceData.end(); ++itr) {
 			// check if pointer is allocated
-			if(itr->second.ptr) {
+			if(itr->second.buffer) {
 				hasDataStored = true;
 			}
 		}
@@ -200,36 +311,20 @@ namespace OPI
 	void SynchronizedData<DataType>::removeDuplicates()
 	{
 		ensure_synchronization(DEVICE_HOST);
-		std::sort( hostData.begin(), hostData.end());
-		hostData.erase( std::unique( hostData.begin(), hostData.end()), hostData.end() );
-		numObjects = hostData.size();
+		HostArray<DataType>& values = hostVector();
+		std::sort( values.begin(), values.end());
+		values.erase( std::unique( values.begin(), values.end()), values.end() );
+		numObjects = values.size();
 		update(DEVICE_HOST);
 	}
 
 	template<class DataType>
 	void SynchronizedData<DataType>::clearDevices()
 	{
-		// retrieve cuda support object
-		GpuSupport* cuda = host.getGPUSupport();
-		// check if the object is valid
-		if(cuda) {
-			// store current device
-			int oldDevice = cuda->getCurrentDevice();
-			// invalidate all device pointers
-			for(typename std::map<Device, DeviceData>::iterator itr = deviceData.begin(); itr != deviceData.end(); ++itr) {
-				// check if pointer is allocated
-				if(itr->second.ptr) {
-					// select device
-					cuda->selectDevice(itr->first - DEVICE_CUDA);
-					// free memory
-					cuda->free(itr->second.ptr);
-				}
-				// reset to default values
-				itr->second.ptr = 0;
-				itr->second.needsUpdate = false;
-			}
-			// select the previously selected cuda device
-			cuda->selectDevice(oldDevice);
+		// release all device buffers, the memory is freed if no other object shares it
+		for(typename std::map<Device, DeviceData>::iterator itr = deviceData.begin(); itr != deviceData.end(); ++itr) {
+			itr->second.buffer.reset();
+			itr->second.needsUpdate = false;
 		}
 	}
 
@@ -237,16 +332,21 @@ namespace OPI
 	template<class DataType>
     void SynchronizedData<DataType>::remove(int index, int arraySize)
 	{
-		// check if data is available and the index range is valid
-		if((hasData()) && (index >= 0) && (index < numObjects))
+		// check if the index range is valid
+		if((index >= 0) && (index + arraySize <= numObjects))
 		{
-			// synchronize data to host
-			ensure_synchronization(DEVICE_HOST);
-			// erase element from host vector
-            hostData.erase(hostData.begin() + index, hostData.begin() + index + arraySize);
-			// update where the latest information is located
-			update(DEVICE_HOST);
-			numObjects -= 1;
+			// columns without data only change their size
+			if(hasData())
+			{
+				// synchronize data to host
+				ensure_synchronization(DEVICE_HOST);
+				// erase element from host vector
+				HostArray<DataType>& values = hostVector();
+				values.erase(values.begin() + index, values.begin() + index + arraySize);
+				// update where the latest information is located
+				update(DEVICE_HOST);
+			}
+			numObjects -= arraySize;
 		}
 	}
 
@@ -262,7 +362,7 @@ namespace OPI
 				// then delete all device data
 				clearDevices();
 				// resize the host vector
-				hostData.reserve(num_Objects);
+				hostVector().reserve(num_Objects);
 				// now the host holds the latest information
 				hostNeedsUpdate = false;
 				latestDevice = DEVICE_HOST;
@@ -287,9 +387,9 @@ namespace OPI
 		{
 			reserve(num_Objects);
 		}
-		if(hostData.capacity() > 0)
+		if(hostData->capacity() > 0)
 		{
-			hostData.resize(num_Objects);
+			hostVector().resize(num_Objects);
 		}
 		numObjects = num_Objects;
     }
@@ -310,9 +410,9 @@ namespace OPI
 		else // we want a synchronization
 			ensure_synchronization(device);
 		if(device == DEVICE_HOST)
-			return hostData.data();
+			return hostData->data();
 		else
-			return deviceData[device].ptr;
+			return devicePointer(device);
 	}
 
 	template<class DataType>
@@ -320,9 +420,11 @@ namespace OPI
 	{
 		// host device?
 		if(device == DEVICE_HOST) {
-			if(hostData.capacity() != (size_t)reservedSize)
-				hostData.reserve(reservedSize);
-			hostData.resize(numObjects);
+			// the content of an outdated replica does not need to be duplicated
+			HostArray<DataType>& values = hostVector(!hostNeedsUpdate);
+			if(values.capacity() != (size_t)reservedSize)
+				values.reserve(reservedSize);
+			values.resize(numObjects);
 		}
 		else if ((device >= DEVICE_CUDA)&&(device <= DEVICE_CUDA_LAST)) {
 			// retrieve cuda support object from host
@@ -331,18 +433,26 @@ namespace OPI
 			if(cuda) {
 				// check if the requested device is not out of range
 				if((device - DEVICE_CUDA) < cuda->getDeviceCount()) {
+					DeviceData& replica = deviceData[device];
 					// check if pointer already allocated
-					if(!deviceData[device].ptr)
+					if(!replica.buffer)
 					{
-						// if not change device
-						int oldDevice = cuda->getCurrentDevice();
-						cuda->selectDevice(device - DEVICE_CUDA);
-						// allocate
-                        cuda->allocate((void**)&(deviceData[device].ptr), sizeof(DataType) * reservedSize);
+						replica.buffer = std::make_shared<DeviceMemory>(host, device, sizeof(DataType) * reservedSize);
 						// set needUpdate flag to true
-						deviceData[device].needsUpdate = true;
-						// select the old device
-						cuda->selectDevice(oldDevice);
+						replica.needsUpdate = true;
+					}
+					else if(replica.buffer.use_count() > 1)
+					{
+						// GpuSupport cannot copy between device buffers, so an up-to-date
+						// shared replica is duplicated through the host memory
+						bool upToDate = (latestDevice == device) || !replica.needsUpdate;
+						if(upToDate)
+							ensure_synchronization(DEVICE_HOST);
+						replica.buffer = std::make_shared<DeviceMemory>(host, device, sizeof(DataType) * reservedSize);
+						if(upToDate)
+							sync_host_to_device(device);
+						else
+							replica.needsUpdate = true;
 					}
 				}
 				else // unknown device
@@ -377,8 +487,9 @@ namespace OPI
 							// select new device
 							cuda->selectDevice(latestDevice - DEVICE_CUDA);
 							// copy data from device to host
-							hostData.resize(numObjects);
-                            cuda->copy(hostData.data(), deviceData[latestDevice].ptr, sizeof(DataType) * numObjects, false);
+							HostArray<DataType>& values = hostVector(false);
+							values.resize(numObjects);
+                            cuda->copy(values.data(), devicePointer(latestDevice), sizeof(DataType) * numObjects, false);
 							// set update flag to false, since we just updated the values
 							hostNeedsUpdate = false;
 							// select the old device
@@ -392,8 +503,10 @@ namespace OPI
 				}
 			}
 			else if ((device >= DEVICE_CUDA)&&(device <= DEVICE_CUDA_LAST)) {
-				// check if pointer already allocated
-				if(latestDevice == DEVICE_HOST) {
+				// the device memory is up to date (e.g. after a batched transfer)
+				if(!deviceData[device].needsUpdate) {
+				}
+				else if(latestDevice == DEVICE_HOST) {
 					sync_host_to_device(device);
 				}
 				else if((latestDevice >= DEVICE_CUDA)&&(latestDevice <= DEVICE_CUDA_LAST)) {
@@ -401,8 +514,6 @@ namespace OPI
 					ensure_synchronization(DEVICE_HOST);
 					// now synchronize from our host to the requested device
 					sync_host_to_device(device);
-					// update the dirty flag
-					deviceData[device].needsUpdate = false;
 				}
 				else // unknown device
 					host.sendError(INVALID_DEVICE);
@@ -424,7 +535,8 @@ namespace OPI
 			// select the right device
 			cuda->selectDevice(device - DEVICE_CUDA);
 			// copy data from host to device
-            cuda->copy(deviceData[device].ptr, hostData.data(), sizeof(DataType) * numObjects, true);
+            cuda->copy(devicePointer(device), hostData->data(), sizeof(DataType) * numObjects, true);
+			deviceData[device].needsUpdate = false;
 			// select the old device again
 			cuda->selectDevice(oldDevice);
 		}
@@ -432,6 +544,111 @@ namespace OPI
 			host.sendError(CUDA_REQUIRED);
 	}
 
+	template<class DataType>
+	void SynchronizedData<DataType>::snapshot(DataType* dest)
+	{
+		if(hostNeedsUpdate && (latestDevice >= DEVICE_CUDA) && (latestDevice <= DEVICE_CUDA_LAST)) {
+			// retrieve cuda support object
+			GpuSupport* cuda = host.getGPUSupport();
+			if(cuda) {
+				// copy directly from the device with the latest data
+				int oldDevice = cuda->getCurrentDevice();
+				cuda->selectDevice(latestDevice - DEVICE_CUDA);
+				cuda->copy(dest, devicePointer(latestDevice), sizeof(DataType) * numObjects, false);
+				cuda->selectDevice(oldDevice);
+			}
+			else // no cuda support
+				host.sendError(CUDA_REQUIRED);
+		}
+		else if(hostData->size() >= (size_t)numObjects) {
+			// copy large arrays using multiple threads
+			const DataType* source = hostData->data();
+			parallelFor(0, numObjects, 1 << 16, [source, dest](int begin, int end) {
+				std::copy(source + begin, source + end, dest + begin);
+			});
+		}
+	}
+
+	template<class DataType>
+	size_t SynchronizedData<DataType>::getEntrySize() const
+	{
+		return sizeof(DataType);
+	}
+
+	template<class DataType>
+	bool SynchronizedData<DataType>::isCurrent(Device device) const
+	{
+		if(device == DEVICE_HOST)
+			return !hostNeedsUpdate;
+		typename std::map<Device, DeviceData>::const_iterator itr = deviceData.find(device);
+		if(itr == deviceData.end() || !itr->second.buffer)
+			return false;
+		return (latestDevice == device) || !itr->second.needsUpdate;
+	}
+
+	template<class DataType>
+	void SynchronizedData<DataType>::setCurrent(Device device)
+	{
+		if(device == DEVICE_HOST)
+			hostNeedsUpdate = false;
+		else
+			deviceData[device].needsUpdate = false;
+	}
+
+	template<class DataType>
+	bool SynchronizedData<DataType>::ownsRegion(Device device, const void* block, size_t offset) const
+	{
+		const void* expected = static_cast<const char*>(block) + offset;
+		if(device == DEVICE_HOST)
+			return hostData.use_count() == 1 && hostData->data() == expected;
+		typename std::map<Device, DeviceData>::const_iterator itr = deviceData.find(device);
+		if(itr == deviceData.end() || !itr->second.buffer)
+			return false;
+		return itr->second.buffer.use_count() == 1 && itr->second.buffer->ptr == expected;
+	}
+
+	/**
+	 * The latest data is synchronized to the host first, so the host memory holds all
+	 * objects afterwards even if it did not hold any data before. Device memory is released
+	 * because its capacity might differ from the new region.
+	 */
+	template<class DataType>
+	void SynchronizedData<DataType>::attachHost(const std::shared_ptr<char>& block, size_t offset, int capacity)
+	{
+		if(hasData())
+			ensure_synchronization(DEVICE_HOST);
+		// a shared array is replaced instead of moving its content
+		if(hostData.use_count() > 1) {
+			std::shared_ptr< HostArray<DataType> > region = std::make_shared< HostArray<DataType> >(host.getHostAllocator());
+			region->attach(block, reinterpret_cast<DataType*>(block.get() + offset), capacity);
+			region->assign(hostData->begin(), hostData->begin() + std::min<size_t>(hostData->size(), capacity));
+			hostData = region;
+		}
+		else
+			hostData->attach(block, reinterpret_cast<DataType*>(block.get() + offset), capacity);
+		clearDevices();
+		reservedSize = capacity;
+		numObjects = std::min(numObjects, capacity);
+		hostData->resize(numObjects);
+		if(latestDevice != DEVICE_NOT_SET)
+			latestDevice = DEVICE_HOST;
+	}
+
+	template<class DataType>
+	void SynchronizedData<DataType>::attachDevice(Device device, const std::shared_ptr<DeviceMemory>& block, size_t offset)
+	{
+		DeviceData& replica = deviceData[device];
+		if(replica.buffer && replica.buffer->ptr == static_cast<char*>(block->ptr) + offset)
+			return;
+		// the host has to hold the latest data before the old memory is released
+		if(latestDevice == device && hostNeedsUpdate)
+			ensure_synchronization(DEVICE_HOST);
+		if(latestDevice == device)
+			latestDevice = DEVICE_HOST;
+		replica.buffer = std::make_shared<DeviceMemory>(block, offset);
+		replica.needsUpdate = true;
+	}
+
 	template<class DataType>
 	void SynchronizedData<DataType>::update(Device device)
 	{
@@ -441,7 +658,7 @@ namespace OPI
 		for(typename std::map<Device, DeviceData>::iterator itr = deviceData.begin(); itr != deviceData.end(); ++itr)
 		{
 			// if the device has some memory allocated
-			if(itr->second.ptr)
+			if(itr->second.buffer)
 				// it may need an update
 				itr->second.needsUpdate = (itr->first != device);
 		}
@@ -0,0 +1,51 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_ALLOCATOR_H
+#define OPI_ALLOCATOR_H
+#include "opi_common.h"
+#include <cstddef>
+namespace OPI
+{
+	/*! \brief Interface for the host memory of Populations, IndexLists and IndexPairLists.
+	 * \ingroup CPP_API_GROUP
+	 *
+	 * All host memory of these classes is requested from the allocator of their Host.
+	 * Implementations must be thread-safe, since memory may be allocated and freed on
+	 * several threads at the same time.
+	 */
+	class OPI_API_EXPORT HostAllocator
+	{
+		public:
+			virtual ~HostAllocator() {}
+
+			/**
+			 * @brief allocate Allocates a block of host memory.
+			 * @param bytes The size of the block in bytes, never zero.
+			 * @return A pointer aligned to at least 64 bytes, or a null pointer on failure.
+			 */
+			virtual void* allocate(size_t bytes) = 0;
+
+			/**
+			 * @brief free Releases a block returned by allocate().
+			 * @param memory The pointer returned by allocate().
+			 * @param bytes The size that was passed to allocate().
+			 */
+			virtual void free(void* memory, size_t bytes) = 0;
+	};
+}
+
+#endif
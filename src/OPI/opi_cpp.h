@@ -18,12 +18,21 @@
 #define OPI_CPP_API_H
 #include "opi_error.h"
 #include "opi_population.h"
+#include "opi_population_stream.h"
+#include "opi_population_checkpoint.h"
 #include "opi_indexpairlist.h"
 #include "opi_indexlist.h"
+#include "opi_trajectory_buffer.h"
 #include "opi_host.h"
+#include "opi_allocator.h"
 #include "opi_propagator.h"
 #include "opi_perturbation_module.h"
+#include "opi_propagator_integrator.h"
+#include "opi_custom_propagator.h"
 #include "opi_query.h"
 #include "opi_collisiondetection.h"
 #include "opi_gpusupport.h"
+#include "opi_orbit_math.h"
+#include "opi_frame_transform.h"
+#include "opi_ephemeris_cache.h"
 #endif
@@ -15,6 +15,13 @@
  * License along with this library.
  */
 #include "opi_custom_propagator.h"
+#include "opi_perturbation_module.h"
+#include "opi_propagator_integrator.h"
+#include "opi_orbit_math.h"
+#include "internal/opi_parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
 
 namespace OPI
 {
@@ -22,12 +29,54 @@ namespace OPI
 	{
 		std::vector<PerturbationModule*> modules;
 		PropagatorIntegrator* integrator;
+		double mu;
+		//! modules used by the running propagation, including the assigned ones
+		std::vector<PerturbationModule*> activeModules;
+		//! per-thread sums of the element changes, kept to avoid reallocation
+		std::vector< std::vector<Orbit> > deltas;
 	};
 
+	namespace
+	{
+		//! Returns the columns of the Population that are allocated
+		DataMask getAllocatedColumns(const Population& data)
+		{
+			DataMask columns = MASK_NONE;
+			for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+			{
+				if(data.hasData(type))
+					columns |= 1 << type;
+			}
+			return columns;
+		}
+
+		//! Allocates the columns on the host and detaches them from copies of the Population
+		void materializeColumns(const Population& data, DataMask columns)
+		{
+			if(columns & MASK_ORBIT)
+				data.getOrbit();
+			if(columns & MASK_PROPERTIES)
+				data.getObjectProperties();
+			if(columns & MASK_CARTESIAN)
+				data.getPosition();
+			if(columns & MASK_VELOCITY)
+				data.getVelocity();
+			if(columns & MASK_ACCELERATION)
+				data.getAcceleration();
+			if(columns & MASK_BYTES)
+				data.getBytes();
+			if(columns & MASK_EPOCH)
+				data.getEpoch();
+		}
+	}
+
 	CustomPropagator::CustomPropagator(const std::string &name)
 	{
 		setName(name);
+		useModules();
 		impl->integrator = 0;
+		impl->mu = EARTH_MU;
+		registerProperty("mu", &impl->mu);
 	}
 
 	CustomPropagator::~CustomPropagator()
@@ -45,11 +94,181 @@ namespace OPI
 		impl->integrator = integrator;
 	}
 
+	PropagatorIntegrator* CustomPropagator::getIntegrator() const
+	{
+		return impl->integrator;
+	}
+
+	double CustomPropagator::getGravitationalParameter() const
+	{
+		return impl->mu;
+	}
+
+	/**
+	 * \detail
+	 * All modules are enabled and prepared for the time step before the propagation; the
+	 * columns read by any module are synchronized to the host once, so that the modules
+	 * can access them concurrently.
+	 */
     ErrorCode CustomPropagator::runPropagation(Population& data, double julian_day, double dt )
 	{
+		impl->activeModules = impl->modules;
+		for(int i = 0; i < getPerturbationModuleCount(); ++i)
+			impl->activeModules.push_back(getPerturbationModule(i));
+
+		ErrorCode status = SUCCESS;
+		DataMask read = MASK_NONE;
+		for(size_t i = 0; i < impl->activeModules.size() && status == SUCCESS; ++i)
+		{
+			status = impl->activeModules[i]->enable();
+			if(status == SUCCESS)
+				status = impl->activeModules[i]->setTimeStep(julian_day);
+			read |= impl->activeModules[i]->getReadColumns();
+		}
+		if(status != SUCCESS)
+			return status;
+		data.prefetch(read & getAllocatedColumns(data));
+
+		if(!impl->integrator)
+			return propagateElements(data, dt);
+
+		if(!data.hasData(DATA_CARTESIAN) || !data.hasData(DATA_VELOCITY))
+		{
+			if(!data.hasData(DATA_ORBIT))
+				return INVALID_TYPE;
+			status = data.computeCartesian(REF_UNSPECIFIED, impl->mu);
+		}
+		if(status == SUCCESS)
+			status = impl->integrator->integrate(data, julian_day, dt, *this);
+		if(status == SUCCESS && data.hasData(DATA_ORBIT) && (getOutputMask() & MASK_ORBIT))
+			status = data.computeElements(impl->mu);
+		return status;
+	}
+
+	/**
+	 * \detail
+	 * Every worker thread owns one delta buffer and evaluates every n-th module into it.
+	 * The buffers are then summed up per object range, together with the Keplerian drift
+	 * of the mean anomaly and the optional conversion to Cartesian states, so the orbits are
+	 * read and written only once. The modules share the Population, so before they run,
+	 * every column they may access is allocated and detached from copies on the host; a
+	 * lazy allocation or copy-on-write inside a module would modify the column concurrently.
+	 * These are the declared columns of each module, or the allocated ones for modules
+	 * without a declaration.
+	 */
+	ErrorCode CustomPropagator::propagateElements(Population& data, double dt)
+	{
+		if(!data.hasData(DATA_ORBIT))
+			return INVALID_TYPE;
+		const int size = data.getSize();
+		const std::vector<PerturbationModule*>& modules = impl->activeModules;
+		const int moduleCount = static_cast<int>(modules.size());
+		DataMask accessed = MASK_NONE;
+		for(int module = 0; module < moduleCount; ++module)
+		{
+			DataMask columns = modules[module]->getReadColumns() | modules[module]->getWrittenColumns();
+			accessed |= modules[module]->hasColumnUsage() ? columns : columns & getAllocatedColumns(data);
+		}
+		materializeColumns(data, accessed);
+		const int threads = std::min(getWorkerCount(), moduleCount);
+		if(static_cast<int>(impl->deltas.size()) < threads)
+			impl->deltas.resize(threads);
+
+		std::vector<ErrorCode> results(std::max(threads, 1), SUCCESS);
+		std::vector< std::vector<Orbit> >& deltas = impl->deltas;
+		parallelFor(0, threads, 1, [&](int begin, int end) {
+			for(int thread = begin; thread < end; ++thread)
+			{
+				std::vector<Orbit>& delta = deltas[thread];
+				delta.resize(size);
+				memset(static_cast<void*>(delta.data()), 0, size * sizeof(Orbit));
+				for(int module = thread; module < moduleCount; module += threads)
+				{
+					ErrorCode result = modules[module]->calculate(data, delta.data(), static_cast<float>(dt));
+					if(result != SUCCESS && result != NOT_IMPLEMENTED && results[thread] == SUCCESS)
+						results[thread] = result;
+				}
+			}
+		});
+		for(int thread = 0; thread < threads; ++thread)
+		{
+			if(results[thread] != SUCCESS)
+				return results[thread];
+		}
+
+		Orbit* orbits = data.getOrbit();
+		const bool cartesian = (getOutputMask() & (MASK_CARTESIAN | MASK_VELOCITY)) != 0;
+		Vector3* position = cartesian ? data.getPosition(DEVICE_HOST, true) : 0;
+		Vector3* velocity = cartesian ? data.getVelocity(DEVICE_HOST, true) : 0;
+		const double mu = impl->mu;
+		const double twoPi = 6.28318530717958647693;
+		parallelFor(0, size, 1 << 14, [&](int begin, int end) {
+			for(int i = begin; i < end; ++i)
+			{
+				Orbit orbit = orbits[i];
+				double meanMotion = getMeanMotion(orbit.semi_major_axis, mu);
+				for(int thread = 0; thread < threads; ++thread)
+					orbit = orbit + deltas[thread][i];
+				double meanAnomaly = fmod(orbit.mean_anomaly + meanMotion * dt, twoPi);
+				orbit.mean_anomaly = (meanAnomaly < 0.0) ? meanAnomaly + twoPi : meanAnomaly;
+				orbits[i] = orbit;
+			}
+			if(cartesian)
+				convertElementsToState(orbits + begin, position + begin, velocity + begin, end - begin, mu);
+		});
+		data.update(DATA_ORBIT);
+		if(cartesian)
+			data.updateColumns(MASK_CARTESIAN | MASK_VELOCITY);
 		return SUCCESS;
 	}
 
+	/**
+	 * \detail
+	 * The point mass term initializes the accelerations of a block, the modules then add
+	 * their contributions to the same block.
+	 */
+	ErrorCode CustomPropagator::calculateAccelerations(const StateBatch& batch) const
+	{
+		const int blockSize = 256;
+		const std::vector<PerturbationModule*>& modules = impl->activeModules;
+		const double mu = impl->mu;
+		ErrorCode status = SUCCESS;
+		for(int first = 0; first < batch.count; first += blockSize)
+		{
+			int count = std::min(blockSize, batch.count - first);
+			const Vector3* position = batch.position + first;
+			Vector3* acceleration = batch.acceleration + first;
+			for(int i = 0; i < count; ++i)
+			{
+				const Vector3& r = position[i];
+				double inverseRadius = 1.0 / sqrt(r.x * r.x + r.y * r.y + r.z * r.z);
+				double factor = -mu * inverseRadius * inverseRadius * inverseRadius;
+				acceleration[i].x = factor * r.x;
+				acceleration[i].y = factor * r.y;
+				acceleration[i].z = factor * r.z;
+			}
+			StateBatch block;
+			block.count = count;
+			block.position = position;
+			block.velocity = batch.velocity + first;
+			block.julian_day = batch.julian_day + first;
+			block.properties = batch.properties ? batch.properties + first : 0;
+			block.acceleration = acceleration;
+			for(size_t module = 0; module < modules.size(); ++module)
+			{
+				ErrorCode result = modules[module]->calculateAcceleration(block);
+				if(result != SUCCESS && result != NOT_IMPLEMENTED && status == SUCCESS)
+					status = result;
+			}
+		}
+		return status;
+	}
+
+	bool CustomPropagator::cartesianCoordinates()
+	{
+		return true;
+	}
+
 	int CustomPropagator::requiresCUDA()
 	{
 		return 0;
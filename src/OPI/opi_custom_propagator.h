@@ -18,6 +18,7 @@
 #define OPI_HOST_MODULED_PROPAGATOR_H
 
 #include "opi_propagator.h"
+#include "opi_perturbation_module.h"
 #include <vector>
 namespace OPI
 {
@@ -28,7 +29,24 @@ namespace OPI
 
 	//! \brief This class represents a propagator which can be composed from different perturbation modules and an integrator at runtime.
 	//! \ingroup CPP_API_GROUP
-	class CustomPropagator:
+	/*!
+	 * With an integrator, the Cartesian state of all objects is integrated numerically with
+	 * the accelerations of the central body and all modules (see calculateAccelerations()).
+	 * If the Population holds no position or velocity yet, they are calculated from the
+	 * orbits first; afterwards the orbits are replaced by the osculating elements of the new
+	 * states if the Population holds orbits.
+	 *
+	 * Without an integrator, the orbital elements are propagated: all modules add their
+	 * element changes over the time step (PerturbationModule::calculate()) to per-thread
+	 * delta buffers, the buffers are summed up in parallel and the mean anomaly is advanced
+	 * by the Keplerian mean motion. Modules are evaluated concurrently and must only read
+	 * the Population in calculate().
+	 *
+	 * The gravitational parameter of the central body is set with the property "mu"
+	 * (km^3/s^2, defaults to EARTH_MU). Modules assigned with assignPerturbationModule()
+	 * are used in addition to the ones added with addModule().
+	 */
+	class OPI_API_EXPORT CustomPropagator:
 			public Propagator
 	{
 		public:
@@ -39,6 +57,26 @@ namespace OPI
 			void addModule(PerturbationModule* module);
 			/// Sets the integrator for this propagator
 			void setIntegrator(PropagatorIntegrator* integrator);
+			/// Returns the integrator of this propagator, or a null pointer if none is set
+			PropagatorIntegrator* getIntegrator() const;
+
+			/**
+			 * @brief calculateAccelerations Calculates the total acceleration of a batch of objects.
+			 *
+			 * The accelerations of the batch are set to the point mass gravity of the central
+			 * body plus the accelerations of all modules that implement
+			 * PerturbationModule::calculateAcceleration(). The modules are called for blocks of
+			 * a few hundred objects, so the state of a block stays in the cache for all modules.
+			 * This function is thread-safe and is called concurrently by integrators.
+			 * @return OPI::SUCCESS, or the first error returned by a module.
+			 */
+			ErrorCode calculateAccelerations(const StateBatch& batch) const;
+
+			//! Returns the gravitational parameter of the central body in km^3/s^2
+			double getGravitationalParameter() const;
+
+			//! Returns true, the Cartesian state is always generated
+			virtual bool cartesianCoordinates();
 
 		protected:
 			/// Override the propagation method
@@ -46,6 +84,8 @@ namespace OPI
 			virtual int requiresCUDA();
 
 		private:
+			//! Propagates the orbital elements without an integrator
+			ErrorCode propagateElements(Population& data, double dt);
 			Pimpl<CustomPropagatorImpl> impl;
 	};
 }
@@ -0,0 +1,534 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_ephemeris_cache.h"
+#include "opi_host.h"
+#include "opi_indexlist.h"
+#include "opi_trajectory_buffer.h"
+#include "internal/opi_parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace
+	{
+		//! The highest supported polynomial degree
+		const int MAX_DEGREE = 15;
+		//! Times up to this many seconds outside of the window are clamped to it
+		const double WINDOW_TOLERANCE = 1e-6;
+
+		//! Calculates the Chebyshev polynomials T_0..T_degree and their derivatives at tau
+		inline void chebyshevBasis(double tau, int degree, double* value, double* derivative)
+		{
+			value[0] = 1.0;
+			derivative[0] = 0.0;
+			if(degree > 0)
+			{
+				value[1] = tau;
+				derivative[1] = 1.0;
+			}
+			for(int n = 1; n < degree; ++n)
+			{
+				value[n + 1] = 2.0 * tau * value[n] - value[n - 1];
+				derivative[n + 1] = 2.0 * value[n] + 2.0 * tau * derivative[n] - derivative[n - 1];
+			}
+		}
+	}
+
+	struct EphemerisCacheImpl
+	{
+		int steps;
+		int degree;
+		//! the degree and segment length in seconds the coefficients were fitted with
+		int fittedDegree;
+		double length;
+		double begin;
+		int segmentCount;
+		int objectCount;
+		ReferenceFrame frame;
+		//! coefficients[((segment * objectCount + object) * 3 + axis) * (fittedDegree + 1) + n]
+		std::vector<double> coefficients;
+
+		//! Returns the offset of a time from the window start in seconds, or NaN outside of the window
+		double getOffset(double julian_day, double dt) const
+		{
+			double offset = (julian_day - begin) * 86400.0 + dt;
+			double window = segmentCount * length;
+			if(!(offset >= -WINDOW_TOLERANCE && offset <= window + WINDOW_TOLERANCE))
+				return NAN;
+			return std::min(std::max(offset, 0.0), window);
+		}
+
+		/**
+		 * Calculates the matrix that maps the positions and scaled velocities of the samples
+		 * of a segment to the Chebyshev coefficients (the least squares solution).
+		 * The result has degree + 1 rows and 2 * (steps + 1) columns.
+		 */
+		std::vector<double> fittingMatrix() const
+		{
+			const int samples = steps + 1;
+			const int columns = degree + 1;
+			const int rows = 2 * samples;
+			// design matrix: one position row and one velocity row per sample
+			std::vector<double> design(rows * columns);
+			double value[MAX_DEGREE + 1], derivative[MAX_DEGREE + 1];
+			for(int j = 0; j < samples; ++j)
+			{
+				chebyshevBasis(-1.0 + 2.0 * j / steps, degree, value, derivative);
+				for(int n = 0; n < columns; ++n)
+				{
+					design[j * columns + n] = value[n];
+					design[(samples + j) * columns + n] = derivative[n];
+				}
+			}
+			// solve the normal equations (A^T A) X = A^T by Gaussian elimination
+			std::vector<double> normal(columns * columns, 0.0);
+			std::vector<double> result(columns * rows, 0.0);
+			for(int a = 0; a < columns; ++a)
+			{
+				for(int b = 0; b < columns; ++b)
+				{
+					for(int r = 0; r < rows; ++r)
+						normal[a * columns + b] += design[r * columns + a] * design[r * columns + b];
+				}
+				for(int r = 0; r < rows; ++r)
+					result[a * rows + r] = design[r * columns + a];
+			}
+			for(int col = 0; col < columns; ++col)
+			{
+				int pivot = col;
+				for(int r = col + 1; r < columns; ++r)
+				{
+					if(fabs(normal[r * columns + col]) > fabs(normal[pivot * columns + col]))
+						pivot = r;
+				}
+				for(int c = 0; c < columns; ++c)
+					std::swap(normal[col * columns + c], normal[pivot * columns + c]);
+				for(int c = 0; c < rows; ++c)
+					std::swap(result[col * rows + c], result[pivot * rows + c]);
+				for(int r = 0; r < columns; ++r)
+				{
+					if(r == col)
+						continue;
+					double factor = normal[r * columns + col] / normal[col * columns + col];
+					for(int c = 0; c < columns; ++c)
+						normal[r * columns + c] -= factor * normal[col * columns + c];
+					for(int c = 0; c < rows; ++c)
+						result[r * rows + c] -= factor * result[col * rows + c];
+				}
+			}
+			for(int r = 0; r < columns; ++r)
+			{
+				for(int c = 0; c < rows; ++c)
+					result[r * rows + c] /= normal[r * columns + r];
+			}
+			return result;
+		}
+
+		/**
+		 * Evaluates objects at offsets in seconds from the window start. Object i is
+		 * indices[i] (or i without a list) and is evaluated at offsets[i * offsetStride], so a
+		 * stride of zero evaluates all objects at the same time. The states are written to
+		 * the object index if scatter is set and to i otherwise.
+		 */
+		void evaluate(const int* indices, int count, const double* offsets, int offsetStride,
+					  Vector3* position, Vector3* velocity, bool scatter) const
+		{
+			const int stride = fittedDegree + 1;
+			parallelFor(0, count, 4096, [&](int first, int last) {
+				double value[MAX_DEGREE + 1], derivative[MAX_DEGREE + 1];
+				double basisOffset = NAN;
+				int segment = 0;
+				for(int i = first; i < last; ++i)
+				{
+					const double offset = offsets[i * offsetStride];
+					// the basis is shared by consecutive objects at the same time
+					if(offset != basisOffset)
+					{
+						segment = std::min(static_cast<int>(offset / length), segmentCount - 1);
+						chebyshevBasis(2.0 * (offset - segment * length) / length - 1.0, fittedDegree, value, derivative);
+						basisOffset = offset;
+					}
+					const int object = indices ? indices[i] : i;
+					const double* c = &coefficients[(static_cast<size_t>(segment) * objectCount + object) * 3 * stride];
+					double p[3] = {0.0, 0.0, 0.0};
+					double v[3] = {0.0, 0.0, 0.0};
+					for(int axis = 0; axis < 3; ++axis)
+					{
+						for(int n = 0; n < stride; ++n)
+						{
+							p[axis] += c[axis * stride + n] * value[n];
+							v[axis] += c[axis * stride + n] * derivative[n];
+						}
+					}
+					const int target = scatter ? object : i;
+					position[target].x = p[0];
+					position[target].y = p[1];
+					position[target].z = p[2];
+					if(velocity)
+					{
+						const double scale = 2.0 / length;
+						velocity[target].x = v[0] * scale;
+						velocity[target].y = v[1] * scale;
+						velocity[target].z = v[2] * scale;
+					}
+				}
+			});
+		}
+
+		/**
+		 * Evaluates all objects at count offsets into an (object x time) trajectory. The basis
+		 * of every time is computed once and shared by all objects.
+		 */
+		void evaluateTrajectory(const double* offsets, int count, Vector3* position, Vector3* velocity) const
+		{
+			const int stride = fittedDegree + 1;
+			std::vector<int> segments(count);
+			std::vector<double> values(static_cast<size_t>(count) * stride);
+			std::vector<double> derivatives(static_cast<size_t>(count) * stride);
+			for(int t = 0; t < count; ++t)
+			{
+				segments[t] = std::min(static_cast<int>(offsets[t] / length), segmentCount - 1);
+				chebyshevBasis(2.0 * (offsets[t] - segments[t] * length) / length - 1.0, fittedDegree,
+							   &values[t * stride], &derivatives[t * stride]);
+			}
+			const double scale = 2.0 / length;
+			parallelFor(0, objectCount, 64, [&](int first, int last) {
+				for(int object = first; object < last; ++object)
+				{
+					for(int t = 0; t < count; ++t)
+					{
+						const double* c = &coefficients[(static_cast<size_t>(segments[t]) * objectCount + object) * 3 * stride];
+						const double* value = &values[t * stride];
+						const double* derivative = &derivatives[t * stride];
+						double p[3] = {0.0, 0.0, 0.0};
+						double v[3] = {0.0, 0.0, 0.0};
+						for(int axis = 0; axis < 3; ++axis)
+						{
+							for(int n = 0; n < stride; ++n)
+							{
+								p[axis] += c[axis * stride + n] * value[n];
+								v[axis] += c[axis * stride + n] * derivative[n];
+							}
+						}
+						const size_t target = static_cast<size_t>(object) * count + t;
+						position[target].x = p[0];
+						position[target].y = p[1];
+						position[target].z = p[2];
+						if(velocity)
+						{
+							velocity[target].x = v[0] * scale;
+							velocity[target].y = v[1] * scale;
+							velocity[target].z = v[2] * scale;
+						}
+					}
+				}
+			});
+		}
+	};
+
+	//! \endcond
+
+	EphemerisCache::EphemerisCache(const std::string& name)
+	{
+		setName(name);
+		impl->steps = 4;
+		impl->degree = 9;
+		impl->fittedDegree = 9;
+		impl->length = 0.0;
+		impl->begin = 0.0;
+		impl->segmentCount = 0;
+		impl->objectCount = 0;
+		impl->frame = REF_UNSPECIFIED;
+	}
+
+	EphemerisCache::~EphemerisCache()
+	{
+	}
+
+	ErrorCode EphemerisCache::setSegments(int steps, int degree)
+	{
+		if(steps < 1 || degree < 1 || degree > std::min(2 * steps + 1, MAX_DEGREE))
+			return INVALID_ARGUMENT;
+		impl->steps = steps;
+		impl->degree = degree;
+		return SUCCESS;
+	}
+
+	/**
+	 * \detail
+	 * Only the samples of two segments are kept. The coefficients of every segment are the
+	 * product of one fitting matrix, shared by all segments and objects, with the sampled
+	 * positions and the velocities scaled to the segment length. A completed segment is fitted
+	 * on a worker thread while the source propagates into the other sample buffer; the worker
+	 * is joined before that buffer is needed again.
+	 */
+	ErrorCode EphemerisCache::build(Propagator& source, const Population& population, double begin, double end, double step)
+	{
+		clear();
+		const int objects = population.getSize();
+		if(objects == 0 || !(end > begin) || !(step > 0.0))
+		{
+			if(getHost())
+				getHost()->sendError(INVALID_ARGUMENT);
+			return INVALID_ARGUMENT;
+		}
+		const int steps = impl->steps;
+		const int samples = steps + 1;
+		const int columns = 2 * samples;
+		const int stride = impl->degree + 1;
+		const double segmentLength = steps * step;
+		const int segments = std::max(1, static_cast<int>(ceil((end - begin) * 86400.0 / segmentLength - 1e-9)));
+		const std::vector<double> fitting = impl->fittingMatrix();
+		std::vector<double> coefficients(static_cast<size_t>(segments) * objects * 3 * stride);
+		// the samples of the segment that is propagated and of the segment that is fitted
+		std::vector<Vector3> positions[2], velocities[2];
+		for(int buffer = 0; buffer < 2; ++buffer)
+		{
+			positions[buffer].resize(static_cast<size_t>(samples) * objects);
+			velocities[buffer].resize(static_cast<size_t>(samples) * objects);
+		}
+		int filling = 0;
+		std::thread fitter;
+
+		auto fit = [&](int segment, int buffer) {
+			const std::vector<Vector3>& segmentPositions = positions[buffer];
+			const std::vector<Vector3>& segmentVelocities = velocities[buffer];
+			const double scale = 0.5 * segmentLength;
+			parallelFor(0, objects, 1024, [&](int first, int last) {
+				std::vector<double> rhs(columns);
+				for(int object = first; object < last; ++object)
+				{
+					double* c = &coefficients[(static_cast<size_t>(segment) * objects + object) * 3 * stride];
+					for(int axis = 0; axis < 3; ++axis)
+					{
+						for(int j = 0; j < samples; ++j)
+						{
+							const Vector3& r = segmentPositions[static_cast<size_t>(j) * objects + object];
+							const Vector3& v = segmentVelocities[static_cast<size_t>(j) * objects + object];
+							rhs[j] = (axis == 0) ? r.x : (axis == 1) ? r.y : r.z;
+							rhs[samples + j] = scale * ((axis == 0) ? v.x : (axis == 1) ? v.y : v.z);
+						}
+						for(int n = 0; n < stride; ++n)
+						{
+							double sum = 0.0;
+							for(int j = 0; j < columns; ++j)
+								sum += fitting[n * columns + j] * rhs[j];
+							c[axis * stride + n] = sum;
+						}
+					}
+				}
+			});
+		};
+
+		Population sampled(population);
+		const bool cartesian = source.cartesianCoordinates();
+		ErrorCode status = SUCCESS;
+		for(int k = 0; k <= segments * steps && status == SUCCESS; ++k)
+		{
+			// the first sample is the state at begin, then the copy is advanced step by step
+			if(k == 0)
+				status = source.propagate(sampled, begin, 0.0);
+			else
+				status = source.propagate(sampled, begin + (k - 1) * step / 86400.0, step);
+			if(status == SUCCESS && !cartesian)
+				status = sampled.computeCartesian(source.referenceFrame() == REF_NONE ? REF_UNSPECIFIED : source.referenceFrame());
+			if(status != SUCCESS)
+				break;
+			const int sample = (k == 0) ? 0 : (k - 1) % steps + 1;
+			const Vector3* position = sampled.getPosition();
+			const Vector3* velocity = sampled.getVelocity();
+			std::copy(position, position + objects, positions[filling].begin() + static_cast<size_t>(sample) * objects);
+			std::copy(velocity, velocity + objects, velocities[filling].begin() + static_cast<size_t>(sample) * objects);
+			if(k == 0 || sample != steps)
+				continue;
+
+			// the segment is complete, the other buffer is free once the previous fit is done
+			if(fitter.joinable())
+				fitter.join();
+			const int next = 1 - filling;
+			// the last sample starts the next segment
+			std::copy(positions[filling].begin() + static_cast<size_t>(steps) * objects, positions[filling].end(), positions[next].begin());
+			std::copy(velocities[filling].begin() + static_cast<size_t>(steps) * objects, velocities[filling].end(), velocities[next].begin());
+			fitter = std::thread(fit, k / steps - 1, filling);
+			filling = next;
+		}
+		if(fitter.joinable())
+			fitter.join();
+		if(status != SUCCESS)
+			return status;
+
+		impl->coefficients.swap(coefficients);
+		impl->fittedDegree = impl->degree;
+		impl->length = segmentLength;
+		impl->begin = begin;
+		impl->segmentCount = segments;
+		impl->objectCount = objects;
+		impl->frame = cartesian ? source.referenceFrame() : REF_UNSPECIFIED;
+		return SUCCESS;
+	}
+
+	void EphemerisCache::clear()
+	{
+		std::vector<double>().swap(impl->coefficients);
+		impl->segmentCount = 0;
+		impl->objectCount = 0;
+	}
+
+	double EphemerisCache::getBegin() const
+	{
+		return impl->begin;
+	}
+
+	double EphemerisCache::getEnd() const
+	{
+		return impl->begin + impl->segmentCount * impl->length / 86400.0;
+	}
+
+	int EphemerisCache::getObjectCount() const
+	{
+		return impl->objectCount;
+	}
+
+	ErrorCode EphemerisCache::getStateAt(double julian_day, IndexList& indices, Vector3* position, Vector3* velocity) const
+	{
+		const int* list = indices.getData(DEVICE_HOST);
+		const int count = indices.getSize();
+		ErrorCode status = SUCCESS;
+		const double offset = impl->getOffset(julian_day, 0.0);
+		if(std::isnan(offset))
+			status = INVALID_ARGUMENT;
+		for(int i = 0; i < count && status == SUCCESS; ++i)
+		{
+			if(list[i] < 0 || list[i] >= impl->objectCount)
+				status = INDEX_RANGE;
+		}
+		if(status == SUCCESS)
+			impl->evaluate(list, count, &offset, 0, position, velocity, false);
+		else if(getHost())
+			getHost()->sendError(status);
+		return status;
+	}
+
+	ErrorCode EphemerisCache::getStateAt(double julian_day, Vector3* position, Vector3* velocity) const
+	{
+		const double offset = impl->getOffset(julian_day, 0.0);
+		if(std::isnan(offset))
+		{
+			if(getHost())
+				getHost()->sendError(INVALID_ARGUMENT);
+			return INVALID_ARGUMENT;
+		}
+		impl->evaluate(0, impl->objectCount, &offset, 0, position, velocity, false);
+		return SUCCESS;
+	}
+
+	/**
+	 * \detail
+	 * The Population must hold the cached objects in the order they had during build().
+	 */
+	ErrorCode EphemerisCache::runPropagation(Population& data, double julian_day, double dt)
+	{
+		const double offset = impl->getOffset(julian_day, dt);
+		if(data.getSize() != impl->objectCount || std::isnan(offset))
+			return INVALID_ARGUMENT;
+		impl->evaluate(0, impl->objectCount, &offset, 0, data.getPosition(DEVICE_HOST, true), data.getVelocity(DEVICE_HOST, true), true);
+		data.updateColumns(MASK_CARTESIAN | MASK_VELOCITY);
+		return SUCCESS;
+	}
+
+	ErrorCode EphemerisCache::runIndexedPropagation(Population& data, IndexList& indices, double julian_day, double dt)
+	{
+		const int* list = indices.getData(DEVICE_HOST);
+		const int count = indices.getSize();
+		const double offset = impl->getOffset(julian_day, dt);
+		if(data.getSize() != impl->objectCount || std::isnan(offset))
+			return INVALID_ARGUMENT;
+		for(int i = 0; i < count; ++i)
+		{
+			if(list[i] < 0 || list[i] >= impl->objectCount)
+				return INDEX_RANGE;
+		}
+		impl->evaluate(list, count, &offset, 0, data.getPosition(DEVICE_HOST), data.getVelocity(DEVICE_HOST), true);
+		data.updateColumns(MASK_CARTESIAN | MASK_VELOCITY);
+		return SUCCESS;
+	}
+
+	ErrorCode EphemerisCache::runMultiTimePropagation(Population& data, double* julian_days, int length, double dt)
+	{
+		if(data.getSize() != impl->objectCount)
+			return INVALID_ARGUMENT;
+		std::vector<double> offsets(impl->objectCount);
+		for(int i = 0; i < impl->objectCount; ++i)
+		{
+			offsets[i] = impl->getOffset(julian_days[i], dt);
+			if(std::isnan(offsets[i]))
+				return INVALID_ARGUMENT;
+		}
+		impl->evaluate(0, impl->objectCount, offsets.data(), 1, data.getPosition(DEVICE_HOST, true), data.getVelocity(DEVICE_HOST, true), true);
+		data.updateColumns(MASK_CARTESIAN | MASK_VELOCITY);
+		return SUCCESS;
+	}
+
+	/**
+	 * \detail
+	 * The trajectory is evaluated object by object, so the coefficients of an object are
+	 * read once per segment.
+	 */
+	ErrorCode EphemerisCache::runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory)
+	{
+		if(data.getSize() != impl->objectCount)
+			return INVALID_ARGUMENT;
+		std::vector<double> offsets(length);
+		for(int t = 0; t < length; ++t)
+		{
+			offsets[t] = impl->getOffset(julian_days[t], 0.0);
+			if(std::isnan(offsets[t]))
+				return INVALID_ARGUMENT;
+		}
+		impl->evaluateTrajectory(offsets.data(), length, trajectory.getPosition(DEVICE_HOST, true), trajectory.getVelocity(DEVICE_HOST, true));
+		trajectory.update(DEVICE_HOST);
+		// the Population ends at the last time
+		impl->evaluate(0, impl->objectCount, &offsets[length - 1], 0, data.getPosition(DEVICE_HOST, true), data.getVelocity(DEVICE_HOST, true), true);
+		data.updateColumns(MASK_CARTESIAN | MASK_VELOCITY);
+		return SUCCESS;
+	}
+
+	bool EphemerisCache::backwardPropagation()
+	{
+		return true;
+	}
+
+	bool EphemerisCache::cartesianCoordinates()
+	{
+		return true;
+	}
+
+	ReferenceFrame EphemerisCache::referenceFrame()
+	{
+		return impl->frame;
+	}
+
+	int EphemerisCache::requiresCUDA()
+	{
+		return 0;
+	}
+}
@@ -0,0 +1,132 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_EPHEMERIS_CACHE_H
+#define OPI_EPHEMERIS_CACHE_H
+
+#include "opi_propagator.h"
+namespace OPI
+{
+	class IndexList;
+	class TrajectoryBuffer;
+
+	class EphemerisCacheImpl;
+
+	//! \brief A Propagator that interpolates the states of another propagator from polynomial segments.
+	//! \ingroup CPP_API_GROUP
+	/*!
+	 * build() propagates a copy of a Population with a source propagator over a time window
+	 * in equidistant steps and fits, for every object, polynomial segments in a Chebyshev basis
+	 * to the sampled positions and velocities. A segment spans a number of steps and matches
+	 * the positions and velocities of all its samples, exactly if the degree is
+	 * 2 * steps + 1 and in the least squares sense for lower degrees. One step with degree 3
+	 * is cubic Hermite interpolation; the default of four steps with degree 9 keeps the
+	 * interpolation error of LEO objects below a millimeter for steps of two minutes. This
+	 * assumes that the sampled velocities are the derivatives of the positions; for
+	 * propagators where they are not (e.g. SGP4), the error grows with the mismatch times
+	 * the segment length.
+	 *
+	 * States at arbitrary times inside the window are then evaluated from the polynomials with
+	 * getStateAt(), or with propagate() and propagateTrajectory() for a Population that holds
+	 * the same objects in the same order as the one the cache was built from. The cache holds
+	 * segments * objects * 3 * (degree + 1) coefficients.
+	 */
+	class OPI_API_EXPORT EphemerisCache:
+			public Propagator
+	{
+		public:
+			//! Creates an empty ephemeris cache with the specified name
+			EphemerisCache(const std::string& name);
+			~EphemerisCache();
+
+			/**
+			 * @brief setSegments Sets the length and polynomial degree of the segments for the next build().
+			 * @param steps The number of sampling steps covered by a segment (default 4).
+			 * @param degree The degree of the polynomials, between 1 and min(2 * steps + 1, 15)
+			 *   (default 9).
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT if steps or degree are out of range.
+			 */
+			ErrorCode setSegments(int steps, int degree);
+
+			/**
+			 * @brief build Samples a propagator over a time window and fits the segments.
+			 *
+			 * The Population is copied and propagated from begin in steps of the given length
+			 * until the window is covered by full segments, so the window can end up to one
+			 * segment after end. The states of the source are converted from the orbits with
+			 * Population::computeCartesian() if it does not produce Cartesian states. Each
+			 * completed segment is fitted for all objects on a worker thread while the source
+			 * propagates the samples of the next segment. The previous content of the cache is
+			 * replaced.
+			 * @param source The propagator to sample.
+			 * @param population The objects with their state at begin.
+			 * @param begin The start of the window as Julian date.
+			 * @param end The end of the window as Julian date.
+			 * @param step The sampling step in seconds.
+			 * @return OPI::SUCCESS, INVALID_ARGUMENT for an empty Population or window or a
+			 *   step <= 0, or the error returned by the source propagator.
+			 */
+			ErrorCode build(Propagator& source, const Population& population, double begin, double end, double step);
+
+			//! Removes all segments
+			void clear();
+
+			//! Returns the start of the window as Julian date
+			double getBegin() const;
+			//! Returns the end of the window as Julian date
+			double getEnd() const;
+			//! Returns the number of cached objects
+			int getObjectCount() const;
+
+			/**
+			 * @brief getStateAt Evaluates the states of the listed objects at the same time.
+			 * @param julian_day The time as Julian date, inside the window.
+			 * @param indices The indices of the objects in the Population the cache was built from.
+			 * @param position Receives one position per index.
+			 * @param velocity Receives one velocity per index; may be a null pointer.
+			 * @return OPI::SUCCESS, INVALID_ARGUMENT for times outside the window or
+			 *   INDEX_RANGE for invalid indices.
+			 */
+			ErrorCode getStateAt(double julian_day, IndexList& indices, Vector3* position, Vector3* velocity = 0) const;
+
+			/**
+			 * @brief getStateAt Evaluates the states of all objects at the same time.
+			 * @param position Receives getObjectCount() positions.
+			 * @param velocity Receives getObjectCount() velocities; may be a null pointer.
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT for times outside the window.
+			 */
+			ErrorCode getStateAt(double julian_day, Vector3* position, Vector3* velocity = 0) const;
+
+			//! Returns true, states before the current one can be evaluated as well
+			virtual bool backwardPropagation();
+			//! Returns true, the cache produces position and velocity
+			virtual bool cartesianCoordinates();
+			//! Returns the reference frame of the source propagator
+			virtual ReferenceFrame referenceFrame();
+
+		protected:
+			virtual ErrorCode runPropagation(Population& data, double julian_day, double dt);
+			virtual ErrorCode runIndexedPropagation(Population& data, IndexList& indices, double julian_day, double dt);
+			virtual ErrorCode runMultiTimePropagation(Population& data, double* julian_days, int length, double dt);
+			virtual ErrorCode runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory);
+			virtual int requiresCUDA();
+
+		private:
+			Pimpl<EphemerisCacheImpl> impl;
+	};
+}
+
+#endif
@@ -40,6 +40,10 @@ namespace OPI
 				return "Invalid property";
 			case INCOMPATIBLE_TYPES:
 				return "INCOMPATIBLE_TYPES";
+			case FILE_NOT_FOUND:
+				return "File not found";
+			case INVALID_FILE_FORMAT:
+				return "Invalid file format";
 			case NOT_IMPLEMENTED:
 				return "Not implemented";
 			case CUDA_REQUIRED:
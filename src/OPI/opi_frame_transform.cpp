@@ -0,0 +1,677 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_frame_transform.h"
+#include "opi_population.h"
+#include "opi_host.h"
+#include "internal/opi_parallel.h"
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	namespace
+	{
+		const double PI = 3.14159265358979323846;
+		const double ARCSEC = PI / 648000.0;
+		const double DEGREE = PI / 180.0;
+		const double J2000_EPOCH = 2451545.0;
+		const double SECONDS_PER_DAY = 86400.0;
+		// angular velocity of the Earth in rad/s
+		const double EARTH_ROTATION = 7.292115146706979e-5;
+		// rate of Greenwich mean sidereal time in rad per second of UT1
+		const double SIDEREAL_RATE = 7.2921158553e-5;
+		// cached epochs above which the cache is cleared before the next transformation
+		const size_t MAX_CACHED_EPOCHS = 1 << 16;
+
+		// the frames with a definition, inertial frames first
+		enum Frame
+		{
+			FRAME_GCRF,
+			FRAME_J2000,
+			FRAME_MOD,
+			FRAME_TOD,
+			FRAME_TEME,
+			FRAME_ITRF,
+			FRAME_INVALID
+		};
+		const int INERTIAL_FRAMES = FRAME_ITRF;
+
+		Frame getFrame(ReferenceFrame frame)
+		{
+			switch(frame)
+			{
+				case REF_GCRF:
+				case REF_ECI:
+					return FRAME_GCRF;
+				case REF_J2000:
+					return FRAME_J2000;
+				case REF_MOD:
+					return FRAME_MOD;
+				case REF_TOD:
+					return FRAME_TOD;
+				case REF_TEME:
+					return FRAME_TEME;
+				case REF_ITRF:
+				case REF_ECEF:
+					return FRAME_ITRF;
+				default:
+					return FRAME_INVALID;
+			}
+		}
+
+		struct Matrix3
+		{
+			double m[3][3];
+		};
+
+		Matrix3 identity()
+		{
+			Matrix3 result = {{{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}}};
+			return result;
+		}
+
+		Matrix3 operator*(const Matrix3& a, const Matrix3& b)
+		{
+			Matrix3 result;
+			for(int i = 0; i < 3; ++i)
+				for(int j = 0; j < 3; ++j)
+					result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+			return result;
+		}
+
+		Matrix3 transpose(const Matrix3& a)
+		{
+			Matrix3 result;
+			for(int i = 0; i < 3; ++i)
+				for(int j = 0; j < 3; ++j)
+					result.m[i][j] = a.m[j][i];
+			return result;
+		}
+
+		// coordinate rotations about the x, y and z axes
+		Matrix3 rotateX(double angle)
+		{
+			double c = cos(angle), s = sin(angle);
+			Matrix3 result = {{{1.0, 0.0, 0.0}, {0.0, c, s}, {0.0, -s, c}}};
+			return result;
+		}
+
+		Matrix3 rotateY(double angle)
+		{
+			double c = cos(angle), s = sin(angle);
+			Matrix3 result = {{{c, 0.0, -s}, {0.0, 1.0, 0.0}, {s, 0.0, c}}};
+			return result;
+		}
+
+		Matrix3 rotateZ(double c, double s)
+		{
+			Matrix3 result = {{{c, s, 0.0}, {-s, c, 0.0}, {0.0, 0.0, 1.0}}};
+			return result;
+		}
+
+		Matrix3 rotateZ(double angle)
+		{
+			return rotateZ(cos(angle), sin(angle));
+		}
+
+		// returns omega x m for the rotation of the Earth about the z axis
+		Matrix3 crossEarthRotation(const Matrix3& a)
+		{
+			Matrix3 result;
+			for(int j = 0; j < 3; ++j)
+			{
+				result.m[0][j] = -EARTH_ROTATION * a.m[1][j];
+				result.m[1][j] = EARTH_ROTATION * a.m[0][j];
+				result.m[2][j] = 0.0;
+			}
+			return result;
+		}
+
+		// a term of the IAU-80 nutation series, multiples of D, M, M', F and Omega and the
+		// coefficients of the sine (longitude) and cosine (obliquity) in units of 0.0001"
+		struct NutationTerm
+		{
+			signed char d, m, mp, f, om;
+			double psi, psiT, eps, epsT;
+		};
+
+		const NutationTerm NUTATION[] = {
+			{ 0,  0,  0,  0,  1, -171996.0, -174.2, 92025.0,  8.9},
+			{-2,  0,  0,  2,  2,  -13187.0,   -1.6,  5736.0, -3.1},
+			{ 0,  0,  0,  2,  2,   -2274.0,   -0.2,   977.0, -0.5},
+			{ 0,  0,  0,  0,  2,    2062.0,    0.2,  -895.0,  0.5},
+			{ 0,  1,  0,  0,  0,    1426.0,   -3.4,    54.0, -0.1},
+			{ 0,  0,  1,  0,  0,     712.0,    0.1,    -7.0,  0.0},
+			{-2,  1,  0,  2,  2,    -517.0,    1.2,   224.0, -0.6},
+			{ 0,  0,  0,  2,  1,    -386.0,   -0.4,   200.0,  0.0},
+			{ 0,  0,  1,  2,  2,    -301.0,    0.0,   129.0, -0.1},
+			{-2, -1,  0,  2,  2,     217.0,   -0.5,   -95.0,  0.3},
+			{-2,  0,  1,  0,  0,    -158.0,    0.0,     0.0,  0.0},
+			{-2,  0,  0,  2,  1,     129.0,    0.1,   -70.0,  0.0},
+			{ 0,  0, -1,  2,  2,     123.0,    0.0,   -53.0,  0.0},
+			{ 2,  0,  0,  0,  0,      63.0,    0.0,     0.0,  0.0},
+			{ 0,  0,  1,  0,  1,      63.0,    0.1,   -33.0,  0.0},
+			{ 2,  0, -1,  2,  2,     -59.0,    0.0,    26.0,  0.0},
+			{ 0,  0, -1,  0,  1,     -58.0,   -0.1,    32.0,  0.0},
+			{ 0,  0,  1,  2,  1,     -51.0,    0.0,    27.0,  0.0},
+			{-2,  0,  2,  0,  0,      48.0,    0.0,     0.0,  0.0},
+			{ 0,  0, -2,  2,  1,      46.0,    0.0,   -24.0,  0.0},
+			{ 2,  0,  0,  2,  2,     -38.0,    0.0,    16.0,  0.0},
+			{ 0,  0,  2,  2,  2,     -31.0,    0.0,    13.0,  0.0},
+			{ 0,  0,  2,  0,  0,      29.0,    0.0,     0.0,  0.0},
+			{-2,  0,  1,  2,  2,      29.0,    0.0,   -12.0,  0.0},
+			{ 0,  0,  0,  2,  0,      26.0,    0.0,     0.0,  0.0},
+			{-2,  0,  0,  2,  0,     -22.0,    0.0,     0.0,  0.0},
+			{ 0,  0, -1,  2,  1,      21.0,    0.0,   -10.0,  0.0},
+			{ 0,  2,  0,  0,  0,      17.0,   -0.1,     0.0,  0.0},
+			{ 2,  0, -1,  0,  1,      16.0,    0.0,    -8.0,  0.0},
+			{-2,  2,  0,  2,  2,     -16.0,    0.1,     7.0,  0.0},
+			{ 0,  1,  0,  0,  1,     -15.0,    0.0,     9.0,  0.0},
+			{-2,  0,  1,  0,  1,     -13.0,    0.0,     7.0,  0.0},
+			{ 0, -1,  0,  0,  1,     -12.0,    0.0,     6.0,  0.0},
+			{ 0,  0,  2, -2,  0,      11.0,    0.0,     0.0,  0.0},
+			{ 2,  0, -1,  2,  1,     -10.0,    0.0,     5.0,  0.0},
+			{ 2,  0,  1,  2,  2,      -8.0,    0.0,     3.0,  0.0},
+			{ 0,  1,  0,  2,  2,       7.0,    0.0,    -3.0,  0.0},
+			{-2,  1,  1,  0,  0,      -7.0,    0.0,     0.0,  0.0},
+			{ 0, -1,  0,  2,  2,      -7.0,    0.0,     3.0,  0.0},
+			{ 2,  0,  0,  2,  1,      -7.0,    0.0,     3.0,  0.0},
+			{ 2,  0,  1,  0,  0,       6.0,    0.0,     0.0,  0.0},
+			{-2,  0,  2,  2,  2,       6.0,    0.0,    -3.0,  0.0},
+			{-2,  0,  1,  2,  1,       6.0,    0.0,    -3.0,  0.0},
+			{ 2,  0, -2,  0,  1,      -6.0,    0.0,     3.0,  0.0},
+			{ 2,  0,  0,  0,  1,      -6.0,    0.0,     3.0,  0.0},
+			{ 0, -1,  1,  0,  0,       5.0,    0.0,     0.0,  0.0},
+			{-2, -1,  0,  2,  1,      -5.0,    0.0,     3.0,  0.0},
+			{-2,  0,  0,  0,  1,      -5.0,    0.0,     3.0,  0.0},
+			{ 0,  0,  2,  2,  1,      -5.0,    0.0,     3.0,  0.0}
+		};
+
+		// the rotations of an epoch bin that are shared by all objects in it
+		struct EpochRotation
+		{
+			// rotation from each inertial frame to TOD
+			Matrix3 toTod[INERTIAL_FRAMES];
+			// Greenwich apparent sidereal angle at the center of the bin
+			double cosSidereal;
+			double sinSidereal;
+			// center of the bin as Julian date (UTC)
+			double julianDay;
+		};
+
+		void computeEpochRotation(EpochRotation& rotation, double julianDay, double ut1MinusUtc, double ttMinusUtc)
+		{
+			double t = (julianDay + ttMinusUtc / SECONDS_PER_DAY - J2000_EPOCH) / 36525.0;
+			double t2 = t * t;
+			double t3 = t2 * t;
+
+			// IAU-76 precession
+			double zeta = (2306.2181 * t + 0.30188 * t2 + 0.017998 * t3) * ARCSEC;
+			double theta = (2004.3109 * t - 0.42665 * t2 - 0.041833 * t3) * ARCSEC;
+			double z = (2306.2181 * t + 1.09468 * t2 + 0.018203 * t3) * ARCSEC;
+			Matrix3 precession = rotateZ(-z) * rotateY(theta) * rotateZ(-zeta);
+
+			// IAU-80 nutation
+			double d = (297.85036 + 445267.111480 * t - 0.0019142 * t2 + t3 / 189474.0) * DEGREE;
+			double m = (357.52772 + 35999.050340 * t - 0.0001603 * t2 - t3 / 300000.0) * DEGREE;
+			double mp = (134.96298 + 477198.867398 * t + 0.0086972 * t2 + t3 / 56250.0) * DEGREE;
+			double f = (93.27191 + 483202.017538 * t - 0.0036825 * t2 + t3 / 327270.0) * DEGREE;
+			double om = (125.04452 - 1934.136261 * t + 0.0020708 * t2 + t3 / 450000.0) * DEGREE;
+			double dpsi = 0.0;
+			double deps = 0.0;
+			for(size_t i = 0; i < sizeof(NUTATION) / sizeof(NUTATION[0]); ++i)
+			{
+				const NutationTerm& term = NUTATION[i];
+				double argument = term.d * d + term.m * m + term.mp * mp + term.f * f + term.om * om;
+				dpsi += (term.psi + term.psiT * t) * sin(argument);
+				deps += (term.eps + term.epsT * t) * cos(argument);
+			}
+			dpsi *= 1e-4 * ARCSEC;
+			deps *= 1e-4 * ARCSEC;
+			double meanObliquity = (84381.448 - 46.8150 * t - 0.00059 * t2 + 0.001813 * t3) * ARCSEC;
+			Matrix3 nutation = rotateX(-meanObliquity - deps) * rotateZ(-dpsi) * rotateX(meanObliquity);
+
+			// equation of the equinoxes, with the terms of the Moon's node since 1997
+			double equinoxes = dpsi * cos(meanObliquity);
+			if(julianDay > 2450449.5)
+				equinoxes += (0.00264 * sin(om) + 0.000063 * sin(2.0 * om)) * ARCSEC;
+
+			// frame bias between GCRF and the mean equator and equinox of J2000
+			Matrix3 bias = rotateX(0.0068192 * ARCSEC) * rotateY(-0.016617 * ARCSEC) * rotateZ(-0.0146 * ARCSEC);
+
+			rotation.toTod[FRAME_MOD] = nutation;
+			rotation.toTod[FRAME_J2000] = nutation * precession;
+			rotation.toTod[FRAME_GCRF] = rotation.toTod[FRAME_J2000] * bias;
+			rotation.toTod[FRAME_TOD] = identity();
+			rotation.toTod[FRAME_TEME] = rotateZ(-equinoxes);
+
+			// IAU-82 Greenwich mean sidereal time
+			double tu = (julianDay + ut1MinusUtc / SECONDS_PER_DAY - J2000_EPOCH) / 36525.0;
+			double gmst = 67310.54841 + (876600.0 * 3600.0 + 8640184.812866) * tu + 0.093104 * tu * tu - 6.2e-6 * tu * tu * tu;
+			double sidereal = fmod(gmst, SECONDS_PER_DAY) * (2.0 * PI / SECONDS_PER_DAY) + equinoxes;
+			rotation.cosSidereal = cos(sidereal);
+			rotation.sinSidereal = sin(sidereal);
+			rotation.julianDay = julianDay;
+		}
+	}
+
+	class FrameTransformImpl
+	{
+		public:
+			FrameTransformImpl(Host& _host):
+				host(_host),
+				ut1MinusUtc(0.0),
+				ttMinusUtc(69.184),
+				polarMotion(identity()),
+				resolution(60.0)
+			{
+			}
+
+			//! The parts of a transformation that are constant within an epoch bin
+			struct BinTransformation
+			{
+				// applied before and after the rotation of the Earth
+				Matrix3 before;
+				Matrix3 after;
+				// into (forward) or out of ITRF, neither for inertial frames
+				bool rotating;
+				bool forward;
+				// center of the bin as Julian date
+				double julianDay;
+			};
+
+			long long getKey(double julianDay) const
+			{
+				return (long long)floor(julianDay * (SECONDS_PER_DAY / resolution) + 0.5);
+			}
+
+			//! Sets up the transformation between two different frames within a cached bin
+			void getBinTransformation(long long key, Frame from, Frame to, BinTransformation& result) const
+			{
+				const EpochRotation& bin = cache.find(key)->second;
+				result.julianDay = bin.julianDay;
+				result.rotating = (from == FRAME_ITRF || to == FRAME_ITRF);
+				result.forward = (to == FRAME_ITRF);
+				Matrix3 sidereal = rotateZ(bin.cosSidereal, bin.sinSidereal);
+				if(!result.rotating)
+				{
+					result.before = transpose(bin.toTod[to]) * bin.toTod[from];
+					result.after = identity();
+				}
+				else if(result.forward)
+				{
+					result.before = sidereal * bin.toTod[from];
+					result.after = polarMotion;
+				}
+				else {
+					result.before = transpose(polarMotion);
+					result.after = transpose(bin.toTod[to]) * transpose(sidereal);
+				}
+			}
+
+			//! Returns the rotation of the Earth from the center of the bin to the epoch
+			static void getEarthRotation(const BinTransformation& bin, double julianDay, double& c, double& s)
+			{
+				// the angle is small, so a short series is exact
+				double delta = SIDEREAL_RATE * (julianDay - bin.julianDay) * SECONDS_PER_DAY;
+				if(!bin.forward)
+					delta = -delta;
+				double delta2 = delta * delta;
+				c = 1.0 - delta2 * (1.0 / 2.0 - delta2 * (1.0 / 24.0 - delta2 / 720.0));
+				s = delta * (1.0 - delta2 * (1.0 / 6.0 - delta2 * (1.0 / 120.0 - delta2 / 5040.0)));
+			}
+
+			/**
+			 * Combines the transformation at an epoch into rotation and rate:
+			 * v_pef = R v_tod - omega x r_pef into ITRF, v_tod = R^T (v_pef + omega x r_pef) out of it.
+			 */
+			static void getTransformation(const BinTransformation& bin, double julianDay, Matrix3& rotation, Matrix3& rate)
+			{
+				if(!bin.rotating)
+				{
+					rotation = bin.before;
+					rate = Matrix3();
+					return;
+				}
+				double c, s;
+				getEarthRotation(bin, julianDay, c, s);
+				Matrix3 earth = rotateZ(c, s);
+				rotation = bin.after * earth * bin.before;
+				if(bin.forward)
+				{
+					rate = bin.after * crossEarthRotation(earth * bin.before);
+					for(int i = 0; i < 3; ++i)
+						for(int j = 0; j < 3; ++j)
+							rate.m[i][j] = -rate.m[i][j];
+				}
+				else
+					rate = bin.after * earth * crossEarthRotation(bin.before);
+			}
+
+			//! Computes the missing bins for the given epochs, epochs are read with the given stride
+			ErrorCode prepare(const double* epochs, int stride, int count)
+			{
+				if(cache.size() > MAX_CACHED_EPOCHS)
+					cache.clear();
+				std::vector<std::pair<long long, EpochRotation*> > missing;
+				double previous = NAN;
+				long long previousKey = 0;
+				for(int i = 0; i < count; ++i)
+				{
+					double julianDay = epochs[(size_t)i * stride];
+					if(julianDay == previous)
+						continue;
+					previous = julianDay;
+					if(!std::isfinite(julianDay))
+					{
+						for(size_t j = 0; j < missing.size(); ++j)
+							cache.erase(missing[j].first);
+						return INVALID_ARGUMENT;
+					}
+					long long key = getKey(julianDay);
+					if(i > 0 && key == previousKey)
+						continue;
+					previousKey = key;
+					if(cache.count(key) == 0)
+						missing.push_back(std::make_pair(key, &cache[key]));
+				}
+				double ut1 = ut1MinusUtc;
+				double tt = ttMinusUtc;
+				double binWidth = resolution / SECONDS_PER_DAY;
+				parallelFor(0, (int)missing.size(), 16, [&missing, ut1, tt, binWidth](int begin, int end) {
+					for(int i = begin; i < end; ++i)
+						computeEpochRotation(*missing[i].second, missing[i].first * binWidth, ut1, tt);
+				});
+				return SUCCESS;
+			}
+
+			//! Transforms the states in place, a stride of zero uses the first epoch for all objects
+			ErrorCode run(Vector3* position, Vector3* velocity, const double* epochs, int stride, int count, ReferenceFrame fromFrame, ReferenceFrame toFrame)
+			{
+				Frame from = getFrame(fromFrame);
+				Frame to = getFrame(toFrame);
+				if(from == FRAME_INVALID || to == FRAME_INVALID || count < 0 || (count > 0 && (!position || !epochs)))
+					return INVALID_ARGUMENT;
+				if(from == to || count == 0)
+					return SUCCESS;
+				ErrorCode status = prepare(epochs, stride, stride == 0 ? 1 : count);
+				if(status != SUCCESS)
+					return status;
+				parallelFor(0, count, 1 << 14, [this, position, velocity, epochs, stride, from, to](int begin, int end) {
+					BinTransformation bin;
+					Matrix3 rotation, rate;
+					long long lastKey = 0;
+					int first = begin;
+					while(first < end)
+					{
+						// consecutive objects with the same epoch share the transformation
+						double julianDay = epochs[(size_t)first * stride];
+						int last = first + 1;
+						while(last < end && epochs[(size_t)last * stride] == julianDay)
+							++last;
+						long long key = getKey(julianDay);
+						if(first == begin || key != lastKey)
+						{
+							getBinTransformation(key, from, to, bin);
+							if(!bin.rotating)
+								getTransformation(bin, julianDay, rotation, rate);
+						}
+						lastKey = key;
+						// short runs into or out of ITRF rotate each object by its own angle
+						const bool perObject = bin.rotating && last - first < 16;
+						if(!bin.rotating || perObject)
+						{
+							// inertial transformations are the same within a bin, and objects that are
+							// rotated by their own angle need not share the epoch
+							while(last < end && last - first < 1024 && getKey(epochs[(size_t)last * stride]) == key)
+								++last;
+						}
+						if(perObject)
+							applyEarthRotation(bin, epochs, stride, position, velocity, first, last);
+						else {
+							if(bin.rotating)
+								getTransformation(bin, julianDay, rotation, rate);
+							apply(rotation, rate, bin.rotating, position, velocity, first, last);
+						}
+						first = last;
+					}
+				});
+				return SUCCESS;
+			}
+
+			static void apply(const Matrix3& rotation, const Matrix3& rate, bool rotating, Vector3* position, Vector3* velocity, int begin, int end)
+			{
+				const double r00 = rotation.m[0][0], r01 = rotation.m[0][1], r02 = rotation.m[0][2];
+				const double r10 = rotation.m[1][0], r11 = rotation.m[1][1], r12 = rotation.m[1][2];
+				const double r20 = rotation.m[2][0], r21 = rotation.m[2][1], r22 = rotation.m[2][2];
+				if(velocity && rotating)
+				{
+					const double d00 = rate.m[0][0], d01 = rate.m[0][1], d02 = rate.m[0][2];
+					const double d10 = rate.m[1][0], d11 = rate.m[1][1], d12 = rate.m[1][2];
+					const double d20 = rate.m[2][0], d21 = rate.m[2][1], d22 = rate.m[2][2];
+					for(int i = begin; i < end; ++i)
+					{
+						double x = position[i].x, y = position[i].y, z = position[i].z;
+						double vx = velocity[i].x, vy = velocity[i].y, vz = velocity[i].z;
+						position[i].x = r00 * x + r01 * y + r02 * z;
+						position[i].y = r10 * x + r11 * y + r12 * z;
+						position[i].z = r20 * x + r21 * y + r22 * z;
+						velocity[i].x = r00 * vx + r01 * vy + r02 * vz + d00 * x + d01 * y + d02 * z;
+						velocity[i].y = r10 * vx + r11 * vy + r12 * vz + d10 * x + d11 * y + d12 * z;
+						velocity[i].z = r20 * vx + r21 * vy + r22 * vz + d20 * x + d21 * y + d22 * z;
+					}
+				}
+				else {
+					for(int i = begin; i < end; ++i)
+					{
+						double x = position[i].x, y = position[i].y, z = position[i].z;
+						position[i].x = r00 * x + r01 * y + r02 * z;
+						position[i].y = r10 * x + r11 * y + r12 * z;
+						position[i].z = r20 * x + r21 * y + r22 * z;
+					}
+					if(velocity)
+					{
+						for(int i = begin; i < end; ++i)
+						{
+							double x = velocity[i].x, y = velocity[i].y, z = velocity[i].z;
+							velocity[i].x = r00 * x + r01 * y + r02 * z;
+							velocity[i].y = r10 * x + r11 * y + r12 * z;
+							velocity[i].z = r20 * x + r21 * y + r22 * z;
+						}
+					}
+				}
+			}
+
+			//! Transforms objects of one bin into or out of ITRF, each at its own epoch
+			static void applyEarthRotation(const BinTransformation& bin, const double* epochs, int stride, Vector3* position, Vector3* velocity, int begin, int end)
+			{
+				const Matrix3& a = bin.before;
+				const Matrix3& b = bin.after;
+				for(int i = begin; i < end; ++i)
+				{
+					double c, s;
+					getEarthRotation(bin, epochs[(size_t)i * stride], c, s);
+					Vector3 r = position[i];
+					Vector3 v = velocity ? velocity[i] : Vector3(0.0, 0.0, 0.0);
+					double px = a.m[0][0] * r.x + a.m[0][1] * r.y + a.m[0][2] * r.z;
+					double py = a.m[1][0] * r.x + a.m[1][1] * r.y + a.m[1][2] * r.z;
+					double pz = a.m[2][0] * r.x + a.m[2][1] * r.y + a.m[2][2] * r.z;
+					double qx = a.m[0][0] * v.x + a.m[0][1] * v.y + a.m[0][2] * v.z;
+					double qy = a.m[1][0] * v.x + a.m[1][1] * v.y + a.m[1][2] * v.z;
+					double qz = a.m[2][0] * v.x + a.m[2][1] * v.y + a.m[2][2] * v.z;
+					if(!bin.forward)
+					{
+						qx -= EARTH_ROTATION * py;
+						qy += EARTH_ROTATION * px;
+					}
+					double x = c * px + s * py;
+					py = c * py - s * px;
+					px = x;
+					x = c * qx + s * qy;
+					qy = c * qy - s * qx;
+					qx = x;
+					if(bin.forward)
+					{
+						qx += EARTH_ROTATION * py;
+						qy -= EARTH_ROTATION * px;
+					}
+					position[i].x = b.m[0][0] * px + b.m[0][1] * py + b.m[0][2] * pz;
+					position[i].y = b.m[1][0] * px + b.m[1][1] * py + b.m[1][2] * pz;
+					position[i].z = b.m[2][0] * px + b.m[2][1] * py + b.m[2][2] * pz;
+					if(velocity)
+					{
+						velocity[i].x = b.m[0][0] * qx + b.m[0][1] * qy + b.m[0][2] * qz;
+						velocity[i].y = b.m[1][0] * qx + b.m[1][1] * qy + b.m[1][2] * qz;
+						velocity[i].z = b.m[2][0] * qx + b.m[2][1] * qy + b.m[2][2] * qz;
+					}
+				}
+			}
+
+			Host& host;
+			double ut1MinusUtc;
+			double ttMinusUtc;
+			Matrix3 polarMotion;
+			// width of an epoch bin in seconds
+			double resolution;
+			// rotations of the epoch bins, indexed by the epoch divided by the resolution
+			std::unordered_map<long long, EpochRotation> cache;
+	};
+
+	//! \endcond
+
+	FrameTransform::FrameTransform(Host& host):
+		impl(host)
+	{
+	}
+
+	FrameTransform::~FrameTransform()
+	{
+	}
+
+	void FrameTransform::setTimeOffsets(double ut1MinusUtc, double ttMinusUtc)
+	{
+		impl->ut1MinusUtc = ut1MinusUtc;
+		impl->ttMinusUtc = ttMinusUtc;
+		impl->cache.clear();
+	}
+
+	/**
+	 * \detail
+	 * The pole coordinates are applied as W = R2(-x) R1(-y) from PEF to ITRF.
+	 */
+	void FrameTransform::setPolarMotion(double x, double y)
+	{
+		impl->polarMotion = rotateY(-x * ARCSEC) * rotateX(-y * ARCSEC);
+		impl->cache.clear();
+	}
+
+	ErrorCode FrameTransform::setEpochResolution(double seconds)
+	{
+		ErrorCode status = SUCCESS;
+		if(!(seconds >= 0.001 && seconds <= 3600.0))
+			status = INVALID_ARGUMENT;
+		else {
+			impl->resolution = seconds;
+			impl->cache.clear();
+		}
+		impl->host.sendError(status);
+		return status;
+	}
+
+	void FrameTransform::clearCache()
+	{
+		impl->cache.clear();
+	}
+
+	ErrorCode FrameTransform::getRotation(ReferenceFrame from, ReferenceFrame to, double julian_day, double* rotation, double* rate)
+	{
+		ErrorCode status = SUCCESS;
+		Frame fromFrame = getFrame(from);
+		Frame toFrame = getFrame(to);
+		if(fromFrame == FRAME_INVALID || toFrame == FRAME_INVALID || !rotation)
+			status = INVALID_ARGUMENT;
+		else
+			status = impl->prepare(&julian_day, 0, 1);
+		if(status == SUCCESS)
+		{
+			Matrix3 matrix = identity();
+			Matrix3 derivative = Matrix3();
+			if(fromFrame != toFrame)
+			{
+				FrameTransformImpl::BinTransformation bin;
+				impl->getBinTransformation(impl->getKey(julian_day), fromFrame, toFrame, bin);
+				FrameTransformImpl::getTransformation(bin, julian_day, matrix, derivative);
+			}
+			for(int i = 0; i < 9; ++i)
+			{
+				rotation[i] = matrix.m[i / 3][i % 3];
+				if(rate)
+					rate[i] = derivative.m[i / 3][i % 3];
+			}
+		}
+		impl->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode FrameTransform::transform(Vector3* position, Vector3* velocity, int count, ReferenceFrame from, ReferenceFrame to, double julian_day)
+	{
+		ErrorCode status = impl->run(position, velocity, &julian_day, 0, count, from, to);
+		impl->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode FrameTransform::transform(Vector3* position, Vector3* velocity, const double* julian_days, int count, ReferenceFrame from, ReferenceFrame to)
+	{
+		ErrorCode status = impl->run(position, velocity, julian_days, 1, count, from, to);
+		impl->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode FrameTransform::transform(Population& population, ReferenceFrame from, ReferenceFrame to, double julian_day)
+	{
+		ErrorCode status = SUCCESS;
+		if(!population.hasData(DATA_CARTESIAN))
+			status = INVALID_TYPE;
+		else {
+			bool velocity = population.hasData(DATA_VELOCITY);
+			status = impl->run(population.getPosition(DEVICE_HOST), velocity ? population.getVelocity(DEVICE_HOST) : 0, &julian_day, 0, population.getSize(), from, to);
+			if(status == SUCCESS)
+				population.updateColumns(velocity ? MASK_CARTESIAN | MASK_VELOCITY : MASK_CARTESIAN, DEVICE_HOST);
+		}
+		impl->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode FrameTransform::transform(Population& population, ReferenceFrame from, ReferenceFrame to)
+	{
+		ErrorCode status = SUCCESS;
+		if(!population.hasData(DATA_CARTESIAN) || !population.hasData(DATA_EPOCH))
+			status = INVALID_TYPE;
+		else {
+			bool velocity = population.hasData(DATA_VELOCITY);
+			const Epoch* epochs = population.getEpoch(DEVICE_HOST);
+			status = impl->run(population.getPosition(DEVICE_HOST), velocity ? population.getVelocity(DEVICE_HOST) : 0, &epochs->current_epoch, sizeof(Epoch) / sizeof(double), population.getSize(), from, to);
+			if(status == SUCCESS)
+				population.updateColumns(velocity ? MASK_CARTESIAN | MASK_VELOCITY : MASK_CARTESIAN, DEVICE_HOST);
+		}
+		impl->host.sendError(status);
+		return status;
+	}
+}
@@ -0,0 +1,150 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_FRAME_TRANSFORM_H
+#define OPI_FRAME_TRANSFORM_H
+#include "opi_common.h"
+#include "opi_error.h"
+#include "opi_datatypes.h"
+#include "opi_pimpl_helper.h"
+namespace OPI
+{
+	class Host;
+	class Population;
+	class FrameTransformImpl;
+
+	/*! \brief Converts position and velocity columns between reference frames.
+	 * \ingroup CPP_API_GROUP
+	 *
+	 * The transformations follow the IAU-76/FK5 reduction: frame bias (GCRF to J2000),
+	 * IAU-76 precession (MOD), IAU-80 nutation (TOD, truncated to the terms above 0.5 mas),
+	 * the equation of the equinoxes (TEME), Greenwich apparent sidereal time (PEF) and polar
+	 * motion (ITRF). REF_ECI is treated as GCRF and REF_ECEF as ITRF. Velocities into or out
+	 * of ITRF include the rotation of the Earth; the slow rates of precession and nutation
+	 * are neglected.
+	 *
+	 * Precession, nutation and the sidereal angle are evaluated once per epoch bin (see
+	 * setEpochResolution()) and kept in a cache, so they are shared by all objects and all
+	 * calls at similar epochs. Objects with the same epoch are transformed together by one
+	 * 3x3 matrix-vector pass; for objects with their own epochs, the rotation of the Earth
+	 * within the bin is applied exactly. Julian dates are given in UTC.
+	 *
+	 * A FrameTransform must not be used by several threads at the same time.
+	 */
+	class OPI_API_EXPORT FrameTransform
+	{
+		public:
+			/**
+			 * @brief FrameTransform Creates a transformation with an empty cache.
+			 * @param host The OPI Host used for error reporting.
+			 */
+			FrameTransform(Host& host);
+
+			/**
+			 * @brief Destructor.
+			 */
+			~FrameTransform();
+
+			/**
+			 * @brief setTimeOffsets Sets the offsets of UT1 and TT to UTC and clears the cache.
+			 * @param ut1MinusUtc UT1 - UTC in seconds (default 0).
+			 * @param ttMinusUtc TT - UTC in seconds (default 69.184, valid since 2017).
+			 */
+			void setTimeOffsets(double ut1MinusUtc, double ttMinusUtc = 69.184);
+
+			/**
+			 * @brief setPolarMotion Sets the pole coordinates and clears the cache.
+			 * @param x The x coordinate of the pole in arc seconds (default 0).
+			 * @param y The y coordinate of the pole in arc seconds (default 0).
+			 */
+			void setPolarMotion(double x, double y);
+
+			/**
+			 * @brief setEpochResolution Sets the width of the epoch bins and clears the cache.
+			 *
+			 * Precession and nutation are evaluated at the center of a bin; within one minute
+			 * (the default) they change by less than 0.05 mas.
+			 * @param seconds The width of an epoch bin in seconds, between 0.001 and 3600.
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT if seconds is out of range.
+			 */
+			ErrorCode setEpochResolution(double seconds);
+
+			/**
+			 * @brief clearCache Removes all cached epochs.
+			 */
+			void clearCache();
+
+			/**
+			 * @brief getRotation Returns the transformation between two frames at an epoch.
+			 *
+			 * A state is transformed by position' = rotation * position and
+			 * velocity' = rotation * velocity + rate * position.
+			 * @param rotation Receives the rotation matrix as 9 values in row-major order.
+			 * @param rate Receives the derivative of the rotation matrix in 1/s as 9 values in
+			 *   row-major order; may be a null pointer.
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT for frames without a definition.
+			 */
+			ErrorCode getRotation(ReferenceFrame from, ReferenceFrame to, double julian_day, double* rotation, double* rate = 0);
+
+			/**
+			 * @brief transform Transforms states that refer to the same epoch.
+			 * @param position The positions to transform in place.
+			 * @param velocity The velocities to transform in place; may be a null pointer.
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT for frames without a definition or an
+			 *   invalid epoch.
+			 */
+			ErrorCode transform(Vector3* position, Vector3* velocity, int count, ReferenceFrame from, ReferenceFrame to, double julian_day);
+
+			/**
+			 * @brief transform Transforms states that refer to individual epochs.
+			 *
+			 * Consecutive objects with the same epoch are transformed by the same matrices,
+			 * so sorting the objects by epoch speeds up the transformation.
+			 * @param position The positions to transform in place.
+			 * @param velocity The velocities to transform in place; may be a null pointer.
+			 * @param julian_days The epoch of each object.
+			 * @return OPI::SUCCESS or INVALID_ARGUMENT for frames without a definition or an
+			 *   invalid epoch.
+			 */
+			ErrorCode transform(Vector3* position, Vector3* velocity, const double* julian_days, int count, ReferenceFrame from, ReferenceFrame to);
+
+			/**
+			 * @brief transform Transforms the states of a Population that refer to the same epoch.
+			 *
+			 * The position column and, if present, the velocity column are transformed on the
+			 * host and marked as updated. Accelerations are not transformed.
+			 * @return OPI::SUCCESS, INVALID_TYPE if the Population holds no positions or
+			 *   INVALID_ARGUMENT for frames without a definition or an invalid epoch.
+			 */
+			ErrorCode transform(Population& population, ReferenceFrame from, ReferenceFrame to, double julian_day);
+
+			/**
+			 * @brief transform Transforms the states of a Population at their current epochs.
+			 *
+			 * Like transform(Population&, ReferenceFrame, ReferenceFrame, double), with the
+			 * epoch of each object taken from current_epoch of the Epoch column.
+			 * @return OPI::SUCCESS, INVALID_TYPE if the Population holds no positions or
+			 *   epochs, or INVALID_ARGUMENT for frames without a definition or an invalid epoch.
+			 */
+			ErrorCode transform(Population& population, ReferenceFrame from, ReferenceFrame to);
+
+		private:
+			FrameTransform(const FrameTransform& other);
+			Pimpl<FrameTransformImpl> impl;
+	};
+}
+
+#endif
@@ -21,8 +21,12 @@
 #include "internal/opi_propagator_plugin.h"
 #include "internal/opi_query_plugin.h"
 #include "opi_custom_propagator.h"
+#include "opi_ephemeris_cache.h"
+#include "opi_perturbation_module.h"
+#include "opi_propagator_integrator.h"
 #include "opi_collisiondetection.h"
 #include "internal/dynlib.h"
+#include "internal/opi_memory.h"
 #include <iostream>
 #ifdef _MSC_VER
 #include "internal/msdirent.h"
@@ -49,6 +53,9 @@ namespace OPI
 			OPI_ErrorCallback errorCallback;
 			void* errorCallbackParameter;
 			mutable ErrorCode lastError;
+			DefaultHostAllocator defaultAllocator;
+			HostAllocator* allocator;
+			DeviceMemoryPool devicePool;
 	};
 
 	//! \endcond
@@ -64,6 +71,7 @@ namespace OPI
 
 		impl->gpuSupport = 0;
 		impl->gpuSupportPluginHandle = 0;
+		impl->allocator = &impl->defaultAllocator;
 	}
 	Host::~Host()
 	{
@@ -86,7 +94,20 @@ namespace OPI
 			delete impl->detectionlist[i];
 		}
 
+		for(size_t i = 0; i < impl->modulelist.size(); ++i)
+		{
+			impl->modulelist[i]->disable();
+			delete impl->modulelist[i];
+		}
+
+		for(size_t i = 0; i < impl->integratorlist.size(); ++i)
+		{
+			impl->integratorlist[i]->disable();
+			delete impl->integratorlist[i];
+		}
+
 		// now free the support plugin memory
+		impl->devicePool.clear(impl->gpuSupport);
 		if(impl->gpuSupport)
 			impl->gpuSupport->shutdown();
 		delete impl->gpuSupport;
@@ -318,6 +339,36 @@ namespace OPI
                 addPropagator(propagator);
             }
             break;
+        }
+            // a perturbation module for custom propagators
+        case OPI_PROPAGATOR_MODULE_PLUGIN:
+        {
+            PerturbationModule* module = 0;
+            // this plugin uses the cpp interface
+            if(plugin->getInfo().cppPlugin) {
+                pluginPerturbationModuleFunction proc_create = (pluginPerturbationModuleFunction)plugin->getHandle()->loadFunction("OPI_Plugin_createPerturbationModule");
+                if(proc_create)
+                    module = proc_create(this);
+            }
+            // if the module is valid, add it to the list
+            if(module && pluginSupported(module, platform))
+                addPerturbationModule(module);
+            break;
+        }
+            // an integrator for custom propagators
+        case OPI_PROPAGATOR_INTEGRATOR_PLUGIN:
+        {
+            PropagatorIntegrator* integrator = 0;
+            // this plugin uses the cpp interface
+            if(plugin->getInfo().cppPlugin) {
+                pluginPropagatorIntegratorFunction proc_create = (pluginPropagatorIntegratorFunction)plugin->getHandle()->loadFunction("OPI_Plugin_createPropagatorIntegrator");
+                if(proc_create)
+                    integrator = proc_create(this);
+            }
+            // if the integrator is valid, add it to the list
+            if(integrator && pluginSupported(integrator, platform))
+                addPropagatorIntegrator(integrator);
+            break;
         }
             // a distance query plugin
         case OPI_DISTANCE_QUERY_PLUGIN:
@@ -421,6 +472,68 @@ namespace OPI
 		impl->propagagorlist.push_back(propagator);
 	}
 
+	void Host::addPerturbationModule(PerturbationModule *module)
+	{
+		module->setHost(this);
+		impl->modulelist.push_back(module);
+	}
+
+	PerturbationModule* Host::getPerturbationModule(const std::string& name) const
+	{
+		for(size_t i = 0; i < impl->modulelist.size(); ++i)
+		{
+			if(impl->modulelist[i]->getName() == name)
+				return impl->modulelist[i];
+		}
+		return 0;
+	}
+
+	PerturbationModule* Host::getPerturbationModule(int index) const
+	{
+		if((index < 0)||(index >= static_cast<int>(impl->modulelist.size())))
+		{
+			sendError(INDEX_RANGE);
+			return 0;
+		}
+		return impl->modulelist[index];
+	}
+
+	int Host::getPerturbationModuleCount() const
+	{
+		return impl->modulelist.size();
+	}
+
+	void Host::addPropagatorIntegrator(PropagatorIntegrator *integrator)
+	{
+		integrator->setHost(this);
+		impl->integratorlist.push_back(integrator);
+	}
+
+	PropagatorIntegrator* Host::getPropagatorIntegrator(const std::string& name) const
+	{
+		for(size_t i = 0; i < impl->integratorlist.size(); ++i)
+		{
+			if(impl->integratorlist[i]->getName() == name)
+				return impl->integratorlist[i];
+		}
+		return 0;
+	}
+
+	PropagatorIntegrator* Host::getPropagatorIntegrator(int index) const
+	{
+		if((index < 0)||(index >= static_cast<int>(impl->integratorlist.size())))
+		{
+			sendError(INDEX_RANGE);
+			return 0;
+		}
+		return impl->integratorlist[index];
+	}
+
+	int Host::getPropagatorIntegratorCount() const
+	{
+		return impl->integratorlist.size();
+	}
+
 	void Host::addDistanceQuery(DistanceQuery *query)
 	{
 		query->setHost(this);
@@ -497,9 +610,46 @@ namespace OPI
 		return prop;
 	}
 
+	EphemerisCache* Host::createEphemerisCache(const std::string& name)
+	{
+		EphemerisCache* cache = new EphemerisCache(name);
+		addPropagator(cache);
+		return cache;
+	}
+
 	/**
 	 * \cond INTERNAL_DOCUMENTATION
 	 */
+	void Host::setMemoryPlacement(MemoryPlacement placement, bool hugePages)
+	{
+		impl->defaultAllocator.setPlacement(placement, hugePages);
+	}
+
+	void Host::setAllocator(HostAllocator* allocator)
+	{
+		impl->allocator = allocator ? allocator : &impl->defaultAllocator;
+	}
+
+	void Host::setDeviceMemoryCacheLimit(size_t bytes)
+	{
+		impl->devicePool.setLimit(impl->gpuSupport, bytes);
+	}
+
+	void Host::releaseDeviceMemoryCache()
+	{
+		impl->devicePool.clear(impl->gpuSupport);
+	}
+
+	HostAllocator* Host::getHostAllocator() const
+	{
+		return impl->allocator;
+	}
+
+	DeviceMemoryPool* Host::getDeviceMemoryPool() const
+	{
+		return &impl->devicePool;
+	}
+
 	GpuSupport* Host::getGPUSupport() const
 	{
 		return impl->gpuSupport;
@@ -28,12 +28,15 @@ struct cudaDeviceProp;
 namespace OPI
 {
 	class CustomPropagator;
+	class EphemerisCache;
 	class Propagator;
 	class PerturbationModule;
 	class PropagatorIntegrator;
 	class DistanceQuery;
 	class Plugin;
 	class GpuSupport;
+	class HostAllocator;
+	class DeviceMemoryPool;
 	class DynLib;
 	class CollisionDetection;
 
@@ -136,6 +139,16 @@ namespace OPI
 			 */
 			CustomPropagator* createCustomPropagator(const std::string& name);
 
+			//! Adds an empty EphemerisCache with the given name to the list of available Propagators.
+			/** The cache is filled with EphemerisCache::build() and then evaluates the states of
+			 * the sampled propagator at arbitrary times inside the sampled window.
+			 * \see EphemerisCache
+			 * \returns a new instance of an EphemerisCache.
+			 */
+			EphemerisCache* createEphemerisCache(const std::string& name);
+
+			//! Adds and registers a Perturbation Module which is not implemented by a plugin
+			void addPerturbationModule(PerturbationModule* module);
 			//! Find a propagator module by name, returns 0 (null pointer) if not found
 			PerturbationModule* getPerturbationModule(const std::string& name) const;
 			//! Find a propagator module by index, returns 0 (null pointer) if not found
@@ -143,6 +156,8 @@ namespace OPI
 			//! Returns the number of known modules
 			int getPerturbationModuleCount() const;
 
+			//! Adds and registers a Propagator Integrator which is not implemented by a plugin
+			void addPropagatorIntegrator(PropagatorIntegrator* integrator);
 			//! Find a propagator integrator by name, returns 0 (null pointer) if not found
 			PropagatorIntegrator* getPropagatorIntegrator(const std::string& name) const;
 			//! Find a propagator integrator by index, returns 0 (null pointer) if not found
@@ -172,8 +187,39 @@ namespace OPI
 
 			//! Returns the code of the last occured Error of this host or its plugins
 			ErrorCode getLastError() const;
+			//! Sets how large host memory blocks (2 MiB and more) of Populations and index lists are placed.
+			/** On Linux, MEMORY_PLACEMENT_INTERLEAVED distributes the pages of each block
+			 * round-robin across all NUMA nodes. MEMORY_PLACEMENT_PARTITIONED spreads the first
+			 * touch of the pages across threads, so with the operating system's first-touch policy
+			 * a block is distributed over the nodes those threads run on. The threads are not
+			 * pinned and the page ranges do not follow the objects of each column, so this does
+			 * not place objects on the node of the thread that later processes them.
+			 * MEMORY_PLACEMENT_DEFAULT leaves the placement to the operating system. If hugePages
+			 * is set, large blocks are marked for transparent huge pages. The settings apply to
+			 * memory allocated afterwards; the defaults are MEMORY_PLACEMENT_DEFAULT with huge pages.
+			 */
+			void setMemoryPlacement(MemoryPlacement placement, bool hugePages = true);
+			//! Sets the allocator for the host memory of Populations and index lists.
+			/** A null pointer restores the default allocator. Memory is always returned to the
+			 * allocator it was obtained from, so the allocator has to stay valid until every
+			 * object that allocated memory with it is destroyed. The placement set by
+			 * setMemoryPlacement() only applies to the default allocator.
+			 */
+			void setAllocator(HostAllocator* allocator);
+			//! Sets how many bytes of released device memory are cached for reuse (default 256 MiB).
+			/** Device buffers are taken from and returned to a cache of blocks sorted by device
+			 * and size class, which avoids synchronizing cudaMalloc and cudaFree calls for
+			 * short-lived objects. A limit of zero disables the cache.
+			 */
+			void setDeviceMemoryCacheLimit(size_t bytes);
+			//! Frees all device memory that is cached for reuse
+			void releaseDeviceMemoryCache();
 
 			//! \cond INTERNAL_DOCUMENTATION
+			//! Returns the allocator used for host memory
+			HostAllocator* getHostAllocator() const;
+			//! Returns the cache of device memory blocks
+			DeviceMemoryPool* getDeviceMemoryPool() const;
 
 			//! Returns the CUDA Support object
 			GpuSupport* getGPUSupport() const;
@@ -55,6 +55,60 @@ OPI_PLUGIN_EXPORT OPI::Propagator* OPI_Plugin_createPropagator(OPI::Host& host)
 #endif
 #endif
 
+// the plugin implements a cpp perturbation module
+#ifdef OPI_IMPLEMENT_CPP_PERTURBATION_MODULE
+// enable the auto-declaration
+#define OPI_DECLARE_PLUGIN
+// set the cpp interface variable
+#define OPI_PLUGIN_USES_CPP_INTERFACE true
+// implement the interface function
+#ifdef __cplusplus
+extern "C" {
+#endif
+OPI_PLUGIN_EXPORT OPI::PerturbationModule* OPI_Plugin_createPerturbationModule(OPI::Host& host)
+{
+	OPI::PerturbationModule* out = new OPI_IMPLEMENT_CPP_PERTURBATION_MODULE(host);
+	out->setName(OPI_PLUGIN_NAME);
+	out->setAuthor(OPI_PLUGIN_AUTHOR);
+	out->setDescription(OPI_PLUGIN_DESC);
+	return out;
+}
+// if not already set, set the plugin type to perturbation module
+#ifndef OPI_PLUGIN_TYPE
+#define OPI_PLUGIN_TYPE OPI_PROPAGATOR_MODULE_PLUGIN
+#endif
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+// the plugin implements a cpp integrator
+#ifdef OPI_IMPLEMENT_CPP_PROPAGATOR_INTEGRATOR
+// enable the auto-declaration
+#define OPI_DECLARE_PLUGIN
+// set the cpp interface variable
+#define OPI_PLUGIN_USES_CPP_INTERFACE true
+// implement the interface function
+#ifdef __cplusplus
+extern "C" {
+#endif
+OPI_PLUGIN_EXPORT OPI::PropagatorIntegrator* OPI_Plugin_createPropagatorIntegrator(OPI::Host& host)
+{
+	OPI::PropagatorIntegrator* out = new OPI_IMPLEMENT_CPP_PROPAGATOR_INTEGRATOR(host);
+	out->setName(OPI_PLUGIN_NAME);
+	out->setAuthor(OPI_PLUGIN_AUTHOR);
+	out->setDescription(OPI_PLUGIN_DESC);
+	return out;
+}
+// if not already set, set the plugin type to integrator
+#ifndef OPI_PLUGIN_TYPE
+#define OPI_PLUGIN_TYPE OPI_PROPAGATOR_INTEGRATOR_PLUGIN
+#endif
+#ifdef __cplusplus
+}
+#endif
+#endif
+
 #ifdef OPI_DECLARE_COLLISION_DETECTION_PLUGIN
 #define OPI_DECLARE_PLUGIN
 #define OPI_PLUGIN_TYPE OPI_COLLISION_DETECTION_PLUGIN
@@ -16,6 +16,7 @@
  */
 #include "opi_indexlist.h"
 #include "internal/opi_synchronized_data.h"
+#include <vector>
 namespace OPI
 {
 	/**
@@ -36,10 +37,35 @@ namespace OPI
 	{
 	}
 
+	IndexList::IndexList(IndexList&& other):
+		impl(std::move(other.impl))
+	{
+	}
+
 	IndexList::~IndexList()
 	{
 	}
 
+	IndexList& IndexList::operator=(IndexList&& other)
+	{
+		impl = std::move(other.impl);
+		return *this;
+	}
+
+	void IndexList::swap(IndexList& other)
+	{
+		impl.swap(other.impl);
+	}
+
+	/**
+	 * The size of the list is its reserved size (see getSize()), so the reservation is reset
+	 * while the host memory is kept.
+	 */
+	void IndexList::clear()
+	{
+		impl->data.clear(false);
+	}
+
 	void IndexList::add(int index)
 	{
 		impl->data.add(index);
@@ -75,6 +101,27 @@ namespace OPI
 		impl->data.removeDuplicates();
 	}
 
+	void IndexList::assign(const int* indices, int count)
+	{
+		impl->data.assign(indices, count);
+	}
+
+	void IndexList::remap(const IndexList& table)
+	{
+		const int* newIndex = table.getData(DEVICE_HOST);
+		int tableSize = table.getSize();
+		const int* indices = getData(DEVICE_HOST);
+		std::vector<int> result;
+		result.reserve(getSize());
+		for(int i = 0; i < getSize(); ++i)
+		{
+			int index = indices[i];
+			if(index >= 0 && index < tableSize && newIndex[index] >= 0)
+				result.push_back(newIndex[index]);
+		}
+		assign(result.data(), result.size());
+	}
+
 	void IndexList::update(Device device, int numPairs)
 	{
 		impl->data.resize(numPairs);
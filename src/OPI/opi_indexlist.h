@@ -33,8 +33,17 @@ namespace OPI
 		public:
 			//! The host object must be valid
 			IndexList(Host& host);
+			//! Takes over the content of other, which may only be destroyed or assigned to afterwards
+			IndexList(IndexList&& other);
 			~IndexList();
 
+			//! Exchanges the content with other, whose destruction releases the former content of this list
+			IndexList& operator=(IndexList&& other);
+			//! Exchanges the content with other in O(1)
+			void swap(IndexList& other);
+			//! Removes all entries but keeps the allocated memory
+			void clear();
+
 			//! Adds an index to the list
 			void add(int index);
 			//! Sorts the list
@@ -52,6 +61,15 @@ namespace OPI
 
 			//! Removes duplicate entries from this list
 			void removeDuplicates();
+
+			//! Replaces the content of this list with count indices
+			void assign(const int* indices, int count);
+			//! Replaces every index i by table[i] and drops indices that are mapped to -1
+			/**
+			 * The table is usually the remap table returned by Population::compact().
+			 * Indices outside of the table are dropped as well.
+			 */
+			void remap(const IndexList& table);
 		private:
 			//! Private implementation details (pimpl-idiom)
 			Pimpl<IndexListImpl> impl;
@@ -15,6 +15,7 @@
  * License along with this library.
  */
 #include "opi_indexpairlist.h"
+#include "opi_indexlist.h"
 #include "internal/opi_synchronized_data.h"
 namespace OPI
 {
@@ -66,10 +67,31 @@ namespace OPI
 	{
 	}
 
+	IndexPairList::IndexPairList(IndexPairList&& other):
+		impl(std::move(other.impl))
+	{
+	}
+
 	IndexPairList::~IndexPairList()
 	{
 	}
 
+	IndexPairList& IndexPairList::operator=(IndexPairList&& other)
+	{
+		impl = std::move(other.impl);
+		return *this;
+	}
+
+	void IndexPairList::swap(IndexPairList& other)
+	{
+		impl.swap(other.impl);
+	}
+
+	void IndexPairList::clear()
+	{
+		impl->data.clear();
+	}
+
 	void IndexPairList::add(const IndexPair &pair)
 	{
 		impl->data.add(pair);
@@ -113,6 +135,33 @@ namespace OPI
 		impl->data.removeDuplicates();
 	}
 
+	/**
+	 * The table is usually the remap table returned by Population::compact(). Pairs
+	 * containing an index outside of the table are dropped as well.
+	 */
+	void IndexPairList::remap(const IndexList& table)
+	{
+		const int* newIndex = table.getData(DEVICE_HOST);
+		int tableSize = table.getSize();
+		const IndexPair* pairs = getData(DEVICE_HOST);
+		std::vector<IndexPair> result;
+		result.reserve(getPairsUsed());
+		for(int i = 0; i < getPairsUsed(); ++i)
+		{
+			const IndexPair& pair = pairs[i];
+			if(pair.object1 < 0 || pair.object1 >= tableSize || pair.object2 < 0 || pair.object2 >= tableSize)
+				continue;
+			if(newIndex[pair.object1] >= 0 && newIndex[pair.object2] >= 0)
+			{
+				IndexPair mapped;
+				mapped.object1 = newIndex[pair.object1];
+				mapped.object2 = newIndex[pair.object2];
+				result.push_back(mapped);
+			}
+		}
+		impl->data.assign(result.data(), result.size());
+	}
+
 	IndexPair* IndexPairList::getData(Device device, bool no_sync) const
 	{
 		return impl->data.getData(device, no_sync);
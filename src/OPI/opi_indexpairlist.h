@@ -21,6 +21,7 @@
 #include "opi_pimpl_helper.h"
 namespace OPI
 {
+	class IndexList;
 	class IndexPairListImpl;
 	class Host;
 	class IndexPair;
@@ -32,8 +33,17 @@ namespace OPI
 		public:
 			/// The host object must be valid
 			IndexPairList(Host& host);
+			/// Takes over the content of other, which may only be destroyed or assigned to afterwards
+			IndexPairList(IndexPairList&& other);
 			~IndexPairList();
 
+			/// Exchanges the content with other, whose destruction releases the former content of this list
+			IndexPairList& operator=(IndexPairList&& other);
+			/// Exchanges the content with other in O(1)
+			void swap(IndexPairList& other);
+			/// Removes all entries but keeps the allocated memory
+			void clear();
+
 			//! Adds an indexpair to the list
 			void add(const IndexPair& pair);
 			void add(int object1, int object2);
@@ -48,6 +58,8 @@ namespace OPI
 			int getTotalSpace() const;
 
 			void removeDuplicates();
+			/// Replaces both indices of every pair using the table and drops pairs containing an index mapped to -1
+			void remap(const IndexList& table);
 			/// Returns a device-specific pointer to the data
 			IndexPair* getData(Device device = DEVICE_HOST, bool no_sync = false) const;
 		private:
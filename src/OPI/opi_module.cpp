@@ -320,6 +320,10 @@ namespace OPI
 			std::string description;
 			std::map<std::string, Property> properties;
 			void* privateData;
+			bool columnUsageDeclared;
+			DataMask readColumns;
+			DataMask writtenColumns;
+			Device targetDevice;
 			template<class T> ErrorCode setValue(const std::string& name, const T& value);
 	};
 
@@ -333,6 +337,10 @@ namespace OPI
 	{
 		data->host = 0;
 		data->enabled = false;
+		data->columnUsageDeclared = false;
+		data->readColumns = MASK_ALL;
+		data->writtenColumns = MASK_ALL;
+		data->targetDevice = DEVICE_HOST;
 	}
 
 	Module::~Module()
@@ -409,6 +417,34 @@ namespace OPI
 		return data->description;
 	}
 
+	void Module::setColumnUsage(DataMask read, DataMask written, Device device)
+	{
+		data->columnUsageDeclared = true;
+		data->readColumns = read;
+		data->writtenColumns = written;
+		data->targetDevice = device;
+	}
+
+	bool Module::hasColumnUsage() const
+	{
+		return data->columnUsageDeclared;
+	}
+
+	DataMask Module::getReadColumns() const
+	{
+		return data->readColumns;
+	}
+
+	DataMask Module::getWrittenColumns() const
+	{
+		return data->writtenColumns;
+	}
+
+	Device Module::getTargetDevice() const
+	{
+		return data->targetDevice;
+	}
+
 	Host* Module::getHost() const
 	{
 		return data->host;
@@ -144,6 +144,29 @@ namespace OPI
 			int getPropertySize(int index) const;
 
 
+			/**
+			 * @brief setColumnUsage Declares which Population columns this module accesses.
+			 *
+			 * With a declaration, OPI synchronizes all read columns to the target device before
+			 * the module is called, using as few transfers as possible, and marks all written
+			 * columns as updated on the target device afterwards. Calling Population::update()
+			 * for these columns is then not necessary. The indexed propagation fallback only
+			 * copies the declared columns. Without a declaration (the default), the module has to
+			 * synchronize and update the columns itself.
+			 * @param read The columns the module reads (see DataMask).
+			 * @param written The columns the module writes (see DataMask).
+			 * @param device The device the module works on.
+			 */
+			void setColumnUsage(DataMask read, DataMask written, Device device = DEVICE_HOST);
+			//! Checks if the module has declared its column usage
+			bool hasColumnUsage() const;
+			//! Returns the columns the module reads, MASK_ALL if not declared
+			DataMask getReadColumns() const;
+			//! Returns the columns the module writes, MASK_ALL if not declared
+			DataMask getWrittenColumns() const;
+			//! Returns the device the module works on, DEVICE_HOST if not declared
+			Device getTargetDevice() const;
+
 			//! Sets a private module-internal data pointer
 			void setPrivateData(void* private_data);
 			//! Returns the module-internal data pointer
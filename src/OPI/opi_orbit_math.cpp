@@ -0,0 +1,98 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_orbit_math.h"
+#include <cmath>
+
+// the baseline kernels use NEON on ARM64, where it is always available
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define OPI_SIMD_NEON
+#endif
+#define OPI_SIMD_NAMESPACE generic
+#include "internal/opi_orbit_kernels_impl.h"
+#undef OPI_SIMD_NAMESPACE
+
+namespace OPI
+{
+	namespace
+	{
+		const OrbitKernels& selectOrbitKernels()
+		{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#ifdef OPI_HAVE_AVX512_KERNELS
+			if(__builtin_cpu_supports("avx512f"))
+				return avx512::kernels;
+#endif
+#ifdef OPI_HAVE_AVX2_KERNELS
+			if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+				return avx2::kernels;
+#endif
+#endif
+			return generic::kernels;
+		}
+	}
+
+	const OrbitKernels& getOrbitKernels()
+	{
+		static const OrbitKernels& kernels = selectOrbitKernels();
+		return kernels;
+	}
+
+	void meanToEccentricAnomaly(const double* meanAnomaly, const double* eccentricity, double* eccentricAnomaly, int count, double tolerance, int maxIterations)
+	{
+		getOrbitKernels().meanToEccentric(meanAnomaly, eccentricity, eccentricAnomaly, count, tolerance, maxIterations);
+	}
+
+	void eccentricToTrueAnomaly(const double* eccentricAnomaly, const double* eccentricity, double* trueAnomaly, int count)
+	{
+		getOrbitKernels().eccentricToTrue(eccentricAnomaly, eccentricity, trueAnomaly, count);
+	}
+
+	void meanToTrueAnomaly(const double* meanAnomaly, const double* eccentricity, double* trueAnomaly, int count, double tolerance, int maxIterations)
+	{
+		getOrbitKernels().meanToTrue(meanAnomaly, eccentricity, trueAnomaly, count, tolerance, maxIterations);
+	}
+
+	void trueToMeanAnomaly(const double* trueAnomaly, const double* eccentricity, double* meanAnomaly, int count)
+	{
+		getOrbitKernels().trueToMean(trueAnomaly, eccentricity, meanAnomaly, count);
+	}
+
+	void convertElementsToState(const Orbit* orbits, Vector3* position, Vector3* velocity, int count, double mu)
+	{
+		getOrbitKernels().elementsToState(orbits, position, velocity, count, mu);
+	}
+
+	void convertStateToElements(const Vector3* position, const Vector3* velocity, Orbit* orbits, int count, double mu)
+	{
+		getOrbitKernels().stateToElements(position, velocity, orbits, count, mu);
+	}
+
+	double getMeanMotion(double semiMajorAxis, double mu)
+	{
+		return sqrt(mu / (semiMajorAxis * semiMajorAxis * semiMajorAxis));
+	}
+
+	double getOrbitalPeriod(double semiMajorAxis, double mu)
+	{
+		return 6.28318530717958647693 / getMeanMotion(semiMajorAxis, mu);
+	}
+
+	const char* getOrbitMathInstructionSet()
+	{
+		return getOrbitKernels().name;
+	}
+}
@@ -0,0 +1,85 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_ORBIT_MATH_H
+#define OPI_ORBIT_MATH_H
+#include "opi_common.h"
+#include "opi_datatypes.h"
+
+/*! \file opi_orbit_math.h
+ * \brief Batch conversions between anomalies, orbital elements and Cartesian state vectors.
+ *
+ * All functions process arrays of objects and use the widest vector instruction set
+ * supported by the CPU (AVX-512 or AVX2 on x86-64, NEON on ARM64), which is selected
+ * once at runtime. Angles are given in radians, lengths in km and times in seconds.
+ * Only elliptic orbits (0 <= e < 1) are supported; other eccentricities yield NaN.
+ * Output arrays may be the same as input arrays of the same type.
+ */
+namespace OPI
+{
+	//! Standard gravitational parameter of the Earth in km^3/s^2 (WGS-84)
+	const double EARTH_MU = 398600.4418;
+
+	/**
+	 * @brief meanToEccentricAnomaly Solves Kepler's equation for count objects.
+	 * @param tolerance Newton's method stops for an object when the last correction is
+	 *   smaller than this value (in radians).
+	 * @param maxIterations Maximum number of Newton iterations.
+	 *
+	 * The eccentric anomaly is returned in the same revolution as the mean anomaly.
+	 */
+	OPI_API_EXPORT void meanToEccentricAnomaly(const double* meanAnomaly, const double* eccentricity, double* eccentricAnomaly, int count, double tolerance = 1e-12, int maxIterations = 50);
+
+	//! Converts eccentric anomalies to true anomalies in the same revolution.
+	OPI_API_EXPORT void eccentricToTrueAnomaly(const double* eccentricAnomaly, const double* eccentricity, double* trueAnomaly, int count);
+
+	//! Converts mean anomalies to true anomalies in the same revolution, see meanToEccentricAnomaly().
+	OPI_API_EXPORT void meanToTrueAnomaly(const double* meanAnomaly, const double* eccentricity, double* trueAnomaly, int count, double tolerance = 1e-12, int maxIterations = 50);
+
+	//! Converts true anomalies to mean anomalies in the same revolution.
+	OPI_API_EXPORT void trueToMeanAnomaly(const double* trueAnomaly, const double* eccentricity, double* meanAnomaly, int count);
+
+	/**
+	 * @brief convertElementsToState Calculates position and velocity from the orbital elements.
+	 * @param position Receives the positions in km; may be a null pointer.
+	 * @param velocity Receives the velocities in km/s; may be a null pointer.
+	 * @param mu Gravitational parameter of the central body in km^3/s^2.
+	 *
+	 * The elements are read from semi_major_axis, eccentricity, inclination, raan,
+	 * arg_of_perigee and mean_anomaly; bol and eol are ignored.
+	 */
+	OPI_API_EXPORT void convertElementsToState(const Orbit* orbits, Vector3* position, Vector3* velocity, int count, double mu = EARTH_MU);
+
+	/**
+	 * @brief convertStateToElements Calculates the orbital elements from position and velocity.
+	 *
+	 * All angles are returned in [0, 2pi). For equatorial orbits the ascending node is
+	 * placed on the x axis, for circular orbits the perigee is placed on the ascending node.
+	 * bol and eol of the orbits are not changed.
+	 */
+	OPI_API_EXPORT void convertStateToElements(const Vector3* position, const Vector3* velocity, Orbit* orbits, int count, double mu = EARTH_MU);
+
+	//! Returns the mean motion in rad/s for the given semi-major axis.
+	OPI_API_EXPORT double getMeanMotion(double semiMajorAxis, double mu = EARTH_MU);
+
+	//! Returns the orbital period in seconds for the given semi-major axis.
+	OPI_API_EXPORT double getOrbitalPeriod(double semiMajorAxis, double mu = EARTH_MU);
+
+	//! Returns the name of the instruction set used by the orbit math functions.
+	OPI_API_EXPORT const char* getOrbitMathInstructionSet();
+}
+
+#endif
@@ -25,7 +25,22 @@ namespace OPI
 		return NOT_IMPLEMENTED;
 	}
 
-	ErrorCode setTimeStep(double julian_day)
+	ErrorCode PerturbationModule::calculateAcceleration(const StateBatch& batch)
+	{
+		return runAccelerationCalculation(batch);
+	}
+
+	ErrorCode PerturbationModule::runAccelerationCalculation(const StateBatch& batch)
+	{
+		return NOT_IMPLEMENTED;
+	}
+
+	ErrorCode PerturbationModule::setTimeStep(double julian_day)
+	{
+		return runSetTimeStep(julian_day);
+	}
+
+	ErrorCode PerturbationModule::runSetTimeStep(double julian_day)
 	{
 		// overload if necessary
 		return OPI::SUCCESS;
@@ -28,11 +28,39 @@ namespace OPI
 	//! Contains the module implementation data
 	class PerturbationModuleImpl;
 
+	/*!
+	 * \brief Host arrays of the objects whose accelerations are calculated.
+	 *
+	 * \ingroup CPP_API_GROUP
+	 * Entry i of every array belongs to the same object. The arrays are usually not the
+	 * columns of a Population but scratch buffers of an integrator holding intermediate
+	 * states, so modules must only access the objects through this structure.
+	 */
+	struct StateBatch
+	{
+		//! Number of entries
+		int count;
+		//! Positions in km
+		const Vector3* position;
+		//! Velocities in km/s
+		const Vector3* velocity;
+		//! Times of the states as Julian dates
+		const double* julian_day;
+		//! Object properties, a null pointer if the Population holds none
+		const ObjectProperties* properties;
+		//! Receives the accelerations in km/s^2
+		Vector3* acceleration;
+	};
+
 	/*!
 	 * \brief This class represents a pertubation module which can be used by a Propagator
 	 *
 	 * \ingroup CPP_API_GROUP
-	 * \see Module, Host
+	 * Modules can provide two kinds of contributions: changes of the orbital elements over a
+	 * time step (calculate()), which are used by CustomPropagators without an integrator,
+	 * and accelerations (calculateAcceleration()), which are used by numerical integrators.
+	 * A module only has to implement the kind that fits its model.
+	 * \see Module, Host, CustomPropagator
 	 */
 	class OPI_API_EXPORT PerturbationModule:
 			public Module
@@ -45,10 +73,25 @@ namespace OPI
 			 * The calculated pertubation forces will be added to the values present in data_out
 			 */
 			ErrorCode calculate(Population& data, Orbit* delta, float dt );
+
+			/**
+			 * @brief calculateAcceleration Adds the accelerations of this module to a batch.
+			 *
+			 * The accelerations of all entries are added to batch.acceleration. This function
+			 * is called concurrently for different batches and must be thread-safe.
+			 * @return OPI::SUCCESS, or NOT_IMPLEMENTED if the module provides no accelerations.
+			 */
+			ErrorCode calculateAcceleration(const StateBatch& batch);
+
+			//! Prepares the module for calculations around the given time (Julian date)
 			ErrorCode setTimeStep(double julian_day);
 
 		protected:
 			virtual ErrorCode runCalculation(Population& data, Orbit* delta, float dt );
+			//! Override this to provide accelerations, see calculateAcceleration()
+			virtual ErrorCode runAccelerationCalculation(const StateBatch& batch);
+			//! Override this to precompute time-dependent data, e.g. tables or ephemerides
+			virtual ErrorCode runSetTimeStep(double julian_day);
 
 		private:
 			Pimpl<PerturbationModuleImpl> impl;
@@ -16,6 +16,8 @@
  */
 #ifndef OPI_INTERNAL_PIMPL_HELPER_H
 #define OPI_INTERNAL_PIMPL_HELPER_H
+#include <algorithm>
+#include <type_traits>
 
 namespace OPI
 {
@@ -27,14 +29,24 @@ namespace OPI
 		public:
 			//! allocate impl data on construction
 			Pimpl() { data = new T; }
-			template< class T2>
+			//! allocate impl data constructed from value; never used for copying another Pimpl
+			template< class T2, class = typename std::enable_if<!std::is_same<typename std::decay<T2>::type, Pimpl>::value>::type>
 			Pimpl(T2& value) { data = new T(value); }
+			//! take over the impl data, other is left without any
+			Pimpl(Pimpl&& other): data(other.data) { other.data = 0; }
 
 			~Pimpl() { delete data; }
+			//! exchange the impl data, other is freed with the former data of this object
+			Pimpl& operator=(Pimpl&& other) { std::swap(data, other.data); return *this; }
+			void swap(Pimpl& other) { std::swap(data, other.data); }
 			T* operator->() const { return data; }
 			T* operator*() const { return data; }
 
 		private:
+			// copying the pointer would delete the impl data twice
+			Pimpl(const Pimpl&);
+			Pimpl& operator=(const Pimpl&);
+
 			T* data;
 	};
 }
@@ -17,10 +17,20 @@
 #include "opi_population.h"
 #include "opi_host.h"
 #include "opi_indexlist.h"
+#include "opi_population_checkpoint.h"
 #include "opi_gpusupport.h"
 #include "internal/opi_synchronized_data.h"
+#include "internal/opi_population_file.h"
+#include "internal/opi_catalog_import.h"
+#include "internal/opi_id_index.h"
+#include "internal/opi_parallel.h"
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <sstream>
@@ -31,6 +41,74 @@ namespace OPI
 	 * \cond INTERNAL_DOCUMENTATION
 	 */
 
+	// tombstones and generations of a Population with enabled slot map
+	struct SlotMap
+	{
+			SlotMap(): tombstones(0) {}
+
+			bool isValid(int index) const
+			{
+				return (valid[index >> 6] >> (index & 63)) & 1;
+			}
+
+			void setValid(int index, bool value)
+			{
+				if(value)
+					valid[index >> 6] |= 1ull << (index & 63);
+				else
+					valid[index >> 6] &= ~(1ull << (index & 63));
+			}
+
+			// new slots are valid, tombstones beyond the new size are dropped
+			void resize(int size)
+			{
+				int oldSize = generations.size();
+				generations.resize(size, 0);
+				valid.resize((size + 63) / 64, 0);
+				for(int i = oldSize; i < size; ++i)
+					setValid(i, true);
+				if(size < oldSize)
+				{
+					if(size & 63)
+						valid.back() &= (1ull << (size & 63)) - 1;
+					int count = 0;
+					for(size_t w = 0; w < valid.size(); ++w)
+						for(unsigned long long bits = valid[w]; bits; bits &= bits - 1)
+							count++;
+					tombstones = size - count;
+				}
+			}
+
+			// makes all slots valid and invalidates all existing handles
+			void revalidate()
+			{
+				for(size_t i = 0; i < generations.size(); ++i)
+				{
+					generations[i]++;
+					setValid(i, true);
+				}
+				tombstones = 0;
+			}
+
+			// one bit per slot, set for live objects
+			std::vector<unsigned long long> valid;
+			std::vector<int> generations;
+			int tombstones;
+	};
+
+	// one host memory block and one block per device holding all columns of a Population
+	struct ColumnSlab
+	{
+			std::shared_ptr<char> host;
+			std::map< Device, std::shared_ptr<DeviceMemory> > devices;
+			// offset of every column in bytes, aligned to HOST_MEMORY_ALIGNMENT
+			size_t offsets[DATA_EPOCH + 1];
+			size_t bytes;
+			// number of objects and byte array size the block was laid out for
+			int capacity;
+			int byteArraySize;
+	};
+
 	// this holds all internal Population variables (pimpl)
 	struct ObjectRawData
 	{
@@ -41,8 +119,21 @@ namespace OPI
 				data_position(host),
 				data_velocity(host),
                 data_acceleration(host),
-                data_bytes(host)
+                data_bytes(host),
+                data_epoch(host),
+                object_names(std::make_shared< std::vector<std::string> >()),
+                idIndexEnabled(false),
+                idIndexValid(false),
+                compactionThreshold(0.25f),
+                slabEnabled(false)
 			{
+				columns[DATA_ORBIT] = &data_orbit;
+				columns[DATA_PROPERTIES] = &data_properties;
+				columns[DATA_CARTESIAN] = &data_position;
+				columns[DATA_VELOCITY] = &data_velocity;
+				columns[DATA_ACCELERATION] = &data_acceleration;
+				columns[DATA_BYTES] = &data_bytes;
+				columns[DATA_EPOCH] = &data_epoch;
 
 			}
 
@@ -54,15 +145,87 @@ namespace OPI
 			SynchronizedData<Vector3> data_velocity;
             SynchronizedData<Vector3> data_acceleration;
             SynchronizedData<char> data_bytes;
+            SynchronizedData<Epoch> data_epoch;
+            // all columns indexed by DataType
+            SynchronizedStorage* columns[DATA_EPOCH + 1];
+
+            //! Returns the object names, duplicating them first if they are shared with a copy
+            std::vector<std::string>& names()
+            {
+                if(object_names.use_count() > 1)
+                    object_names = std::make_shared< std::vector<std::string> >(*object_names);
+                return *object_names;
+            }
 
-            // non-synchronized data
-            std::vector<std::string> object_names;
+            // non-synchronized data, shared between copies until modified
+            std::shared_ptr< std::vector<std::string> > object_names;
             std::string lastPropagatorName;
 
+            // compression settings used when writing to disk
+            ColumnCompression compression[DATA_EPOCH + 1];
+
+            // id lookup table, rebuilt on demand after the ids or indices changed; the const
+            // lookups rebuild it while holding idIndexMutex
+            IdIndex idIndex;
+            bool idIndexEnabled;
+            std::atomic<bool> idIndexValid;
+            std::mutex idIndexMutex;
+
+            //! Returns the slot map, duplicating it first if it is shared with a copy
+            SlotMap& slots()
+            {
+                if(slotMap.use_count() > 1)
+                    slotMap = std::make_shared<SlotMap>(*slotMap);
+                return *slotMap;
+            }
+
+            // tombstones for removed objects, null if the slot map is disabled
+            std::shared_ptr<SlotMap> slotMap;
+            float compactionThreshold;
+
+            // single memory block for all columns, null if disabled or not packed yet
+            std::shared_ptr<ColumnSlab> slab;
+            bool slabEnabled;
+
 			// data size
 			int size;
             int byteArraySize;
 	};
+
+	namespace
+	{
+		//! Copies source to dest if the binary representations differ
+		template<class T>
+		bool assignIfChanged(T& dest, const T& source)
+		{
+			if(memcmp(&dest, &source, sizeof(T)) == 0)
+				return false;
+			dest = source;
+			return true;
+		}
+
+		//! ObjectProperties contains padding, so the members are compared individually
+		bool assignIfChanged(ObjectProperties& dest, const ObjectProperties& source)
+		{
+			if(dest.mass == source.mass && dest.diameter == source.diameter
+				&& dest.area_to_mass == source.area_to_mass && dest.drag_coefficient == source.drag_coefficient
+				&& dest.reflectivity == source.reflectivity && dest.id == source.id)
+				return false;
+			dest = source;
+			return true;
+		}
+
+		//! Moves the entries of a column to the positions given by newIndex, -1 drops an entry
+		template<class T>
+		void compactColumn(T* values, const std::vector<int>& newIndex, int entrySize = 1)
+		{
+			for(size_t i = 0; i < newIndex.size(); ++i)
+			{
+				if(newIndex[i] >= 0 && newIndex[i] != (int)i)
+					std::copy(values + i * entrySize, values + (i + 1) * entrySize, values + (size_t)newIndex[i] * entrySize);
+			}
+		}
+	}
 	/**
 	 * \endcond
 	 */
@@ -76,278 +239,387 @@ namespace OPI
 		resize(size);        
 	}
 
+    /**
+     * \detail
+     * The columns and object names are shared with the source (on the host and on every
+     * device) and only duplicated when one of the Populations requests access to them.
+     */
     Population::Population(const Population& source) : data(source.getHostPointer())
     {
-        data->size = 0;
-        data->byteArraySize = 1;
+        data->size = source.getSize();
+        data->byteArraySize = source.getByteArraySize();
         data->lastPropagatorName = source.getLastPropagatorName();
-        int s = source.getSize();
-        int b = source.getByteArraySize();
-        resize(s);
-        resizeByteArray(b);
+        std::copy(source.data->compression, source.data->compression + DATA_EPOCH + 1, data->compression);
 
-        // TODO Use std::copy instead
-        memcpy(getOrbit(), source.getOrbit(), s*sizeof(Orbit));
-        memcpy(getObjectProperties(), source.getObjectProperties(), s*sizeof(ObjectProperties));
-        memcpy(getPosition(), source.getPosition(), s*sizeof(Vector3));
-        memcpy(getVelocity(), source.getVelocity(), s*sizeof(Vector3));
-        memcpy(getAcceleration(), source.getAcceleration(), s*sizeof(Vector3));
-        memcpy(getBytes(), source.getBytes(), b*s*sizeof(char));
-
-        update(DATA_ORBIT);
-        update(DATA_PROPERTIES);
-        update(DATA_CARTESIAN);
-        update(DATA_VELOCITY);
-        update(DATA_ACCELERATION);
-        update(DATA_BYTES);
+        data->data_orbit.share(source.data->data_orbit);
+        data->data_properties.share(source.data->data_properties);
+        data->data_position.share(source.data->data_position);
+        data->data_velocity.share(source.data->data_velocity);
+        data->data_acceleration.share(source.data->data_acceleration);
+        data->data_bytes.share(source.data->data_bytes);
+        data->data_epoch.share(source.data->data_epoch);
+        data->object_names = source.data->object_names;
+        data->slotMap = source.data->slotMap;
+        data->compactionThreshold = source.data->compactionThreshold;
+        // the shared columns stay in the slab of the source, the copy packs its own on resize
+        data->slabEnabled = source.data->slabEnabled;
     }
 
-    Population::Population(const Population& source, IndexList &list) : data(source.getHostPointer())
+    Population::Population(const Population& source, IndexList &list, DataMask columns) : data(source.getHostPointer())
     {
         data->size = 0;
         data->byteArraySize = 1;
         data->lastPropagatorName = source.getLastPropagatorName();
+        std::copy(source.data->compression, source.data->compression + DATA_EPOCH + 1, data->compression);
         int s = list.getSize();
         int b = source.getByteArraySize();
         resize(s);
         resizeByteArray(b);
-        int* listdata = list.getData(DEVICE_HOST);
-
-        Orbit* orbits = source.getOrbit(DEVICE_HOST, false);
-        ObjectProperties* props = source.getObjectProperties(DEVICE_HOST, false);
-        Vector3* pos = source.getPosition(DEVICE_HOST, false);
-        Vector3* vel = source.getVelocity(DEVICE_HOST, false);
-        Vector3* acc = source.getAcceleration(DEVICE_HOST, false);
-        char* bytes = source.getBytes(DEVICE_HOST, false);
-
-        Orbit* thisOrbit = getOrbit();
-        ObjectProperties* thisProps = getObjectProperties();
-        Vector3* thisPos = getPosition();
-        Vector3* thisVel = getVelocity();
-        Vector3* thisAcc = getAcceleration();
-        char* thisBytes = getBytes();
-
-        for(int i = 0; i < list.getSize(); ++i)
+        const int* listdata = list.getData(DEVICE_HOST);
+
+        // columns without data in the source stay unallocated
+        for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
         {
-            thisOrbit[i] = orbits[listdata[i]];
-            thisProps[i] = props[listdata[i]];
-            thisPos[i] = pos[listdata[i]];
-            thisVel[i] = vel[listdata[i]];
-            thisAcc[i] = acc[listdata[i]];
-            for (int j=0; j<b; j++)
-            {
-                thisBytes[i*b+j] = bytes[listdata[i]*b+j];
-            }
+            if(!(columns & (1 << type)) || !source.hasData(type))
+                continue;
+            const char* from = source.getColumnPointer(type);
+            char* to = getColumnPointer(type);
+            size_t entrySize = getColumnEntrySize(type);
+            for(int i = 0; i < s; ++i)
+                memcpy(to + i * entrySize, from + (size_t)listdata[i] * entrySize, entrySize);
+            update(type);
         }
+    }
 
-        update(DATA_ORBIT);
-        update(DATA_PROPERTIES);
-        update(DATA_CARTESIAN);
-        update(DATA_VELOCITY);
-        update(DATA_ACCELERATION);
-        update(DATA_BYTES);
+    Population::Population(Population&& source) : data(std::move(source.data))
+    {
     }
 
 	Population::~Population()
 	{
     }
 
+    Population& Population::operator=(const Population& source)
+    {
+        if(this != &source)
+        {
+            Population copy(source);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    Population& Population::operator=(Population&& source)
+    {
+        data = std::move(source.data);
+        return *this;
+    }
+
+    void Population::swap(Population& other)
+    {
+        data.swap(other.data);
+    }
+
 	/**
 	 * \detail
-	 * The File will contain a 32-bit integer containing the number of Objects.
-	 * Following are the blocks of data consisting of:
-	 * A 32-bit integer declaring the type of the block, followed by another 32-bit integer defining the size of one entry
-	 * followed by entry_size * number_of_objects bytes containing the actual data
+	 * The file starts with a header containing a magic number, the file version, the number
+	 * of objects, the per-object size of the byte array and the name of the last propagator.
+	 * It is followed by blocks of column data, each consisting of a header (type of the block,
+	 * size of one entry, index of the first object, number of objects, encoding and payload
+	 * size) followed by the actual data. Columns are split into blocks of at most 65536
+	 * objects which are encoded according to the compression settings of the column (see
+	 * setCompression) and written in parallel.
 	 *
 	 * This will not work between machines with different endianness!
 	 */
 	void Population::write(const std::string& filename)
 	{
-		int temp;
-        int versionNumber = 1;
-        int magic = 47627;
-        int nameLength = data->lastPropagatorName.length();
-		std::ofstream out(filename.c_str(), std::ofstream::binary);
-		if(out.is_open())
-		{                        
-            out.write(reinterpret_cast<char*>(&magic), sizeof(int));
-            out.write(reinterpret_cast<char*>(&versionNumber), sizeof(int));
-			out.write(reinterpret_cast<char*>(&data->size), sizeof(int));
-            out.write(reinterpret_cast<char*>(&nameLength), sizeof(int));
-            out.write(reinterpret_cast<char*>(&data->lastPropagatorName), data->lastPropagatorName.length());
-			if(data->data_orbit.hasData())
-			{
-				temp = DATA_ORBIT;
-				out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-				temp = sizeof(Orbit);
-				out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-				out.write(reinterpret_cast<char*>(getOrbit()), sizeof(Orbit) * data->size);
-			}
-			if(data->data_properties.hasData())
-			{
-				temp = DATA_PROPERTIES;
-				out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-				temp = sizeof(ObjectProperties);
-				out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-				out.write(reinterpret_cast<char*>(getObjectProperties()), sizeof(ObjectProperties) * data->size);
-			}
-            if(data->data_position.hasData())
-            {
-                temp = DATA_CARTESIAN;
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                temp = sizeof(Vector3);
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                out.write(reinterpret_cast<char*>(getPosition()), sizeof(Vector3) * data->size);
-            }
-            if(data->data_velocity.hasData())
-            {
-                temp = DATA_VELOCITY;
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                temp = sizeof(Vector3);
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                out.write(reinterpret_cast<char*>(getVelocity()), sizeof(Vector3) * data->size);
-            }
-            if(data->data_acceleration.hasData())
-            {
-                temp = DATA_VELOCITY;
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                temp = sizeof(Vector3);
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                out.write(reinterpret_cast<char*>(getAcceleration()), sizeof(Vector3) * data->size);
-            }
-            if(data->data_bytes.hasData())
-            {
-                temp = DATA_BYTES;
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                temp = data->byteArraySize;
-                out.write(reinterpret_cast<char*>(&temp), sizeof(int));
-                out.write(reinterpret_cast<char*>(getBytes()), data->byteArraySize * data->size);
-            }
+		PopulationFileWriter out;
+		ErrorCode status = out.open(filename, data->lastPropagatorName, data->byteArraySize);
+		if(status == SUCCESS)
+		{
+			writeRange(out, 0);
+			status = out.finish(data->size);
+		}
+		data->host.sendError(status);
+	}
+
+	/**
+	 * \detail
+	 * Queues the blocks of all stored columns in an opened population file. The blocks are
+	 * marked as containing the objects [first, first + getSize()) of the file and are written
+	 * when the file writer is flushed. The data is synchronized to the host if necessary.
+	 */
+	void Population::writeRange(PopulationFileWriter& out, int first)
+	{
+		if(data->data_orbit.hasData())
+			out.addColumn(DATA_ORBIT, sizeof(Orbit), first, data->size, reinterpret_cast<char*>(getOrbit()), getColumnCompression(DATA_ORBIT));
+		if(data->data_properties.hasData())
+			out.addColumn(DATA_PROPERTIES, sizeof(ObjectProperties), first, data->size, reinterpret_cast<char*>(getObjectProperties()), getColumnCompression(DATA_PROPERTIES));
+		if(data->data_position.hasData())
+			out.addColumn(DATA_CARTESIAN, sizeof(Vector3), first, data->size, reinterpret_cast<char*>(getPosition()), getColumnCompression(DATA_CARTESIAN));
+		if(data->data_velocity.hasData())
+			out.addColumn(DATA_VELOCITY, sizeof(Vector3), first, data->size, reinterpret_cast<char*>(getVelocity()), getColumnCompression(DATA_VELOCITY));
+		if(data->data_acceleration.hasData())
+			out.addColumn(DATA_ACCELERATION, sizeof(Vector3), first, data->size, reinterpret_cast<char*>(getAcceleration()), getColumnCompression(DATA_ACCELERATION));
+		if(data->data_bytes.hasData())
+			out.addColumn(DATA_BYTES, data->byteArraySize, first, data->size, getBytes(), getColumnCompression(DATA_BYTES));
+		if(data->data_epoch.hasData())
+			out.addColumn(DATA_EPOCH, sizeof(Epoch), first, data->size, reinterpret_cast<char*>(getEpoch()), getColumnCompression(DATA_EPOCH));
+	}
+
+	ErrorCode Population::importTLE(const std::string& filename)
+	{
+		// the names are set by parallel workers, so they must not be shared with a copy
+		data->names();
+		ErrorCode status = importTLECatalog(*this, filename);
+		data->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode Population::importCSV(const std::string& filename)
+	{
+		// the names are set by parallel workers, so they must not be shared with a copy
+		data->names();
+		ErrorCode status = importCSVCatalog(*this, filename);
+		data->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode Population::setCompression(DataType type, CompressionMode mode, int mantissaBits)
+	{
+		ErrorCode status = SUCCESS;
+		if(type < DATA_ORBIT || type > DATA_EPOCH)
+			status = INVALID_TYPE;
+		else if(mantissaBits < 0 || mantissaBits > 52)
+			status = INVALID_ARGUMENT;
+		else {
+			data->compression[type].mode = mode;
+			data->compression[type].mantissaBits = mantissaBits;
+		}
+		data->host.sendError(status);
+		return status;
+	}
+
+	CompressionMode Population::getCompression(DataType type) const
+	{
+		if(type < DATA_ORBIT || type > DATA_EPOCH)
+			return COMPRESSION_NONE;
+		return data->compression[type].mode;
+	}
+
+	/**
+	 * \detail
+	 * Lossy compression only touches the leading doubles of an entry, which excludes the
+	 * object id of ObjectProperties and the byte array.
+	 */
+	ColumnCompression Population::getColumnCompression(int type) const
+	{
+		ColumnCompression compression = data->compression[type];
+		switch(type)
+		{
+			case DATA_ORBIT:
+				compression.doubleCount = sizeof(Orbit) / sizeof(double);
+				break;
+			case DATA_PROPERTIES:
+				compression.doubleCount = 5;
+				break;
+			case DATA_CARTESIAN:
+			case DATA_VELOCITY:
+			case DATA_ACCELERATION:
+				compression.doubleCount = 3;
+				break;
+			case DATA_EPOCH:
+				compression.doubleCount = sizeof(Epoch) / sizeof(double);
+				break;
+			default:
+				compression.doubleCount = 0;
+		}
+		return compression;
+	}
+
+	ErrorCode Population::checkpoint(const std::string& filename, PopulationCheckpoint& handle, FileSyncPolicy policy)
+	{
+		return handle.start(*this, filename, policy);
+	}
+
+	bool Population::hasData(int type) const
+	{
+		switch(type)
+		{
+			case DATA_ORBIT:
+				return data->data_orbit.hasData();
+			case DATA_PROPERTIES:
+				return data->data_properties.hasData();
+			case DATA_CARTESIAN:
+				return data->data_position.hasData();
+			case DATA_VELOCITY:
+				return data->data_velocity.hasData();
+			case DATA_ACCELERATION:
+				return data->data_acceleration.hasData();
+			case DATA_BYTES:
+				return data->data_bytes.hasData();
+			case DATA_EPOCH:
+				return data->data_epoch.hasData();
 		}
+		return false;
 	}
 
 	/**
 	 * \detail
-	 * See Population::write for more information
+	 * The data is copied from the device holding the latest version without synchronizing
+	 * the host memory of this Population.
+	 */
+	void Population::snapshotColumn(int type, char* dest) const
+	{
+		switch(type)
+		{
+			case DATA_ORBIT:
+				data->data_orbit.snapshot(reinterpret_cast<Orbit*>(dest));
+				break;
+			case DATA_PROPERTIES:
+				data->data_properties.snapshot(reinterpret_cast<ObjectProperties*>(dest));
+				break;
+			case DATA_CARTESIAN:
+				data->data_position.snapshot(reinterpret_cast<Vector3*>(dest));
+				break;
+			case DATA_VELOCITY:
+				data->data_velocity.snapshot(reinterpret_cast<Vector3*>(dest));
+				break;
+			case DATA_ACCELERATION:
+				data->data_acceleration.snapshot(reinterpret_cast<Vector3*>(dest));
+				break;
+			case DATA_BYTES:
+				data->data_bytes.snapshot(dest);
+				break;
+			case DATA_EPOCH:
+				data->data_epoch.snapshot(reinterpret_cast<Epoch*>(dest));
+				break;
+		}
+	}
+
+	/**
+	 * \detail
+	 * See Population::write for more information. Files written by older versions of OPI
+	 * (file version 1) can be read as well.
 	 */
 	ErrorCode Population::read(const std::string& filename)
 	{
-        int number_of_objects = 0;
-        int magicNumber = 0;
-        int versionNumber = 0;
-        int propagatorNameLength = 0;
-        char* propagatorName;
+		PopulationFileReader in;
+		ErrorCode status = in.open(filename);
+		if(status == SUCCESS)
+		{
+			int number_of_objects = in.getSize();
+			resize(number_of_objects);
+			resizeByteArray(in.getByteArraySize());
+			data->lastPropagatorName = in.getPropagatorName();
+			status = readRange(in, 0, number_of_objects);
+			if(data->slotMap)
+				data->slots().revalidate();
+		}
+		data->host.sendError(status);
+		return status;
+	}
 
-        std::ifstream in(filename.c_str(), std::ifstream::binary);
-		if(in.is_open())
-        {
-            in.read(reinterpret_cast<char*>(&magicNumber), sizeof(int));
-            if (magicNumber == 47627)
-            {
-                in.read(reinterpret_cast<char*>(&versionNumber), sizeof(int));
-                if (versionNumber == 1)
-                {
-                    in.read(reinterpret_cast<char*>(&number_of_objects), sizeof(int));
-                    resize(number_of_objects);
-                    data->size = number_of_objects;
-                    in.read(reinterpret_cast<char*>(&propagatorNameLength), sizeof(int));
-                    in.read(reinterpret_cast<char*>(&propagatorName), propagatorNameLength*sizeof(char));
-                    data->lastPropagatorName = std::string(propagatorName);
-                    while(in.good())
-                    {
-                        int type;
-                        int size;
-                        in.read(reinterpret_cast<char*>(&type), sizeof(int));
-                        if(!in.eof())
-                        {
-                            in.read(reinterpret_cast<char*>(&size), sizeof(int));
-                            switch(type)
-                            {
-                            case DATA_ORBIT:
-                                if(size == sizeof(Orbit))
-                                {
-                                    Orbit* orbit = getOrbit(DEVICE_HOST, true);
-                                    in.read(reinterpret_cast<char*>(orbit), sizeof(Orbit) * number_of_objects);
-                                    data->data_orbit.update(DEVICE_HOST);
-                                    break;
-                                }
-                            case DATA_PROPERTIES:
-                                if(size == sizeof(ObjectProperties))
-                                {
-                                    ObjectProperties* prop = getObjectProperties(DEVICE_HOST, true);
-                                    in.read(reinterpret_cast<char*>(prop), sizeof(ObjectProperties) * number_of_objects);
-                                    data->data_properties.update(DEVICE_HOST);
-                                    break;
-                                }
-                            case DATA_CARTESIAN:
-                                if(size == sizeof(Vector3))
-                                {
-                                    Vector3* pos = getPosition(DEVICE_HOST, true);
-                                    in.read(reinterpret_cast<char*>(pos), sizeof(Vector3) * number_of_objects);
-                                    data->data_position.update(DEVICE_HOST);
-                                    break;
-                                }
-                            case DATA_VELOCITY:
-                                if(size == sizeof(Vector3))
-                                {
-                                    Vector3* vel = getVelocity(DEVICE_HOST, true);
-                                    in.read(reinterpret_cast<char*>(vel), sizeof(Vector3) * number_of_objects);
-                                    data->data_velocity.update(DEVICE_HOST);
-                                    break;
-                                }
-                            case DATA_ACCELERATION:
-                                if(size == sizeof(Vector3))
-                                {
-                                    Vector3* acc = getAcceleration(DEVICE_HOST, true);
-                                    in.read(reinterpret_cast<char*>(acc), sizeof(Vector3) * number_of_objects);
-                                    data->data_acceleration.update(DEVICE_HOST);
-                                    break;
-                                }
-                            case DATA_BYTES:
-                                if(size == size) //TODO
-                                {
-                                    resizeByteArray(size);
-                                    char* bytes = getBytes(DEVICE_HOST, true);
-                                    in.read(bytes, size * number_of_objects * sizeof(char));
-                                    data->data_bytes.update(DEVICE_HOST);
-                                    break;
-                                }
-                            default:
-                                std::cout << "Found unknown block id " << type << std::endl;
-                                in.seekg(number_of_objects * size);
-                            }
-                        }
-                    }
-                }
-                else std::cout << "Unknown file version" << std::endl;
-            }
-            else std::cout << filename << " does not appear to be an OPI population file." << std::endl;
+	/**
+	 * \detail
+	 * Reads the objects [first, first + getSize()) from an opened population file into this
+	 * Population. The Population must already have the correct size and byte array size.
+	 * Columns that are not present in the file are left untouched.
+	 */
+	ErrorCode Population::readRange(PopulationFileReader& in, int first, int count)
+	{
+		ErrorCode status = SUCCESS;
+		if(in.hasColumn(DATA_ORBIT))
+		{
+			status = in.readColumn(DATA_ORBIT, sizeof(Orbit), first, count, reinterpret_cast<char*>(getOrbit(DEVICE_HOST, true)));
+			data->data_orbit.update(DEVICE_HOST);
 		}
-		return SUCCESS;
+		if(status == SUCCESS && in.hasColumn(DATA_PROPERTIES))
+		{
+			status = in.readColumn(DATA_PROPERTIES, sizeof(ObjectProperties), first, count, reinterpret_cast<char*>(getObjectProperties(DEVICE_HOST, true)));
+			data->data_properties.update(DEVICE_HOST);
+			data->idIndexValid = false;
+		}
+		if(status == SUCCESS && in.hasColumn(DATA_CARTESIAN))
+		{
+			status = in.readColumn(DATA_CARTESIAN, sizeof(Vector3), first, count, reinterpret_cast<char*>(getPosition(DEVICE_HOST, true)));
+			data->data_position.update(DEVICE_HOST);
+		}
+		if(status == SUCCESS && in.hasColumn(DATA_VELOCITY))
+		{
+			status = in.readColumn(DATA_VELOCITY, sizeof(Vector3), first, count, reinterpret_cast<char*>(getVelocity(DEVICE_HOST, true)));
+			data->data_velocity.update(DEVICE_HOST);
+		}
+		if(status == SUCCESS && in.hasColumn(DATA_ACCELERATION))
+		{
+			status = in.readColumn(DATA_ACCELERATION, sizeof(Vector3), first, count, reinterpret_cast<char*>(getAcceleration(DEVICE_HOST, true)));
+			data->data_acceleration.update(DEVICE_HOST);
+		}
+		if(status == SUCCESS && in.hasColumn(DATA_BYTES))
+		{
+			status = in.readColumn(DATA_BYTES, data->byteArraySize, first, count, getBytes(DEVICE_HOST, true));
+			data->data_bytes.update(DEVICE_HOST);
+		}
+		if(status == SUCCESS && in.hasColumn(DATA_EPOCH))
+		{
+			status = in.readColumn(DATA_EPOCH, sizeof(Epoch), first, count, reinterpret_cast<char*>(getEpoch(DEVICE_HOST, true)));
+			data->data_epoch.update(DEVICE_HOST);
+		}
+		return status;
 	}
 
     void Population::resize(int size, int byteArraySize)
 	{
 		if(data->size != size)
 		{
+			if(data->slabEnabled && !reuseSlab(size, byteArraySize))
+				packSlab(size, byteArraySize);
 			data->data_orbit.resize(size);
 			data->data_properties.resize(size);
 			data->data_position.resize(size);
 			data->data_velocity.resize(size);
             data->data_acceleration.resize(size);
             data->data_bytes.resize(size*byteArraySize);
-            data->object_names.resize(size);
+            data->data_epoch.resize(size);
+            data->names().resize(size);
+            if(data->slotMap)
+                data->slots().resize(size);
 			data->size = size;
             data->byteArraySize = byteArraySize;
+			data->idIndexValid = false;
 		}
 	}
 
     void Population::resizeByteArray(int size)
     {
+        if(data->slabEnabled && size != data->byteArraySize)
+            packSlab(data->size, size);
         data->data_bytes.resize(data->size * size);
         data->byteArraySize = size;
     }
 
+    /**
+     * \detail
+     * Columns that share memory with a copy release it instead of duplicating it. Tombstones
+     * of the slot map are dropped, handles obtained before must not be used anymore.
+     */
+    void Population::clear()
+    {
+        data->data_orbit.clear();
+        data->data_properties.clear();
+        data->data_position.clear();
+        data->data_velocity.clear();
+        data->data_acceleration.clear();
+        data->data_bytes.clear();
+        data->data_epoch.clear();
+        data->names().clear();
+        if(data->slotMap)
+            data->slots().resize(0);
+        data->size = 0;
+        data->idIndexValid = false;
+    }
+
     std::string Population::getLastPropagatorName() const
     {
         return data->lastPropagatorName;
@@ -361,7 +633,7 @@ namespace OPI
     std::string Population::getObjectName(int index)
     {
         if (index < data->size)
-            return data->object_names[index];
+            return (*data->object_names)[index];
         else return "";
     }
 
@@ -369,7 +641,7 @@ namespace OPI
     {
         if (index < data->size)
         {
-            data->object_names[index] = name;
+            data->names()[index] = name;
         }
         else std::cout << "Cannot set object name: Index (" << index << ") out of range!" << std::endl;
     }
@@ -382,6 +654,8 @@ namespace OPI
 	 */
 	Orbit* Population::getOrbit(Device device, bool no_sync) const
 	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
 		return data->data_orbit.getData(device, no_sync);
 	}
 
@@ -392,6 +666,8 @@ namespace OPI
 	 */
 	ObjectProperties* Population::getObjectProperties(Device device, bool no_sync) const
 	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
 		return data->data_properties.getData(device, no_sync);
 	}
 
@@ -402,6 +678,8 @@ namespace OPI
 	 */
     Vector3* Population::getPosition(Device device, bool no_sync) const
 	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
 		return data->data_position.getData(device, no_sync);
 	}
 
@@ -412,6 +690,8 @@ namespace OPI
 	 */
 	Vector3* Population::getVelocity(Device device, bool no_sync) const
 	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
 		return data->data_velocity.getData(device, no_sync);
 	}
 
@@ -422,19 +702,42 @@ namespace OPI
 	 */
 	Vector3* Population::getAcceleration(Device device, bool no_sync) const
 	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
 		return data->data_acceleration.getData(device, no_sync);
     }
 
     char* Population::getBytes(Device device, bool no_sync) const
     {
+        if(data->slab)
+        	synchronizeSlab(device, !no_sync);
         return data->data_bytes.getData(device, no_sync);
     }
 
+	/**
+	 * @details
+	 * If no_sync is set to false, a synchronization is performed to ensure the latest up-to-date data on the
+	 * requested device.
+	 */
+	Epoch* Population::getEpoch(Device device, bool no_sync) const
+	{
+		if(data->slab)
+			synchronizeSlab(device, !no_sync);
+		return data->data_epoch.getData(device, no_sync);
+	}
+
 	void Population::remove(IndexList &list)
 	{
 		list.sort();
 		int* listdata = list.getData(DEVICE_HOST);
+		// with a slot map the indices of the other objects do not change
 		int offset = 0;
+		if(data->slotMap)
+		{
+			for(int i = 0; i < list.getSize(); ++i)
+				remove(listdata[i]);
+			return;
+		}
 		for(int i = 0; i < list.getSize(); ++i)
 		{
 			remove(listdata[i] - offset);
@@ -442,23 +745,14 @@ namespace OPI
 		}
 	}
 
-    void Population::insert(Population& source, IndexList& list)
+    /**
+     * \detail
+     * Only columns holding data in the source are copied, so columns that are not
+     * allocated in either Population stay unallocated.
+     */
+    void Population::insert(Population& source, IndexList& list, DataMask columns)
     {
-        int* listdata = list.getData(DEVICE_HOST);
-
-        Orbit* orbits = source.getOrbit(DEVICE_HOST, false);
-        ObjectProperties* props = source.getObjectProperties(DEVICE_HOST, false);
-        Vector3* pos = source.getPosition(DEVICE_HOST, false);
-        Vector3* vel = source.getVelocity(DEVICE_HOST, false);
-        Vector3* acc = source.getAcceleration(DEVICE_HOST, false);
-        char* bytes = source.getBytes(DEVICE_HOST, false);
-
-        Orbit* thisOrbit = getOrbit();
-        ObjectProperties* thisProps = getObjectProperties();
-        Vector3* thisPos = getPosition();
-        Vector3* thisVel = getVelocity();
-        Vector3* thisAcc = getAcceleration();
-        char* thisBytes = getBytes();
+        const int* listdata = list.getData(DEVICE_HOST);
 
         if (getByteArraySize() != source.getByteArraySize())
         {
@@ -467,51 +761,62 @@ namespace OPI
 
         if (list.getSize() >= source.getSize())
         {
-            for(int i = 0; i < list.getSize(); ++i)
+            for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
             {
-                int l = listdata[i];
-                if (l < getSize())
+                if(!(columns & (1 << type)) || !source.hasData(type)
+                    || (type == DATA_BYTES && getByteArraySize() != source.getByteArraySize()))
+                    continue;
+                const char* from = source.getColumnPointer(type);
+                char* to = getColumnPointer(type);
+                size_t entrySize = getColumnEntrySize(type);
+                for(int i = 0; i < source.getSize(); ++i)
                 {
-                    thisOrbit[l] = orbits[i];
-                    thisProps[l] = props[i];
-                    thisPos[l] = pos[i];
-                    thisVel[l] = vel[i];
-                    thisAcc[l] = acc[i];
-                    if (getByteArraySize() == source.getByteArraySize())
-                    {
-                        int b = getByteArraySize();
-                        for (int j=0; j<b; j++)
-                        {
-                            thisBytes[l*b+j] = bytes[i*b+j];
-                        }
-                    }
-                }
-                else {
-                    std::cout << "Cannot insert - index out of range: " << l << std::endl;
+                    int l = listdata[i];
+                    if (l >= 0 && l < getSize())
+                        memcpy(to + (size_t)l * entrySize, from + (size_t)i * entrySize, entrySize);
                 }
+                update(type);
+            }
+            for(int i = 0; i < source.getSize(); ++i)
+            {
+                if (listdata[i] < 0 || listdata[i] >= getSize())
+                    std::cout << "Cannot insert - index out of range: " << listdata[i] << std::endl;
             }
         }
         else {
             std::cout << "Cannot insert - not enough elements in index list!" << std::endl;
         }
-
-        update(DATA_ORBIT);
-        update(DATA_PROPERTIES);
-        update(DATA_CARTESIAN);
-        update(DATA_VELOCITY);
-        update(DATA_ACCELERATION);
-        update(DATA_BYTES);
     }
 
+	/**
+	 * \detail
+	 * With an enabled slot map, the object is only marked as removed and its data stays in
+	 * place until the next compaction.
+	 */
 	void Population::remove(int index)
 	{
+		if(data->slotMap)
+		{
+			if(index < 0 || index >= data->size || !data->slotMap->isValid(index))
+				return;
+			if(data->idIndexEnabled && data->idIndexValid && !data->idIndex.erase(getObjectProperties()[index].id, index))
+				data->idIndexValid = false;
+			SlotMap& slots = data->slots();
+			slots.setValid(index, false);
+			slots.generations[index]++;
+			slots.tombstones++;
+			return;
+		}
 		data->data_acceleration.remove(index);
 		data->data_orbit.remove(index);
 		data->data_position.remove(index);
 		data->data_properties.remove(index);
         data->data_velocity.remove(index);
         data->data_bytes.remove(index*data->byteArraySize, data->byteArraySize);
+		data->data_epoch.remove(index);
+		data->names().erase(data->names().begin() + index);
 		data->size--;
+		data->idIndexValid = false;
 	}
 
 	ErrorCode Population::update(int type, Device device)
@@ -524,6 +829,7 @@ namespace OPI
 				break;
 			case DATA_PROPERTIES:
 				data->data_properties.update(device);
+				data->idIndexValid = false;
 				break;
 			case DATA_VELOCITY:
 				data->data_velocity.update(device);
@@ -537,6 +843,9 @@ namespace OPI
             case DATA_BYTES:
                 data->data_bytes.update(device);
                 break;
+			case DATA_EPOCH:
+				data->data_epoch.update(device);
+				break;
 			default:
 				status = INVALID_TYPE;
 		}
@@ -544,6 +853,98 @@ namespace OPI
 		return status;
 	}
 
+	void Population::updateColumns(DataMask columns, Device device)
+	{
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(columns & (1 << type))
+				update(type, device);
+		}
+	}
+
+	/**
+	 * \detail
+	 * The slab is synchronized first so that the columns it holds are transferred in
+	 * batches, the per-column synchronization then only handles the remaining columns.
+	 */
+	void Population::prefetch(DataMask columns, Device device) const
+	{
+		// columns that were never allocated stay lazy
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(!hasData(type))
+				columns &= ~(1 << type);
+		}
+		if(data->slab)
+			synchronizeSlab(device, true, columns);
+		if(columns & MASK_ORBIT)
+			data->data_orbit.getData(device, false);
+		if(columns & MASK_PROPERTIES)
+			data->data_properties.getData(device, false);
+		if(columns & MASK_CARTESIAN)
+			data->data_position.getData(device, false);
+		if(columns & MASK_VELOCITY)
+			data->data_velocity.getData(device, false);
+		if(columns & MASK_ACCELERATION)
+			data->data_acceleration.getData(device, false);
+		if(columns & MASK_BYTES)
+			data->data_bytes.getData(device, false);
+		if(columns & MASK_EPOCH)
+			data->data_epoch.getData(device, false);
+	}
+
+	/**
+	 * \detail
+	 * The conversion is split into ranges of objects with parallelFor(), each range is
+	 * processed by the vectorized kernels. The state columns are fully overwritten, so
+	 * their outdated host data is not synchronized before.
+	 */
+	ErrorCode Population::computeCartesian(ReferenceFrame frame, double mu)
+	{
+		ErrorCode status = SUCCESS;
+		if(frame == REF_NONE || !(mu > 0.0))
+			status = INVALID_ARGUMENT;
+		else if(frame == REF_ITRF || frame == REF_ECEF)
+			status = NOT_IMPLEMENTED;
+		else if(!hasData(DATA_ORBIT))
+			status = INVALID_TYPE;
+		else {
+			const Orbit* orbits = getOrbit(DEVICE_HOST);
+			Vector3* position = getPosition(DEVICE_HOST, true);
+			Vector3* velocity = getVelocity(DEVICE_HOST, true);
+			parallelFor(0, data->size, 1 << 14, [orbits, position, velocity, mu](int begin, int end) {
+				convertElementsToState(orbits + begin, position + begin, velocity + begin, end - begin, mu);
+			});
+			updateColumns(MASK_CARTESIAN | MASK_VELOCITY, DEVICE_HOST);
+		}
+		data->host.sendError(status);
+		return status;
+	}
+
+	/**
+	 * \detail
+	 * The Orbit column is synchronized as well, since bol and eol are kept.
+	 */
+	ErrorCode Population::computeElements(double mu)
+	{
+		ErrorCode status = SUCCESS;
+		if(!(mu > 0.0))
+			status = INVALID_ARGUMENT;
+		else if(!hasData(DATA_CARTESIAN) || !hasData(DATA_VELOCITY))
+			status = INVALID_TYPE;
+		else {
+			const Vector3* position = getPosition(DEVICE_HOST);
+			const Vector3* velocity = getVelocity(DEVICE_HOST);
+			Orbit* orbits = getOrbit(DEVICE_HOST);
+			parallelFor(0, data->size, 1 << 14, [orbits, position, velocity, mu](int begin, int end) {
+				convertStateToElements(position + begin, velocity + begin, orbits + begin, end - begin, mu);
+			});
+			update(DATA_ORBIT, DEVICE_HOST);
+		}
+		data->host.sendError(status);
+		return status;
+	}
+
 	int Population::getSize() const
 	{
 		return data->size;
@@ -554,6 +955,578 @@ namespace OPI
         return data->byteArraySize;
     }
 
+	/**
+	 * \detail
+	 * Enabling slab allocation (again) packs all columns into a new block.
+	 */
+	void Population::setSlabAllocationEnabled(bool enabled)
+	{
+		data->slabEnabled = enabled;
+		if(enabled)
+			packSlab(data->size, data->byteArraySize);
+		else
+			data->slab.reset();
+	}
+
+	bool Population::isSlabAllocationEnabled() const
+	{
+		return data->slabEnabled;
+	}
+
+	/**
+	 * \detail
+	 * The columns are laid out in the order of DataType, each one starting at a multiple of
+	 * HOST_MEMORY_ALIGNMENT. Existing data is moved into the new block and device memory
+	 * is released; a device block is allocated on the first request for device data.
+	 */
+	void Population::packSlab(int size, int byteArraySize)
+	{
+		std::shared_ptr<ColumnSlab> slab = std::make_shared<ColumnSlab>();
+		int capacity[DATA_EPOCH + 1];
+		size_t offset = 0;
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			capacity[type] = (type == DATA_BYTES) ? size * byteArraySize : size;
+			offset = (offset + HOST_MEMORY_ALIGNMENT - 1) / HOST_MEMORY_ALIGNMENT * HOST_MEMORY_ALIGNMENT;
+			slab->offsets[type] = offset;
+			offset += capacity[type] * data->columns[type]->getEntrySize();
+		}
+		slab->bytes = std::max(offset, HOST_MEMORY_ALIGNMENT);
+		slab->host = allocateHostBlock(data->host.getHostAllocator(), slab->bytes);
+		slab->capacity = size;
+		slab->byteArraySize = byteArraySize;
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+			data->columns[type]->attachHost(slab->host, slab->offsets[type], capacity[type]);
+		data->slab = slab;
+	}
+
+	/**
+	 * \detail
+	 * A cleared Population is refilled in place if all columns still use the slab, so
+	 * clear() keeps the memory in slab mode as well.
+	 */
+	bool Population::reuseSlab(int size, int byteArraySize) const
+	{
+		if(data->size > 0 || !data->slab || size > data->slab->capacity || byteArraySize != data->slab->byteArraySize)
+			return false;
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(!data->columns[type]->ownsRegion(DEVICE_HOST, data->slab->host.get(), data->slab->offsets[type]))
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * \detail
+	 * Makes sure all columns use the block of the slab on the given device. If transfer is
+	 * set, all columns that are outdated on the device are copied with one transfer per run
+	 * of adjacent columns. Columns that are up to date on both sides may be part of a run,
+	 * all other columns (e.g. ones that are shared with a copy of this Population) are left
+	 * to the regular per-column synchronization. Only runs containing an outdated column
+	 * of the given mask are copied; other outdated columns are updated along if they are
+	 * part of such a run.
+	 */
+	void Population::synchronizeSlab(Device device, bool transfer, DataMask columns) const
+	{
+		ColumnSlab& slab = *data->slab;
+		GpuSupport* cuda = data->host.getGPUSupport();
+		if(!cuda)
+			return;
+		if(device != DEVICE_HOST)
+		{
+			if(device < DEVICE_CUDA || device > DEVICE_CUDA_LAST || device - DEVICE_CUDA >= cuda->getDeviceCount())
+				return;
+			std::shared_ptr<DeviceMemory>& block = slab.devices[device];
+			if(!block)
+				block = std::make_shared<DeviceMemory>(data->host, device, slab.bytes);
+			for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+				data->columns[type]->attachDevice(device, block, slab.offsets[type]);
+		}
+		if(!transfer)
+			return;
+
+		int oldDevice = cuda->getCurrentDevice();
+		for(std::map< Device, std::shared_ptr<DeviceMemory> >::iterator itr = slab.devices.begin(); itr != slab.devices.end(); ++itr)
+		{
+			// uploads go to the requested device, downloads may come from every device
+			if(device != DEVICE_HOST && itr->first != device)
+				continue;
+			Device source = (device == DEVICE_HOST) ? itr->first : DEVICE_HOST;
+			char* hostBlock = slab.host.get();
+			char* deviceBlock = static_cast<char*>(itr->second->ptr);
+			cuda->selectDevice(itr->first - DEVICE_CUDA);
+			int first = -1;
+			bool pending[DATA_EPOCH + 1];
+			for(int type = DATA_ORBIT; type <= DATA_EPOCH + 1; ++type)
+			{
+				bool usable = false;
+				if(type <= DATA_EPOCH)
+				{
+					SynchronizedStorage* column = data->columns[type];
+					bool owned = column->getSize() > 0
+						&& column->ownsRegion(DEVICE_HOST, hostBlock, slab.offsets[type])
+						&& column->ownsRegion(itr->first, deviceBlock, slab.offsets[type]);
+					pending[type] = owned && column->isCurrent(source) && !column->isCurrent(device);
+					usable = pending[type] || (owned && column->isCurrent(source) && column->isCurrent(device));
+				}
+				if(usable && first < 0)
+					first = type;
+				else if(!usable && first >= 0)
+				{
+					// copy the run [first, type) if it contains outdated columns
+					int last = type - 1;
+					bool needed = false;
+					for(int i = first; i <= last; ++i)
+						needed |= pending[i] && (columns & (1 << i));
+					if(needed)
+					{
+						size_t begin = slab.offsets[first];
+						size_t end = slab.offsets[last] + data->columns[last]->getSize() * data->columns[last]->getEntrySize();
+						if(device == DEVICE_HOST)
+							cuda->copy(hostBlock + begin, deviceBlock + begin, end - begin, false);
+						else
+							cuda->copy(deviceBlock + begin, hostBlock + begin, end - begin, true);
+						for(int i = first; i <= last; ++i)
+						{
+							if(pending[i])
+								data->columns[i]->setCurrent(device);
+						}
+					}
+					first = -1;
+				}
+			}
+		}
+		cuda->selectDevice(oldDevice);
+	}
+
+	/**
+	 * \detail
+	 * Disabling the slot map removes all tombstones without creating a remap table.
+	 */
+	void Population::setSlotMapEnabled(bool enabled)
+	{
+		if(enabled && !data->slotMap)
+		{
+			data->slotMap = std::make_shared<SlotMap>();
+			data->slotMap->resize(data->size);
+		}
+		else if(!enabled && data->slotMap)
+		{
+			IndexList remap(data->host);
+			compact(remap, true);
+			data->slotMap.reset();
+		}
+	}
+
+	bool Population::isSlotMapEnabled() const
+	{
+		return (bool)data->slotMap;
+	}
+
+	bool Population::isValid(int index) const
+	{
+		if(index < 0 || index >= data->size)
+			return false;
+		return !data->slotMap || data->slotMap->isValid(index);
+	}
+
+	ObjectHandle Population::getHandle(int index) const
+	{
+		if(!isValid(index))
+			return ObjectHandle(-1, 0);
+		return ObjectHandle(index, data->slotMap ? data->slotMap->generations[index] : 0);
+	}
+
+	int Population::resolve(const ObjectHandle& handle) const
+	{
+		if(!isValid(handle.index))
+			return -1;
+		int generation = data->slotMap ? data->slotMap->generations[handle.index] : 0;
+		return (generation == handle.generation) ? handle.index : -1;
+	}
+
+	int Population::getValidCount() const
+	{
+		return data->size - (data->slotMap ? data->slotMap->tombstones : 0);
+	}
+
+	float Population::getFragmentation() const
+	{
+		if(!data->slotMap || data->size == 0)
+			return 0.0f;
+		return (float)data->slotMap->tombstones / data->size;
+	}
+
+	void Population::setCompactionThreshold(float ratio)
+	{
+		data->compactionThreshold = ratio;
+	}
+
+	/**
+	 * \detail
+	 * The remaining objects keep their order. After compaction, all objects are valid again.
+	 */
+	bool Population::compact(IndexList& remap, bool force)
+	{
+		if(!data->slotMap || data->slotMap->tombstones == 0)
+			return false;
+		if(!force && getFragmentation() < data->compactionThreshold)
+			return false;
+		std::vector<int> newIndex(data->size);
+		int next = 0;
+		for(int i = 0; i < data->size; ++i)
+			newIndex[i] = data->slotMap->isValid(i) ? next++ : -1;
+		compact(newIndex, next);
+		remap.assign(newIndex.data(), newIndex.size());
+		return true;
+	}
+
+	void Population::getValidIndices(IndexList& list) const
+	{
+		std::vector<int> indices;
+		indices.reserve(getValidCount());
+		for(int i = 0; i < data->size; ++i)
+		{
+			if(isValid(i))
+				indices.push_back(i);
+		}
+		list.assign(indices.data(), indices.size());
+	}
+
+	/**
+	 * \detail
+	 * While the index is disabled, findById performs a linear search and findByIds builds a
+	 * temporary index for every call.
+	 */
+	void Population::setIdIndexEnabled(bool enabled)
+	{
+		data->idIndexEnabled = enabled;
+		if(!enabled)
+		{
+			data->idIndex.clear();
+			data->idIndexValid = false;
+		}
+	}
+
+	bool Population::isIdIndexEnabled() const
+	{
+		return data->idIndexEnabled;
+	}
+
+	/**
+	 * \detail
+	 * The objects of the update are matched to the objects of this Population by their
+	 * ObjectProperties::id using the id index (or a temporary one if the index is disabled).
+	 * Matched objects are compared column by column and only overwritten if they differ. With
+	 * MERGE_REPLACE, all objects that are not part of the update are removed in a single
+	 * compaction pass that keeps the order of the remaining objects. New objects are appended
+	 * at the end with a single resize. Only columns that hold data in the update are copied,
+	 * appended objects are set to zero in the remaining columns. Names are copied if they are
+	 * not empty in the update.
+	 *
+	 * The touched ranges contain every object whose data or index has changed: overwritten
+	 * objects, all objects behind the first removed one and the appended objects.
+	 */
+	ErrorCode Population::merge(const Population& update, MergePolicy policy, std::vector<IndexRange>* touched)
+	{
+		ErrorCode status = SUCCESS;
+		if(&update == this || (update.getSize() > 0 && !update.hasData(DATA_PROPERTIES)))
+			status = INVALID_ARGUMENT;
+		else if(update.hasData(DATA_BYTES) && update.getByteArraySize() != data->byteArraySize)
+			status = INCOMPATIBLE_TYPES;
+		if(touched)
+			touched->clear();
+		if(status != SUCCESS)
+		{
+			data->host.sendError(status);
+			return status;
+		}
+
+		bool columns[DATA_EPOCH + 1];
+		bool modified[DATA_EPOCH + 1];
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			columns[type] = update.hasData(type);
+			modified[type] = false;
+		}
+		const int updateSize = update.getSize();
+		const int byteArraySize = data->byteArraySize;
+		const std::vector<std::string>& names = *update.data->object_names;
+
+		// overwrite existing objects
+		IdIndex temporary;
+		const IdIndex& index = getIdIndex(temporary);
+		int oldSize = data->size;
+		std::vector<char> changed(oldSize, 0);
+		std::vector<char> present(oldSize, 0);
+		std::vector<int> appended;
+		{
+			const Orbit* sourceOrbit = columns[DATA_ORBIT] ? update.getOrbit() : 0;
+			const ObjectProperties* sourceProperties = update.getObjectProperties();
+			const Vector3* sourcePosition = columns[DATA_CARTESIAN] ? update.getPosition() : 0;
+			const Vector3* sourceVelocity = columns[DATA_VELOCITY] ? update.getVelocity() : 0;
+			const Vector3* sourceAcceleration = columns[DATA_ACCELERATION] ? update.getAcceleration() : 0;
+			const char* sourceBytes = columns[DATA_BYTES] ? update.getBytes() : 0;
+			const Epoch* sourceEpoch = columns[DATA_EPOCH] ? update.getEpoch() : 0;
+			Orbit* orbit = columns[DATA_ORBIT] ? getOrbit() : 0;
+			ObjectProperties* properties = getObjectProperties();
+			Vector3* position = columns[DATA_CARTESIAN] ? getPosition() : 0;
+			Vector3* velocity = columns[DATA_VELOCITY] ? getVelocity() : 0;
+			Vector3* acceleration = columns[DATA_ACCELERATION] ? getAcceleration() : 0;
+			char* bytes = columns[DATA_BYTES] ? getBytes() : 0;
+			Epoch* epoch = columns[DATA_EPOCH] ? getEpoch() : 0;
+
+			for(int j = 0; j < updateSize; ++j)
+			{
+				int i = index.find(sourceProperties[j].id);
+				if(i < 0)
+				{
+					if(policy != MERGE_UPDATE)
+						appended.push_back(j);
+					continue;
+				}
+				present[i] = 1;
+				bool result = assignIfChanged(properties[i], sourceProperties[j]);
+				modified[DATA_PROPERTIES] |= result;
+				if(orbit && assignIfChanged(orbit[i], sourceOrbit[j]))
+					result = modified[DATA_ORBIT] = true;
+				if(position && assignIfChanged(position[i], sourcePosition[j]))
+					result = modified[DATA_CARTESIAN] = true;
+				if(velocity && assignIfChanged(velocity[i], sourceVelocity[j]))
+					result = modified[DATA_VELOCITY] = true;
+				if(acceleration && assignIfChanged(acceleration[i], sourceAcceleration[j]))
+					result = modified[DATA_ACCELERATION] = true;
+				if(epoch && assignIfChanged(epoch[i], sourceEpoch[j]))
+					result = modified[DATA_EPOCH] = true;
+				if(bytes && memcmp(bytes + (size_t)i * byteArraySize, sourceBytes + (size_t)j * byteArraySize, byteArraySize) != 0)
+				{
+					memcpy(bytes + (size_t)i * byteArraySize, sourceBytes + (size_t)j * byteArraySize, byteArraySize);
+					result = modified[DATA_BYTES] = true;
+				}
+				if(!names[j].empty())
+					data->names()[i] = names[j];
+				if(result)
+					changed[i] = 1;
+			}
+		}
+
+		// remove missing objects
+		int firstMoved = oldSize;
+		if(policy == MERGE_REPLACE)
+		{
+			std::vector<int> newIndex(oldSize);
+			int next = 0;
+			for(int i = 0; i < oldSize; ++i)
+			{
+				newIndex[i] = present[i] ? next++ : -1;
+				if(!present[i] && firstMoved == oldSize)
+					firstMoved = i;
+			}
+			if(next < oldSize)
+			{
+				compact(newIndex, next);
+				compactColumn(changed.data(), newIndex);
+				changed.resize(next);
+			}
+		}
+
+		// append new objects
+		int firstAppended = data->size;
+		if(!appended.empty())
+		{
+			int count = appended.size();
+			resize(firstAppended + count, byteArraySize);
+			for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+			{
+				if(!columns[type] && !hasData(type))
+					continue;
+				modified[type] = true;
+				char* dest = getColumnPointer(type);
+				size_t entrySize = getColumnEntrySize(type);
+				const char* source = update.getColumnPointer(type);
+				for(int k = 0; k < count; ++k)
+				{
+					char* entry = dest + (size_t)(firstAppended + k) * entrySize;
+					if(columns[type])
+						memcpy(entry, source + (size_t)appended[k] * entrySize, entrySize);
+					else
+						memset(entry, 0, entrySize);
+				}
+			}
+			for(int k = 0; k < count; ++k)
+				data->names()[firstAppended + k] = names[appended[k]];
+		}
+
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(modified[type])
+				this->update(type);
+		}
+
+		if(touched)
+		{
+			int tail = std::min(firstMoved, firstAppended);
+			for(int i = 0; i < data->size; ++i)
+			{
+				if(i < tail && !changed[i])
+					continue;
+				if(!touched->empty() && touched->back().first + touched->back().count == i)
+					touched->back().count++;
+				else
+					touched->push_back(IndexRange(i, 1));
+			}
+		}
+		return SUCCESS;
+	}
+
+	/**
+	 * \detail
+	 * All columns holding data are synchronized to the host and compacted there.
+	 */
+	void Population::compact(const std::vector<int>& newIndex, int newSize)
+	{
+		if(data->data_orbit.hasData())
+			compactColumn(getOrbit(), newIndex);
+		if(data->data_properties.hasData())
+			compactColumn(getObjectProperties(), newIndex);
+		if(data->data_position.hasData())
+			compactColumn(getPosition(), newIndex);
+		if(data->data_velocity.hasData())
+			compactColumn(getVelocity(), newIndex);
+		if(data->data_acceleration.hasData())
+			compactColumn(getAcceleration(), newIndex);
+		if(data->data_bytes.hasData())
+			compactColumn(getBytes(), newIndex, data->byteArraySize);
+		if(data->data_epoch.hasData())
+			compactColumn(getEpoch(), newIndex);
+		compactColumn(data->names().data(), newIndex);
+		if(data->slotMap)
+		{
+			// moved objects get a new generation, so all existing handles become invalid
+			SlotMap& slots = data->slots();
+			compactColumn(slots.generations.data(), newIndex);
+			slots.generations.resize(newSize);
+			slots.valid.assign((newSize + 63) / 64, 0);
+			slots.revalidate();
+		}
+		resize(newSize, data->byteArraySize);
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			if(hasData(type))
+				update(type);
+		}
+	}
+
+	char* Population::getColumnPointer(int type) const
+	{
+		switch(type)
+		{
+			case DATA_ORBIT:
+				return reinterpret_cast<char*>(getOrbit());
+			case DATA_PROPERTIES:
+				return reinterpret_cast<char*>(getObjectProperties());
+			case DATA_CARTESIAN:
+				return reinterpret_cast<char*>(getPosition());
+			case DATA_VELOCITY:
+				return reinterpret_cast<char*>(getVelocity());
+			case DATA_ACCELERATION:
+				return reinterpret_cast<char*>(getAcceleration());
+			case DATA_BYTES:
+				return getBytes();
+			case DATA_EPOCH:
+				return reinterpret_cast<char*>(getEpoch());
+		}
+		return 0;
+	}
+
+	int Population::getColumnEntrySize(int type) const
+	{
+		switch(type)
+		{
+			case DATA_ORBIT:
+				return sizeof(Orbit);
+			case DATA_PROPERTIES:
+				return sizeof(ObjectProperties);
+			case DATA_CARTESIAN:
+			case DATA_VELOCITY:
+			case DATA_ACCELERATION:
+				return sizeof(Vector3);
+			case DATA_BYTES:
+				return data->byteArraySize;
+			case DATA_EPOCH:
+				return sizeof(Epoch);
+		}
+		return 0;
+	}
+
+	int Population::findById(int id) const
+	{
+		if(data->idIndexEnabled)
+		{
+			IdIndex unused;
+			return getIdIndex(unused).find(id);
+		}
+		ObjectProperties* properties = getObjectProperties();
+		for(int i = 0; i < data->size; ++i)
+		{
+			if(properties[i].id == id && isValid(i))
+				return i;
+		}
+		return -1;
+	}
+
+	/**
+	 * \detail
+	 * Large batches are looked up on multiple threads.
+	 */
+	int Population::findByIds(const int* ids, int count, IndexList& result) const
+	{
+		IdIndex temporary;
+		const IdIndex& index = getIdIndex(temporary);
+
+		result.update(DEVICE_HOST, count);
+		int* indices = result.getData(DEVICE_HOST, true);
+		std::atomic<int> found(0);
+		parallelFor(0, count, 1 << 16, [&index, ids, indices, &found](int begin, int end) {
+			int hits = 0;
+			for(int i = begin; i < end; ++i)
+			{
+				indices[i] = index.find(ids[i]);
+				if(indices[i] >= 0) hits++;
+			}
+			found += hits;
+		});
+		result.update(DEVICE_HOST, count);
+		return found;
+	}
+
+	/**
+	 * \detail
+	 * If the id index is disabled, the temporary index is built and returned instead.
+	 * The shared index is rebuilt under a mutex, so concurrent lookups on a const
+	 * Population build it only once and never see a partially built table.
+	 */
+	const IdIndex& Population::getIdIndex(IdIndex& temporary) const
+	{
+		const unsigned long long* valid = data->slotMap ? data->slotMap->valid.data() : 0;
+		if(!data->idIndexEnabled)
+		{
+			temporary.build(getObjectProperties(), data->size, valid);
+			return temporary;
+		}
+		if(!data->idIndexValid.load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> lock(data->idIndexMutex);
+			if(!data->idIndexValid.load(std::memory_order_relaxed))
+			{
+				data->idIndex.build(getObjectProperties(), data->size, valid);
+				data->idIndexValid.store(true, std::memory_order_release);
+			}
+		}
+		return data->idIndex;
+	}
+
     Host& Population::getHostPointer() const
     {
         return data->host;
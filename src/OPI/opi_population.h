@@ -19,8 +19,10 @@
 #include "opi_common.h"
 #include "opi_error.h"
 #include "opi_datatypes.h"
+#include "opi_orbit_math.h"
 #include "opi_pimpl_helper.h"
 #include <string>
+#include <vector>
 namespace OPI
 {
 	class ObjectRawData;
@@ -29,6 +31,11 @@ namespace OPI
 	class Vector3;
 	class IndexPair;
 	class IndexList;
+	class PopulationFileReader;
+	class PopulationFileWriter;
+	class PopulationCheckpoint;
+	struct ColumnCompression;
+	class IdIndex;
 
 	/*! \brief This class contains all parameters required for processing orbital objects.
 	 * \ingroup CPP_API_GROUP
@@ -52,11 +59,12 @@ namespace OPI
             /**
              * @brief Population Copy constructor
              *
-             * This function creates a deep copy of a Population on the host. Device data
-             * will be downloaded as part of this operation. The copy does not contain any
-             * device data so synchronization will happen again in the other direction as soon
-             * as the copy is requested on the device. This function may therefore impact
-             * the performance of CUDA/OpenCL propagators when used in every propagation step.
+             * The copy shares the data of the source on the host and on all devices, so
+             * no data is copied or downloaded when the copy is created. A column is
+             * duplicated (separately for the host and each device) as soon as either
+             * Population requests a pointer to it, so columns that are never accessed
+             * are never copied. Pointers retrieved from the source before the copy was
+             * created must not be used to modify the source afterwards.
              *
              * @param source The Population to be copied from.
              */
@@ -73,8 +81,39 @@ namespace OPI
              * @param source The Population to be copied from.
              * @param list An IndexList containing the indices of the elements of the source
              * Population that should be copied.
+             * @param columns The columns to copy (see DataMask). Columns without data in the
+             * source are never copied.
              */
-            Population(const Population& source, IndexList &list);
+            Population(const Population& source, IndexList &list, DataMask columns = MASK_ALL);
+
+            /**
+             * @brief Population Move constructor
+             *
+             * Takes over the data of the source without copying or allocating anything. The
+             * source may only be destroyed or assigned to afterwards.
+             *
+             * @param source The Population to be moved from.
+             */
+            Population(Population&& source);
+
+            /**
+             * @brief operator= Replaces the content with a copy of another Population.
+             *
+             * Like the copy constructor, the data is shared until either Population accesses it.
+             */
+            Population& operator=(const Population& source);
+
+            /**
+             * @brief operator= Exchanges the data with another Population.
+             *
+             * The former data of this Population is released when the source is destroyed.
+             */
+            Population& operator=(Population&& source);
+
+            /**
+             * @brief swap Exchanges the data (including the host) with another Population in O(1).
+             */
+            void swap(Population& other);
 
             /**
              * @brief Destructor. Cleans up host and device memory.
@@ -100,6 +139,16 @@ namespace OPI
              */
             void resizeByteArray(int size);
 
+            /**
+             * @brief clear Removes all objects but keeps the allocated memory.
+             *
+             * The host and device memory of all columns is kept, so the Population can be
+             * refilled with up to the previous number of objects without allocating memory.
+             * The per-object size of the byte array is kept as well. With slab allocation, the
+             * slab is reused unless a column was shared with a copy or the byte array size changes.
+             */
+            void clear();
+
             /**
              * @brief getSize Returns the number of elements in the Population.
              * @return Number of elements.
@@ -114,6 +163,18 @@ namespace OPI
              */
             int getByteArraySize() const;
 
+            /**
+             * @brief hasData Checks if memory has been allocated for a column.
+             *
+             * Columns are allocated on the host or a device when a pointer to them is
+             * requested for the first time (or when they are read from a file), so columns
+             * that are never used by any plugin take no memory. Copies, write() and merge()
+             * skip columns without data. With slab allocation, all columns are allocated.
+             * @param type The column (see DataType).
+             * @return True if the column is allocated on the host or any device.
+             */
+            bool hasData(int type) const;
+
             /**
              * @brief getLastPropagatorName Returns the name of the last plugin the Population
              * was propagated with.
@@ -158,22 +219,247 @@ namespace OPI
              * exceed the size of this population.
              * @param source The Population from which the elements are copied.
              * @param list A list of indices into the destination Population.
+             * @param columns The columns to copy (see DataMask).
              */
-            void insert(Population& source, IndexList& list);
+            void insert(Population& source, IndexList& list, DataMask columns = MASK_ALL);
 
 			//! Removes an object
 			void remove(int index);
 			//! Removes a number of objects
 			void remove(IndexList& list);
 
+            /**
+             * @brief setSlabAllocationEnabled Stores all columns in a single memory block.
+             *
+             * While enabled, all columns share one aligned host allocation and one allocation
+             * per device, so resizing the Population allocates memory only once. When the data
+             * of one column is requested on a device (or on the host), all other columns that
+             * are outdated there are transferred as well, with one copy per run of adjacent
+             * columns instead of one copy per column. This reduces the call overhead for small
+             * and medium-sized Populations. All columns are allocated while enabled, even ones
+             * that are never used. Columns that are modified while they are shared with a copy
+             * of the Population move out of the block until it is resized or this function is
+             * called again. Slab allocation is disabled by default.
+             * @param enabled Set to true to enable slab allocation.
+             */
+            void setSlabAllocationEnabled(bool enabled = true);
+
+            /**
+             * @brief isSlabAllocationEnabled Checks if slab allocation is enabled.
+             * @return true if slab allocation is enabled.
+             */
+            bool isSlabAllocationEnabled() const;
+
+            /**
+             * @brief setSlotMapEnabled Enables or disables stable object indices.
+             *
+             * While the slot map is enabled, remove() does not move any data. Removed objects
+             * become tombstones that keep their slot (and are still processed by propagators)
+             * until compact() is called, so indices, IndexLists and ObjectHandles stay valid in
+             * the meantime and removing an object is O(1). Use isValid() or getValidIndices()
+             * to skip tombstones. Disabling the slot map removes all tombstones. The slot map
+             * is disabled by default.
+             * @param enabled Set to true to enable the slot map.
+             */
+            void setSlotMapEnabled(bool enabled = true);
+
+            /**
+             * @brief isSlotMapEnabled Checks if the slot map is enabled.
+             * @return true if the slot map is enabled.
+             */
+            bool isSlotMapEnabled() const;
+
+            /**
+             * @brief isValid Checks if an index refers to an object that has not been removed.
+             * @param index The index to check.
+             * @return true if the index is in range and the object is not a tombstone.
+             */
+            bool isValid(int index) const;
+
+            /**
+             * @brief getHandle Returns a handle to an object.
+             *
+             * Handles detect removed objects: if the object is removed, the handle no longer
+             * resolves. Handles are invalidated by compaction and reading a file.
+             * @param index The index of the object.
+             * @return The handle, or a handle with index -1 if the index is not valid.
+             */
+            ObjectHandle getHandle(int index) const;
+
+            /**
+             * @brief resolve Returns the current index of the object a handle refers to.
+             * @param handle A handle returned by getHandle().
+             * @return The index of the object, or -1 if the object has been removed or moved.
+             */
+            int resolve(const ObjectHandle& handle) const;
+
+            /**
+             * @brief getValidCount Returns the number of objects that are not tombstones.
+             * @return The number of valid objects.
+             */
+            int getValidCount() const;
+
+            /**
+             * @brief getFragmentation Returns the fraction of slots occupied by tombstones.
+             * @return A value between 0 and 1.
+             */
+            float getFragmentation() const;
+
+            /**
+             * @brief setCompactionThreshold Sets the fragmentation at which compact() removes tombstones.
+             * @param ratio The fraction of tombstones, defaults to 0.25.
+             */
+            void setCompactionThreshold(float ratio);
+
+            /**
+             * @brief compact Removes all tombstones if the fragmentation exceeds the threshold.
+             *
+             * The remaining objects keep their order and are moved to the front. The remap
+             * table contains the new index of every old slot, or -1 for removed objects, and
+             * can be applied to IndexLists and IndexPairLists with their remap() functions.
+             * All handles are invalidated.
+             * @param remap Receives the remap table if the Population was compacted.
+             * @param force Compact even if the fragmentation is below the threshold.
+             * @return true if the Population was compacted.
+             */
+            bool compact(IndexList& remap, bool force = false);
+
+            /**
+             * @brief getValidIndices Returns the indices of all valid objects.
+             * @param list Receives the indices in ascending order.
+             */
+            void getValidIndices(IndexList& list) const;
+
 			//! Stores the Object Data to disk
 			void write(const std::string& filename);
+
+            /**
+             * @brief checkpoint Stores the Population to disk in the background.
+             *
+             * All columns are copied into staging buffers owned by the given handle before
+             * this function returns, so the Population can be modified or propagated while
+             * the file is written. Data residing on a device is copied to the staging buffers
+             * directly without synchronizing the host memory of the Population. The file is
+             * written with parallel positional writes on background threads; use the handle
+             * to check for completion. A handle can only run one checkpoint at a time, starting
+             * a new one waits for the previous checkpoint of the same handle to finish.
+             * @param filename The file to write.
+             * @param handle The handle that owns the staging buffers and tracks completion.
+             * @param policy Defines if the file is flushed to the storage device after writing.
+             * @return OPI::SUCCESS if the checkpoint was started, or an error code otherwise.
+             */
+            ErrorCode checkpoint(const std::string& filename, PopulationCheckpoint& handle, FileSyncPolicy policy = FILE_SYNC_NONE);
 			//! Loads the Object Data from disk
 			ErrorCode read(const std::string& filename);
 
+            /**
+             * @brief importTLE Reads a catalog of two-line element sets.
+             *
+             * The Population is resized to the number of element sets in the file. Each set
+             * may be preceded by a name line (with or without the "0 " prefix of the three-line
+             * format). The mean elements are converted to an Orbit in kilometers and radians,
+             * with the semi-major axis derived from the mean motion using the WGS-72
+             * gravitational parameter. The catalog number is stored as the object id (alpha-5
+             * numbers are decoded), the element set epoch as Julian date in both epochs and
+             * B* as area to mass ratio assuming a drag coefficient of 2.2, so that
+             * B* = area_to_mass * drag_coefficient * 0.15696615 / 2. Other columns are not
+             * modified. The file is memory-mapped and parsed on multiple threads.
+             * @param filename The TLE file to read.
+             * @return OPI::SUCCESS, or an error code if the file cannot be read or contains
+             * malformed element sets.
+             */
+            ErrorCode importTLE(const std::string& filename);
+
+            /**
+             * @brief importCSV Reads a catalog of objects from a CSV file.
+             *
+             * The Population is resized to the number of records in the file. The first line
+             * must contain the column names, which are matched to the members of Orbit,
+             * ObjectProperties and Epoch, to x, y, z (position), vx, vy, vz (velocity), epoch
+             * (sets both epochs) and name. Unknown columns are ignored and values are stored
+             * without unit conversion. Only columns that appear in the file are modified, fields
+             * that are empty are set to zero. The file is memory-mapped and parsed on multiple
+             * threads.
+             * @param filename The CSV file to read.
+             * @return OPI::SUCCESS, or an error code if the file cannot be read or contains
+             * malformed records.
+             */
+            ErrorCode importCSV(const std::string& filename);
+
+            /**
+             * @brief setCompression Selects how a column is compressed when it is written to disk.
+             *
+             * The setting applies to write(), checkpoint() and PopulationStreamWriter; read()
+             * detects compressed data automatically. Compressed columns are byte-shuffled (so that
+             * equal high-order bytes of neighbouring objects are stored next to each other) and
+             * compressed with a fast LZ codec. COMPRESSION_LOSSY additionally rounds all floating
+             * point values of the column to the given number of mantissa bits before compressing.
+             * The object id and the byte array are always stored losslessly. Blocks that do not get
+             * smaller are stored uncompressed.
+             * @param type The column to configure.
+             * @param mode The compression mode. All columns default to COMPRESSION_NONE.
+             * @param mantissaBits Number of mantissa bits (0-52) kept by lossy compression.
+             * @return OPI::SUCCESS, or an error code if type or mantissaBits are out of range.
+             */
+            ErrorCode setCompression(DataType type, CompressionMode mode, int mantissaBits = 52);
+
+            /**
+             * @brief getCompression Returns the compression mode of a column.
+             * @param type The column to query.
+             * @return The compression mode set with setCompression().
+             */
+            CompressionMode getCompression(DataType type) const;
+
 			//! Notify about updates on the specified device
 			ErrorCode update(int type, Device device = DEVICE_HOST);
 
+            /**
+             * @brief updateColumns Notifies about updates of several columns on the specified device.
+             * @param columns The updated columns (see DataMask).
+             * @param device The device holding the updated data.
+             */
+            void updateColumns(DataMask columns, Device device = DEVICE_HOST);
+
+            /**
+             * @brief prefetch Synchronizes several columns to a device at once.
+             *
+             * With slab allocation, outdated adjacent columns are transferred together.
+             * Columns that are not allocated yet are skipped, so a mask of declared inputs
+             * does not allocate columns the Population does not hold.
+             * @param columns The columns to synchronize (see DataMask).
+             * @param device The device that should hold the latest data afterwards.
+             */
+            void prefetch(DataMask columns, Device device = DEVICE_HOST) const;
+
+            /**
+             * @brief computeCartesian Calculates position and velocity from the orbital elements.
+             *
+             * The osculating elements of the Orbit column are converted to the position and
+             * velocity columns of all objects, in parallel with vectorized kernels (see
+             * opi_orbit_math.h). The state is given in the inertial frame the elements refer
+             * to; frame only states which frame that is. Earth-fixed frames require a rotation
+             * that depends on the epoch and are not supported. Orbits are synchronized to the
+             * host first and both state columns are marked as updated on the host.
+             * @param frame The inertial reference frame of the elements.
+             * @param mu Gravitational parameter of the central body in km^3/s^2.
+             * @return OPI::SUCCESS, INVALID_TYPE if the Population holds no orbits,
+             * NOT_IMPLEMENTED for Earth-fixed frames or INVALID_ARGUMENT for REF_NONE and mu <= 0.
+             */
+            ErrorCode computeCartesian(ReferenceFrame frame = REF_UNSPECIFIED, double mu = EARTH_MU);
+
+            /**
+             * @brief computeElements Calculates the orbital elements from position and velocity.
+             *
+             * The counterpart of computeCartesian(): the position and velocity columns are
+             * converted to osculating elements, which replace semi_major_axis, eccentricity,
+             * inclination, raan, arg_of_perigee and mean_anomaly of the Orbit column. bol and
+             * eol are kept. Only elliptic orbits are supported, other states yield NaN.
+             * @param mu Gravitational parameter of the central body in km^3/s^2.
+             * @return OPI::SUCCESS, INVALID_TYPE if the Population holds no position or
+             * velocity, or INVALID_ARGUMENT for mu <= 0.
+             */
+            ErrorCode computeElements(double mu = EARTH_MU);
+
 			//! Retrieve the orbital parameters on the specified device
 			Orbit* getOrbit(Device device = DEVICE_HOST, bool no_sync = false) const;
 			//! Retrieve the object properties on the specified device
@@ -186,6 +472,68 @@ namespace OPI
             Vector3* getAcceleration(Device device = DEVICE_HOST, bool no_sync = false) const;
             //! Retrieve the arbitrary binary information on the specified device
             char* getBytes(Device device = DEVICE_HOST, bool no_sync = false) const;
+			//! Retrieve the epochs of the objects' states on the specified device
+			Epoch* getEpoch(Device device = DEVICE_HOST, bool no_sync = false) const;
+
+            /**
+             * @brief merge Merges a newer snapshot of the catalog into this Population.
+             *
+             * Objects are matched by ObjectProperties::id. Matching objects are overwritten in
+             * place if their data differs, so unchanged objects keep their index and data.
+             * Depending on the policy, objects that only exist in the update are appended and
+             * objects that do not exist in the update are removed. Only columns holding data in
+             * the update are merged. The byte array sizes of both Populations must match if the
+             * update contains byte array data.
+             * @param update The Population containing the new data. It must hold object properties.
+             * @param policy MERGE_UPDATE only overwrites existing objects, MERGE_UPSERT also
+             * appends new objects and MERGE_REPLACE additionally removes missing objects.
+             * @param touched If not null, receives the sorted ranges of objects whose data or
+             * index has changed, e.g. for partial uploads of device data.
+             * @return OPI::SUCCESS, or an error code if the Populations are incompatible.
+             */
+            ErrorCode merge(const Population& update, MergePolicy policy = MERGE_UPSERT, std::vector<IndexRange>* touched = 0);
+
+            /**
+             * @brief setIdIndexEnabled Enables or disables the hash index from object ids to indices.
+             *
+             * While enabled, the Population keeps a hash table that maps ObjectProperties::id to
+             * the index of the object. The table is rebuilt in one pass on the first lookup after
+             * the ids or indices have changed, i.e. after update(DATA_PROPERTIES), resize(),
+             * insert(), remove() or reading from a file. The index is disabled by default.
+             * findById() and findByIds() may be called from several threads at once.
+             * @param enabled Set to true to enable the index, false to release it.
+             */
+            void setIdIndexEnabled(bool enabled = true);
+
+            /**
+             * @brief isIdIndexEnabled Checks if the id index is enabled.
+             * @return true if the id index is enabled.
+             */
+            bool isIdIndexEnabled() const;
+
+            /**
+             * @brief findById Returns the index of the object with the given id.
+             *
+             * Uses the id index if it is enabled and a linear search otherwise. The object
+             * properties are synchronized to the host if necessary. If several objects share
+             * the same id, the one with the lowest index is returned.
+             * @param id The object id (ObjectProperties::id) to look up.
+             * @return The index of the object, or -1 if no object has the given id.
+             */
+            int findById(int id) const;
+
+            /**
+             * @brief findByIds Looks up the indices of a number of objects.
+             *
+             * After the call, the list contains one entry per id holding the index of the
+             * object with that id, or -1 if the id does not exist. If the id index is disabled,
+             * a temporary index is built for this call.
+             * @param ids Pointer to count object ids.
+             * @param count Number of ids to look up.
+             * @param result The IndexList that receives the indices.
+             * @return The number of ids that were found.
+             */
+            int findByIds(const int* ids, int count, IndexList& result) const;
 
             /**
              * @brief sanityCheck Performs various checks on the Population data and generate a debug string.
@@ -206,6 +554,32 @@ namespace OPI
             Host& getHostPointer() const;
 
 		private:
+			friend class PopulationStreamReaderImpl;
+			friend class PopulationStreamWriter;
+			friend class PopulationCheckpoint;
+			//! Reads a range of objects from an opened population file
+			ErrorCode readRange(PopulationFileReader& in, int first, int count);
+			//! Queues all objects for writing to an opened population file, starting at object index first
+			void writeRange(PopulationFileWriter& out, int first);
+			//! Copies the latest data of a column to dest
+			void snapshotColumn(int type, char* dest) const;
+			//! Returns the compression settings of a column for the file writer
+			ColumnCompression getColumnCompression(int type) const;
+			//! Returns the id index, rebuilding it if necessary
+			const IdIndex& getIdIndex(IdIndex& temporary) const;
+			//! Moves object i to newIndex[i] (or drops it if negative) and shrinks to newSize
+			void compact(const std::vector<int>& newIndex, int newSize);
+			//! Returns the host pointer of a column
+			char* getColumnPointer(int type) const;
+			//! Returns the size of one entry of a column in bytes
+			int getColumnEntrySize(int type) const;
+			//! Moves all columns into a new memory block for size objects
+			void packSlab(int size, int byteArraySize);
+			//! Checks if a cleared Population can be refilled with size objects in the current slab
+			bool reuseSlab(int size, int byteArraySize) const;
+			//! Prepares the slab for access on a device and batches outdated columns into few transfers
+			void synchronizeSlab(Device device, bool transfer, DataMask columns = MASK_ALL) const;
+
 			//! Private implementation data
             Pimpl<ObjectRawData> data;
     };
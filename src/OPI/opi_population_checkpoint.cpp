@@ -0,0 +1,130 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_population_checkpoint.h"
+#include "opi_population.h"
+#include "opi_host.h"
+#include "internal/opi_population_file.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	class PopulationCheckpointImpl
+	{
+		public:
+			PopulationCheckpointImpl(Host& _host):
+				host(_host),
+				finished(true),
+				status(SUCCESS)
+			{
+			}
+
+			//! Writes the staging buffers to the file, runs on the worker thread
+			void write(std::string filename, FileSyncPolicy policy)
+			{
+				PopulationFileWriter file;
+				ErrorCode result = file.open(filename, propagatorName, byteArraySize);
+				if(result == SUCCESS)
+				{
+					for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+					{
+						if(stored[type])
+							file.addColumn(type, entrySize[type], 0, size, &staging[type][0], compression[type]);
+					}
+					result = file.finish(size, policy);
+				}
+				status = result;
+				finished = true;
+			}
+
+			Host& host;
+			std::thread worker;
+			std::atomic<bool> finished;
+			ErrorCode status;
+
+			// snapshot of the Population
+			std::vector<char> staging[DATA_EPOCH + 1];
+			bool stored[DATA_EPOCH + 1];
+			int entrySize[DATA_EPOCH + 1];
+			ColumnCompression compression[DATA_EPOCH + 1];
+			std::string propagatorName;
+			int size;
+			int byteArraySize;
+	};
+	/**
+	 * \endcond
+	 */
+
+	PopulationCheckpoint::PopulationCheckpoint(Host& host):
+		impl(host)
+	{
+	}
+
+	PopulationCheckpoint::~PopulationCheckpoint()
+	{
+		wait();
+	}
+
+	ErrorCode PopulationCheckpoint::start(Population& population, const std::string& filename, FileSyncPolicy policy)
+	{
+		// the staging buffers may still be in use
+		wait();
+
+		impl->size = population.getSize();
+		impl->byteArraySize = population.getByteArraySize();
+		impl->propagatorName = population.getLastPropagatorName();
+		impl->entrySize[DATA_ORBIT] = sizeof(Orbit);
+		impl->entrySize[DATA_PROPERTIES] = sizeof(ObjectProperties);
+		impl->entrySize[DATA_CARTESIAN] = sizeof(Vector3);
+		impl->entrySize[DATA_VELOCITY] = sizeof(Vector3);
+		impl->entrySize[DATA_ACCELERATION] = sizeof(Vector3);
+		impl->entrySize[DATA_BYTES] = impl->byteArraySize;
+		impl->entrySize[DATA_EPOCH] = sizeof(Epoch);
+		for(int type = DATA_ORBIT; type <= DATA_EPOCH; ++type)
+		{
+			impl->stored[type] = population.hasData(type) && impl->size > 0;
+			impl->compression[type] = population.getColumnCompression(type);
+			if(impl->stored[type])
+			{
+				// keeps the capacity of previous checkpoints
+				impl->staging[type].resize((size_t)impl->entrySize[type] * impl->size);
+				population.snapshotColumn(type, &impl->staging[type][0]);
+			}
+		}
+
+		impl->status = SUCCESS;
+		impl->finished = false;
+		impl->worker = std::thread(&PopulationCheckpointImpl::write, *impl, filename, policy);
+		return SUCCESS;
+	}
+
+	bool PopulationCheckpoint::isFinished() const
+	{
+		return impl->finished;
+	}
+
+	ErrorCode PopulationCheckpoint::wait()
+	{
+		if(impl->worker.joinable())
+			impl->worker.join();
+		impl->host.sendError(impl->status);
+		return impl->status;
+	}
+}
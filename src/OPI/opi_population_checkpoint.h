@@ -0,0 +1,80 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_POPULATION_CHECKPOINT_H
+#define OPI_POPULATION_CHECKPOINT_H
+#include "opi_common.h"
+#include "opi_error.h"
+#include "opi_pimpl_helper.h"
+#include <string>
+namespace OPI
+{
+	class Host;
+	class Population;
+	class PopulationCheckpointImpl;
+
+	/*! \brief Writes a snapshot of a Population to disk in the background.
+	 * \ingroup CPP_API_GROUP
+	 *
+	 * A checkpoint handle owns the staging buffers that hold the snapshot while it is being
+	 * written. The buffers are reused by subsequent checkpoints of the same handle, so keeping
+	 * one handle for periodic checkpoints avoids repeated allocations.
+	 * \see Population::checkpoint
+	 */
+	class OPI_API_EXPORT PopulationCheckpoint
+	{
+		public:
+			/**
+			 * @brief PopulationCheckpoint Creates an idle checkpoint handle.
+			 * @param host The OPI Host used for error reporting.
+			 */
+			PopulationCheckpoint(Host& host);
+
+			/**
+			 * @brief Destructor. Waits for a running checkpoint to finish.
+			 */
+			~PopulationCheckpoint();
+
+			/**
+			 * @brief start Snapshots a Population and starts writing it in the background.
+			 *
+			 * Equivalent to Population::checkpoint().
+			 * @param population The Population to store.
+			 * @param filename The file to write.
+			 * @param policy Defines if the file is flushed to the storage device after writing.
+			 * @return OPI::SUCCESS if the checkpoint was started.
+			 */
+			ErrorCode start(Population& population, const std::string& filename, FileSyncPolicy policy = FILE_SYNC_NONE);
+
+			/**
+			 * @brief isFinished Checks if the last checkpoint has been written completely.
+			 * @return true if no checkpoint is running.
+			 */
+			bool isFinished() const;
+
+			/**
+			 * @brief wait Waits until the last checkpoint has been written.
+			 * @return OPI::SUCCESS if the file was written successfully, or an error code otherwise.
+			 */
+			ErrorCode wait();
+
+		private:
+			PopulationCheckpoint(const PopulationCheckpoint& other);
+			Pimpl<PopulationCheckpointImpl> impl;
+	};
+}
+
+#endif
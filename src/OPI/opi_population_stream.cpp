@@ -0,0 +1,243 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_population_stream.h"
+#include "opi_host.h"
+#include "internal/opi_population_file.h"
+#include <thread>
+#include <algorithm>
+namespace OPI
+{
+	/**
+	 * \cond INTERNAL_DOCUMENTATION
+	 */
+	class PopulationStreamReaderImpl
+	{
+		public:
+			PopulationStreamReaderImpl(Host& _host):
+				host(_host),
+				bufferA(_host),
+				bufferB(_host),
+				current(&bufferA),
+				pendingBuffer(0),
+				chunkSize(0),
+				currentOffset(0),
+				pendingOffset(0),
+				prefetch(true),
+				status(SUCCESS),
+				pendingStatus(SUCCESS)
+			{
+			}
+
+			//! Starts reading the chunk at offset into the buffer that is not current
+			void start(int offset)
+			{
+				int count = std::min(chunkSize, file.getSize() - offset);
+				if(count <= 0)
+					return;
+				pendingBuffer = (current == &bufferA) ? &bufferB : &bufferA;
+				pendingOffset = offset;
+				// resizing may touch device memory, so do it on the calling thread
+				pendingBuffer->resize(count);
+				pendingBuffer->resizeByteArray(file.getByteArraySize());
+				pendingBuffer->setLastPropagatorName(file.getPropagatorName());
+				if(prefetch)
+					worker = std::thread(&PopulationStreamReaderImpl::read, this, pendingBuffer, offset, count);
+				else
+					read(pendingBuffer, offset, count);
+			}
+
+			//! Waits until the pending chunk has been read
+			void wait()
+			{
+				if(worker.joinable())
+					worker.join();
+			}
+
+			void read(Population* target, int offset, int count)
+			{
+				pendingStatus = target->readRange(file, offset, count);
+			}
+
+			Host& host;
+			PopulationFileReader file;
+			Population bufferA;
+			Population bufferB;
+			Population* current;
+			Population* pendingBuffer;
+			std::thread worker;
+			int chunkSize;
+			int currentOffset;
+			int pendingOffset;
+			bool prefetch;
+			ErrorCode status;
+			ErrorCode pendingStatus;
+	};
+
+	class PopulationStreamWriterImpl
+	{
+		public:
+			PopulationStreamWriterImpl(Host& _host):
+				host(_host),
+				numObjects(0),
+				byteArraySize(0)
+			{
+			}
+
+			Host& host;
+			std::string filename;
+			PopulationFileWriter file;
+			int numObjects;
+			int byteArraySize;
+	};
+	/**
+	 * \endcond
+	 */
+
+	PopulationStreamReader::PopulationStreamReader(Host& host, const std::string& filename, int chunkSize, bool prefetch):
+		impl(host)
+	{
+		impl->chunkSize = chunkSize;
+		impl->prefetch = prefetch;
+		impl->status = (chunkSize > 0) ? impl->file.open(filename) : INVALID_ARGUMENT;
+		if(impl->status == SUCCESS)
+		{
+			if(prefetch)
+				impl->start(0);
+		}
+		host.sendError(impl->status);
+	}
+
+	PopulationStreamReader::~PopulationStreamReader()
+	{
+		impl->wait();
+	}
+
+	bool PopulationStreamReader::next()
+	{
+		if(impl->status != SUCCESS)
+			return false;
+		// without prefetching, the chunk is read now
+		if(!impl->pendingBuffer)
+		{
+			int offset = (impl->current->getSize() > 0) ? impl->currentOffset + impl->current->getSize() : 0;
+			impl->start(offset);
+			if(!impl->pendingBuffer)
+				return false;
+		}
+		impl->wait();
+		impl->status = impl->pendingStatus;
+		if(impl->status != SUCCESS)
+		{
+			impl->pendingBuffer = 0;
+			impl->host.sendError(impl->status);
+			return false;
+		}
+		impl->current = impl->pendingBuffer;
+		impl->currentOffset = impl->pendingOffset;
+		impl->pendingBuffer = 0;
+		if(impl->prefetch)
+			impl->start(impl->currentOffset + impl->current->getSize());
+		return true;
+	}
+
+	void PopulationStreamReader::rewind()
+	{
+		impl->wait();
+		impl->pendingBuffer = 0;
+		impl->currentOffset = 0;
+		impl->current->resize(0);
+		if(impl->status == SUCCESS && impl->prefetch)
+			impl->start(0);
+	}
+
+	Population& PopulationStreamReader::getChunk()
+	{
+		return *impl->current;
+	}
+
+	int PopulationStreamReader::getChunkOffset() const
+	{
+		return impl->currentOffset;
+	}
+
+	int PopulationStreamReader::getChunkSize() const
+	{
+		return impl->chunkSize;
+	}
+
+	int PopulationStreamReader::getTotalSize() const
+	{
+		return impl->file.getSize();
+	}
+
+	ErrorCode PopulationStreamReader::getStatus() const
+	{
+		return impl->status;
+	}
+
+	PopulationStreamWriter::PopulationStreamWriter(Host& host, const std::string& filename):
+		impl(host)
+	{
+		impl->filename = filename;
+	}
+
+	PopulationStreamWriter::~PopulationStreamWriter()
+	{
+		close();
+	}
+
+	ErrorCode PopulationStreamWriter::append(Population& chunk)
+	{
+		ErrorCode status = SUCCESS;
+		// the header is written with the first chunk
+		if(!impl->file.isOpen())
+		{
+			if(impl->numObjects > 0)
+				status = FILE_NOT_FOUND;
+			else
+			{
+				impl->byteArraySize = chunk.getByteArraySize();
+				status = impl->file.open(impl->filename, chunk.getLastPropagatorName(), impl->byteArraySize);
+			}
+		}
+		if(status == SUCCESS && chunk.getByteArraySize() != impl->byteArraySize)
+			status = INCOMPATIBLE_TYPES;
+		if(status == SUCCESS)
+		{
+			chunk.writeRange(impl->file, impl->numObjects);
+			status = impl->file.flush();
+		}
+		if(status == SUCCESS)
+			impl->numObjects += chunk.getSize();
+		impl->host.sendError(status);
+		return status;
+	}
+
+	ErrorCode PopulationStreamWriter::close()
+	{
+		ErrorCode status = SUCCESS;
+		if(impl->file.isOpen())
+			status = impl->file.finish(impl->numObjects);
+		impl->host.sendError(status);
+		return status;
+	}
+
+	int PopulationStreamWriter::getSize() const
+	{
+		return impl->numObjects;
+	}
+}
@@ -0,0 +1,165 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_POPULATION_STREAM_H
+#define OPI_POPULATION_STREAM_H
+#include "opi_common.h"
+#include "opi_error.h"
+#include "opi_population.h"
+#include "opi_pimpl_helper.h"
+#include <string>
+namespace OPI
+{
+	class Host;
+	class PopulationStreamReaderImpl;
+	class PopulationStreamWriterImpl;
+
+	/*! \brief Reads a population file in chunks of a fixed number of objects.
+	 * \ingroup CPP_API_GROUP
+	 *
+	 * Use this class to process population files that are too large to be held in memory
+	 * at once. Every chunk is exposed as a Population containing up to chunkSize objects.
+	 * Two Population buffers are used alternately, so the memory (including device memory)
+	 * of a chunk is reused for the chunk after next. If prefetching is enabled, the next
+	 * chunk is read on a background thread while the current one is being processed.
+	 *
+	 * \code
+	 * OPI::PopulationStreamReader reader(host, "catalog.opi", 100000);
+	 * while(reader.next())
+	 * {
+	 *     propagator->propagate(reader.getChunk(), julian_day, dt);
+	 *     writer.append(reader.getChunk());
+	 * }
+	 * \endcode
+	 */
+	class OPI_API_EXPORT PopulationStreamReader
+	{
+		public:
+			/**
+			 * @brief PopulationStreamReader Opens a population file for chunked reading.
+			 *
+			 * If prefetching is enabled, reading the first chunk starts immediately.
+			 * @param host The OPI Host that the chunk Populations are intended for.
+			 * @param filename The population file to read.
+			 * @param chunkSize The maximum number of objects per chunk.
+			 * @param prefetch If true, the next chunk is read in the background.
+			 */
+			PopulationStreamReader(Host& host, const std::string& filename, int chunkSize, bool prefetch = true);
+			~PopulationStreamReader();
+
+			/**
+			 * @brief next Advances to the next chunk.
+			 *
+			 * Waits for the chunk to be read (if it is being prefetched) and starts
+			 * prefetching the one after that. Populations returned by getChunk() before this
+			 * call must no longer be used by the caller after the following call to next().
+			 * @return true if a new chunk is available, false at the end of the file or on errors.
+			 */
+			bool next();
+
+			/**
+			 * @brief rewind Restarts reading at the beginning of the file.
+			 */
+			void rewind();
+
+			/**
+			 * @brief getChunk Returns the current chunk.
+			 * @return A Population holding the objects [getChunkOffset(), getChunkOffset() + getChunk().getSize()).
+			 */
+			Population& getChunk();
+
+			/**
+			 * @brief getChunkOffset Returns the index of the first object of the current chunk.
+			 * @return The offset of the current chunk inside the file.
+			 */
+			int getChunkOffset() const;
+
+			/**
+			 * @brief getChunkSize Returns the maximum number of objects per chunk.
+			 * @return The chunk size this reader was created with.
+			 */
+			int getChunkSize() const;
+
+			/**
+			 * @brief getTotalSize Returns the number of objects stored in the file.
+			 * @return Number of objects.
+			 */
+			int getTotalSize() const;
+
+			/**
+			 * @brief getStatus Returns the status of the last file operation.
+			 * @return OPI::SUCCESS if no errors occurred, otherwise the error code.
+			 */
+			ErrorCode getStatus() const;
+
+		private:
+			PopulationStreamReader(const PopulationStreamReader& other);
+			Pimpl<PopulationStreamReaderImpl> impl;
+	};
+
+	/*! \brief Writes a population file by appending chunks of objects.
+	 * \ingroup CPP_API_GROUP
+	 *
+	 * Every call to append() adds all objects of the given Population to the end of the
+	 * file, so the total size of the file is not limited by the available memory. The
+	 * resulting file can be read with Population::read() or a PopulationStreamReader.
+	 * All appended Populations must have the same byte array size.
+	 */
+	class OPI_API_EXPORT PopulationStreamWriter
+	{
+		public:
+			/**
+			 * @brief PopulationStreamWriter Creates a writer for the given file.
+			 *
+			 * The file is created when the first chunk is appended.
+			 * @param host The OPI Host used for error reporting.
+			 * @param filename The population file to write.
+			 */
+			PopulationStreamWriter(Host& host, const std::string& filename);
+
+			/**
+			 * @brief Destructor. Closes the file if this has not been done yet.
+			 */
+			~PopulationStreamWriter();
+
+			/**
+			 * @brief append Appends all objects of a Population to the file.
+			 *
+			 * The data is synchronized to the host if necessary.
+			 * @param chunk The Population to append.
+			 * @return OPI::SUCCESS if the data was written, or an error code otherwise.
+			 */
+			ErrorCode append(Population& chunk);
+
+			/**
+			 * @brief close Writes the final object count and closes the file.
+			 * @return OPI::SUCCESS if the file was finished successfully.
+			 */
+			ErrorCode close();
+
+			/**
+			 * @brief getSize Returns the number of objects written so far.
+			 * @return Number of objects.
+			 */
+			int getSize() const;
+
+		private:
+			PopulationStreamWriter(const PopulationStreamWriter& other);
+			Pimpl<PopulationStreamWriterImpl> impl;
+	};
+}
+
+#endif
@@ -18,6 +18,8 @@
 #include "opi_host.h"
 #include "opi_perturbation_module.h"
 #include "opi_indexlist.h"
+#include "opi_trajectory_buffer.h"
+#include "internal/opi_parallel.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
@@ -30,14 +32,55 @@ namespace OPI
 	{
 		public:
 			PropagatorImpl():
-				allowPerturbationModules(false)
+				allowPerturbationModules(false),
+				indexedPropagationMissing(false),
+				outputMask(MASK_ALL)
 			{
 			}
 
 			bool allowPerturbationModules;
+			// set when runIndexedPropagation returned NOT_IMPLEMENTED
+			bool indexedPropagationMissing;
 			std::vector<PerturbationModule*> perturbationModules;
+			// the output requested by the running propagation call
+			DataMask outputMask;
 	};
 
+	namespace
+	{
+		// the columns covered by the output mask of a propagation call
+		const int STATE_COLUMNS = MASK_ORBIT | MASK_CARTESIAN | MASK_VELOCITY | MASK_ACCELERATION;
+
+		// returns the written columns of a module that are valid after a call with the given output
+		DataMask validColumns(const Module& module, DataMask output)
+		{
+			return module.getWrittenColumns() & (output | ~STATE_COLUMNS);
+		}
+
+		// the number of steps the trajectory fallback collects before writing them per object
+		const int TRAJECTORY_BLOCK = 8;
+
+		// sets the output mask for the duration of a (possibly nested) propagation call
+		class OutputScope
+		{
+			public:
+				OutputScope(DataMask& current, DataMask output):
+					mask(current),
+					previous(current)
+				{
+					mask = output;
+				}
+				~OutputScope()
+				{
+					mask = previous;
+				}
+
+			private:
+				DataMask& mask;
+				DataMask previous;
+		};
+	}
+
 	//! \endcond
 
     Propagator::Propagator()
@@ -59,6 +102,20 @@ namespace OPI
 		return data->allowPerturbationModules;
 	}
 
+	/**
+	 * The module is looked up among the modules of the Host. Nothing is assigned if the
+	 * propagator does not use modules or no module with the given name exists.
+	 */
+	PerturbationModule* Propagator::assignPerturbationModule(const std::string& name)
+	{
+		PerturbationModule* module = 0;
+		if(data->allowPerturbationModules && getHost())
+			module = getHost()->getPerturbationModule(name);
+		if(module)
+			data->perturbationModules.push_back(module);
+		return module;
+	}
+
 	PerturbationModule* Propagator::getPerturbationModule(int index)
 	{
 		return data->perturbationModules[index];
@@ -69,14 +126,21 @@ namespace OPI
 		return data->perturbationModules.size();
 	}
 
-    ErrorCode Propagator::propagate(Population& objectdata, double julian_day, double dt)
+    ErrorCode Propagator::propagate(Population& objectdata, double julian_day, double dt, DataMask output)
 	{
 		ErrorCode status = SUCCESS;
+		OutputScope scope(data->outputMask, output);
 		// ensure this propagator is enabled
 		status = enable();
 		// an error occured?
 		if(status == SUCCESS)
+		{
+			if(hasColumnUsage())
+				objectdata.prefetch(getReadColumns(), getTargetDevice());
 			status = runPropagation(objectdata, julian_day, dt);
+			if(status == SUCCESS && hasColumnUsage())
+				objectdata.updateColumns(validColumns(*this, output), getTargetDevice());
+		}
 		getHost()->sendError(status);
         if (status == SUCCESS && objectdata.getLastPropagatorName() != getName())
         {
@@ -87,17 +151,26 @@ namespace OPI
 
 	/**
 	 * If the runPropagation method for index-based propagation is not overloaded (returning OPI_NOT_IMPLEMENTED)
-	 * this function will perform a normal propagation instead.
+	 * this function will perform a normal propagation instead. If the propagator declared its
+	 * column usage, only the read and written columns are copied for the normal propagation and
+	 * only the written columns are copied back.
 	 */
-    ErrorCode Propagator::propagate(Population& objectdata, IndexList& indices, double julian_day, double dt)
+    ErrorCode Propagator::propagate(Population& objectdata, IndexList& indices, double julian_day, double dt, DataMask output)
 	{
 		ErrorCode status = SUCCESS;
+		OutputScope scope(data->outputMask, output);
+		// the fallback works on an indexed copy on the host, so nothing is prefetched for it
+		if(hasColumnUsage() && !data->indexedPropagationMissing)
+			objectdata.prefetch(getReadColumns(), getTargetDevice());
 		status = runIndexedPropagation(objectdata, indices, julian_day, dt);
+		if(status == SUCCESS && hasColumnUsage())
+			objectdata.updateColumns(validColumns(*this, output), getTargetDevice());
 		if(status == NOT_IMPLEMENTED)
         {
-            Population indexedData = Population(objectdata, indices);
-            propagate(indexedData, julian_day, dt);
-            objectdata.insert(indexedData, indices);
+            data->indexedPropagationMissing = true;
+            Population indexedData(objectdata, indices, getReadColumns() | getWrittenColumns());
+            propagate(indexedData, julian_day, dt, output);
+            objectdata.insert(indexedData, indices, validColumns(*this, output));
         }
 		getHost()->sendError(status);
         if (status == SUCCESS && objectdata.getLastPropagatorName() != getName())
@@ -107,20 +180,29 @@ namespace OPI
 		return status;
 	}
 
-    ErrorCode Propagator::propagate(Population& objectdata, double* julian_days, int length, double dt)
+    ErrorCode Propagator::propagate(Population& objectdata, double* julian_days, int length, double dt, DataMask output)
     {
         ErrorCode status = SUCCESS;
+        OutputScope scope(data->outputMask, output);
         if (length < 1 || length < objectdata.getSize())
         {
             status = INDEX_RANGE;
         }
         else if (length == 1)
         {
+            if(hasColumnUsage())
+                objectdata.prefetch(getReadColumns(), getTargetDevice());
             status = runPropagation(objectdata, julian_days[0], dt);
+            if(status == SUCCESS && hasColumnUsage())
+                objectdata.updateColumns(validColumns(*this, output), getTargetDevice());
         }
         else if (length >= objectdata.getSize())
         {
+            if(hasColumnUsage())
+                objectdata.prefetch(getReadColumns(), getTargetDevice());
             status = runMultiTimePropagation(objectdata, julian_days, length, dt);
+            if(status == SUCCESS && hasColumnUsage())
+                objectdata.updateColumns(validColumns(*this, output), getTargetDevice());
             if (status == NOT_IMPLEMENTED)
             {
                 ErrorCode innerStatus = SUCCESS;
@@ -128,7 +210,7 @@ namespace OPI
                 {
                     IndexList indices(*getHost());
                     indices.add(i);
-                    innerStatus = propagate(objectdata, indices, julian_days[i], dt);
+                    innerStatus = propagate(objectdata, indices, julian_days[i], dt, output);
                 }
                 if (innerStatus != SUCCESS) status = innerStatus;
             }
@@ -142,6 +224,90 @@ namespace OPI
         return status;
     }
 
+	/**
+	 * The fallback propagates the Population in place, so every step costs one propagation
+	 * call plus one copy of the state columns on the host. Plugins that implement
+	 * runTrajectoryPropagation() avoid both.
+	 */
+	ErrorCode Propagator::propagateTrajectory(Population& objectdata, const double* julian_days, int length, TrajectoryBuffer& trajectory)
+	{
+		ErrorCode status = SUCCESS;
+		const bool cartesian = cartesianCoordinates();
+		DataMask output = MASK_ORBIT;
+		if(cartesian)
+			output = MASK_CARTESIAN | (trajectory.hasVelocities() ? MASK_VELOCITY : MASK_NONE);
+		if(!julian_days || length < 1 || trajectory.getObjectCount() != objectdata.getSize() || trajectory.getTimeCount() != length)
+			status = INVALID_ARGUMENT;
+		else
+			status = enable();
+		if(status == SUCCESS)
+		{
+			OutputScope scope(data->outputMask, output);
+			if(hasColumnUsage())
+				objectdata.prefetch(getReadColumns(), getTargetDevice());
+			status = runTrajectoryPropagation(objectdata, julian_days, length, trajectory);
+			if(status == SUCCESS && hasColumnUsage())
+				objectdata.updateColumns(validColumns(*this, output), getTargetDevice());
+		}
+		if(status == NOT_IMPLEMENTED)
+		{
+			const int objects = objectdata.getSize();
+			Vector3* positions = trajectory.getPosition(DEVICE_HOST, true);
+			Vector3* velocities = trajectory.getVelocity(DEVICE_HOST, true);
+			const ReferenceFrame frame = referenceFrame();
+			// the states of the last steps, so every object's trajectory is written in runs
+			std::vector<Vector3> stagedPositions(static_cast<size_t>(objects) * TRAJECTORY_BLOCK);
+			std::vector<Vector3> stagedVelocities(velocities ? stagedPositions.size() : 0);
+			status = SUCCESS;
+			for(int t = 0; t < length; ++t)
+			{
+				if(t == 0)
+					status = propagate(objectdata, julian_days[0], 0.0, output);
+				else
+					status = propagate(objectdata, julian_days[t - 1], (julian_days[t] - julian_days[t - 1]) * 86400.0, output);
+				if(status == SUCCESS && !cartesian)
+					status = objectdata.computeCartesian(frame == REF_NONE ? REF_UNSPECIFIED : frame);
+				if(status != SUCCESS)
+					break;
+				const int slot = t % TRAJECTORY_BLOCK;
+				const Vector3* position = objectdata.getPosition(DEVICE_HOST);
+				std::copy(position, position + objects, stagedPositions.begin() + (size_t)slot * objects);
+				if(velocities)
+				{
+					const Vector3* velocity = objectdata.getVelocity(DEVICE_HOST);
+					std::copy(velocity, velocity + objects, stagedVelocities.begin() + (size_t)slot * objects);
+				}
+				if(slot == TRAJECTORY_BLOCK - 1 || t == length - 1)
+				{
+					const int first = t - slot;
+					parallelFor(0, objects, 1024, [&](int begin, int end) {
+						for(int i = begin; i < end; ++i)
+						{
+							for(int k = 0; k <= slot; ++k)
+							{
+								positions[(size_t)i * length + first + k] = stagedPositions[(size_t)k * objects + i];
+								if(velocities)
+									velocities[(size_t)i * length + first + k] = stagedVelocities[(size_t)k * objects + i];
+							}
+						}
+					});
+				}
+			}
+			trajectory.update(DEVICE_HOST);
+		}
+		getHost()->sendError(status);
+		if(status == SUCCESS && objectdata.getLastPropagatorName() != getName())
+		{
+			objectdata.setLastPropagatorName(getName());
+		}
+		return status;
+	}
+
+	DataMask Propagator::getOutputMask() const
+	{
+		return data->outputMask;
+	}
+
 	bool Propagator::backwardPropagation()
 	{
         return false;
@@ -171,6 +337,11 @@ namespace OPI
         return NOT_IMPLEMENTED;
     }
 
+    ErrorCode Propagator::runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory)
+    {
+        return NOT_IMPLEMENTED;
+    }
+
     void Propagator::loadConfigFile()
     {
         loadConfigFile(configFileName);
@@ -28,6 +28,7 @@ namespace OPI
 	class Population;
 	class IndexList;
 	class PerturbationModule;
+	class TrajectoryBuffer;
 
 	//! Contains the propagation implementation data
 	class PropagatorImpl;
@@ -86,9 +87,13 @@ namespace OPI
              * @param data The Population to be propagated.
              * @param julian_day The base date in Julian date format.
              * @param dt The time step, in seconds, from last propagation.
+             * @param output The columns that have to be valid after the propagation, any
+             * combination of MASK_ORBIT, MASK_CARTESIAN, MASK_VELOCITY and MASK_ACCELERATION.
+             * Propagators can skip computing other state columns (see getOutputMask()), which
+             * are undefined afterwards. Defaults to all columns.
              * @return OPI::SUCCESS if propagation was successful, or other error code.
              */
-            ErrorCode propagate(Population& data, double julian_day, double dt);
+            ErrorCode propagate(Population& data, double julian_day, double dt, DataMask output = MASK_ALL);
 
             /**
              * @brief propagate Starts the index-based propagation for the given time step.
@@ -104,11 +109,12 @@ namespace OPI
              * should be propagated.
              * @param julian_day The base date in Julian date format.
              * @param dt The time step, in seconds, from last propagation.
+             * @param output The columns that have to be valid after the propagation.
              * @return OPI::SUCCESS if propagation was successful; OPI::NOT_IMPLEMENTED if propagation
              * was performed with OPI's inherent method (which should still give you valid results); or
              * any other error code returned by the plugin.
              */
-            ErrorCode propagate(Population& data, IndexList& indices, double julian_day, double dt);
+            ErrorCode propagate(Population& data, IndexList& indices, double julian_day, double dt, DataMask output = MASK_ALL);
 
             /**
              * @brief propagate Starts propagation with individual times for each object.
@@ -123,11 +129,34 @@ namespace OPI
              * @param julian_days An array of Julian dates, one for each element in the Population.
              * @param length The length of the julian_days array. Must be the same size as the Population's.
              * @param dt The time step, in seconds, from last propagation.
+             * @param output The columns that have to be valid after the propagation.
              * @return OPI::SUCCESS if propagation was successful; OPI::NOT_IMPLEMENTED if propagation
              * was performed with OPI's inherent method (which should still give you valid results); or
              * any other ErrorCode returned by the plugin.
              */
-            ErrorCode propagate(Population& data, double* julian_days, int length, double dt);
+            ErrorCode propagate(Population& data, double* julian_days, int length, double dt, DataMask output = MASK_ALL);
+
+            /**
+             * @brief propagateTrajectory Propagates the Population to several times and records the states.
+             *
+             * Writes the position and, if the buffer holds them, the velocity of every object at
+             * every time into the TrajectoryBuffer. Afterwards, the Population holds the state at
+             * the last time, like after the equivalent sequence of propagate() calls. This
+             * function calls runTrajectoryPropagation() which can be implemented by the plugin to
+             * generate all states in one pass, e.g. in a single kernel launch that writes to the
+             * device memory of the buffer. If the plugin returns NOT_IMPLEMENTED, the Population
+             * is propagated from time to time with propagate() and the states are copied after
+             * each step. Propagators that do not produce Cartesian states are converted with
+             * Population::computeCartesian() in this case.
+             * @param data The Population to be propagated.
+             * @param julian_days The output times as Julian dates, usually in ascending order.
+             * @param length The number of output times.
+             * @param trajectory The buffer receiving the states, which has to be sized for the
+             * objects of the Population and length times (see TrajectoryBuffer::resize()).
+             * @return OPI::SUCCESS if propagation was successful, INVALID_ARGUMENT if no times are
+             * given or the buffer does not match, or any other ErrorCode returned by the plugin.
+             */
+            ErrorCode propagateTrajectory(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory);
 
 			//! Assigns a module to this propagator
 			/**
@@ -164,6 +193,16 @@ namespace OPI
 		protected:
 			//! Defines that this propagator (can) use Perturbation Modules
 			void useModules();
+			/**
+			 * @brief getOutputMask Returns the columns the running propagation call has to produce.
+			 *
+			 * Propagators can check this mask (a DataMask) to skip e.g. the conversion to
+			 * Cartesian state vectors and the associated writes and transfers if MASK_CARTESIAN,
+			 * MASK_VELOCITY and MASK_ACCELERATION are not set. Columns outside of the state
+			 * (orbit, position, velocity and acceleration) are not affected by the mask.
+			 * @return The mask passed to propagate(), MASK_ALL outside of a propagation call.
+			 */
+			DataMask getOutputMask() const;
 			//! The actual propagation implementation
 			//! The C Namespace equivalent for this function is OPI_Plugin_propagate
             virtual ErrorCode runPropagation(Population& data, double julian_day, double dt) = 0;
@@ -173,6 +212,10 @@ namespace OPI
             //! Override this to implement propagation with individual times.
             //! OPI will make sure that the julian_days vector length matches that of the Population.
             virtual ErrorCode runMultiTimePropagation(Population& data, double* julian_days, int length, double dt);
+            //! Override this to generate trajectories in one pass.
+            //! OPI will make sure that the buffer matches the Population and the number of times.
+            //! The C Namespace equivalent for this function is OPI_Plugin_propagateTrajectory
+            virtual ErrorCode runTrajectoryPropagation(Population& data, const double* julian_days, int length, TrajectoryBuffer& trajectory);
             //! Variable to hold the appropriate name for the config file.
             std::string configFileName;
 
@@ -0,0 +1,95 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_PROPAGATOR_INTEGRATOR_H
+#define OPI_PROPAGATOR_INTEGRATOR_H
+
+#include "opi_common.h"
+#include "opi_module.h"
+#include "opi_error.h"
+#include "opi_datatypes.h"
+#include "opi_pimpl_helper.h"
+namespace OPI
+{
+	class Population;
+	class CustomPropagator;
+
+	//! \brief States requested at intermediate times of an integration
+	//! \ingroup CPP_API_GROUP
+	/*!
+	 * The states of object i at time k are stored at index i * count + k. Integrators
+	 * interpolate them from the accepted steps (dense output), so the step sizes are not
+	 * limited by the output times.
+	 */
+	struct DenseOutput
+	{
+		//! Number of output times
+		int count;
+		//! Output times in seconds after the start of the integration, ordered in the direction of dt and within [0, dt]
+		const double* times;
+		//! Receives the positions; may be a null pointer
+		Vector3* position;
+		//! Receives the velocities; may be a null pointer
+		Vector3* velocity;
+	};
+
+	//! Contains the integrator implementation data
+	class PropagatorIntegratorImpl;
+
+	/*!
+	 * \brief This class represents a numerical integrator used by a CustomPropagator
+	 *
+	 * \ingroup CPP_API_GROUP
+	 * The integrator advances the Cartesian state (position and velocity) of a whole
+	 * Population. The accelerations are evaluated in batches with
+	 * CustomPropagator::calculateAccelerations(), which sums the central body gravity and
+	 * the accelerations of all perturbation modules of the propagator.
+	 * \see Module, Host, CustomPropagator
+	 */
+	class OPI_API_EXPORT PropagatorIntegrator:
+			public Module
+	{
+		public:
+			PropagatorIntegrator();
+			virtual ~PropagatorIntegrator();
+
+			/**
+			 * @brief integrate Advances the state of all objects by dt seconds.
+			 *
+			 * The states of the position and velocity columns refer to julian_day and are
+			 * replaced by the states at julian_day + dt / 86400.
+			 * @param data The Population to integrate.
+			 * @param julian_day The time of the current states.
+			 * @param dt The time span to integrate in seconds, may be negative.
+			 * @param propagator The propagator providing the accelerations.
+			 * @param output Optional states to record at intermediate times.
+			 */
+			ErrorCode integrate(Population& data, double julian_day, double dt, const CustomPropagator& propagator, const DenseOutput* output = 0);
+
+		protected:
+			//! Override this to implement the integration
+			/**
+			 * Integrators should also store the accelerations of the final states in the
+			 * acceleration column and fill output if it is given.
+			 */
+			virtual ErrorCode runIntegration(Population& data, double julian_day, double dt, const CustomPropagator& propagator, const DenseOutput* output) = 0;
+
+		private:
+			Pimpl<PropagatorIntegratorImpl> impl;
+	};
+}
+
+#endif
@@ -42,7 +42,13 @@ namespace OPI
 		status = enable();
 		// an error occured?
 		if(status == SUCCESS)
+		{
+			if(hasColumnUsage())
+				data.prefetch(getReadColumns(), getTargetDevice());
 			status = runRebuild(data);
+			if(status == SUCCESS && hasColumnUsage())
+				data.updateColumns(getWrittenColumns(), getTargetDevice());
+		}
 		// forward propagation call
 		getHost()->sendError(status);
 		return status;
@@ -57,7 +63,11 @@ namespace OPI
 		status = enable();
 		// an error occured?
 		if(status == SUCCESS)
+		{
+			if(hasColumnUsage())
+				data.prefetch(getReadColumns(), getTargetDevice());
 			status = runCubicPairQuery(data, pairs, cube_size);
+		}
 		getHost()->sendError(status);
 		// forward propagation call
 		return status;
@@ -0,0 +1,105 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "opi_trajectory_buffer.h"
+#include "internal/opi_synchronized_data.h"
+namespace OPI
+{
+	/**
+	 * @cond INTERNAL_DOCUMENTATION
+	 */
+	class TrajectoryBufferImpl
+	{
+		public:
+			TrajectoryBufferImpl(Host& host):
+				objects(0),
+				times(0),
+				velocities(true),
+				states(host)
+			{
+			}
+
+			int objects;
+			int times;
+			bool velocities;
+			// all positions followed by all velocities
+			SynchronizedData<Vector3> states;
+	};
+	/**
+	 * @endcond
+	 */
+
+	TrajectoryBuffer::TrajectoryBuffer(Host& host, int objects, int times, bool velocities):
+		impl(host)
+	{
+		impl->velocities = velocities;
+		resize(objects, times);
+	}
+
+	TrajectoryBuffer::~TrajectoryBuffer()
+	{
+	}
+
+	/**
+	 * The memory is reallocated on all devices if the number of states changes.
+	 */
+	void TrajectoryBuffer::resize(int objects, int times)
+	{
+		objects = std::max(objects, 0);
+		times = std::max(times, 0);
+		const int size = objects * times * (impl->velocities ? 2 : 1);
+		if(size != impl->states.getSize())
+		{
+			impl->states.clear(false);
+			impl->states.resize(size);
+		}
+		impl->objects = objects;
+		impl->times = times;
+	}
+
+	int TrajectoryBuffer::getObjectCount() const
+	{
+		return impl->objects;
+	}
+
+	int TrajectoryBuffer::getTimeCount() const
+	{
+		return impl->times;
+	}
+
+	bool TrajectoryBuffer::hasVelocities() const
+	{
+		return impl->velocities;
+	}
+
+	Vector3* TrajectoryBuffer::getPosition(Device device, bool no_sync) const
+	{
+		return impl->states.getData(device, no_sync);
+	}
+
+	Vector3* TrajectoryBuffer::getVelocity(Device device, bool no_sync) const
+	{
+		if(!impl->velocities)
+			return 0;
+		Vector3* states = impl->states.getData(device, no_sync);
+		return states ? states + impl->objects * impl->times : 0;
+	}
+
+	void TrajectoryBuffer::update(Device device)
+	{
+		impl->states.update(device);
+	}
+}
@@ -0,0 +1,64 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_TRAJECTORY_BUFFER_H
+#define OPI_TRAJECTORY_BUFFER_H
+#include "opi_common.h"
+#include "opi_datatypes.h"
+
+#include "opi_pimpl_helper.h"
+namespace OPI
+{
+	class TrajectoryBufferImpl;
+	class Host;
+
+	//! \brief This class holds the states of a number of objects at a number of times
+	//! \ingroup CPP_API_GROUP
+	/*!
+	 * The buffer is filled by Propagator::propagateTrajectory(). The state of object o at time
+	 * t is stored at index o * getTimeCount() + t, so the trajectory of every object is
+	 * contiguous. Positions and velocities share one memory block on each device, which is
+	 * synchronized with a single transfer.
+	 */
+	class OPI_API_EXPORT TrajectoryBuffer
+	{
+		public:
+			//! Creates a buffer for objects * times states, the host object must be valid
+			TrajectoryBuffer(Host& host, int objects = 0, int times = 0, bool velocities = true);
+			~TrajectoryBuffer();
+
+			//! Changes the dimensions of the buffer, the content is undefined afterwards unless they are unchanged
+			void resize(int objects, int times);
+			//! Returns the number of objects
+			int getObjectCount() const;
+			//! Returns the number of times per object
+			int getTimeCount() const;
+			//! Returns true if the buffer holds velocities
+			bool hasVelocities() const;
+
+			//! Returns a device-specific pointer to the positions
+			Vector3* getPosition(Device device = DEVICE_HOST, bool no_sync = false) const;
+			//! Returns a device-specific pointer to the velocities, or a null pointer if the buffer holds none
+			Vector3* getVelocity(Device device = DEVICE_HOST, bool no_sync = false) const;
+			//! Notifies the buffer that positions and velocities have been written on the device
+			void update(Device device);
+
+		private:
+			//! Private implementation details (pimpl-idiom)
+			Pimpl<TrajectoryBufferImpl> impl;
+	};
+}
+#endif // OPI_TRAJECTORY_BUFFER_H
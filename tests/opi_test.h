@@ -0,0 +1,75 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#ifndef OPI_TEST_H
+#define OPI_TEST_H
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+// Minimal checks for the behaviour tests. Every failed check is reported with its location,
+// OPI_TEST_RESULT() returns the exit code of the test.
+namespace opi_test
+{
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	inline bool check(bool condition, const char* expression, const char* file, int line)
+	{
+		if(!condition)
+		{
+			std::printf("%s:%d: check failed: %s\n", file, line, expression);
+			++failures();
+		}
+		return condition;
+	}
+
+	inline bool checkClose(double value, double expected, double tolerance, const char* expression, const char* file, int line)
+	{
+		// NaN never passes
+		if(!(std::fabs(value - expected) <= tolerance))
+		{
+			std::printf("%s:%d: check failed: %s is %.12g, expected %.12g +- %g\n", file, line, expression, value, expected, tolerance);
+			++failures();
+			return false;
+		}
+		return true;
+	}
+
+	inline int result(const char* name)
+	{
+		if(failures() > 0)
+			std::printf("%s: %d check(s) failed\n", name, failures());
+		else
+			std::printf("%s: all checks passed\n", name);
+		return failures() > 0 ? 1 : 0;
+	}
+
+	// returns the path of a scratch file in the test output directory
+	inline std::string outputFile(const std::string& name)
+	{
+		return std::string(OPI_TEST_OUTPUT_DIR) + "/" + name;
+	}
+}
+
+#define OPI_CHECK(condition) opi_test::check((condition), #condition, __FILE__, __LINE__)
+#define OPI_CHECK_CLOSE(value, expected, tolerance) opi_test::checkClose((value), (expected), (tolerance), #value, __FILE__, __LINE__)
+#define OPI_TEST_RESULT(name) opi_test::result(name)
+
+#endif
@@ -0,0 +1,198 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <fstream>
+#include <sstream>
+
+// TLE and CSV catalog import.
+namespace
+{
+	const double DEG = 3.14159265358979323846 / 180.0;
+
+	void writeFile(const std::string& filename, const std::string& content)
+	{
+		std::ofstream out(filename.c_str(), std::ofstream::binary);
+		out << content;
+	}
+
+	// semi-major axis in km for a mean motion in revolutions per day (WGS-72)
+	double semiMajorAxis(double revolutionsPerDay)
+	{
+		const double n = revolutionsPerDay * 2.0 * 3.14159265358979323846 / 86400.0;
+		return std::cbrt(398600.8 / (n * n));
+	}
+
+	const char* TLE_00005[] = {
+		"1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+		"2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667"
+	};
+	const char* TLE_06251[] = {
+		"1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985",
+		"2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774"
+	};
+	const char* TLE_A0001[] = {
+		"1 A0001U 75081A   06176.33215444  .00000099  00000-0 -11873-3 0   813",
+		"2 A0001  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656"
+	};
+
+	void testTLE(OPI::Host& host)
+	{
+		std::ostringstream text;
+		text << "0 VANGUARD 1\n" << TLE_00005[0] << "\n" << TLE_00005[1] << "\n";
+		text << "DELTA 1 DEB  \r\n" << TLE_06251[0] << "\r\n" << TLE_06251[1] << "\r\n";
+		text << TLE_A0001[0] << "\n" << TLE_A0001[1];
+		writeFile(opi_test::outputFile("catalog.tle"), text.str());
+
+		OPI::Population population(host);
+		OPI_CHECK(population.importTLE(opi_test::outputFile("catalog.tle")) == OPI::SUCCESS);
+		OPI_CHECK(population.getSize() == 3);
+		if(population.getSize() != 3)
+			return;
+		const OPI::Orbit* orbit = population.getOrbit();
+		const OPI::ObjectProperties* properties = population.getObjectProperties();
+		const OPI::Epoch* epoch = population.getEpoch();
+
+		OPI_CHECK(properties[0].id == 5);
+		OPI_CHECK(population.getObjectName(0) == "VANGUARD 1");
+		OPI_CHECK_CLOSE(epoch[0].original_epoch, 2451543.5 + 179.78495062, 1e-8);
+		OPI_CHECK_CLOSE(epoch[0].current_epoch, epoch[0].original_epoch, 0.0);
+		OPI_CHECK_CLOSE(orbit[0].semi_major_axis, semiMajorAxis(10.82419157), 1e-6);
+		OPI_CHECK_CLOSE(orbit[0].eccentricity, 0.1859667, 1e-12);
+		OPI_CHECK_CLOSE(orbit[0].inclination, 34.2682 * DEG, 1e-12);
+		OPI_CHECK_CLOSE(orbit[0].raan, 348.7242 * DEG, 1e-12);
+		OPI_CHECK_CLOSE(orbit[0].arg_of_perigee, 331.7664 * DEG, 1e-12);
+		OPI_CHECK_CLOSE(orbit[0].mean_anomaly, 19.3264 * DEG, 1e-12);
+		OPI_CHECK_CLOSE(properties[0].drag_coefficient, 2.2, 0.0);
+		OPI_CHECK_CLOSE(properties[0].area_to_mass * properties[0].drag_coefficient * 0.15696615 / 2.0, 0.28098e-4, 1e-15);
+
+		OPI_CHECK(properties[1].id == 6251);
+		OPI_CHECK(population.getObjectName(1) == "DELTA 1 DEB");
+		OPI_CHECK_CLOSE(epoch[1].original_epoch, 2453735.5 + 176.82412014, 1e-8);
+		OPI_CHECK_CLOSE(orbit[1].eccentricity, 0.0030035, 1e-12);
+
+		// alpha-5 catalog number, negative B* and no name line
+		OPI_CHECK(properties[2].id == 100001);
+		OPI_CHECK(population.getObjectName(2) == "");
+		OPI_CHECK_CLOSE(properties[2].area_to_mass * properties[2].drag_coefficient * 0.15696615 / 2.0, -0.11873e-3, 1e-15);
+		OPI_CHECK_CLOSE(orbit[2].semi_major_axis, semiMajorAxis(2.00491383), 1e-6);
+	}
+
+	void testLargeTLE(OPI::Host& host)
+	{
+		// enough element sets to be split into many chunks
+		const int count = 20000;
+		std::ostringstream text;
+		for(int i = 0; i < count; ++i)
+		{
+			std::string line1 = TLE_06251[0], line2 = TLE_06251[1];
+			char number[6];
+			std::snprintf(number, sizeof(number), "%05d", i + 1);
+			line1.replace(2, 5, number);
+			line2.replace(2, 5, number);
+			text << "OBJECT " << i << "\n" << line1 << "\n" << line2 << "\n";
+		}
+		writeFile(opi_test::outputFile("large.tle"), text.str());
+
+		OPI::Population population(host);
+		OPI_CHECK(population.importTLE(opi_test::outputFile("large.tle")) == OPI::SUCCESS);
+		OPI_CHECK(population.getSize() == count);
+		int misplaced = 0;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			std::ostringstream name;
+			name << "OBJECT " << i;
+			if(population.getObjectProperties()[i].id != i + 1 || population.getObjectName(i) != name.str())
+				misplaced++;
+		}
+		OPI_CHECK(misplaced == 0);
+
+		// importing into a Population of the same size whose names are shared with a copy
+		OPI::Population copy(population);
+		OPI_CHECK(population.importTLE(opi_test::outputFile("large.tle")) == OPI::SUCCESS);
+		OPI_CHECK(population.getSize() == count);
+		misplaced = 0;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			std::ostringstream name;
+			name << "OBJECT " << i;
+			if(population.getObjectName(i) != name.str() || copy.getObjectName(i) != name.str())
+				misplaced++;
+		}
+		OPI_CHECK(misplaced == 0);
+	}
+
+	void testMalformedTLE(OPI::Host& host)
+	{
+		std::string line2 = TLE_00005[1];
+		line2[10] = 'x';
+		writeFile(opi_test::outputFile("malformed.tle"), std::string(TLE_00005[0]) + "\n" + line2 + "\n");
+		OPI::Population population(host);
+		OPI_CHECK(population.importTLE(opi_test::outputFile("malformed.tle")) == OPI::INVALID_FILE_FORMAT);
+		OPI_CHECK(population.importTLE(opi_test::outputFile("missing.tle")) == OPI::FILE_NOT_FOUND);
+	}
+
+	void testCSV(OPI::Host& host)
+	{
+		writeFile(opi_test::outputFile("catalog.csv"),
+				  "# a comment\n"
+				  "id,name,semi_major_axis,eccentricity,x,vz,epoch,unknown\n"
+				  "17,first,7000.5,0.01,1.5,-7.25,2451545.0,foo\n"
+				  "18,\"second, quoted\",42164,,2,3,2451546.5,bar\n");
+		OPI::Population population(host);
+		OPI_CHECK(population.importCSV(opi_test::outputFile("catalog.csv")) == OPI::SUCCESS);
+		OPI_CHECK(population.getSize() == 2);
+		if(population.getSize() != 2)
+			return;
+		OPI_CHECK(population.getObjectProperties()[0].id == 17);
+		OPI_CHECK(population.getObjectProperties()[1].id == 18);
+		OPI_CHECK(population.getObjectName(0) == "first");
+		OPI_CHECK(population.getObjectName(1) == "second, quoted");
+		OPI_CHECK_CLOSE(population.getOrbit()[0].semi_major_axis, 7000.5, 0.0);
+		OPI_CHECK_CLOSE(population.getOrbit()[0].eccentricity, 0.01, 0.0);
+		// empty fields are zero
+		OPI_CHECK_CLOSE(population.getOrbit()[1].eccentricity, 0.0, 0.0);
+		OPI_CHECK_CLOSE(population.getPosition()[0].x, 1.5, 0.0);
+		OPI_CHECK_CLOSE(population.getVelocity()[0].z, -7.25, 0.0);
+		OPI_CHECK_CLOSE(population.getEpoch()[1].original_epoch, 2451546.5, 0.0);
+		OPI_CHECK_CLOSE(population.getEpoch()[1].current_epoch, 2451546.5, 0.0);
+
+		// columns that are not in the file are not allocated
+		writeFile(opi_test::outputFile("orbits.csv"), "semi_major_axis,eccentricity,inclination\n7000,0.01,0.5\n");
+		OPI::Population orbits(host);
+		OPI_CHECK(orbits.importCSV(opi_test::outputFile("orbits.csv")) == OPI::SUCCESS);
+		OPI_CHECK(orbits.getSize() == 1);
+		OPI_CHECK(orbits.hasData(OPI::DATA_ORBIT));
+		OPI_CHECK(!orbits.hasData(OPI::DATA_CARTESIAN));
+		OPI_CHECK(!orbits.hasData(OPI::DATA_VELOCITY));
+		OPI_CHECK(!orbits.hasData(OPI::DATA_PROPERTIES));
+		OPI_CHECK(!orbits.hasData(OPI::DATA_EPOCH));
+
+		writeFile(opi_test::outputFile("malformed.csv"), "id,eccentricity\n1,0.1\n2,abc\n");
+		OPI_CHECK(population.importCSV(opi_test::outputFile("malformed.csv")) == OPI::INVALID_FILE_FORMAT);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testTLE(host);
+	testLargeTLE(host);
+	testMalformedTLE(host);
+	testCSV(host);
+	return OPI_TEST_RESULT("TestCatalogImport");
+}
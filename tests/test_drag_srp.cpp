@@ -0,0 +1,236 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Atmospheric drag and solar radiation pressure of the DragSRPCPP module.
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	const double DEGREES = PI / 180.0;
+	const double EARTH_RADIUS = 6378.137;
+	const double EARTH_ROTATION = 7.292115e-5;
+	const double JD = 2451545.0 + 80.0;
+
+	// the low precision sun position of the Astronomical Almanac that the module uses
+	OPI::Vector3 sunPosition(double julian_day)
+	{
+		const double n = julian_day - 2451545.0;
+		const double meanLongitude = (280.460 + 0.9856474 * n) * DEGREES;
+		const double meanAnomaly = (357.528 + 0.9856003 * n) * DEGREES;
+		const double longitude = meanLongitude + (1.915 * std::sin(meanAnomaly) + 0.020 * std::sin(2.0 * meanAnomaly)) * DEGREES;
+		const double obliquity = (23.439 - 0.0000004 * n) * DEGREES;
+		const double distance = (1.00014 - 0.01671 * std::cos(meanAnomaly) - 0.00014 * std::cos(2.0 * meanAnomaly)) * 149597870.7;
+		return OPI::Vector3(distance * std::cos(longitude), distance * std::cos(obliquity) * std::sin(longitude), distance * std::sin(obliquity) * std::sin(longitude));
+	}
+
+	double norm(const OPI::Vector3& v)
+	{
+		return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	}
+
+	// returns the accelerations of the module for the given states
+	std::vector<OPI::Vector3> accelerations(OPI::PerturbationModule* module, const std::vector<OPI::Vector3>& position,
+											const std::vector<OPI::Vector3>& velocity, const OPI::ObjectProperties& properties)
+	{
+		const int count = static_cast<int>(position.size());
+		std::vector<double> times(count, JD);
+		std::vector<OPI::ObjectProperties> objects(count, properties);
+		std::vector<OPI::Vector3> result(count, OPI::Vector3(0.0, 0.0, 0.0));
+		OPI::StateBatch batch;
+		batch.count = count;
+		batch.position = position.data();
+		batch.velocity = velocity.data();
+		batch.julian_day = times.data();
+		batch.properties = objects.data();
+		batch.acceleration = result.data();
+		OPI_CHECK(module->setTimeStep(JD) == OPI::SUCCESS);
+		OPI_CHECK(module->calculateAcceleration(batch) == OPI::SUCCESS);
+		return result;
+	}
+
+	const OPI::ObjectProperties PROPERTIES(100.0, 1.0, 0.01, 2.2, 1.3, 1);
+
+	// densities in kg/m^3 at a geodetic latitude, derived from the drag of objects moving east at
+	// 7.5 km/s relative to the atmosphere
+	std::vector<double> densities(OPI::PerturbationModule* module, const std::vector<double>& altitudes, double longitude, double latitude = 0.0)
+	{
+		const double flattening = 1.0 / 298.257223563;
+		const OPI::Vector3 radial(std::cos(latitude) * std::cos(longitude), std::cos(latitude) * std::sin(longitude), std::sin(latitude));
+		const OPI::Vector3 east(-std::sin(longitude), std::cos(longitude), 0.0);
+		std::vector<OPI::Vector3> position, velocity;
+		for(size_t i = 0; i < altitudes.size(); ++i)
+		{
+			// the module measures the altitude above the ellipsoid
+			const double r = altitudes[i] + EARTH_RADIUS * (1.0 - flattening * std::sin(latitude) * std::sin(latitude));
+			position.push_back(radial * r);
+			velocity.push_back(east * (7.5 + EARTH_ROTATION * r * std::cos(latitude)));
+		}
+		std::vector<OPI::Vector3> a = accelerations(module, position, velocity, PROPERTIES);
+		std::vector<double> result;
+		for(size_t i = 0; i < a.size(); ++i)
+			result.push_back(norm(a[i]) / (0.5e3 * PROPERTIES.drag_coefficient * PROPERTIES.area_to_mass * 7.5 * 7.5));
+		return result;
+	}
+
+	void setActivity(OPI::PerturbationModule* module, double f107)
+	{
+		module->setProperty("f107", f107);
+		module->setProperty("f107_average", f107);
+		module->setProperty("kp", 0.0);
+	}
+
+	// for Kp = 0 the exospheric temperature at night is 379 K + 3.24 K * F10.7 (+ 0.03 K)
+	double fluxForTemperature(double temperature)
+	{
+		return (temperature - 379.0 - 0.03) / 3.24;
+	}
+
+	void testDensity(OPI::PerturbationModule* module)
+	{
+		module->setProperty("drag", 1);
+		module->setProperty("srp", 0);
+		module->setProperty("diurnal_variation", 0);
+		setActivity(module, fluxForTemperature(1000.0));
+		// US Standard Atmosphere 1976, which has an exospheric temperature of 1000 K; the
+		// temperature profile of the module is shaped differently between 120 km and the exosphere
+		const std::vector<double> altitudes = { 150.0, 200.0, 300.0, 400.0, 500.0, 600.0, 800.0, 1000.0 };
+		const double reference[] = { 2.076e-9, 2.541e-10, 1.916e-11, 2.803e-12, 5.215e-13, 1.137e-13, 1.136e-14, 3.561e-15 };
+		const std::vector<double> density = densities(module, altitudes, 0.0);
+		for(size_t i = 0; i < altitudes.size(); ++i)
+			OPI_CHECK_CLOSE(density[i] / reference[i], 1.0, 0.25);
+		// without an atmosphere above the table
+		OPI_CHECK(densities(module, std::vector<double>(1, 3000.0), 0.0)[0] == 0.0);
+	}
+
+	// the exospheric temperature is 1.3 times the night value at the peak of the diurnal bulge
+	void testDiurnalVariation(OPI::PerturbationModule* module)
+	{
+		const std::vector<double> altitude(1, 500.0);
+		module->setProperty("diurnal_variation", 0);
+		setActivity(module, fluxForTemperature(1300.0));
+		const double hot = densities(module, altitude, 0.0)[0];
+		setActivity(module, fluxForTemperature(1000.0));
+		const double cold = densities(module, altitude, 0.0)[0];
+
+		module->setProperty("diurnal_variation", 1);
+		// near an equinox, the bulge is centered on the equator about 31 degrees east of the sun
+		const OPI::Vector3 sun = sunPosition(JD);
+		const double sunLongitude = std::atan2(sun.y, sun.x);
+		const double day = densities(module, altitude, sunLongitude + 31.2 * DEGREES)[0];
+		const double night = densities(module, altitude, sunLongitude + 211.2 * DEGREES)[0];
+		OPI_CHECK_CLOSE(day / hot, 1.0, 0.02);
+		OPI_CHECK_CLOSE(night / cold, 1.0, 0.02);
+		// the density at noon is between the two
+		const double noon = densities(module, altitude, sunLongitude)[0];
+		OPI_CHECK(noon > cold && noon < day);
+
+		// away from the equator the peak temperature is T_night * (1 + 0.3 cos^2.2(eta)) with
+		// eta = |latitude - declination| / 2
+		const double latitude = 60.0 * DEGREES;
+		const double eta = 0.5 * std::fabs(latitude - std::asin(sun.z / norm(sun)));
+		const double peak = 999.97 * (1.0 + 0.3 * std::pow(std::cos(eta), 2.2)) + 0.03;
+		const double north = densities(module, altitude, sunLongitude + 31.2 * DEGREES, latitude)[0];
+		module->setProperty("diurnal_variation", 0);
+		setActivity(module, fluxForTemperature(peak));
+		OPI_CHECK_CLOSE(north / densities(module, altitude, 0.0, latitude)[0], 1.0, 0.01);
+	}
+
+	void testDrag(OPI::PerturbationModule* module)
+	{
+		module->setProperty("drag", 1);
+		module->setProperty("srp", 0);
+		module->setProperty("diurnal_variation", 0);
+		setActivity(module, 150.0);
+		const double altitude = 400.0;
+		const double density = densities(module, std::vector<double>(1, altitude), 0.0)[0];
+
+		// an inclined orbit crossing the equator, the atmosphere rotates with the Earth
+		const double r = EARTH_RADIUS + altitude;
+		const std::vector<OPI::Vector3> position(1, OPI::Vector3(0.0, r, 0.0));
+		const std::vector<OPI::Vector3> velocity(1, OPI::Vector3(-5.0, 0.3, 5.0));
+		const OPI::Vector3 relative(-5.0 + EARTH_ROTATION * r, 0.3, 5.0);
+		const OPI::Vector3 a = accelerations(module, position, velocity, PROPERTIES)[0];
+		const double speed = norm(relative);
+		const double expected = 0.5e3 * density * PROPERTIES.drag_coefficient * PROPERTIES.area_to_mass * speed * speed;
+		OPI_CHECK_CLOSE(norm(a) / expected, 1.0, 1e-9);
+		// opposite to the velocity relative to the atmosphere
+		OPI_CHECK_CLOSE((a.x * relative.x + a.y * relative.y + a.z * relative.z) / (norm(a) * speed), -1.0, 1e-12);
+	}
+
+	void testRadiationPressure(OPI::PerturbationModule* module)
+	{
+		module->setProperty("drag", 0);
+		module->setProperty("srp", 1);
+		module->setProperty("shadow_model", std::string("conical"));
+		const OPI::Vector3 sun = sunPosition(JD);
+		const OPI::Vector3 sunDirection = sun / norm(sun);
+		const OPI::Vector3 perpendicular = OPI::Vector3(-sunDirection.y, sunDirection.x, 0.0) / std::sqrt(sunDirection.x * sunDirection.x + sunDirection.y * sunDirection.y);
+		const double r = 7000.0;
+		// the apparent radius of the Earth, an object behind the Earth at this angle from the
+		// anti-sun direction sees the sun half covered by the limb
+		const double limb = std::asin(EARTH_RADIUS / r);
+		std::vector<OPI::Vector3> position;
+		position.push_back(sunDirection * r);
+		position.push_back(sunDirection * -r);
+		position.push_back(sunDirection * (-r * std::cos(limb)) + perpendicular * (r * std::sin(limb)));
+		position.push_back(sunDirection * (-r * std::cos(limb - 1.0 * DEGREES)) + perpendicular * (r * std::sin(limb - 1.0 * DEGREES)));
+		position.push_back(sunDirection * (-r * std::cos(limb + 0.2 * DEGREES)) + perpendicular * (r * std::sin(limb + 0.2 * DEGREES)));
+		const std::vector<OPI::Vector3> velocity(position.size(), OPI::Vector3(0.0, 0.0, 0.0));
+		std::vector<OPI::Vector3> a = accelerations(module, position, velocity, PROPERTIES);
+
+		// sunlit: 4.56e-6 N/m^2 at 1 AU, away from the sun
+		const OPI::Vector3 away = position[0] - sun;
+		const double distance = norm(away) / 149597870.7;
+		const double expected = 1e-3 * 4.56e-6 / (distance * distance) * PROPERTIES.reflectivity * PROPERTIES.area_to_mass;
+		OPI_CHECK_CLOSE(norm(a[0]) / expected, 1.0, 1e-9);
+		OPI_CHECK_CLOSE((a[0].x * away.x + a[0].y * away.y + a[0].z * away.z) / (norm(a[0]) * norm(away)), 1.0, 1e-12);
+		// umbra
+		OPI_CHECK(norm(a[1]) == 0.0);
+		OPI_CHECK(norm(a[3]) == 0.0);
+		// penumbra: about half of the solar disc is visible
+		const double fraction = norm(a[2]) / expected;
+		OPI_CHECK(fraction > 0.4 && fraction < 0.6);
+		const double outerFraction = norm(a[4]) / expected;
+		OPI_CHECK(outerFraction > fraction && outerFraction < 1.0);
+
+		// the cylindrical model has no penumbra
+		module->setProperty("shadow_model", std::string("cylindrical"));
+		a = accelerations(module, position, velocity, PROPERTIES);
+		OPI_CHECK(norm(a[1]) == 0.0);
+		OPI_CHECK(norm(a[3]) == 0.0);
+		OPI_CHECK_CLOSE(norm(a[4]) / expected, 1.0, 1e-3);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	host.loadPlugins(OPI_TEST_PLUGIN_DIR);
+	OPI::PerturbationModule* module = host.getPerturbationModule("DragSRPCPP");
+	OPI_CHECK(module != 0);
+	if(module)
+	{
+		testDensity(module);
+		testDiurnalVariation(module);
+		testDrag(module);
+		testRadiationPressure(module);
+	}
+	return OPI_TEST_RESULT("TestDragSRP");
+}
@@ -0,0 +1,273 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Interpolation of a source propagator by the ephemeris cache.
+namespace
+{
+	const double BEGIN = 2451545.0;
+
+	// two-body motion from the orbit column, with exact velocities
+	class KeplerPropagator: public OPI::Propagator
+	{
+		public:
+			KeplerPropagator()
+			{
+				setName("Kepler");
+			}
+
+			bool cartesianCoordinates()
+			{
+				return true;
+			}
+
+		protected:
+			OPI::ErrorCode runPropagation(OPI::Population& data, double julian_day, double dt)
+			{
+				OPI::Orbit* orbits = data.getOrbit();
+				for(int i = 0; i < data.getSize(); ++i)
+					orbits[i].mean_anomaly += OPI::getMeanMotion(orbits[i].semi_major_axis) * dt;
+				convertElementsToState(orbits, data.getPosition(OPI::DEVICE_HOST, true), data.getVelocity(OPI::DEVICE_HOST, true), data.getSize());
+				data.update(OPI::DATA_ORBIT);
+				data.update(OPI::DATA_CARTESIAN);
+				data.update(OPI::DATA_VELOCITY);
+				return OPI::SUCCESS;
+			}
+
+			int requiresCUDA()
+			{
+				return 0;
+			}
+	};
+
+	void fill(OPI::Population& population)
+	{
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			population.getOrbit()[i] = OPI::Orbit(6800.0 + 25.0 * i, 0.002 * (i % 10), 0.05 * i, 0.1 * i, 0.2 * i, 0.3 * i, 0.0, 0.0);
+			population.getObjectProperties()[i].id = i + 1;
+		}
+		population.update(OPI::DATA_ORBIT);
+		population.update(OPI::DATA_PROPERTIES);
+	}
+
+	// the analytic states of all objects seconds after BEGIN
+	void expected(const OPI::Population& initial, double seconds, std::vector<OPI::Vector3>& position, std::vector<OPI::Vector3>& velocity)
+	{
+		std::vector<OPI::Orbit> orbits(initial.getOrbit(), initial.getOrbit() + initial.getSize());
+		for(size_t i = 0; i < orbits.size(); ++i)
+			orbits[i].mean_anomaly += OPI::getMeanMotion(orbits[i].semi_major_axis) * seconds;
+		position.resize(orbits.size());
+		velocity.resize(orbits.size());
+		OPI::convertElementsToState(orbits.data(), position.data(), velocity.data(), static_cast<int>(orbits.size()));
+	}
+
+	double distance(const OPI::Vector3& a, const OPI::Vector3& b)
+	{
+		const OPI::Vector3 d = a - b;
+		return std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+	}
+
+	// largest position and velocity errors of the cache at times spread over all segments
+	void maxError(const OPI::EphemerisCache& cache, const OPI::Population& initial, double& positionError, double& velocityError)
+	{
+		const int objects = initial.getSize();
+		std::vector<OPI::Vector3> position(objects), velocity(objects), truePosition, trueVelocity;
+		positionError = 0.0;
+		velocityError = 0.0;
+		const double window = (cache.getEnd() - cache.getBegin()) * 86400.0;
+		for(double seconds = 0.0; seconds <= window; seconds += 97.3)
+		{
+			const double jd = BEGIN + seconds / 86400.0;
+			OPI_CHECK(cache.getStateAt(jd, position.data(), velocity.data()) == OPI::SUCCESS);
+			// Julian dates resolve about 40 microseconds, so the reference is taken at the rounded time
+			expected(initial, (jd - BEGIN) * 86400.0, truePosition, trueVelocity);
+			for(int i = 0; i < objects; ++i)
+			{
+				positionError = std::max(positionError, distance(position[i], truePosition[i]));
+				velocityError = std::max(velocityError, distance(velocity[i], trueVelocity[i]));
+			}
+		}
+	}
+
+	void testAccuracy(OPI::Host& host, OPI::Propagator& source)
+	{
+		OPI::Population population(host, 50);
+		fill(population);
+		OPI::EphemerisCache* cache = host.createEphemerisCache("AccuracyCache");
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 0.25, 120.0) == OPI::SUCCESS);
+		OPI_CHECK(cache->getObjectCount() == 50);
+		OPI_CHECK_CLOSE(cache->getBegin(), BEGIN, 0.0);
+		// the window is covered by whole segments of four steps
+		OPI_CHECK_CLOSE(cache->getEnd(), BEGIN + 0.25, 1e-9);
+		OPI::EphemerisCache* partial = host.createEphemerisCache("PartialCache");
+		OPI_CHECK(partial->build(source, population, BEGIN, BEGIN + 0.01, 120.0) == OPI::SUCCESS);
+		OPI_CHECK_CLOSE(partial->getEnd(), BEGIN + 2 * 480.0 / 86400.0, 1e-9);
+		// the source Population is not propagated
+		OPI_CHECK(population.getOrbit()[1].mean_anomaly == 0.3);
+
+		double positionError, velocityError;
+		maxError(*cache, population, positionError, velocityError);
+		std::cout << "maximum position error: " << positionError << " km, velocity error: " << velocityError << " km/s" << std::endl;
+		OPI_CHECK(positionError < 1e-6);
+		OPI_CHECK(velocityError < 1e-8);
+
+		// one step with degree 3 is cubic Hermite interpolation
+		OPI_CHECK(cache->setSegments(1, 3) == OPI::SUCCESS);
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 0.25, 30.0) == OPI::SUCCESS);
+		maxError(*cache, population, positionError, velocityError);
+		std::cout << "cubic Hermite position error: " << positionError << " km" << std::endl;
+		OPI_CHECK(positionError < 1e-4);
+
+		OPI_CHECK(cache->setSegments(0, 1) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(cache->setSegments(2, 6) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN, 60.0) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 1.0, 0.0) == OPI::INVALID_ARGUMENT);
+	}
+
+	void testStateAt(OPI::Host& host, OPI::Propagator& source)
+	{
+		OPI::Population population(host, 20);
+		fill(population);
+		OPI::EphemerisCache* cache = host.createEphemerisCache("StateCache");
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 0.1, 60.0) == OPI::SUCCESS);
+		const double jd = BEGIN + 0.0371;
+		std::vector<OPI::Vector3> position(20), velocity(20);
+		OPI_CHECK(cache->getStateAt(jd, position.data(), velocity.data()) == OPI::SUCCESS);
+
+		OPI::IndexList indices(host);
+		indices.add(17);
+		indices.add(0);
+		indices.add(5);
+		OPI::Vector3 listed[3], listedVelocity[3];
+		OPI_CHECK(cache->getStateAt(jd, indices, listed, listedVelocity) == OPI::SUCCESS);
+		OPI_CHECK(distance(listed[0], position[17]) == 0.0 && distance(listedVelocity[0], velocity[17]) == 0.0);
+		OPI_CHECK(distance(listed[1], position[0]) == 0.0 && distance(listedVelocity[1], velocity[0]) == 0.0);
+		OPI_CHECK(distance(listed[2], position[5]) == 0.0 && distance(listedVelocity[2], velocity[5]) == 0.0);
+		// velocities are optional
+		OPI_CHECK(cache->getStateAt(jd, indices, listed) == OPI::SUCCESS);
+		OPI_CHECK(distance(listed[2], position[5]) == 0.0);
+
+		indices.add(20);
+		OPI_CHECK(cache->getStateAt(jd, indices, listed, listedVelocity) == OPI::INDEX_RANGE);
+
+		// times outside of the window
+		OPI_CHECK(cache->getStateAt(BEGIN - 0.01, position.data()) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(cache->getStateAt(cache->getEnd() + 0.01, position.data()) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(cache->getStateAt(cache->getEnd(), position.data()) == OPI::SUCCESS);
+		OPI::IndexList valid(host);
+		valid.add(3);
+		OPI_CHECK(cache->getStateAt(BEGIN - 0.01, valid, listed) == OPI::INVALID_ARGUMENT);
+	}
+
+	void testPropagate(OPI::Host& host, OPI::Propagator& source)
+	{
+		OPI::Population population(host, 20);
+		fill(population);
+		OPI::EphemerisCache* cache = host.createEphemerisCache("PropagationCache");
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 0.1, 60.0) == OPI::SUCCESS);
+
+		// the Population receives the same states as getStateAt()
+		OPI::Population propagated(population);
+		std::vector<OPI::Vector3> position(20), velocity(20);
+		OPI_CHECK(cache->propagate(propagated, BEGIN + 0.05, 0.0) == OPI::SUCCESS);
+		OPI_CHECK(cache->getStateAt(BEGIN + 0.05, position.data(), velocity.data()) == OPI::SUCCESS);
+		bool equal = true;
+		for(int i = 0; i < 20; ++i)
+			equal = equal && distance(propagated.getPosition()[i], position[i]) < 1e-9 && distance(propagated.getVelocity()[i], velocity[i]) < 1e-12;
+		OPI_CHECK(equal);
+
+		// every object at its own time
+		std::vector<double> jds(20);
+		for(int i = 0; i < 20; ++i)
+			jds[i] = BEGIN + 0.004 * i;
+		OPI_CHECK(cache->propagate(propagated, jds.data(), 20, 0.0) == OPI::SUCCESS);
+		equal = true;
+		for(int i = 0; i < 20; ++i)
+		{
+			OPI::IndexList index(host);
+			index.add(i);
+			OPI::Vector3 r, v;
+			OPI_CHECK(cache->getStateAt(jds[i], index, &r, &v) == OPI::SUCCESS);
+			equal = equal && distance(propagated.getPosition()[i], r) < 1e-9 && distance(propagated.getVelocity()[i], v) < 1e-12;
+		}
+		OPI_CHECK(equal);
+
+		// times outside of the window and Populations that do not match the cache
+		OPI_CHECK(cache->propagate(propagated, cache->getEnd(), 60.0) == OPI::INVALID_ARGUMENT);
+		jds[7] = BEGIN - 1.0;
+		OPI_CHECK(cache->propagate(propagated, jds.data(), 20, 0.0) == OPI::INVALID_ARGUMENT);
+		OPI::Population smaller(host, 10);
+		fill(smaller);
+		OPI_CHECK(cache->propagate(smaller, BEGIN, 0.0) == OPI::INVALID_ARGUMENT);
+	}
+	// trajectories are evaluated object by object and match the states at every time
+	void testTrajectory(OPI::Host& host, OPI::Propagator& source)
+	{
+		const int objects = 20;
+		OPI::Population population(host, objects);
+		fill(population);
+		OPI::EphemerisCache* cache = host.createEphemerisCache("TrajectoryCache");
+		OPI_CHECK(cache->build(source, population, BEGIN, BEGIN + 0.1, 60.0) == OPI::SUCCESS);
+		std::vector<double> times;
+		for(int t = 0; t < 11; ++t)
+			times.push_back(BEGIN + 0.0093 * t);
+		const int length = static_cast<int>(times.size());
+		OPI::TrajectoryBuffer trajectory(host, objects, length);
+		OPI_CHECK(cache->propagateTrajectory(population, times.data(), length, trajectory) == OPI::SUCCESS);
+
+		std::vector<OPI::Vector3> position(objects), velocity(objects);
+		bool equal = true;
+		for(int t = 0; t < length; ++t)
+		{
+			OPI_CHECK(cache->getStateAt(times[t], position.data(), velocity.data()) == OPI::SUCCESS);
+			for(int i = 0; i < objects; ++i)
+			{
+				equal = equal && distance(trajectory.getPosition()[i * length + t], position[i]) < 1e-9;
+				equal = equal && distance(trajectory.getVelocity()[i * length + t], velocity[i]) < 1e-12;
+			}
+		}
+		OPI_CHECK(equal);
+		// the Population ends at the last time
+		equal = true;
+		for(int i = 0; i < objects; ++i)
+			equal = equal && distance(population.getPosition()[i], position[i]) == 0.0 && distance(population.getVelocity()[i], velocity[i]) == 0.0;
+		OPI_CHECK(equal);
+
+		times.back() = cache->getEnd() + 0.01;
+		OPI_CHECK(cache->propagateTrajectory(population, times.data(), length, trajectory) == OPI::INVALID_ARGUMENT);
+		OPI::Population smaller(host, objects - 1);
+		fill(smaller);
+		OPI::TrajectoryBuffer smallerTrajectory(host, objects - 1, length);
+		OPI_CHECK(cache->propagateTrajectory(smaller, times.data(), length, smallerTrajectory) == OPI::INVALID_ARGUMENT);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	KeplerPropagator* source = new KeplerPropagator();
+	host.addPropagator(source);
+	testAccuracy(host, *source);
+	testStateAt(host, *source);
+	testPropagate(host, *source);
+	testTrajectory(host, *source);
+	return OPI_TEST_RESULT("TestEphemerisCache");
+}
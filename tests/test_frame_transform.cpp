@@ -0,0 +1,176 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Batched reference frame transformations against per-object transformations.
+namespace
+{
+	double distance(const OPI::Vector3& a, const OPI::Vector3& b)
+	{
+		const OPI::Vector3 d = a - b;
+		return std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+	}
+
+	void makeStates(std::vector<OPI::Vector3>& position, std::vector<OPI::Vector3>& velocity, int count)
+	{
+		position.resize(count);
+		velocity.resize(count);
+		for(int i = 0; i < count; ++i)
+		{
+			const double angle = 0.37 * i;
+			position[i] = OPI::Vector3(7000.0 * std::cos(angle), 7000.0 * std::sin(angle) * 0.6, 7000.0 * std::sin(angle) * 0.8);
+			velocity[i] = OPI::Vector3(-7.5 * std::sin(angle), 7.5 * std::cos(angle) * 0.6, 7.5 * std::cos(angle) * 0.8);
+		}
+	}
+
+	// transforms the states with individual epochs in one call and object by object
+	void compare(OPI::FrameTransform& transform, const std::vector<double>& epochs, OPI::ReferenceFrame from, OPI::ReferenceFrame to, double& positionError, double& velocityError)
+	{
+		const int count = static_cast<int>(epochs.size());
+		std::vector<OPI::Vector3> position, velocity, expectedPosition, expectedVelocity;
+		makeStates(position, velocity, count);
+		expectedPosition = position;
+		expectedVelocity = velocity;
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), epochs.data(), count, from, to) == OPI::SUCCESS);
+		positionError = 0.0;
+		velocityError = 0.0;
+		for(int i = 0; i < count; ++i)
+		{
+			OPI_CHECK(transform.transform(&expectedPosition[i], &expectedVelocity[i], 1, from, to, epochs[i]) == OPI::SUCCESS);
+			positionError = std::max(positionError, distance(position[i], expectedPosition[i]));
+			velocityError = std::max(velocityError, distance(velocity[i], expectedVelocity[i]));
+		}
+	}
+
+	void testIndividualEpochs(OPI::Host& host)
+	{
+		OPI::FrameTransform transform(host);
+		// the start of a 60 s bin
+		const double start = std::floor(2458849.5 * 1440.0) / 1440.0;
+		const OPI::ReferenceFrame frames[][2] = {
+			{ OPI::REF_TEME, OPI::REF_ITRF }, { OPI::REF_ITRF, OPI::REF_GCRF }, { OPI::REF_GCRF, OPI::REF_TOD }
+		};
+		for(int f = 0; f < 3; ++f)
+		{
+			// 40 distinct epochs 0.5 to 1 s apart in the same bin
+			std::vector<double> epochs;
+			double seconds = 0.25;
+			for(int i = 0; i < 40; ++i)
+			{
+				epochs.push_back(start + seconds / 86400.0);
+				seconds += (i % 2) ? 0.5 : 1.0;
+			}
+			double positionError, velocityError;
+			compare(transform, epochs, frames[f][0], frames[f][1], positionError, velocityError);
+			OPI_CHECK(positionError < 1e-6);
+			OPI_CHECK(velocityError < 1e-9);
+
+			// short runs followed by a long run of one epoch in the same bin
+			epochs.resize(10);
+			epochs.insert(epochs.end(), 30, start + 50.0 / 86400.0);
+			epochs.push_back(start + 55.0 / 86400.0);
+			compare(transform, epochs, frames[f][0], frames[f][1], positionError, velocityError);
+			OPI_CHECK(positionError < 1e-6);
+			OPI_CHECK(velocityError < 1e-9);
+
+			// many bins
+			epochs.clear();
+			for(int i = 0; i < 5000; ++i)
+				epochs.push_back(start + 0.01 * (i / 7));
+			compare(transform, epochs, frames[f][0], frames[f][1], positionError, velocityError);
+			OPI_CHECK(positionError < 1e-6);
+			OPI_CHECK(velocityError < 1e-9);
+		}
+	}
+
+	void testRoundTrip(OPI::Host& host)
+	{
+		OPI::FrameTransform transform(host);
+		std::vector<OPI::Vector3> position, velocity;
+		makeStates(position, velocity, 100);
+		const std::vector<OPI::Vector3> original = position;
+		const std::vector<OPI::Vector3> originalVelocity = velocity;
+		const double epoch = 2458849.5 + 0.123;
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), 100, OPI::REF_GCRF, OPI::REF_ITRF, epoch) == OPI::SUCCESS);
+		OPI_CHECK(distance(position[0], original[0]) > 100.0);
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), 100, OPI::REF_ITRF, OPI::REF_TEME, epoch) == OPI::SUCCESS);
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), 100, OPI::REF_TEME, OPI::REF_GCRF, epoch) == OPI::SUCCESS);
+		double positionError = 0.0, velocityError = 0.0;
+		for(int i = 0; i < 100; ++i)
+		{
+			positionError = std::max(positionError, distance(position[i], original[i]));
+			velocityError = std::max(velocityError, distance(velocity[i], originalVelocity[i]));
+		}
+		OPI_CHECK(positionError < 1e-8);
+		OPI_CHECK(velocityError < 1e-11);
+
+		// the rotation is orthonormal
+		double rotation[9];
+		OPI_CHECK(transform.getRotation(OPI::REF_J2000, OPI::REF_ITRF, epoch, rotation) == OPI::SUCCESS);
+		double orthogonality = 0.0;
+		for(int i = 0; i < 3; ++i)
+			for(int j = 0; j < 3; ++j)
+			{
+				const double dot = rotation[i * 3] * rotation[j * 3] + rotation[i * 3 + 1] * rotation[j * 3 + 1] + rotation[i * 3 + 2] * rotation[j * 3 + 2];
+				orthogonality = std::max(orthogonality, std::fabs(dot - (i == j ? 1.0 : 0.0)));
+			}
+		OPI_CHECK(orthogonality < 1e-14);
+
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), 100, OPI::REF_NONE, OPI::REF_ITRF, epoch) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), 100, OPI::REF_GCRF, OPI::REF_ITRF, std::nan("")) == OPI::INVALID_ARGUMENT);
+	}
+
+	void testPopulation(OPI::Host& host)
+	{
+		OPI::FrameTransform transform(host);
+		OPI::Population population(host, 500);
+		std::vector<OPI::Vector3> position, velocity;
+		makeStates(position, velocity, population.getSize());
+		std::vector<double> epochs(population.getSize());
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			epochs[i] = 2458849.5 + 0.37 * i / 1440.0;
+			population.getPosition()[i] = position[i];
+			population.getVelocity()[i] = velocity[i];
+			population.getEpoch()[i] = OPI::Epoch(epochs[i], epochs[i]);
+		}
+		population.update(OPI::DATA_CARTESIAN);
+		population.update(OPI::DATA_VELOCITY);
+		population.update(OPI::DATA_EPOCH);
+		OPI_CHECK(transform.transform(population, OPI::REF_TEME, OPI::REF_ITRF) == OPI::SUCCESS);
+		OPI_CHECK(transform.transform(position.data(), velocity.data(), epochs.data(), population.getSize(), OPI::REF_TEME, OPI::REF_ITRF) == OPI::SUCCESS);
+		bool same = true;
+		for(int i = 0; i < population.getSize(); ++i)
+			same = same && distance(population.getPosition()[i], position[i]) == 0.0 && distance(population.getVelocity()[i], velocity[i]) == 0.0;
+		OPI_CHECK(same);
+
+		OPI::Population empty(host, 10);
+		OPI_CHECK(transform.transform(empty, OPI::REF_TEME, OPI::REF_ITRF) == OPI::INVALID_TYPE);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testIndividualEpochs(host);
+	testRoundTrip(host);
+	testPopulation(host);
+	return OPI_TEST_RESULT("TestFrameTransform");
+}
@@ -0,0 +1,141 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Gravity field accelerations of the GeopotentialCPP module.
+namespace
+{
+	const double MU = 398600.4415;
+	const double RADIUS = 6378.1363;
+	// J2 of the EGM96 field, -sqrt(5) times the normalized C(2,0)
+	const double J2 = 2.2360679774997897 * 0.484165371736e-03;
+	const double JD = 2451545.0 + 80.0;
+
+	double norm(const OPI::Vector3& v)
+	{
+		return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+	}
+
+	// returns the accelerations of the module for the given positions
+	std::vector<OPI::Vector3> accelerations(OPI::PerturbationModule* module, const std::vector<OPI::Vector3>& position)
+	{
+		const int count = static_cast<int>(position.size());
+		std::vector<OPI::Vector3> velocity(count, OPI::Vector3(0.0, 0.0, 0.0));
+		std::vector<double> times(count, JD);
+		std::vector<OPI::ObjectProperties> objects(count);
+		std::vector<OPI::Vector3> result(count, OPI::Vector3(0.0, 0.0, 0.0));
+		OPI::StateBatch batch;
+		batch.count = count;
+		batch.position = position.data();
+		batch.velocity = velocity.data();
+		batch.julian_day = times.data();
+		batch.properties = objects.data();
+		batch.acceleration = result.data();
+		OPI_CHECK(module->setTimeStep(JD) == OPI::SUCCESS);
+		OPI_CHECK(module->calculateAcceleration(batch) == OPI::SUCCESS);
+		return result;
+	}
+
+	// positions at the given radius spread over all latitudes and longitudes; more than one
+	// batch of lanes so the unused lanes of the last batch are covered as well
+	std::vector<OPI::Vector3> positions(double radius)
+	{
+		std::vector<OPI::Vector3> result;
+		for(int i = 0; i < 11; ++i)
+		{
+			const double latitude = -1.5 + 0.3 * i;
+			const double longitude = 0.7 * i;
+			result.push_back(OPI::Vector3(std::cos(latitude) * std::cos(longitude), std::cos(latitude) * std::sin(longitude), std::sin(latitude)) * radius);
+		}
+		return result;
+	}
+
+	// the zonal degree 2 field must match the analytic J2 acceleration
+	void testJ2(OPI::PerturbationModule* module)
+	{
+		module->setProperty("degree", 2);
+		module->setProperty("order", 0);
+		const double radii[] = { 6678.0, 7000.0, 12000.0, 42164.0 };
+		for(int k = 0; k < 4; ++k)
+		{
+			const std::vector<OPI::Vector3> position = positions(radii[k]);
+			const std::vector<OPI::Vector3> a = accelerations(module, position);
+			for(size_t i = 0; i < a.size(); ++i)
+			{
+				const OPI::Vector3& p = position[i];
+				const double r = norm(p);
+				const double factor = -1.5 * J2 * MU * RADIUS * RADIUS / std::pow(r, 5.0);
+				const double z2 = 5.0 * p.z * p.z / (r * r);
+				const OPI::Vector3 expected(factor * p.x * (1.0 - z2), factor * p.y * (1.0 - z2), factor * p.z * (3.0 - z2));
+				const double scale = std::fabs(factor) * r;
+				OPI_CHECK_CLOSE(a[i].x, expected.x, 1e-10 * scale);
+				OPI_CHECK_CLOSE(a[i].y, expected.y, 1e-10 * scale);
+				OPI_CHECK_CLOSE(a[i].z, expected.z, 1e-10 * scale);
+			}
+		}
+	}
+
+	// far from the Earth the field up to degree 6 approaches the degree 2 field, which in
+	// turn vanishes relative to the central acceleration with (R / r)^2
+	void testFarField(OPI::PerturbationModule* module)
+	{
+		const double radii[] = { 2.0 * RADIUS, 10.0 * RADIUS, 100.0 * RADIUS };
+		double previous = 1.0;
+		for(int k = 0; k < 3; ++k)
+		{
+			const double r = radii[k];
+			const std::vector<OPI::Vector3> position = positions(r);
+			module->setProperty("degree", 2);
+			module->setProperty("order", 2);
+			const std::vector<OPI::Vector3> degree2 = accelerations(module, position);
+			module->setProperty("degree", 6);
+			module->setProperty("order", 6);
+			const std::vector<OPI::Vector3> full = accelerations(module, position);
+			const double central = MU / (r * r);
+			const double bound = 3.0 * J2 * RADIUS * RADIUS / (r * r);
+			double difference = 0.0;
+			for(size_t i = 0; i < full.size(); ++i)
+			{
+				OPI_CHECK(norm(full[i]) / central < 1.01 * bound);
+				const OPI::Vector3 d = full[i] - degree2[i];
+				difference = std::max(difference, norm(d) / norm(degree2[i]));
+			}
+			// the remaining terms fall off at least with another factor R / r
+			OPI_CHECK(difference < 0.02 * RADIUS / r);
+			OPI_CHECK(difference < previous);
+			previous = difference;
+		}
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	host.loadPlugins(OPI_TEST_PLUGIN_DIR);
+	OPI::PerturbationModule* module = host.getPerturbationModule("GeopotentialCPP");
+	OPI_CHECK(module != 0);
+	if(module)
+	{
+		testJ2(module);
+		testFarField(module);
+	}
+	return OPI_TEST_RESULT("TestGeopotential");
+}
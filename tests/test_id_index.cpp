@@ -0,0 +1,175 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <thread>
+#include <vector>
+
+// Id lookups and id-based merging of catalogs.
+namespace
+{
+	// creates a Population whose object i has the id ids[i] and a semi-major axis of 7000 + i
+	void assign(OPI::Population& population, const std::vector<int>& ids)
+	{
+		population.resize(static_cast<int>(ids.size()));
+		for(size_t i = 0; i < ids.size(); ++i)
+		{
+			population.getObjectProperties()[i] = OPI::ObjectProperties(1.0, 1.0, 0.01, 2.2, 1.3, ids[i]);
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+		}
+		population.update(OPI::DATA_PROPERTIES);
+		population.update(OPI::DATA_ORBIT);
+	}
+
+	void testFindById(OPI::Host& host, bool indexed)
+	{
+		OPI::Population population(host);
+		population.setIdIndexEnabled(indexed);
+		OPI_CHECK(population.isIdIndexEnabled() == indexed);
+		std::vector<int> ids;
+		for(int i = 0; i < 10000; ++i)
+			ids.push_back(i * 7 - 3000);
+		// a duplicate id resolves to the lowest index
+		ids[500] = ids[9000];
+		assign(population, ids);
+
+		bool found = true;
+		for(int i = 0; i < 10000; ++i)
+		{
+			if(i != 9000 && population.findById(ids[i]) != i)
+				found = false;
+		}
+		OPI_CHECK(found);
+		OPI_CHECK(population.findById(ids[9000]) == 500);
+		OPI_CHECK(population.findById(1) == -1);
+
+		int query[] = { ids[3], 123456, ids[42] };
+		OPI::IndexList result(host);
+		OPI_CHECK(population.findByIds(query, 3, result) == 2);
+		OPI_CHECK(result.getSize() == 3);
+		OPI_CHECK(result.getData(OPI::DEVICE_HOST)[0] == 3);
+		OPI_CHECK(result.getData(OPI::DEVICE_HOST)[1] == -1);
+		OPI_CHECK(result.getData(OPI::DEVICE_HOST)[2] == 42);
+
+		// changed ids and indices are picked up after update() and remove()
+		population.getObjectProperties()[3].id = 123456;
+		population.update(OPI::DATA_PROPERTIES);
+		OPI_CHECK(population.findById(123456) == 3);
+		OPI_CHECK(population.findById(ids[3]) == -1);
+		population.remove(0);
+		OPI_CHECK(population.findById(123456) == 2);
+	}
+
+	// the first lookups after a change rebuild the index of a const Population concurrently
+	void testConcurrentLookup(OPI::Host& host)
+	{
+		OPI::Population population(host);
+		population.setIdIndexEnabled(true);
+		std::vector<int> ids;
+		for(int i = 0; i < 100000; ++i)
+			ids.push_back(3 * i + 1);
+		assign(population, ids);
+		for(int round = 0; round < 4; ++round)
+		{
+			population.getObjectProperties()[round].id = -round - 1;
+			population.update(OPI::DATA_PROPERTIES);
+			const OPI::Population& lookup = population;
+			std::vector<int> missed(4, 0);
+			std::vector<std::thread> threads;
+			for(int t = 0; t < 4; ++t)
+			{
+				threads.push_back(std::thread([&lookup, &ids, &missed, round, t]() {
+					if(lookup.findById(-round - 1) != round)
+						missed[t]++;
+					for(size_t i = round + 1 + t; i < ids.size(); i += 4)
+					{
+						if(lookup.findById(ids[i]) != static_cast<int>(i))
+							missed[t]++;
+					}
+				}));
+			}
+			for(size_t t = 0; t < threads.size(); ++t)
+				threads[t].join();
+			for(int t = 0; t < 4; ++t)
+				OPI_CHECK(missed[t] == 0);
+		}
+	}
+
+	void testMerge(OPI::Host& host)
+	{
+		OPI::Population catalog(host);
+		assign(catalog, std::vector<int>{ 10, 20, 30, 40 });
+		catalog.setObjectName(1, "twenty");
+
+		// 20 changes, 30 is unchanged, 50 is new, 10 and 40 are missing
+		OPI::Population update(host);
+		assign(update, std::vector<int>{ 30, 20, 50 });
+		update.getOrbit()[0].semi_major_axis = 7002.0;
+		update.getOrbit()[1].semi_major_axis = 8000.0;
+		update.update(OPI::DATA_ORBIT);
+		update.setObjectName(2, "fifty");
+
+		OPI::Population updated(catalog);
+		std::vector<OPI::IndexRange> touched;
+		OPI_CHECK(updated.merge(update, OPI::MERGE_UPDATE, &touched) == OPI::SUCCESS);
+		OPI_CHECK(updated.getSize() == 4);
+		OPI_CHECK(updated.getOrbit()[1].semi_major_axis == 8000.0);
+		OPI_CHECK(updated.getObjectName(1) == "twenty");
+		OPI_CHECK(touched.size() == 1 && touched[0].first == 1 && touched[0].count == 1);
+		// the source of the copy is not modified
+		OPI_CHECK(catalog.getOrbit()[1].semi_major_axis == 7001.0);
+
+		OPI::Population upserted(catalog);
+		OPI_CHECK(upserted.merge(update, OPI::MERGE_UPSERT, &touched) == OPI::SUCCESS);
+		OPI_CHECK(upserted.getSize() == 5);
+		OPI_CHECK(upserted.getObjectProperties()[4].id == 50);
+		OPI_CHECK(upserted.getOrbit()[4].semi_major_axis == 7002.0);
+		OPI_CHECK(upserted.getObjectName(4) == "fifty");
+		OPI_CHECK(touched.size() == 2);
+		OPI_CHECK(touched.size() == 2 && touched[0].first == 1 && touched[0].count == 1);
+		OPI_CHECK(touched.size() == 2 && touched[1].first == 4 && touched[1].count == 1);
+
+		OPI::Population replaced(catalog);
+		OPI_CHECK(replaced.merge(update, OPI::MERGE_REPLACE, &touched) == OPI::SUCCESS);
+		OPI_CHECK(replaced.getSize() == 3);
+		// remaining objects keep their order, new objects are appended
+		OPI_CHECK(replaced.getObjectProperties()[0].id == 20);
+		OPI_CHECK(replaced.getObjectProperties()[1].id == 30);
+		OPI_CHECK(replaced.getObjectProperties()[2].id == 50);
+		OPI_CHECK(replaced.getObjectName(0) == "twenty");
+		OPI_CHECK(touched.size() == 1 && touched[0].first == 0 && touched[0].count == 3);
+
+		// updates need ids, and byte arrays have to match
+		OPI::Population empty(host, 2);
+		empty.getOrbit();
+		OPI_CHECK(replaced.merge(empty) == OPI::INVALID_ARGUMENT);
+		OPI::Population bytes(update);
+		bytes.resizeByteArray(4);
+		bytes.getBytes();
+		OPI_CHECK(replaced.merge(bytes) == OPI::INCOMPATIBLE_TYPES);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testFindById(host, false);
+	testFindById(host, true);
+	testConcurrentLookup(host);
+	testMerge(host);
+	return OPI_TEST_RESULT("TestIdIndex");
+}
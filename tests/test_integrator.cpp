@@ -0,0 +1,83 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Numerical integration of Keplerian orbits with the Runge-Kutta integrator plugin.
+namespace
+{
+	void fill(OPI::Population& population)
+	{
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			// eccentric orbits change their step size along the orbit
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + 20.0 * (i % 500), 0.3 * ((i * 7) % 10) / 10.0,
+				0.1 * (i % 30), 0.01 * i, 0.02 * i, 0.03 * i, 0.0, 0.0);
+		}
+		population.update(OPI::DATA_ORBIT);
+	}
+
+	// returns the largest position error in km against the analytic solution after dt seconds
+	double maxError(const OPI::Population& initial, const OPI::Population& result, double dt)
+	{
+		std::vector<OPI::Orbit> orbits(initial.getOrbit(), initial.getOrbit() + initial.getSize());
+		for(size_t i = 0; i < orbits.size(); ++i)
+			orbits[i].mean_anomaly += OPI::getMeanMotion(orbits[i].semi_major_axis) * dt;
+		std::vector<OPI::Vector3> expected(orbits.size());
+		OPI::convertElementsToState(orbits.data(), expected.data(), 0, static_cast<int>(orbits.size()));
+		double error = 0.0;
+		for(size_t i = 0; i < orbits.size(); ++i)
+		{
+			const OPI::Vector3 d = result.getPosition()[i] - expected[i];
+			error = std::max(error, std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z));
+		}
+		return error;
+	}
+
+	void testMethod(OPI::Host& host, const std::string& method, double tolerance)
+	{
+		OPI::PropagatorIntegrator* integrator = host.getPropagatorIntegrator("RungeKuttaCPP");
+		OPI_CHECK(integrator != 0);
+		if(!integrator)
+			return;
+		OPI_CHECK(integrator->setProperty("method", method) == OPI::SUCCESS);
+		OPI_CHECK(integrator->setProperty("step_size", method == "RK4" ? 10.0 : 0.0) == OPI::SUCCESS);
+		OPI::CustomPropagator* propagator = host.createCustomPropagator("Integrated" + method);
+		propagator->setIntegrator(integrator);
+
+		OPI::Population population(host, 3000);
+		fill(population);
+		OPI::Population initial(population);
+		const double dt = 5400.0;
+		OPI_CHECK(propagator->propagate(population, 2451545.0, dt) == OPI::SUCCESS);
+		const double error = maxError(initial, population, dt);
+		OPI_CHECK(error < tolerance);
+		std::cout << method << " maximum position error: " << error << " km" << std::endl;
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	host.loadPlugins(OPI_TEST_PLUGIN_DIR);
+	testMethod(host, "RK4", 1e-3);
+	testMethod(host, "DP54", 1e-3);
+	testMethod(host, "RKF78", 1e-3);
+	return OPI_TEST_RESULT("TestIntegrator");
+}
@@ -0,0 +1,104 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cstdint>
+#include <set>
+#include <vector>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Placement of large host memory blocks by the default allocator.
+namespace
+{
+	const size_t PAGE_SIZE = 4096;
+
+	// returns the NUMA node of every page of a block, negative for pages that are not resident
+	std::vector<int> pageNodes(const char* memory, size_t bytes)
+	{
+		std::vector<int> status;
+#ifdef __linux__
+		std::vector<void*> pages;
+		for(size_t offset = 0; offset < bytes; offset += PAGE_SIZE)
+			pages.push_back(const_cast<char*>(memory) + offset);
+		status.assign(pages.size(), -1);
+		// without target nodes, move_pages only reports where the pages are
+		if(syscall(SYS_move_pages, 0, pages.size(), pages.data(), 0, status.data(), 0) != 0)
+			status.clear();
+#endif
+		return status;
+	}
+
+	void testPartitioned(OPI::Host& host)
+	{
+		const size_t bytes = 16 << 20;
+		host.setMemoryPlacement(OPI::MEMORY_PLACEMENT_PARTITIONED, false);
+		OPI::HostAllocator* allocator = host.getHostAllocator();
+		char* memory = static_cast<char*>(allocator->allocate(bytes));
+		OPI_CHECK(memory != 0);
+		if(!memory)
+			return;
+		OPI_CHECK(reinterpret_cast<std::uintptr_t>(memory) % (2 << 20) == 0);
+
+		// every page has been touched by the allocator
+		const std::vector<int> nodes = pageNodes(memory, bytes);
+		int missing = 0;
+		for(size_t page = 0; page < nodes.size(); ++page)
+		{
+			if(nodes[page] < 0)
+				missing++;
+		}
+		OPI_CHECK(missing == 0);
+		bool zero = true;
+		for(size_t offset = 0; offset < bytes; offset += 4093)
+			zero = zero && memory[offset] == 0;
+		OPI_CHECK(zero);
+		allocator->free(memory, bytes);
+	}
+
+	void testInterleaved(OPI::Host& host)
+	{
+		const size_t bytes = 16 << 20;
+		host.setMemoryPlacement(OPI::MEMORY_PLACEMENT_INTERLEAVED, false);
+		OPI::HostAllocator* allocator = host.getHostAllocator();
+		char* memory = static_cast<char*>(allocator->allocate(bytes));
+		OPI_CHECK(memory != 0);
+		if(!memory)
+			return;
+		for(size_t offset = 0; offset < bytes; offset += PAGE_SIZE)
+			memory[offset] = 1;
+		// on systems with several nodes the pages are spread across them
+		std::set<int> used;
+		const std::vector<int> nodes = pageNodes(memory, bytes);
+		for(size_t page = 0; page < nodes.size(); ++page)
+			used.insert(nodes[page]);
+		OPI_CHECK(nodes.empty() || *used.begin() >= 0);
+		std::cout << "pages of an interleaved block on " << used.size() << " node(s)" << std::endl;
+		allocator->free(memory, bytes);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testPartitioned(host);
+	testInterleaved(host);
+	host.setMemoryPlacement(OPI::MEMORY_PLACEMENT_DEFAULT);
+	return OPI_TEST_RESULT("TestMemory");
+}
@@ -0,0 +1,178 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Batch conversions of anomalies and orbital elements.
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	void testKepler()
+	{
+		// a count that is not a multiple of any vector width
+		std::vector<double> mean, eccentricity;
+		for(int i = 0; i < 1001; ++i)
+		{
+			mean.push_back(-20.0 + 0.04 * i);
+			eccentricity.push_back(0.99 * ((i * 37) % 100) / 100.0);
+		}
+		const int count = static_cast<int>(mean.size());
+		std::vector<double> eccentric(count), trueAnomaly(count), meanAgain(count);
+		OPI::meanToEccentricAnomaly(mean.data(), eccentricity.data(), eccentric.data(), count);
+		OPI::eccentricToTrueAnomaly(eccentric.data(), eccentricity.data(), trueAnomaly.data(), count);
+		OPI::trueToMeanAnomaly(trueAnomaly.data(), eccentricity.data(), meanAgain.data(), count);
+
+		double keplerError = 0.0, revolutionError = 0.0, roundTripError = 0.0, trueError = 0.0;
+		for(int i = 0; i < count; ++i)
+		{
+			const double e = eccentricity[i];
+			keplerError = std::max(keplerError, std::fabs(eccentric[i] - e * std::sin(eccentric[i]) - mean[i]));
+			revolutionError = std::max(revolutionError, std::fabs(eccentric[i] - mean[i]) - e);
+			roundTripError = std::max(roundTripError, std::fabs(meanAgain[i] - mean[i]));
+			// reference for the true anomaly
+			const double reference = 2.0 * std::atan2(std::sqrt(1.0 + e) * std::sin(eccentric[i] / 2.0), std::sqrt(1.0 - e) * std::cos(eccentric[i] / 2.0));
+			trueError = std::max(trueError, std::fabs(std::remainder(trueAnomaly[i] - reference, 2.0 * PI)));
+		}
+		OPI_CHECK(keplerError < 1e-12);
+		OPI_CHECK(revolutionError <= 1e-12);
+		OPI_CHECK(roundTripError < 1e-10);
+		OPI_CHECK(trueError < 1e-12);
+
+		std::vector<double> direct(count);
+		OPI::meanToTrueAnomaly(mean.data(), eccentricity.data(), direct.data(), count);
+		double directError = 0.0;
+		for(int i = 0; i < count; ++i)
+			directError = std::max(directError, std::fabs(direct[i] - trueAnomaly[i]));
+		OPI_CHECK(directError < 1e-12);
+	}
+
+	void testNonElliptic()
+	{
+		const double mean[] = { 1.0, 1.0, 1.0, 1.0, 1.0 };
+		const double eccentricity[] = { 1.5, 1.0, -0.1, std::nan(""), 0.5 };
+		double result[5];
+		OPI::meanToEccentricAnomaly(mean, eccentricity, result, 5);
+		OPI_CHECK(std::isnan(result[0]) && std::isnan(result[1]) && std::isnan(result[2]) && std::isnan(result[3]));
+		OPI_CHECK(!std::isnan(result[4]));
+		OPI::meanToTrueAnomaly(mean, eccentricity, result, 5);
+		OPI_CHECK(std::isnan(result[0]) && std::isnan(result[1]) && std::isnan(result[2]) && std::isnan(result[3]));
+		OPI::trueToMeanAnomaly(mean, eccentricity, result, 5);
+		OPI_CHECK(std::isnan(result[0]) && std::isnan(result[2]) && !std::isnan(result[4]));
+	}
+
+	void testStateRoundTrip()
+	{
+		std::vector<OPI::Orbit> orbits;
+		for(int i = 0; i < 203; ++i)
+		{
+			orbits.push_back(OPI::Orbit(6800.0 + 200.0 * i, 0.9 * ((i * 13) % 50) / 50.0 + 0.001,
+				0.05 + PI * 0.9 * ((i * 7) % 30) / 30.0, 0.03 * i, 0.05 * i + 0.1, 0.07 * i + 0.2, 0.0, 0.0));
+		}
+		const int count = static_cast<int>(orbits.size());
+		std::vector<OPI::Vector3> position(count), velocity(count);
+		OPI::convertElementsToState(orbits.data(), position.data(), velocity.data(), count);
+
+		double energyError = 0.0;
+		for(int i = 0; i < count; ++i)
+		{
+			// vis-viva equation
+			const OPI::Vector3& r = position[i];
+			const OPI::Vector3& v = velocity[i];
+			const double radius = std::sqrt(r.x * r.x + r.y * r.y + r.z * r.z);
+			const double speed2 = v.x * v.x + v.y * v.y + v.z * v.z;
+			const double a = 1.0 / (2.0 / radius - speed2 / OPI::EARTH_MU);
+			energyError = std::max(energyError, std::fabs(a - orbits[i].semi_major_axis) / orbits[i].semi_major_axis);
+		}
+		OPI_CHECK(energyError < 1e-12);
+
+		std::vector<OPI::Orbit> elements(count);
+		OPI::convertStateToElements(position.data(), velocity.data(), elements.data(), count);
+		double lengthError = 0.0, angleError = 0.0;
+		for(int i = 0; i < count; ++i)
+		{
+			lengthError = std::max(lengthError, std::fabs(elements[i].semi_major_axis - orbits[i].semi_major_axis) / orbits[i].semi_major_axis);
+			lengthError = std::max(lengthError, std::fabs(elements[i].eccentricity - orbits[i].eccentricity));
+			angleError = std::max(angleError, std::fabs(elements[i].inclination - orbits[i].inclination));
+			angleError = std::max(angleError, std::fabs(std::remainder(elements[i].raan - orbits[i].raan, 2.0 * PI)));
+			angleError = std::max(angleError, std::fabs(std::remainder(elements[i].arg_of_perigee - orbits[i].arg_of_perigee, 2.0 * PI)));
+			angleError = std::max(angleError, std::fabs(std::remainder(elements[i].mean_anomaly - orbits[i].mean_anomaly, 2.0 * PI)));
+		}
+		OPI_CHECK(lengthError < 1e-10);
+		OPI_CHECK(angleError < 1e-8);
+
+		// the velocity may be omitted
+		std::vector<OPI::Vector3> positionOnly(count);
+		OPI::convertElementsToState(orbits.data(), positionOnly.data(), 0, count);
+		OPI_CHECK(positionOnly[count - 1].x == position[count - 1].x);
+		OPI_CHECK_CLOSE(OPI::getOrbitalPeriod(7000.0), 2.0 * PI / OPI::getMeanMotion(7000.0), 1e-9);
+	}
+
+	void testPopulation(OPI::Host& host)
+	{
+		OPI::Population population(host, 5000);
+		for(int i = 0; i < population.getSize(); ++i)
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.1 + 1e-4 * (i % 1000), 0.9, 0.001 * i, 0.002 * i, 0.003 * i, 1.0, 2.0);
+		population.update(OPI::DATA_ORBIT);
+		OPI::Population expected(population);
+
+		OPI_CHECK(population.computeCartesian(OPI::REF_ECI) == OPI::SUCCESS);
+		OPI_CHECK(population.hasData(OPI::DATA_CARTESIAN) && population.hasData(OPI::DATA_VELOCITY));
+		std::vector<OPI::Vector3> position(population.getSize()), velocity(population.getSize());
+		OPI::convertElementsToState(expected.getOrbit(), position.data(), velocity.data(), population.getSize());
+		bool same = true;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			same = same && population.getPosition()[i].x == position[i].x && population.getPosition()[i].z == position[i].z
+				&& population.getVelocity()[i].y == velocity[i].y;
+		}
+		OPI_CHECK(same);
+
+		// the elements are recovered, bol and eol are kept
+		OPI_CHECK(population.computeElements() == OPI::SUCCESS);
+		double error = 0.0;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			const OPI::Orbit& a = population.getOrbit()[i];
+			const OPI::Orbit& b = expected.getOrbit()[i];
+			error = std::max(error, std::fabs(a.semi_major_axis - b.semi_major_axis) / b.semi_major_axis);
+			error = std::max(error, std::fabs(std::remainder(a.mean_anomaly - b.mean_anomaly, 2.0 * PI)));
+			OPI_CHECK(a.bol == 1.0 && a.eol == 2.0);
+		}
+		OPI_CHECK(error < 1e-9);
+
+		OPI_CHECK(population.computeCartesian(OPI::REF_NONE) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(population.computeCartesian(OPI::REF_ECEF) == OPI::NOT_IMPLEMENTED);
+		OPI_CHECK(population.computeElements(0.0) == OPI::INVALID_ARGUMENT);
+		OPI::Population empty(host, 10);
+		OPI_CHECK(empty.computeCartesian() == OPI::INVALID_TYPE);
+		OPI_CHECK(empty.computeElements() == OPI::INVALID_TYPE);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testKepler();
+	testNonElliptic();
+	testStateRoundTrip();
+	testPopulation(host);
+	std::cout << "Orbit math instruction set: " << OPI::getOrbitMathInstructionSet() << std::endl;
+	return OPI_TEST_RESULT("TestOrbitMath");
+}
@@ -0,0 +1,252 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// Round trips of population files: whole files, streamed chunks, checkpoints and compression.
+namespace
+{
+	void fill(OPI::Population& population, int first)
+	{
+		const int size = population.getSize();
+		OPI::Orbit* orbits = population.getOrbit();
+		OPI::ObjectProperties* properties = population.getObjectProperties();
+		OPI::Vector3* positions = population.getPosition();
+		OPI::Epoch* epochs = population.getEpoch();
+		char* bytes = population.getBytes();
+		for(int i = 0; i < size; ++i)
+		{
+			const double k = first + i;
+			orbits[i] = OPI::Orbit(7000.0 + k, 1e-7 * k, 0.5 + 1e-4 * k, 0.1 * k, 0.2 * k, 0.3 * k, 0.0, 0.0);
+			properties[i] = OPI::ObjectProperties(100.0 + k, 1.0, 0.01, 2.2, 1.3, first + i);
+			positions[i] = OPI::Vector3(k, -k, 0.5 * k);
+			epochs[i] = OPI::Epoch(2451545.0 + k / 1440.0, 2451545.0 + k / 720.0);
+			for(int b = 0; b < population.getByteArraySize(); ++b)
+				bytes[i * population.getByteArraySize() + b] = static_cast<char>(k + b);
+		}
+		population.update(OPI::DATA_ORBIT);
+		population.update(OPI::DATA_PROPERTIES);
+		population.update(OPI::DATA_CARTESIAN);
+		population.update(OPI::DATA_EPOCH);
+		population.update(OPI::DATA_BYTES);
+	}
+
+	// checks objects [0, count) of population against objects [first, first + count) of expected
+	bool equal(const OPI::Population& population, const OPI::Population& expected, int first, int count)
+	{
+		const int bytes = expected.getByteArraySize();
+		return population.getByteArraySize() == bytes
+			&& memcmp(population.getOrbit(), expected.getOrbit() + first, count * sizeof(OPI::Orbit)) == 0
+			&& memcmp(population.getObjectProperties(), expected.getObjectProperties() + first, count * sizeof(OPI::ObjectProperties)) == 0
+			&& memcmp(population.getPosition(), expected.getPosition() + first, count * sizeof(OPI::Vector3)) == 0
+			&& memcmp(population.getEpoch(), expected.getEpoch() + first, count * sizeof(OPI::Epoch)) == 0
+			&& memcmp(population.getBytes(), expected.getBytes() + first * bytes, count * bytes) == 0;
+	}
+
+	void testWriteRead(OPI::Host& host)
+	{
+		OPI::Population population(host, 1000);
+		population.resizeByteArray(3);
+		fill(population, 0);
+		population.write(opi_test::outputFile("file.opi"));
+
+		OPI::Population loaded(host);
+		OPI_CHECK(loaded.read(opi_test::outputFile("file.opi")) == OPI::SUCCESS);
+		OPI_CHECK(loaded.getSize() == 1000);
+		OPI_CHECK(equal(loaded, population, 0, 1000));
+		// columns that were never written stay unallocated
+		OPI_CHECK(!loaded.hasData(OPI::DATA_VELOCITY));
+	}
+
+	void testStream(OPI::Host& host, bool prefetch)
+	{
+		// the chunk size does not divide the number of objects
+		const int total = 2500;
+		const int chunkSize = 700;
+		OPI::Population expected(host, total);
+		expected.resizeByteArray(2);
+		fill(expected, 0);
+		{
+			OPI::PopulationStreamWriter writer(host, opi_test::outputFile("stream.opi"));
+			for(int first = 0; first < total; first += 1000)
+			{
+				OPI::Population chunk(host, std::min(1000, total - first));
+				chunk.resizeByteArray(2);
+				fill(chunk, first);
+				OPI_CHECK(writer.append(chunk) == OPI::SUCCESS);
+			}
+			OPI_CHECK(writer.getSize() == total);
+			OPI_CHECK(writer.close() == OPI::SUCCESS);
+		}
+
+		OPI::PopulationStreamReader reader(host, opi_test::outputFile("stream.opi"), chunkSize, prefetch);
+		OPI_CHECK(reader.getTotalSize() == total);
+		for(int pass = 0; pass < 2; ++pass)
+		{
+			int read = 0;
+			int chunks = 0;
+			while(reader.next())
+			{
+				OPI::Population& chunk = reader.getChunk();
+				OPI_CHECK(reader.getChunkOffset() == read);
+				OPI_CHECK(chunk.getSize() == std::min(chunkSize, total - read));
+				OPI_CHECK(equal(chunk, expected, read, chunk.getSize()));
+				read += chunk.getSize();
+				++chunks;
+			}
+			OPI_CHECK(reader.getStatus() == OPI::SUCCESS);
+			OPI_CHECK(read == total);
+			OPI_CHECK(chunks == 4);
+			reader.rewind();
+		}
+
+		// a streamed file is a regular population file
+		OPI::Population loaded(host);
+		OPI_CHECK(loaded.read(opi_test::outputFile("stream.opi")) == OPI::SUCCESS);
+		OPI_CHECK(loaded.getSize() == total);
+		OPI_CHECK(equal(loaded, expected, 0, total));
+	}
+
+	void testCheckpoint(OPI::Host& host)
+	{
+		// large enough to be written by several threads
+		OPI::Population population(host, 200000);
+		fill(population, 0);
+		OPI::Population snapshot(population);
+		OPI::PopulationCheckpoint handle(host);
+		for(int round = 0; round < 2; ++round)
+		{
+			OPI_CHECK(population.checkpoint(opi_test::outputFile("checkpoint.opi"), handle, OPI::FILE_SYNC_DATA) == OPI::SUCCESS);
+			// the file holds the state at the time of the call
+			fill(population, 1 + round);
+			OPI_CHECK(handle.wait() == OPI::SUCCESS);
+			OPI_CHECK(handle.isFinished());
+
+			OPI::Population loaded(host);
+			OPI_CHECK(loaded.read(opi_test::outputFile("checkpoint.opi")) == OPI::SUCCESS);
+			OPI_CHECK(loaded.getSize() == snapshot.getSize());
+			OPI_CHECK(equal(loaded, snapshot, 0, snapshot.getSize()));
+			snapshot = population;
+		}
+	}
+
+	long fileSize(const std::string& filename)
+	{
+		std::ifstream in(filename.c_str(), std::ifstream::binary | std::ifstream::ate);
+		return static_cast<long>(in.tellg());
+	}
+
+	void testCompression(OPI::Host& host)
+	{
+		OPI::Population population(host, 50000);
+		fill(population, 0);
+		population.write(opi_test::outputFile("plain.opi"));
+
+		OPI_CHECK(population.setCompression(OPI::DATA_ORBIT, OPI::COMPRESSION_LOSSLESS) == OPI::SUCCESS);
+		OPI_CHECK(population.setCompression(OPI::DATA_PROPERTIES, OPI::COMPRESSION_LOSSLESS) == OPI::SUCCESS);
+		OPI_CHECK(population.setCompression(OPI::DATA_EPOCH, OPI::COMPRESSION_LOSSLESS) == OPI::SUCCESS);
+		OPI_CHECK(population.getCompression(OPI::DATA_ORBIT) == OPI::COMPRESSION_LOSSLESS);
+		population.write(opi_test::outputFile("lossless.opi"));
+		OPI_CHECK(fileSize(opi_test::outputFile("lossless.opi")) < fileSize(opi_test::outputFile("plain.opi")));
+		OPI::Population loaded(host);
+		OPI_CHECK(loaded.read(opi_test::outputFile("lossless.opi")) == OPI::SUCCESS);
+		OPI_CHECK(equal(loaded, population, 0, population.getSize()));
+
+		// lossy compression keeps the relative error of every value below 2^-mantissaBits
+		const int mantissaBits = 20;
+		OPI_CHECK(population.setCompression(OPI::DATA_CARTESIAN, OPI::COMPRESSION_LOSSY, mantissaBits) == OPI::SUCCESS);
+		population.write(opi_test::outputFile("lossy.opi"));
+		OPI_CHECK(loaded.read(opi_test::outputFile("lossy.opi")) == OPI::SUCCESS);
+		OPI_CHECK(loaded.getSize() == population.getSize());
+		double maxError = 0.0;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			const OPI::Vector3& a = population.getPosition()[i];
+			const OPI::Vector3& b = loaded.getPosition()[i];
+			maxError = std::max(maxError, std::fabs(a.x - b.x) / std::max(std::fabs(a.x), 1e-300));
+			maxError = std::max(maxError, std::fabs(a.y - b.y) / std::max(std::fabs(a.y), 1e-300));
+			maxError = std::max(maxError, std::fabs(a.z - b.z) / std::max(std::fabs(a.z), 1e-300));
+		}
+		OPI_CHECK(maxError <= std::ldexp(1.0, -mantissaBits));
+		OPI_CHECK(memcmp(loaded.getOrbit(), population.getOrbit(), population.getSize() * sizeof(OPI::Orbit)) == 0);
+
+		OPI_CHECK(population.setCompression(OPI::DATA_CARTESIAN, OPI::COMPRESSION_LOSSY, 53) == OPI::INVALID_ARGUMENT);
+	}
+
+	// a raw block whose payload size does not match its entries is rejected
+	void testCorruptFile(OPI::Host& host)
+	{
+		OPI::Population population(host, 100);
+		fill(population, 0);
+		population.write(opi_test::outputFile("corrupt.opi"));
+		std::vector<char> file(fileSize(opi_test::outputFile("corrupt.opi")));
+		std::fstream stream(opi_test::outputFile("corrupt.opi").c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		stream.read(&file[0], file.size());
+		// magic, version, size, byte array size and name length precede the name, every block
+		// header holds type, entry size, first object, object count, encoding and payload size
+		int nameLength = 0;
+		memcpy(&nameLength, &file[16], sizeof(int));
+		long long offset = 20 + nameLength;
+		long long last = offset;
+		for(long long blockSize = 0; offset < (long long)file.size(); offset += 28 + blockSize)
+		{
+			int encoding = -1;
+			memcpy(&encoding, &file[offset + 16], sizeof(int));
+			memcpy(&blockSize, &file[offset + 20], sizeof(blockSize));
+			OPI_CHECK(encoding == 0);
+			last = offset;
+		}
+		// the last block claims one byte less than its entries, which the end of the file
+		// would otherwise hide
+		long long payloadSize = 0;
+		memcpy(&payloadSize, &file[last + 20], sizeof(payloadSize));
+		payloadSize -= 1;
+		stream.clear();
+		stream.seekp(last + 20);
+		stream.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+		stream.close();
+
+		OPI::Population loaded(host);
+		OPI_CHECK(loaded.read(opi_test::outputFile("corrupt.opi")) == OPI::INVALID_FILE_FORMAT);
+	}
+
+	void testMissingFile(OPI::Host& host)
+	{
+		OPI::Population loaded(host);
+		OPI_CHECK(loaded.read(opi_test::outputFile("missing.opi")) != OPI::SUCCESS);
+		OPI::PopulationStreamReader reader(host, opi_test::outputFile("missing.opi"), 100);
+		OPI_CHECK(!reader.next());
+		OPI_CHECK(reader.getStatus() != OPI::SUCCESS);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testWriteRead(host);
+	testStream(host, false);
+	testStream(host, true);
+	testCheckpoint(host);
+	testCompression(host);
+	testCorruptFile(host);
+	testMissingFile(host);
+	return OPI_TEST_RESULT("TestPopulationFile");
+}
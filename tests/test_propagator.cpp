@@ -0,0 +1,254 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <vector>
+
+// Propagation calls of the example plugins.
+namespace
+{
+	const double PI = 3.14159265358979323846;
+
+	void testOutputMask(OPI::Host& host)
+	{
+		OPI::Propagator* propagator = host.getPropagator("BasicCPP");
+		OPI_CHECK(propagator != 0);
+		if(!propagator)
+			return;
+		OPI::Population population(host, 1);
+		population.getOrbit()[0] = OPI::Orbit(7000.0, 0.01, 0.5, 0.0, 0.0, 0.0, 0.0, 0.0);
+		population.update(OPI::DATA_ORBIT);
+		const double jd = 2451545.0;
+		const double meanMotion = std::sqrt(398600.5 / (7000.0 * 7000.0 * 7000.0));
+
+		// the mean anomaly is updated even if positions are not requested
+		OPI_CHECK(propagator->propagate(population, jd, 600.0, OPI::MASK_ORBIT) == OPI::SUCCESS);
+		OPI_CHECK_CLOSE(population.getOrbit()[0].mean_anomaly, meanMotion * 600.0, 1e-5);
+		OPI_CHECK(!population.hasData(OPI::DATA_CARTESIAN));
+
+		OPI_CHECK(propagator->propagate(population, jd, 1200.0, OPI::MASK_CARTESIAN) == OPI::SUCCESS);
+		OPI_CHECK_CLOSE(population.getOrbit()[0].mean_anomaly, std::fmod(meanMotion * 1200.0, 2.0 * PI), 1e-5);
+		const OPI::Vector3& position = population.getPosition()[0];
+		const double radius = std::sqrt(position.x * position.x + position.y * position.y + position.z * position.z);
+		OPI_CHECK(radius > 7000.0 * 0.99 && radius < 7000.0 * 1.01);
+	}
+
+	// declared inputs that the Population does not hold are not allocated
+	void testPrefetch(OPI::Host& host)
+	{
+		OPI::Population population(host, 10);
+		population.prefetch(OPI::MASK_ORBIT | OPI::MASK_PROPERTIES);
+		OPI_CHECK(!population.hasData(OPI::DATA_ORBIT));
+		OPI_CHECK(!population.hasData(OPI::DATA_PROPERTIES));
+
+		OPI::Propagator* propagator = host.getPropagator("SGP4CPP");
+		OPI_CHECK(propagator != 0);
+		if(!propagator)
+			return;
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.01, 0.5, 0.0, 0.0, 0.0, 0.0, 0.0);
+			population.getEpoch()[i] = OPI::Epoch(2451545.0, 2451545.0);
+		}
+		population.update(OPI::DATA_ORBIT);
+		population.update(OPI::DATA_EPOCH);
+		// SGP4 reads the properties if they are present
+		OPI_CHECK(propagator->propagate(population, 2451545.0, 60.0) == OPI::SUCCESS);
+		OPI_CHECK(!population.hasData(OPI::DATA_PROPERTIES));
+		OPI_CHECK(population.hasData(OPI::DATA_CARTESIAN));
+	}
+
+	// shrinks the semi-major axis in proportion to its size and records the columns it finds
+	class DecayModule: public OPI::PerturbationModule
+	{
+		public:
+			DecayModule(const std::string& name, OPI::DataMask read)
+			{
+				setName(name);
+				setColumnUsage(read, OPI::MASK_NONE);
+			}
+
+			bool hadProperties;
+			bool hadVelocity;
+
+		protected:
+			OPI::ErrorCode runCalculation(OPI::Population& data, OPI::Orbit* delta, float dt)
+			{
+				hadProperties = data.hasData(OPI::DATA_PROPERTIES);
+				hadVelocity = data.hasData(OPI::DATA_VELOCITY);
+				const OPI::Orbit* orbits = data.getOrbit();
+				for(int i = 0; i < data.getSize(); ++i)
+					delta[i].semi_major_axis -= 1e-9 * dt * orbits[i].semi_major_axis;
+				return OPI::SUCCESS;
+			}
+	};
+
+	// modules run concurrently on one Population, so their columns are prepared before
+	void testElementModules(OPI::Host& host)
+	{
+		DecayModule* first = new DecayModule("FirstDecay", OPI::MASK_ORBIT | OPI::MASK_PROPERTIES);
+		DecayModule* second = new DecayModule("SecondDecay", OPI::MASK_ORBIT);
+		host.addPerturbationModule(first);
+		host.addPerturbationModule(second);
+		OPI::CustomPropagator* propagator = host.createCustomPropagator("Decay");
+		propagator->addModule(first);
+		propagator->addModule(second);
+
+		OPI::Population population(host, 100);
+		for(int i = 0; i < population.getSize(); ++i)
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.01, 0.5, 0.0, 0.0, 0.0, 0.0, 0.0);
+		population.update(OPI::DATA_ORBIT);
+		// the orbits are shared with the copy until one of them is written
+		OPI::Population copy(population);
+		OPI_CHECK(propagator->propagate(population, 2451545.0, 1000.0, OPI::MASK_ORBIT) == OPI::SUCCESS);
+		// declared columns are allocated before the first module runs, undeclared ones are not
+		OPI_CHECK(first->hadProperties && second->hadProperties);
+		OPI_CHECK(!first->hadVelocity && !second->hadVelocity);
+		OPI_CHECK_CLOSE(population.getOrbit()[10].semi_major_axis, 7010.0 - 2e-6 * 7010.0, 1e-6);
+		OPI_CHECK(copy.getOrbit()[10].semi_major_axis == 7010.0);
+	}
+
+	// times that are not a multiple of the batch sizes and not equidistant
+	std::vector<double> trajectoryTimes(double begin)
+	{
+		std::vector<double> times;
+		for(int t = 0; t < 13; ++t)
+			times.push_back(begin + 0.01 * t + 0.001 * t * t);
+		return times;
+	}
+
+	bool sameState(const OPI::Vector3& a, const OPI::Vector3& b, double tolerance)
+	{
+		return std::fabs(a.x - b.x) <= tolerance && std::fabs(a.y - b.y) <= tolerance && std::fabs(a.z - b.z) <= tolerance;
+	}
+
+	// the trajectory equals the states after the equivalent sequence of propagate() calls
+	bool matchesPropagation(OPI::Propagator* propagator, const OPI::Population& initial, const std::vector<double>& times,
+							const OPI::TrajectoryBuffer& trajectory, double tolerance)
+	{
+		OPI::Population stepped(initial);
+		const int length = static_cast<int>(times.size());
+		bool equal = true;
+		for(int t = 0; t < length; ++t)
+		{
+			if(t == 0)
+				OPI_CHECK(propagator->propagate(stepped, times[0], 0.0) == OPI::SUCCESS);
+			else
+				OPI_CHECK(propagator->propagate(stepped, times[t - 1], (times[t] - times[t - 1]) * 86400.0) == OPI::SUCCESS);
+			for(int i = 0; i < stepped.getSize(); ++i)
+			{
+				equal = equal && sameState(trajectory.getPosition()[i * length + t], stepped.getPosition()[i], tolerance);
+				if(trajectory.hasVelocities())
+					equal = equal && sameState(trajectory.getVelocity()[i * length + t], stepped.getVelocity()[i], tolerance * 1e-3);
+			}
+		}
+		return equal;
+	}
+
+	// SGP4 fills the trajectory with its own batched implementation
+	void testTrajectory(OPI::Host& host)
+	{
+		OPI::Propagator* propagator = host.getPropagator("SGP4CPP");
+		OPI_CHECK(propagator != 0);
+		if(!propagator)
+			return;
+		const int objects = 40;
+		const double epoch = 2451545.0;
+		OPI::Population population(host, objects);
+		for(int i = 0; i < objects; ++i)
+		{
+			// every fourth object is a deep-space object
+			const double a = (i % 4 == 3) ? 26000.0 + 400.0 * i : 6800.0 + 20.0 * i;
+			population.getOrbit()[i] = OPI::Orbit(a, 0.001 + 0.01 * (i % 7), 0.1 + 0.04 * i, 0.2 * i, 0.3 * i, 0.4 * i, 0.0, 0.0);
+			population.getObjectProperties()[i] = OPI::ObjectProperties(100.0, 1.0, 0.01, 2.2, 1.3, i + 1);
+			population.getEpoch()[i] = OPI::Epoch(epoch, epoch);
+		}
+		population.update(OPI::DATA_ORBIT);
+		population.update(OPI::DATA_PROPERTIES);
+		population.update(OPI::DATA_EPOCH);
+		const OPI::Population initial(population);
+
+		const std::vector<double> times = trajectoryTimes(epoch + 0.5);
+		const int length = static_cast<int>(times.size());
+		OPI::TrajectoryBuffer trajectory(host, objects, length);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), length, trajectory) == OPI::SUCCESS);
+		OPI_CHECK(matchesPropagation(propagator, initial, times, trajectory, 1e-6));
+
+		// the Population ends at the last time, up to rounding since it is propagated in other batches
+		bool last = true;
+		for(int i = 0; i < objects; ++i)
+		{
+			last = last && sameState(population.getPosition()[i], trajectory.getPosition()[i * length + length - 1], 1e-9);
+			last = last && sameState(population.getVelocity()[i], trajectory.getVelocity()[i * length + length - 1], 1e-12);
+			last = last && population.getEpoch()[i].current_epoch == times[length - 1];
+		}
+		OPI_CHECK(last);
+
+		// the buffer has to match the Population and the number of times
+		OPI::TrajectoryBuffer fewerObjects(host, objects - 1, length);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), length, fewerObjects) == OPI::INVALID_ARGUMENT);
+		OPI::TrajectoryBuffer fewerTimes(host, objects, length - 1);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), length, fewerTimes) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), 0, trajectory) == OPI::INVALID_ARGUMENT);
+		OPI_CHECK(propagator->propagateTrajectory(population, 0, length, trajectory) == OPI::INVALID_ARGUMENT);
+	}
+
+	// BasicCPP does not implement trajectories, so they are recorded from propagate() calls
+	void testTrajectoryFallback(OPI::Host& host)
+	{
+		OPI::Propagator* propagator = host.getPropagator("BasicCPP");
+		OPI_CHECK(propagator != 0);
+		if(!propagator)
+			return;
+		// more objects than fit into one staging block
+		const int objects = 30;
+		OPI::Population population(host, objects);
+		for(int i = 0; i < objects; ++i)
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + 50.0 * i, 0.001 * i, 0.05 * i, 0.1 * i, 0.2 * i, 0.3 * i, 0.0, 0.0);
+		population.update(OPI::DATA_ORBIT);
+		const OPI::Population initial(population);
+
+		const std::vector<double> times = trajectoryTimes(2451545.0);
+		const int length = static_cast<int>(times.size());
+		// the plugin produces no velocities
+		OPI::TrajectoryBuffer trajectory(host, objects, length, false);
+		OPI_CHECK(trajectory.getVelocity() == 0);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), length, trajectory) == OPI::SUCCESS);
+		OPI_CHECK(matchesPropagation(propagator, initial, times, trajectory, 0.0));
+
+		bool last = true;
+		for(int i = 0; i < objects; ++i)
+			last = last && sameState(population.getPosition()[i], trajectory.getPosition()[i * length + length - 1], 0.0);
+		OPI_CHECK(last);
+
+		OPI::TrajectoryBuffer mismatch(host, objects + 1, length, false);
+		OPI_CHECK(propagator->propagateTrajectory(population, times.data(), length, mismatch) == OPI::INVALID_ARGUMENT);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	host.loadPlugins(OPI_TEST_PLUGIN_DIR);
+	testOutputMask(host);
+	testPrefetch(host);
+	testElementModules(host);
+	testTrajectory(host);
+	testTrajectoryFallback(host);
+	return OPI_TEST_RESULT("TestPropagator");
+}
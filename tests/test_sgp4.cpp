@@ -0,0 +1,188 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+// SGP4/SDP4 against the verification vectors of Vallado et al., "Revisiting Spacetrack Report #3" (2006).
+namespace
+{
+	// near-earth, near-earth with drag and a deep-space 12-hour resonant orbit
+	const char* CATALOG =
+		"1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753\n"
+		"2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667\n"
+		"1 06251U 62025E   06176.82412014  .00008885  00000-0  12808-3 0  3985\n"
+		"2 06251  58.0579  54.0425 0030035 139.1568 221.1854 15.56387291  6774\n"
+		"1 08195U 75081A   06176.33215444  .00000099  00000-0  11873-3 0   813\n"
+		"2 08195  64.1586 279.0717 6877146 264.7651  20.2257  2.00491383225656\n";
+
+	struct Reference
+	{
+		int object;
+		double minutes;
+		OPI::Vector3 position;
+		OPI::Vector3 velocity;
+	};
+
+	const Reference REFERENCES[] = {
+		{ 0, 0.0, OPI::Vector3(7022.46529266, -1400.08296755, 0.03995155), OPI::Vector3(1.893841015, 6.405893759, 4.534807250) },
+		{ 0, 360.0, OPI::Vector3(-7154.03120202, -3783.17682504, -3536.19412294), OPI::Vector3(4.741887409, -4.151817765, -2.093935425) },
+		{ 1, 0.0, OPI::Vector3(3988.31022699, 5498.96657235, 0.90055879), OPI::Vector3(-3.290032738, 2.357652820, 6.496623475) },
+		{ 1, 360.0, OPI::Vector3(4993.62642836, 2890.54969900, -3600.40145627), OPI::Vector3(0.347333429, 5.707031557, 5.070699638) },
+		{ 2, 0.0, OPI::Vector3(2349.89483350, -14785.93811562, 0.02119378), OPI::Vector3(2.721488096, -3.256811655, 4.498416672) },
+		{ 2, 360.0, OPI::Vector3(19089.29762968, 3107.89495018, 39958.14661370), OPI::Vector3(-0.410308034, 1.640332277, -0.306873818) }
+	};
+
+	// positions only, the remaining components of these vectors are checked through the other times
+	const Reference POSITIONS[] = {
+		{ 0, 720.0, OPI::Vector3(-7134.59340119, 6531.68641334, 3260.27186483), OPI::Vector3(-4.113793027, 0.0, 0.0) },
+		{ 2, 720.0, OPI::Vector3(2622.13222207, -15125.15464924, 474.51048398), OPI::Vector3(2.688287199, 0.0, 0.0) }
+	};
+
+	bool load(OPI::Population& population)
+	{
+		{
+			std::ofstream out(opi_test::outputFile("vallado.tle").c_str(), std::ofstream::binary);
+			out << CATALOG;
+		}
+		return population.importTLE(opi_test::outputFile("vallado.tle")) == OPI::SUCCESS && population.getSize() == 3;
+	}
+
+	// propagates every object to its own epoch plus the given number of minutes
+	OPI::ErrorCode propagate(OPI::Propagator* propagator, OPI::Population& population, double minutes)
+	{
+		std::vector<double> epochs(population.getSize());
+		for(int i = 0; i < population.getSize(); ++i)
+			epochs[i] = population.getEpoch()[i].original_epoch;
+		return propagator->propagate(population, epochs.data(), population.getSize(), minutes * 60.0);
+	}
+
+	void checkState(const OPI::Population& population, const Reference& reference, bool velocity)
+	{
+		const OPI::Vector3& r = population.getPosition()[reference.object];
+		const OPI::Vector3& v = population.getVelocity()[reference.object];
+		OPI_CHECK_CLOSE(r.x, reference.position.x, 1e-6);
+		OPI_CHECK_CLOSE(r.y, reference.position.y, 1e-6);
+		OPI_CHECK_CLOSE(r.z, reference.position.z, 1e-6);
+		OPI_CHECK_CLOSE(v.x, reference.velocity.x, 1e-9);
+		if(velocity)
+		{
+			OPI_CHECK_CLOSE(v.y, reference.velocity.y, 1e-9);
+			OPI_CHECK_CLOSE(v.z, reference.velocity.z, 1e-9);
+		}
+	}
+
+	void testReferenceVectors(OPI::Propagator* propagator, OPI::Host& host)
+	{
+		OPI::Population population(host);
+		OPI_CHECK(load(population));
+		if(population.getSize() != 3)
+			return;
+		for(double minutes = 0.0; minutes <= 720.0; minutes += 360.0)
+		{
+			OPI_CHECK(propagate(propagator, population, minutes) == OPI::SUCCESS);
+			for(const Reference& reference: REFERENCES)
+			{
+				if(reference.minutes == minutes)
+					checkState(population, reference, true);
+			}
+			for(const Reference& reference: POSITIONS)
+			{
+				if(reference.minutes == minutes)
+					checkState(population, reference, false);
+			}
+			for(int i = 0; i < 3; ++i)
+				OPI_CHECK_CLOSE(population.getEpoch()[i].current_epoch, population.getEpoch()[i].original_epoch + minutes / 1440.0, 1e-9);
+		}
+	}
+
+	// the velocities are the derivatives of the positions, up to the short-periodic terms
+	// which SGP4 only differentiates approximately (below 1 m/s)
+	void testVelocity(OPI::Propagator* propagator, OPI::Host& host)
+	{
+		OPI::Population population(host);
+		if(!load(population))
+			return;
+		const double h = 1.0 / 60.0;
+		for(double minutes = 100.0; minutes <= 700.0; minutes += 300.0)
+		{
+			OPI_CHECK(propagate(propagator, population, minutes - h) == OPI::SUCCESS);
+			std::vector<OPI::Vector3> before(population.getPosition(), population.getPosition() + 3);
+			OPI_CHECK(propagate(propagator, population, minutes + h) == OPI::SUCCESS);
+			std::vector<OPI::Vector3> after(population.getPosition(), population.getPosition() + 3);
+			OPI_CHECK(propagate(propagator, population, minutes) == OPI::SUCCESS);
+			for(int i = 0; i < 3; ++i)
+			{
+				const OPI::Vector3& v = population.getVelocity()[i];
+				OPI_CHECK_CLOSE(v.x, (after[i].x - before[i].x) / (2.0 * h * 60.0), 1e-3);
+				OPI_CHECK_CLOSE(v.y, (after[i].y - before[i].y) / (2.0 * h * 60.0), 1e-3);
+				OPI_CHECK_CLOSE(v.z, (after[i].z - before[i].z) / (2.0 * h * 60.0), 1e-3);
+			}
+		}
+	}
+
+	void testIndexed(OPI::Propagator* propagator, OPI::Host& host)
+	{
+		OPI::Population population(host);
+		if(!load(population))
+			return;
+		OPI_CHECK(propagate(propagator, population, 0.0) == OPI::SUCCESS);
+
+		// the deep-space object at its epoch plus 360 minutes, the others are not touched
+		OPI::IndexList indices(host);
+		indices.add(2);
+		const double jd = population.getEpoch()[2].original_epoch;
+		OPI_CHECK(propagator->propagate(population, indices, jd, 360.0 * 60.0) == OPI::SUCCESS);
+		checkState(population, REFERENCES[0], true);
+		checkState(population, REFERENCES[2], true);
+		checkState(population, REFERENCES[5], true);
+	}
+
+	// changed elements are picked up, invalid elements give NaN states
+	void testChangedElements(OPI::Propagator* propagator, OPI::Host& host)
+	{
+		OPI::Population population(host);
+		if(!load(population))
+			return;
+		OPI_CHECK(propagate(propagator, population, 360.0) == OPI::SUCCESS);
+		population.getOrbit()[1].eccentricity = 1.5;
+		population.update(OPI::DATA_ORBIT);
+		OPI_CHECK(propagate(propagator, population, 360.0) == OPI::SUCCESS);
+		checkState(population, REFERENCES[1], true);
+		checkState(population, REFERENCES[5], true);
+		OPI_CHECK(std::isnan(population.getPosition()[1].x));
+		OPI_CHECK(std::isnan(population.getVelocity()[1].z));
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	host.loadPlugins(OPI_TEST_PLUGIN_DIR);
+	OPI::Propagator* propagator = host.getPropagator("SGP4CPP");
+	OPI_CHECK(propagator != 0);
+	if(propagator)
+	{
+		testReferenceVectors(propagator, host);
+		testVelocity(propagator, host);
+		testIndexed(propagator, host);
+		testChangedElements(propagator, host);
+	}
+	return OPI_TEST_RESULT("TestSGP4");
+}
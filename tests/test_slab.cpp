@@ -0,0 +1,144 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+
+// Slab allocation: all columns in one block of host memory.
+namespace
+{
+	size_t align(size_t offset)
+	{
+		return (offset + 63) / 64 * 64;
+	}
+
+	// checks that the columns follow each other in the slab in the order of their DataType
+	bool packed(const OPI::Population& population)
+	{
+		const size_t size = population.getSize();
+		const char* orbits = reinterpret_cast<const char*>(population.getOrbit());
+		size_t offset = align(size * sizeof(OPI::Orbit));
+		bool result = reinterpret_cast<const char*>(population.getObjectProperties()) == orbits + offset;
+		offset = align(offset + size * sizeof(OPI::ObjectProperties));
+		result = result && reinterpret_cast<const char*>(population.getPosition()) == orbits + offset;
+		offset = align(offset + size * sizeof(OPI::Vector3));
+		result = result && reinterpret_cast<const char*>(population.getVelocity()) == orbits + offset;
+		offset = align(offset + size * sizeof(OPI::Vector3));
+		result = result && reinterpret_cast<const char*>(population.getAcceleration()) == orbits + offset;
+		offset = align(offset + size * sizeof(OPI::Vector3));
+		result = result && population.getBytes() == orbits + offset;
+		offset = align(offset + size * population.getByteArraySize());
+		return result && reinterpret_cast<const char*>(population.getEpoch()) == orbits + offset;
+	}
+
+	void fill(OPI::Population& population)
+	{
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+			population.getEpoch()[i] = OPI::Epoch(2451545.0 + i, 2451545.0 + i);
+		}
+		population.update(OPI::DATA_ORBIT);
+		population.update(OPI::DATA_EPOCH);
+	}
+
+	bool filled(const OPI::Population& population, int count)
+	{
+		bool result = population.getSize() >= count;
+		for(int i = 0; result && i < count; ++i)
+		{
+			result = population.getOrbit()[i].semi_major_axis == 7000.0 + i
+				&& population.getEpoch()[i].current_epoch == 2451545.0 + i;
+		}
+		return result;
+	}
+
+	void testResize(OPI::Host& host)
+	{
+		OPI::Population population(host, 100);
+		population.resizeByteArray(3);
+		fill(population);
+		population.setSlabAllocationEnabled();
+		OPI_CHECK(population.isSlabAllocationEnabled());
+		OPI_CHECK(packed(population));
+		OPI_CHECK(filled(population, 100));
+
+		// the columns are packed for the new size in both directions
+		population.resize(50);
+		OPI_CHECK(packed(population));
+		OPI_CHECK(filled(population, 50));
+		population.resize(100);
+		OPI_CHECK(packed(population));
+		OPI_CHECK(filled(population, 50));
+		population.resize(3000);
+		OPI_CHECK(packed(population));
+		OPI_CHECK(filled(population, 50));
+		population.resizeByteArray(5);
+		OPI_CHECK(packed(population));
+		OPI_CHECK(filled(population, 50));
+	}
+
+	void testClear(OPI::Host& host)
+	{
+		OPI::Population population(host, 100);
+		population.resizeByteArray(3);
+		population.setSlabAllocationEnabled();
+		fill(population);
+		const OPI::Orbit* orbits = population.getOrbit();
+		const OPI::Epoch* epochs = population.getEpoch();
+
+		// refilling a cleared Population keeps the slab
+		population.clear();
+		OPI_CHECK(population.getSize() == 0);
+		population.resize(80, 3);
+		fill(population);
+		OPI_CHECK(population.getOrbit() == orbits);
+		OPI_CHECK(population.getEpoch() == epochs);
+		OPI_CHECK(filled(population, 80));
+
+		// unless the objects do not fit anymore
+		population.clear();
+		population.resize(200);
+		OPI_CHECK(packed(population));
+		fill(population);
+		OPI_CHECK(filled(population, 200));
+	}
+
+	void testCopy(OPI::Host& host)
+	{
+		OPI::Population population(host, 100);
+		population.setSlabAllocationEnabled();
+		fill(population);
+		OPI::Population copy(population);
+		// a column modified while shared moves out of the slab, the copy keeps the old data
+		population.getOrbit()[0].semi_major_axis = 1.0;
+		population.update(OPI::DATA_ORBIT);
+		OPI_CHECK(copy.getOrbit()[0].semi_major_axis == 7000.0);
+		OPI_CHECK(filled(copy, 100));
+		population.resize(200);
+		OPI_CHECK(packed(population));
+		OPI_CHECK(population.getOrbit()[0].semi_major_axis == 1.0);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testResize(host);
+	testClear(host);
+	testCopy(host);
+	return OPI_TEST_RESULT("TestSlab");
+}
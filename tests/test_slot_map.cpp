@@ -0,0 +1,109 @@
+/* OPI: Orbital Propagation Interface
+ * Copyright (C) 2014 Institute of Aerospace Systems, TU Braunschweig, All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+#include "OPI/opi_cpp.h"
+#include "opi_test.h"
+
+// Stable indices: tombstones, handles and compaction.
+namespace
+{
+	void fill(OPI::Population& population)
+	{
+		for(int i = 0; i < population.getSize(); ++i)
+		{
+			population.getObjectProperties()[i] = OPI::ObjectProperties(1.0, 1.0, 0.01, 2.2, 1.3, 100 + i);
+			population.getOrbit()[i] = OPI::Orbit(7000.0 + i, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+		}
+		population.update(OPI::DATA_PROPERTIES);
+		population.update(OPI::DATA_ORBIT);
+	}
+
+	void testTombstones(OPI::Host& host)
+	{
+		OPI::Population population(host, 10);
+		fill(population);
+		population.setSlotMapEnabled();
+		OPI_CHECK(population.isSlotMapEnabled());
+		OPI::ObjectHandle handle = population.getHandle(7);
+		OPI::ObjectHandle removed = population.getHandle(3);
+
+		// removing does not move any object
+		population.remove(3);
+		population.remove(5);
+		OPI_CHECK(population.getSize() == 10);
+		OPI_CHECK(population.getValidCount() == 8);
+		OPI_CHECK(!population.isValid(3) && !population.isValid(5) && population.isValid(4));
+		OPI_CHECK_CLOSE(population.getFragmentation(), 0.2, 1e-6);
+		OPI_CHECK(population.resolve(handle) == 7);
+		OPI_CHECK(population.resolve(removed) == -1);
+		OPI_CHECK(population.getHandle(3).index == -1);
+		OPI_CHECK(population.findById(103) == -1);
+		OPI_CHECK(population.getOrbit()[7].semi_major_axis == 7007.0);
+
+		OPI::IndexList valid(host);
+		population.getValidIndices(valid);
+		OPI_CHECK(valid.getSize() == 8);
+		OPI_CHECK(valid.getSize() == 8 && valid.getData(OPI::DEVICE_HOST)[3] == 4);
+
+		// compaction only happens above the threshold unless forced
+		OPI::IndexList remap(host);
+		population.setCompactionThreshold(0.25f);
+		OPI_CHECK(!population.compact(remap));
+		OPI_CHECK(population.compact(remap, true));
+		OPI_CHECK(population.getSize() == 8);
+		OPI_CHECK(population.getValidCount() == 8);
+		OPI_CHECK(remap.getSize() == 10);
+		if(remap.getSize() == 10)
+		{
+			const int* newIndex = remap.getData(OPI::DEVICE_HOST);
+			OPI_CHECK(newIndex[3] == -1 && newIndex[5] == -1);
+			OPI_CHECK(newIndex[4] == 3 && newIndex[7] == 5 && newIndex[9] == 7);
+		}
+		OPI_CHECK(population.getOrbit()[5].semi_major_axis == 7007.0);
+		OPI_CHECK(population.getObjectProperties()[5].id == 107);
+		OPI_CHECK(population.resolve(handle) == -1);
+		OPI_CHECK(!population.compact(remap, true));
+	}
+
+	void testDuplicateIds(OPI::Host& host, bool indexed)
+	{
+		OPI::Population population(host, 10);
+		fill(population);
+		population.getObjectProperties()[8].id = 102;
+		population.update(OPI::DATA_PROPERTIES);
+		population.setSlotMapEnabled();
+		population.setIdIndexEnabled(indexed);
+		OPI_CHECK(population.findById(102) == 2);
+
+		// the other object with the same id is still found
+		population.remove(2);
+		OPI_CHECK(population.findById(102) == 8);
+		population.remove(8);
+		OPI_CHECK(population.findById(102) == -1);
+		population.remove(4);
+		OPI_CHECK(population.findById(104) == -1);
+		OPI_CHECK(population.findById(109) == 9);
+	}
+}
+
+int main()
+{
+	OPI::Host host;
+	testTombstones(host);
+	testDuplicateIds(host, false);
+	testDuplicateIds(host, true);
+	return OPI_TEST_RESULT("TestSlotMap");
+}